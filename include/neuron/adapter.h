@@ -24,6 +24,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include <sys/un.h>
@@ -44,6 +45,25 @@ typedef int (*neu_adapter_register_metric_cb_t)(neu_adapter_t *   adapter,
                                                 neu_metric_type_e type,
                                                 uint64_t          init);
 
+/**
+ * A tag handle identifies a (group, tag) value slot of a driver. Plugins
+ * resolve it once with driver.resolve_tag when building their group data and
+ * pass it to driver.update_by_handle afterwards, which skips the per-sample
+ * name lookups. Slots are reused after a tag is deleted, the generation makes
+ * a handle of the deleted tag stale instead of pointing at the new one.
+ */
+typedef struct {
+    int32_t  index;
+    uint32_t generation;
+} neu_tag_handle_t;
+
+#define NEU_TAG_HANDLE_INVALID_INDEX (-1)
+
+static inline bool neu_tag_handle_valid(neu_tag_handle_t handle)
+{
+    return handle.index != NEU_TAG_HANDLE_INVALID_INDEX;
+}
+
 typedef struct adapter_callbacks {
     int (*command)(neu_adapter_t *adapter, neu_reqresp_head_t head, void *data);
     int (*response)(neu_adapter_t *adapter, neu_reqresp_head_t *head,
@@ -71,6 +91,15 @@ typedef struct adapter_callbacks {
                                            neu_json_type_e t, neu_type_e type,
                                            neu_json_value_u value,
                                            int64_t          error);
+            neu_tag_handle_t (*resolve_tag)(neu_adapter_t *adapter,
+                                            const char *group, const char *tag);
+            // group level error metrics are only kept by the name based
+            // updates, report errors of a whole group through update.
+            // A handle of a deleted tag is stale, its update is dropped and
+            // NEU_ERR_TAG_NOT_EXIST returned, resolve the tag again then
+            int (*update_by_handle)(neu_adapter_t *adapter,
+                                    neu_tag_handle_t handle, neu_dvalue_t value,
+                                    neu_tag_meta_t *metas, int n_meta);
         } driver;
     };
 } adapter_callbacks_t;
@@ -39,6 +39,11 @@ extern "C" {
 #define NEU_MQTT_CACHE_SYNC_INTERVAL_MAX 12000
 #define NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT 100
 
+// cached messages resent per second after reconnection
+#define NEU_MQTT_CACHE_REPLAY_RATE_MIN 1
+#define NEU_MQTT_CACHE_REPLAY_RATE_MAX 100000
+#define NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT 1000
+
 typedef enum {
     NEU_MQTT_VERSION_V31  = 3,
     NEU_MQTT_VERSION_V311 = 4,
@@ -108,6 +113,9 @@ int  neu_mqtt_client_set_cache_size(neu_mqtt_client_t *client,
 // default to NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT if not set
 int neu_mqtt_client_set_cache_sync_interval(neu_mqtt_client_t *client,
                                             uint32_t           interval);
+// default to NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT if not set
+int neu_mqtt_client_set_cache_replay_rate(neu_mqtt_client_t *client,
+                                          uint32_t           rate);
 int neu_mqtt_client_set_zlog_category(neu_mqtt_client_t *client,
                                       zlog_category_t *  cat);
 
@@ -123,6 +131,10 @@ int neu_mqtt_client_close(neu_mqtt_client_t *client);
  * `errcode` is zero if delivery was successful and nonzero otherwise, and
  * the other arguments are exactly the same what you pass into this function.
  * You may set `cb` to NULL if you do not care about the result.
+ *
+ * With the cache enabled, a message published while disconnected or failed
+ * to be sent is copied to the cache and `errcode` is zero, cached messages
+ * are resent after reconnection.
  */
 int neu_mqtt_client_publish(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
                             char *topic, uint8_t *payload, uint32_t len,
@@ -0,0 +1,114 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_CONNECTION_MQTT_STORE_H
+#define NEURON_CONNECTION_MQTT_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/zlog.h"
+
+/** Store-and-forward log of MQTT messages.
+ *
+ * Messages are appended to fixed size segment files in a directory. Only the
+ * oldest segment, which is being replayed, and the newest one, which is being
+ * appended to, are memory mapped, so the mapped bytes stay within the memory
+ * budget. Segment files never exceed the disk budget: when a new segment does
+ * not fit, the oldest segments are dropped with all their messages. The log
+ * survives restarts, messages not yet consumed are found again on open.
+ *
+ * The store is not thread safe.
+ */
+typedef struct neu_mqtt_store_s neu_mqtt_store_t;
+
+typedef struct {
+    uint8_t        qos;
+    const char *   topic;
+    const uint8_t *payload;
+    uint32_t       len;
+} neu_mqtt_store_msg_t;
+
+/**
+ * @brief Open the store in dir, created if missing.
+ *
+ * @param[in] mem_bytes  memory budget, each of the two mapped segments is
+ *                       half of it.
+ * @param[in] disk_bytes disk budget, at least mem_bytes.
+ * @return NULL on failure.
+ */
+neu_mqtt_store_t *neu_mqtt_store_open(const char *dir, size_t mem_bytes,
+                                      size_t disk_bytes, zlog_category_t *log);
+void              neu_mqtt_store_close(neu_mqtt_store_t *store);
+
+/**
+ * @brief Close the store and remove its segment files and directory.
+ */
+void neu_mqtt_store_destroy(neu_mqtt_store_t *store);
+
+/**
+ * @brief Append a copy of a message, dropping the oldest segments if the
+ * disk budget requires so.
+ *
+ * @return 0 on success, -1 if the message can never fit or on I/O failure.
+ */
+int neu_mqtt_store_push(neu_mqtt_store_t *store, uint8_t qos,
+                        const char *topic, const uint8_t *payload,
+                        uint32_t len);
+
+/**
+ * @brief Read the messages of the oldest segment in order without consuming
+ * them. *cursor is 0 for the first message and is advanced past the message
+ * read. The message references the mapping and is valid until the next call
+ * that modifies the store.
+ *
+ * @return 0 on success, -1 at the end of the oldest segment.
+ */
+int neu_mqtt_store_read(neu_mqtt_store_t *store, uint32_t *cursor,
+                        neu_mqtt_store_msg_t *msg);
+
+/**
+ * @brief Consume the n oldest messages.
+ */
+void neu_mqtt_store_pop(neu_mqtt_store_t *store, size_t n);
+
+size_t neu_mqtt_store_count(const neu_mqtt_store_t *store);
+size_t neu_mqtt_store_disk_used(const neu_mqtt_store_t *store);
+
+/**
+ * @brief Number of messages dropped to keep the disk budget.
+ */
+uint64_t neu_mqtt_store_dropped(const neu_mqtt_store_t *store);
+
+/**
+ * @brief Changes whenever the oldest segment is dropped, messages read before
+ * a change must not be popped.
+ */
+uint64_t neu_mqtt_store_generation(const neu_mqtt_store_t *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -103,6 +103,10 @@ int neu_json_dump_key(void *object, const char *key, char **const result,
 int neu_json_load_key(void *object, const char *key, const char *input,
                       bool must_exist);
 
+/* float value as encoded for a tag without precision and bias, rounding off
+ * the noise of the single precision representation */
+double neu_json_format_float(float value);
+
 #ifdef __cplusplus
 }
 #endif
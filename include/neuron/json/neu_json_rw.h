@@ -26,6 +26,7 @@
 #define _NEU_JSON_API_NEU_JSON_RW_H_
 
 #include "json/json.h"
+#include "utils/json_writer.h"
 
 #include "tag.h"
 
@@ -80,6 +81,8 @@ typedef struct {
     unsigned int current_page;
     unsigned int page_size;
     unsigned int total;
+    bool         by_cursor;
+    int64_t      next_cursor; // only encoded by_cursor
 } neu_json_read_meta_resp_t;
 
 typedef struct {
@@ -160,14 +163,15 @@ int  neu_json_decode_read_req(char *buf, neu_json_read_req_t **result);
 void neu_json_decode_read_req_free(neu_json_read_req_t *req);
 
 typedef struct {
-    char *group;
-    char *node;
-    char *name;
-    char *desc;
-    bool  sync;
-    int   current_page;
-    int   page_size;
-    bool  is_error;
+    char *  group;
+    char *  node;
+    char *  name;
+    char *  desc;
+    bool    sync;
+    int     current_page;
+    int     page_size;
+    bool    is_error;
+    int64_t cursor; // -1 without one
 } neu_json_read_paginate_req_t;
 
 int  neu_json_decode_read_paginate_req(char *                         buf,
@@ -182,6 +186,24 @@ void neu_json_metas_to_json_paginate(
     neu_tag_meta_t *metas, int n_meta,
     neu_json_read_paginate_resp_tag_t *json_tag);
 
+/* Streaming variants of neu_json_encode_read_periodic_resp,
+ * neu_json_encode_read_resp and neu_json_encode_read_resp1. They write the
+ * same fields into an object the caller opened on the writer. Tags are
+ * pulled one at a time through the fill callback, which may point
+ * tag->metas at the NEU_TAG_META_SIZE entries it is given, so encoding does
+ * not allocate per tag. Reals are formatted by neu_json_writer_real, their
+ * text may differ from the jansson encoding. */
+typedef void (*neu_json_tag_fill_fn)(void *ctx, int index,
+                                     neu_json_read_resp_tag_t *tag,
+                                     neu_json_tag_meta_t *     metas);
+
+void neu_json_write_read_periodic(neu_json_writer_t *             w,
+                                  const neu_json_read_periodic_t *periodic);
+void neu_json_write_read_resp(neu_json_writer_t *w, int n_tag,
+                              neu_json_tag_fill_fn fill, void *ctx);
+void neu_json_write_read_resp1(neu_json_writer_t *w, int n_tag,
+                               neu_json_tag_fill_fn fill, void *ctx);
+
 typedef struct {
     char *                    driver;
     char *                    group;
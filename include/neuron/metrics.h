@@ -41,6 +41,7 @@ typedef enum {
     NEU_METRIC_TYPE_GAUAGE,
     NEU_METRIC_TYPE_COUNTER_SET,
     NEU_METRIC_TYPE_ROLLING_COUNTER,
+    NEU_METRIC_TYPE_HISTOGRAM,
 
     NEU_METRIC_TYPE_FLAG_NO_RESET = 0x80,
 } neu_metric_type_e;
@@ -66,6 +67,11 @@ typedef enum {
     "Last request round trip time in milliseconds"
 #define NEU_METRIC_LAST_RTT_MS_MAX 9999
 
+// distribution of round trip time in milliseconds
+#define NEU_METRIC_RTT_MS "rtt_ms"
+#define NEU_METRIC_RTT_MS_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_RTT_MS_HELP "Request round trip time in milliseconds"
+
 // number of bytes sent
 #define NEU_METRIC_SEND_BYTES "send_bytes"
 #define NEU_METRIC_SEND_BYTES_TYPE NEU_METRIC_TYPE_COUNTER_SET
@@ -116,6 +122,13 @@ typedef enum {
 #define NEU_METRIC_GROUP_LAST_TIMER_MS_HELP \
     "Time in milliseconds consumed on last group timer invocation"
 
+// maintained by neuron core
+// distribution of milliseconds consumed in group timer invocations
+#define NEU_METRIC_GROUP_TIMER_MS "group_timer_ms"
+#define NEU_METRIC_GROUP_TIMER_MS_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_GROUP_TIMER_MS_HELP \
+    "Time in milliseconds consumed on group timer invocations"
+
 // maintained by neuron core
 // group last error code
 #define NEU_METRIC_GROUP_LAST_ERROR_CODE "group_last_error_code"
@@ -130,6 +143,42 @@ typedef enum {
 #define NEU_METRIC_GROUP_LAST_ERROR_TS_HELP \
     "Timestamp (ms) of the last encountered error in group data acquisition"
 
+// maintained by neuron core
+// milliseconds the last group read waited for its lane or a scan worker
+#define NEU_METRIC_GROUP_LAST_SCAN_DELAY_MS "group_last_scan_delay_ms"
+#define NEU_METRIC_GROUP_LAST_SCAN_DELAY_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_GROUP_LAST_SCAN_DELAY_MS_HELP \
+    "Time in milliseconds the last group read waited to be scheduled"
+
+// maintained by neuron core
+// number of group reads ending after the next read was due
+#define NEU_METRIC_GROUP_SCAN_OVERRUNS_TOTAL "group_scan_overruns_total"
+#define NEU_METRIC_GROUP_SCAN_OVERRUNS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_GROUP_SCAN_OVERRUNS_TOTAL_HELP \
+    "Total number of group reads ending after the next read was due"
+
+// maintained by neuron core
+// number of group read cycles skipped by late reads
+#define NEU_METRIC_GROUP_SCAN_SKIPPED_TOTAL "group_scan_skipped_cycles_total"
+#define NEU_METRIC_GROUP_SCAN_SKIPPED_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_GROUP_SCAN_SKIPPED_TOTAL_HELP \
+    "Total number of group read cycles skipped by late reads"
+
+// maintained by neuron core
+// distribution of the distance between the interval and the time between
+// the starts of two group reads
+#define NEU_METRIC_GROUP_SCAN_JITTER_MS "group_scan_jitter_ms"
+#define NEU_METRIC_GROUP_SCAN_JITTER_MS_TYPE NEU_METRIC_TYPE_HISTOGRAM
+#define NEU_METRIC_GROUP_SCAN_JITTER_MS_HELP \
+    "Deviation in milliseconds of the group read period from the interval"
+
+// maintained by neuron core
+// interval in effect, larger than the group interval when stretched
+#define NEU_METRIC_GROUP_SCAN_INTERVAL_MS "group_scan_interval_ms"
+#define NEU_METRIC_GROUP_SCAN_INTERVAL_MS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_GROUP_SCAN_INTERVAL_MS_HELP \
+    "Group read interval in milliseconds in effect"
+
 // number of messages sent
 #define NEU_METRIC_SEND_MSGS_TOTAL "send_msgs_total"
 #define NEU_METRIC_SEND_MSGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
@@ -141,11 +190,62 @@ typedef enum {
 #define NEU_METRIC_SEND_MSG_ERRORS_TOTAL_HELP \
     "Total number of errors sending messages"
 
+// number of messages waiting for the app socket
+#define NEU_METRIC_SEND_QUEUE_DEPTH "send_queue_depth"
+#define NEU_METRIC_SEND_QUEUE_DEPTH_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_SEND_QUEUE_DEPTH_HELP \
+    "Number of messages waiting to be sent on the app socket"
+
+// number of messages dropped because the send queue was full
+#define NEU_METRIC_SEND_QUEUE_DROPS_TOTAL "send_queue_drops_total"
+#define NEU_METRIC_SEND_QUEUE_DROPS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_SEND_QUEUE_DROPS_TOTAL_HELP \
+    "Total number of messages dropped because the send queue was full"
+
+// number of group reports in the last upload message
+#define NEU_METRIC_UPLOAD_BATCH_MSGS "upload_batch_msgs"
+#define NEU_METRIC_UPLOAD_BATCH_MSGS_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_UPLOAD_BATCH_MSGS_HELP \
+    "Number of group reports in the last upload message"
+
+// bytes of upload messages before compression
+#define NEU_METRIC_UPLOAD_RAW_BYTES_TOTAL "upload_raw_bytes_total"
+#define NEU_METRIC_UPLOAD_RAW_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_UPLOAD_RAW_BYTES_TOTAL_HELP \
+    "Total bytes of upload messages before compression"
+
+// bytes of upload messages handed to the connection
+#define NEU_METRIC_UPLOAD_WIRE_BYTES_TOTAL "upload_wire_bytes_total"
+#define NEU_METRIC_UPLOAD_WIRE_BYTES_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_UPLOAD_WIRE_BYTES_TOTAL_HELP \
+    "Total bytes of upload messages after batching and compression"
+
 // number of messages received
 #define NEU_METRIC_RECV_MSGS_TOTAL "recv_msgs_total"
 #define NEU_METRIC_RECV_MSGS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
 #define NEU_METRIC_RECV_MSGS_TOTAL_HELP "Total number of messages received"
 
+// maintained by neuron core
+// number of trans data messages waiting for the app
+#define NEU_METRIC_MSG_QUEUE_DEPTH "msg_queue_depth"
+#define NEU_METRIC_MSG_QUEUE_DEPTH_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MSG_QUEUE_DEPTH_HELP \
+    "Number of trans data messages waiting in the app queue"
+
+// maintained by neuron core
+// number of trans data messages dropped by the queue policy
+#define NEU_METRIC_MSG_QUEUE_DROPS_TOTAL "msg_queue_drops_total"
+#define NEU_METRIC_MSG_QUEUE_DROPS_TOTAL_TYPE NEU_METRIC_TYPE_COUNTER
+#define NEU_METRIC_MSG_QUEUE_DROPS_TOTAL_HELP \
+    "Total number of trans data messages dropped by the app queue"
+
+// maintained by neuron core
+// enqueue to dequeue latency of the last trans data message
+#define NEU_METRIC_MSG_QUEUE_LAST_LATENCY_US "msg_queue_last_latency_us"
+#define NEU_METRIC_MSG_QUEUE_LAST_LATENCY_US_TYPE NEU_METRIC_TYPE_GAUAGE
+#define NEU_METRIC_MSG_QUEUE_LAST_LATENCY_US_HELP \
+    "Time in microseconds the last trans data message spent in the app queue"
+
 // number of trans data message within the last 5 seconds
 #define NEU_METRIC_TRANS_DATA_5S "last_5s_trans_data_msgs"
 #define NEU_METRIC_TRANS_DATA_5S_TYPE NEU_METRIC_TYPE_ROLLING_COUNTER
@@ -243,15 +343,35 @@ typedef enum {
     NEU_METRICS_CATEGORY_ALL,
 } neu_metrics_category_e;
 
+// number of histogram buckets, the last one is unbounded
+#define NEU_METRIC_HISTOGRAM_BUCKETS 14
+
+// upper bounds of the bounded histogram buckets
+extern const uint64_t
+    neu_metric_histogram_bounds[NEU_METRIC_HISTOGRAM_BUCKETS - 1];
+
+// histogram of observed values, every field is updated atomically
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t buckets[NEU_METRIC_HISTOGRAM_BUCKETS]; // not cumulative
+} neu_metric_histogram_t;
+
 // metric entry
+//
+// A pointer to an entry serves as a handle for updates without lookup, it is
+// valid until the entry is removed with its group or node. Counters, gauges
+// and histograms are updated atomically, rolling counters under the node
+// lock.
 typedef struct {
-    const char *           name;  // NOTE: should points to string literal
-    const char *           help;  // NOTE: should points to string literal
-    neu_metric_type_e      type;  //
-    uint64_t               init;  //
-    uint64_t               value; //
-    neu_rolling_counter_t *rcnt;  //
-    UT_hash_handle         hh;    // ordered by name
+    const char *            name;  // NOTE: should points to string literal
+    const char *            help;  // NOTE: should points to string literal
+    neu_metric_type_e       type;  //
+    uint64_t                init;  //
+    uint64_t                value; //
+    neu_rolling_counter_t * rcnt;  //
+    neu_metric_histogram_t *hist;  //
+    UT_hash_handle          hh;    // ordered by name
 } neu_metric_entry_t;
 
 // group metrics
@@ -320,6 +440,11 @@ static inline bool neu_metric_type_is_rolling_counter(neu_metric_type_e type)
     return NEU_METRIC_TYPE_ROLLING_COUNTER == (type & NEU_METRIC_TYPE_MASK);
 }
 
+static inline bool neu_metric_type_is_histogram(neu_metric_type_e type)
+{
+    return NEU_METRIC_TYPE_HISTOGRAM == (type & NEU_METRIC_TYPE_MASK);
+}
+
 static inline bool neu_metric_type_no_reset(neu_metric_type_e type)
 {
     return NEU_METRIC_TYPE_FLAG_NO_RESET & type;
@@ -329,11 +454,42 @@ static inline const char *neu_metric_type_str(neu_metric_type_e type)
 {
     if (neu_metric_type_is_counter(type)) {
         return "counter";
+    } else if (neu_metric_type_is_histogram(type)) {
+        return "histogram";
     } else {
         return "gauge";
     }
 }
 
+static inline void neu_metric_histogram_observe(neu_metric_histogram_t *hist,
+                                                uint64_t                v)
+{
+    int i = 0;
+
+    while (i < NEU_METRIC_HISTOGRAM_BUCKETS - 1 &&
+           v > neu_metric_histogram_bounds[i]) {
+        ++i;
+    }
+
+    __atomic_fetch_add(&hist->buckets[i], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->sum, v, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->count, 1, __ATOMIC_RELAXED);
+}
+
+static inline void neu_metric_histogram_reset(neu_metric_histogram_t *hist)
+{
+    for (int i = 0; i < NEU_METRIC_HISTOGRAM_BUCKETS; ++i) {
+        __atomic_store_n(&hist->buckets[i], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&hist->sum, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&hist->count, 0, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t neu_metric_entry_value(const neu_metric_entry_t *entry)
+{
+    return __atomic_load_n(&entry->value, __ATOMIC_RELAXED);
+}
+
 int neu_metric_entries_add(neu_metric_entry_t **entries, const char *name,
                            const char *help, neu_metric_type_e type,
                            uint64_t init);
@@ -343,6 +499,7 @@ static inline void neu_metric_entry_free(neu_metric_entry_t *entry)
     if (neu_metric_type_is_rolling_counter(entry->type)) {
         neu_rolling_counter_free(entry->rcnt);
     }
+    free(entry->hist);
     free(entry);
 }
 
@@ -447,13 +604,13 @@ static inline int neu_node_metrics_add(neu_node_metrics_t *node_metrics,
     return rv;
 }
 
-static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
-                                          const char *        group,
-                                          const char *metric_name, uint64_t n)
+// caller holds the node lock
+static inline neu_metric_entry_t *
+node_metrics_find(neu_node_metrics_t *node_metrics, const char *group,
+                  const char *metric_name)
 {
     neu_metric_entry_t *entry = NULL;
 
-    pthread_mutex_lock(&node_metrics->lock);
     if (NULL == group) {
         HASH_FIND_STR(node_metrics->entries, metric_name, entry);
     } else if (NULL != node_metrics->group_metrics) {
@@ -464,24 +621,89 @@ static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
         }
     }
 
-    if (NULL == entry) {
-        pthread_mutex_unlock(&node_metrics->lock);
-        return -1;
-    }
+    return entry;
+}
 
+// caller holds the node lock for rolling counters
+static inline void metric_entry_update(neu_metric_entry_t *entry, uint64_t n)
+{
     if (neu_metric_type_is_counter(entry->type)) {
-        entry->value += n;
+        __atomic_fetch_add(&entry->value, n, __ATOMIC_RELAXED);
     } else if (neu_metric_type_is_rolling_counter(entry->type)) {
         entry->value =
             neu_rolling_counter_inc(entry->rcnt, global_timestamp, n);
+    } else if (neu_metric_type_is_histogram(entry->type)) {
+        neu_metric_histogram_observe(entry->hist, n);
+    } else {
+        __atomic_store_n(&entry->value, n, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Resolve the handle of a metric registered on the node, or on one of
+ * its groups if group is not NULL.
+ *
+ * @return NULL if there is no such metric.
+ */
+static inline neu_metric_entry_t *
+neu_node_metrics_find(neu_node_metrics_t *node_metrics, const char *group,
+                      const char *metric_name)
+{
+    neu_metric_entry_t *entry = NULL;
+
+    pthread_mutex_lock(&node_metrics->lock);
+    entry = node_metrics_find(node_metrics, group, metric_name);
+    pthread_mutex_unlock(&node_metrics->lock);
+
+    return entry;
+}
+
+/**
+ * @brief Update a metric by its handle, counters are incremented by n,
+ * histograms observe n and gauges are set to n.
+ */
+static inline void
+neu_node_metrics_update_entry(neu_node_metrics_t *node_metrics,
+                              neu_metric_entry_t *entry, uint64_t n)
+{
+    if (neu_metric_type_is_rolling_counter(entry->type)) {
+        pthread_mutex_lock(&node_metrics->lock);
+        metric_entry_update(entry, n);
+        pthread_mutex_unlock(&node_metrics->lock);
     } else {
-        entry->value = n;
+        metric_entry_update(entry, n);
+    }
+}
+
+static inline int neu_node_metrics_update(neu_node_metrics_t *node_metrics,
+                                          const char *        group,
+                                          const char *metric_name, uint64_t n)
+{
+    neu_metric_entry_t *entry = NULL;
+
+    pthread_mutex_lock(&node_metrics->lock);
+    entry = node_metrics_find(node_metrics, group, metric_name);
+    if (NULL == entry) {
+        pthread_mutex_unlock(&node_metrics->lock);
+        return -1;
     }
+
+    metric_entry_update(entry, n);
     pthread_mutex_unlock(&node_metrics->lock);
 
     return 0;
 }
 
+static inline void metric_entry_reset(neu_metric_entry_t *entry)
+{
+    __atomic_store_n(&entry->value, entry->init, __ATOMIC_RELAXED);
+    if (neu_metric_type_is_rolling_counter(entry->type)) {
+        neu_rolling_counter_reset(entry->rcnt);
+    } else if (neu_metric_type_is_histogram(entry->type)) {
+        neu_metric_histogram_reset(entry->hist);
+    }
+}
+
 static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
 {
     neu_metric_entry_t *entry = NULL;
@@ -490,10 +712,7 @@ static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
     HASH_LOOP(hh, node_metrics->entries, entry)
     {
         if (!neu_metric_type_no_reset(entry->type)) {
-            entry->value = entry->init;
-            if (neu_metric_type_is_rolling_counter(entry->type)) {
-                neu_rolling_counter_reset(entry->rcnt);
-            }
+            metric_entry_reset(entry);
         }
     }
 
@@ -503,10 +722,7 @@ static inline void neu_node_metrics_reset(neu_node_metrics_t *node_metrics)
         HASH_LOOP(hh, g->entries, entry)
         {
             if (!neu_metric_type_no_reset(entry->type)) {
-                entry->value = entry->init;
-                if (neu_metric_type_is_rolling_counter(entry->type)) {
-                    neu_rolling_counter_reset(entry->rcnt);
-                }
+                metric_entry_reset(entry);
             }
         }
     }
@@ -32,6 +32,7 @@ extern "C" {
 #include "define.h"
 #include "errcodes.h"
 #include "tag.h"
+#include "tag_values.h"
 #include "type.h"
 #include <math.h>
 
@@ -96,6 +97,8 @@ typedef enum neu_reqresp_type {
     NEU_RESP_ADD_TAG,
     NEU_REQ_ADD_GTAG,
     NEU_RESP_ADD_GTAG,
+    NEU_REQ_IMPORT_TAG,
+    NEU_RESP_IMPORT_TAG,
     NEU_REQ_DEL_TAG,
     NEU_REQ_UPDATE_TAG,
     NEU_RESP_UPDATE_TAG,
@@ -179,6 +182,8 @@ static const char *neu_reqresp_type_string_t[] = {
     [NEU_RESP_ADD_TAG]    = "NEU_RESP_ADD_TAG",
     [NEU_REQ_ADD_GTAG]    = "NEU_REQ_ADD_GTAG",
     [NEU_RESP_ADD_GTAG]   = "NEU_RESP_ADD_GTAG",
+    [NEU_REQ_IMPORT_TAG]  = "NEU_REQ_IMPORT_TAG",
+    [NEU_RESP_IMPORT_TAG] = "NEU_RESP_IMPORT_TAG",
     [NEU_REQ_DEL_TAG]     = "NEU_REQ_DEL_TAG",
     [NEU_REQ_UPDATE_TAG]  = "NEU_REQ_UPDATE_TAG",
     [NEU_RESP_UPDATE_TAG] = "NEU_RESP_UPDATE_TAG",
@@ -333,7 +338,7 @@ typedef struct neu_req_get_group {
 
 typedef struct neu_resp_group_info {
     char     name[NEU_GROUP_NAME_LEN];
-    uint16_t tag_count;
+    uint32_t tag_count;
     uint32_t interval;
 } neu_resp_group_info_t;
 
@@ -350,14 +355,14 @@ typedef struct {
 
 typedef struct {
     char            driver[NEU_NODE_NAME_LEN];
-    uint16_t        n_group;
+    uint32_t        n_group;
     neu_gdatatag_t *groups;
 } neu_req_add_gtag_t;
 
 typedef struct {
     char     driver[NEU_NODE_NAME_LEN];
     char     group[NEU_GROUP_NAME_LEN];
-    uint16_t tag_count;
+    uint32_t tag_count;
     uint32_t interval;
 } neu_resp_driver_group_info_t;
 
@@ -368,13 +373,13 @@ typedef struct {
 typedef struct {
     char           driver[NEU_NODE_NAME_LEN];
     char           group[NEU_GROUP_NAME_LEN];
-    uint16_t       n_tag;
+    uint32_t       n_tag;
     neu_datatag_t *tags;
 } neu_req_add_tag_t, neu_req_update_tag_t;
 
 static inline void neu_req_add_tag_fini(neu_req_add_tag_t *req)
 {
-    for (uint16_t i = 0; i < req->n_tag; i++) {
+    for (uint32_t i = 0; i < req->n_tag; i++) {
         neu_tag_fini(&req->tags[i]);
     }
     free(req->tags);
@@ -390,27 +395,43 @@ static inline int neu_req_add_tag_copy(neu_req_add_tag_t *dst,
         return -1;
     }
     dst->n_tag = src->n_tag;
-    for (uint16_t i = 0; i < src->n_tag; i++) {
+    for (uint32_t i = 0; i < src->n_tag; i++) {
         neu_tag_copy(&dst->tags[i], &src->tags[i]);
     }
     return 0;
 }
 
 typedef struct {
-    uint16_t index;
+    uint32_t index;
     int      error;
 } neu_resp_add_tag_t, neu_resp_update_tag_t;
 
+// tags imported at once into one group, created with interval if missing
+typedef struct {
+    char           driver[NEU_NODE_NAME_LEN];
+    char           group[NEU_GROUP_NAME_LEN];
+    uint32_t       interval;
+    uint32_t       n_tag;
+    neu_datatag_t *tags;
+} neu_req_import_tag_t;
+
+// index is the number of tags imported, or the first tag in error in which
+// case no tag is imported
+typedef struct {
+    uint32_t index;
+    int      error;
+} neu_resp_import_tag_t;
+
 typedef struct neu_req_del_tag {
     char     driver[NEU_NODE_NAME_LEN];
     char     group[NEU_GROUP_NAME_LEN];
-    uint16_t n_tag;
+    uint32_t n_tag;
     char **  tags;
 } neu_req_del_tag_t;
 
 static inline void neu_req_del_tag_fini(neu_req_del_tag_t *req)
 {
-    for (uint16_t i = 0; i < req->n_tag; i++) {
+    for (uint32_t i = 0; i < req->n_tag; i++) {
         free(req->tags[i]);
     }
     free(req->tags);
@@ -426,7 +447,7 @@ static inline int neu_req_del_tag_copy(neu_req_del_tag_t *dst,
         return -1;
     }
     dst->n_tag = src->n_tag;
-    for (uint16_t i = 0; i < src->n_tag; ++i) {
+    for (uint32_t i = 0; i < src->n_tag; ++i) {
         dst->tags[i] = strdup(src->tags[i]);
         if (NULL == dst->tags[i]) {
             while (i-- > 0) {
@@ -636,6 +657,9 @@ typedef struct neu_req_read_group_paginate {
     int   current_page;
     int   page_size;
     bool  is_error;
+
+    bool     by_cursor; // page after cursor instead of current_page
+    uint64_t cursor;    // 0 for the first page
 } neu_req_read_group_paginate_t;
 
 static inline void
@@ -752,6 +776,9 @@ typedef struct {
     bool  is_error;
     int   total_count; // tags count without pagination
 
+    bool     by_cursor;
+    uint64_t next_cursor; // 0 after the last page
+
     UT_array *tags; // neu_resp_tag_value_meta_paginate_t
 } neu_resp_read_group_paginate_t;
 
@@ -783,23 +810,18 @@ neu_resp_read_paginate_free(neu_resp_read_group_paginate_t *resp)
 }
 
 typedef struct {
-    uint16_t        index;
-    pthread_mutex_t mtx;
-} neu_reqresp_trans_data_ctx_t;
-
-typedef struct {
+    // driver and group point into values
     char *driver;
     char *group;
 
-    neu_reqresp_trans_data_ctx_t *ctx;
-    UT_array *                    tags; // neu_resp_tag_value_meta_t
+    neu_tag_values_t *values;
 } neu_reqresp_trans_data_t;
 
 typedef struct {
     char *          node;
     char *          plugin;
     char *          setting;
-    uint16_t        n_group;
+    uint32_t        n_group;
     neu_gdatatag_t *groups;
 } neu_req_driver_t;
 
@@ -808,7 +830,7 @@ static inline void neu_req_driver_fini(neu_req_driver_t *req)
     free(req->node);
     free(req->plugin);
     free(req->setting);
-    for (uint16_t i = 0; i < req->n_group; i++) {
+    for (uint32_t i = 0; i < req->n_group; i++) {
         for (int j = 0; j < req->groups[i].n_tag; j++) {
             neu_tag_fini(&req->groups[i].tags[j]);
         }
@@ -832,141 +854,150 @@ static inline void neu_req_driver_array_fini(neu_req_driver_array_t *req)
 
 static inline void neu_trans_data_free(neu_reqresp_trans_data_t *data)
 {
-    pthread_mutex_lock(&data->ctx->mtx);
-    if (data->ctx->index > 0) {
-        data->ctx->index -= 1;
-    }
-
-    if (data->ctx->index == 0) {
-        utarray_foreach(data->tags, neu_resp_tag_value_meta_t *, tag_value)
-        {
-            if (tag_value->value.type == NEU_TYPE_PTR) {
-                free(tag_value->value.value.ptr.ptr);
-            }
-        }
-        utarray_free(data->tags);
-        free(data->group);
-        free(data->driver);
-        pthread_mutex_unlock(&data->ctx->mtx);
-        pthread_mutex_destroy(&data->ctx->mtx);
-        free(data->ctx);
-    } else {
-        pthread_mutex_unlock(&data->ctx->mtx);
-    }
+    neu_tag_values_unref(data->values);
 }
 
-static inline void neu_tag_value_to_json(neu_resp_tag_value_meta_t *tag_value,
-                                         neu_json_read_resp_tag_t * tag_json)
+static inline void neu_dvalue_to_json(neu_dvalue_t *            value,
+                                      neu_json_read_resp_tag_t *tag_json)
 {
-    tag_json->name  = tag_value->tag;
-    tag_json->error = 0;
-
-    for (int k = 0; k < NEU_TAG_META_SIZE; k++) {
-        if (strlen(tag_value->metas[k].name) > 0) {
-            tag_json->n_meta++;
-        } else {
-            break;
-        }
-    }
-    if (tag_json->n_meta > 0) {
-        tag_json->metas = (neu_json_tag_meta_t *) calloc(
-            tag_json->n_meta, sizeof(neu_json_tag_meta_t));
-    }
-    neu_json_metas_to_json(tag_value->metas, NEU_TAG_META_SIZE, tag_json);
-
-    tag_json->datatag.bias = tag_value->datatag.bias;
-
-    switch (tag_value->value.type) {
+    switch (value->type) {
     case NEU_TYPE_ERROR:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.i32;
-        tag_json->error         = tag_value->value.value.i32;
+        tag_json->value.val_int = value->value.i32;
+        tag_json->error         = value->value.i32;
         break;
     case NEU_TYPE_UINT8:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.u8;
+        tag_json->value.val_int = value->value.u8;
         break;
     case NEU_TYPE_INT8:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.i8;
+        tag_json->value.val_int = value->value.i8;
         break;
     case NEU_TYPE_INT16:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.i16;
+        tag_json->value.val_int = value->value.i16;
         break;
     case NEU_TYPE_INT32:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.i32;
+        tag_json->value.val_int = value->value.i32;
         break;
     case NEU_TYPE_INT64:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.i64;
+        tag_json->value.val_int = value->value.i64;
         break;
     case NEU_TYPE_WORD:
     case NEU_TYPE_UINT16:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.u16;
+        tag_json->value.val_int = value->value.u16;
         break;
     case NEU_TYPE_DWORD:
     case NEU_TYPE_UINT32:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.u32;
+        tag_json->value.val_int = value->value.u32;
         break;
     case NEU_TYPE_LWORD:
     case NEU_TYPE_UINT64:
         tag_json->t             = NEU_JSON_INT;
-        tag_json->value.val_int = tag_value->value.value.u64;
+        tag_json->value.val_int = value->value.u64;
         break;
     case NEU_TYPE_FLOAT:
-        if (isnan(tag_value->value.value.f32)) {
+        if (isnan(value->value.f32)) {
             tag_json->t               = NEU_JSON_FLOAT;
-            tag_json->value.val_float = tag_value->value.value.f32;
+            tag_json->value.val_float = value->value.f32;
             tag_json->error           = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
         } else {
             tag_json->t               = NEU_JSON_FLOAT;
-            tag_json->value.val_float = tag_value->value.value.f32;
-            tag_json->precision       = tag_value->value.precision;
+            tag_json->value.val_float = value->value.f32;
+            tag_json->precision       = value->precision;
         }
         break;
     case NEU_TYPE_DOUBLE:
-        if (isnan(tag_value->value.value.d64)) {
+        if (isnan(value->value.d64)) {
             tag_json->t                = NEU_JSON_DOUBLE;
-            tag_json->value.val_double = tag_value->value.value.d64;
+            tag_json->value.val_double = value->value.d64;
             tag_json->error            = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
         } else {
             tag_json->t                = NEU_JSON_DOUBLE;
-            tag_json->value.val_double = tag_value->value.value.d64;
-            tag_json->precision        = tag_value->value.precision;
+            tag_json->value.val_double = value->value.d64;
+            tag_json->precision        = value->precision;
         }
         break;
     case NEU_TYPE_BOOL:
         tag_json->t              = NEU_JSON_BOOL;
-        tag_json->value.val_bool = tag_value->value.value.boolean;
+        tag_json->value.val_bool = value->value.boolean;
         break;
     case NEU_TYPE_BIT:
         tag_json->t             = NEU_JSON_BIT;
-        tag_json->value.val_bit = tag_value->value.value.u8;
+        tag_json->value.val_bit = value->value.u8;
         break;
     case NEU_TYPE_STRING:
     case NEU_TYPE_TIME:
     case NEU_TYPE_DATA_AND_TIME:
         tag_json->t             = NEU_JSON_STR;
-        tag_json->value.val_str = tag_value->value.value.str;
+        tag_json->value.val_str = value->value.str;
         break;
     case NEU_TYPE_PTR:
         tag_json->t             = NEU_JSON_STR;
-        tag_json->value.val_str = (char *) tag_value->value.value.ptr.ptr;
+        tag_json->value.val_str = (char *) value->value.ptr.ptr;
         break;
     case NEU_TYPE_BYTES:
         tag_json->t                      = NEU_JSON_BYTES;
-        tag_json->value.val_bytes.length = tag_value->value.value.bytes.length;
-        tag_json->value.val_bytes.bytes  = tag_value->value.value.bytes.bytes;
+        tag_json->value.val_bytes.length = value->value.bytes.length;
+        tag_json->value.val_bytes.bytes  = value->value.bytes.bytes;
         break;
     default:
         break;
     }
 }
 
+static inline void neu_tag_value_to_json(neu_resp_tag_value_meta_t *tag_value,
+                                         neu_json_read_resp_tag_t * tag_json)
+{
+    tag_json->name  = tag_value->tag;
+    tag_json->error = 0;
+
+    for (int k = 0; k < NEU_TAG_META_SIZE; k++) {
+        if (strlen(tag_value->metas[k].name) > 0) {
+            tag_json->n_meta++;
+        } else {
+            break;
+        }
+    }
+    if (tag_json->n_meta > 0) {
+        tag_json->metas = (neu_json_tag_meta_t *) calloc(
+            tag_json->n_meta, sizeof(neu_json_tag_meta_t));
+    }
+    neu_json_metas_to_json(tag_value->metas, NEU_TAG_META_SIZE, tag_json);
+
+    tag_json->datatag.bias = tag_value->datatag.bias;
+
+    neu_dvalue_to_json(&tag_value->value, tag_json);
+}
+
+// metas go to the NEU_TAG_META_SIZE entries of the caller, nothing allocated
+static inline void neu_tag_value_fill_json(neu_resp_tag_value_meta_t *tag_value,
+                                           neu_json_read_resp_tag_t * tag_json,
+                                           neu_json_tag_meta_t *      metas)
+{
+    tag_json->name  = tag_value->tag;
+    tag_json->error = 0;
+    tag_json->metas = metas;
+
+    for (int k = 0; k < NEU_TAG_META_SIZE; k++) {
+        if (strlen(tag_value->metas[k].name) > 0) {
+            tag_json->n_meta++;
+        } else {
+            break;
+        }
+    }
+    neu_json_metas_to_json(tag_value->metas, tag_json->n_meta, tag_json);
+
+    tag_json->datatag.bias = tag_value->datatag.bias;
+
+    neu_dvalue_to_json(&tag_value->value, tag_json);
+}
+
 static inline void
 neu_tag_value_to_json_paginate(neu_resp_tag_value_meta_paginate_t *tag_value,
                                neu_json_read_paginate_resp_tag_t * tag_json)
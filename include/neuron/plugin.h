@@ -113,6 +113,18 @@ typedef struct neu_plugin_intf_funs {
                              char *ctx);
             int (*test_read_tag)(neu_plugin_t *plugin, void *req,
                                  neu_datatag_t tag);
+            // optional, groups on different lanes may be read concurrently
+            // by the scan workers, while the writes and the groups on one
+            // lane are never run at the same time. NULL puts every group on
+            // NEU_SCAN_LANE_DEFAULT (0) with the writes, and a scan_workers
+            // setting above 1 is rejected for the node.
+            uint32_t (*group_lane)(neu_plugin_t *plugin,
+                                   neu_plugin_group_t *group);
+            // optional, validates a batch of non static tags in one call,
+            // on failure *index is the first invalid tag. NULL falls back to
+            // validate_tag on every tag.
+            int (*validate_tags)(neu_plugin_t *plugin, neu_datatag_t *tags,
+                                 uint32_t n_tag, uint32_t *index);
         } driver;
     };
 
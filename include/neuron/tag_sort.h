@@ -40,7 +40,7 @@ typedef int (*neu_tag_sort_cmp)(neu_tag_sort_elem_t *tag1,
 
 typedef struct {
     struct {
-        uint16_t size;
+        uint32_t size;
         void *   context;
     } info;
 
@@ -48,7 +48,7 @@ typedef struct {
 } neu_tag_sort_t;
 
 typedef struct {
-    uint16_t        n_sort;
+    uint32_t        n_sort;
     neu_tag_sort_t *sorts;
 } neu_tag_sort_result_t;
 
@@ -0,0 +1,151 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+config_ **/
+
+#ifndef _NEU_TAG_VALUES_H_
+#define _NEU_TAG_VALUES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "utils/utarray.h"
+
+#include "json/neu_json_rw.h"
+#include "tag.h"
+#include "type.h"
+
+/**
+ * Immutable table of the tag names of a group, shared by all the reports of
+ * the group until the group changes. Entries are referenced by index.
+ */
+typedef struct neu_tag_names neu_tag_names_t;
+
+/**
+ * @brief Build a name table from a neu_datatag_t array.
+ *
+ * @param[in] tags neu_datatag_t array, index i of the table is tags[i].
+ * @return the table with a reference count of 1.
+ */
+neu_tag_names_t *neu_tag_names_new(UT_array *tags);
+neu_tag_names_t *neu_tag_names_ref(neu_tag_names_t *names);
+void             neu_tag_names_unref(neu_tag_names_t *names);
+uint32_t         neu_tag_names_size(const neu_tag_names_t *names);
+const char *     neu_tag_names_get(const neu_tag_names_t *names, uint32_t i);
+
+/**
+ * Columnar tag values of one group report. Each value is a tag index, a type,
+ * a precision and an 8 bytes scalar; strings and bytes are packed into one
+ * shared buffer, and metas are only stored for the values that carry them.
+ *
+ * Once built, a value set is an immutable snapshot shared by all the
+ * subscribers of the group. Each holder owns a reference and the last
+ * neu_tag_values_unref releases it, no lock is involved.
+ */
+typedef struct neu_tag_values neu_tag_values_t;
+
+/**
+ * @brief Create an empty value set.
+ *
+ * @param[in] driver the driver name, copied.
+ * @param[in] group the group name, copied.
+ * @param[in] names the name table of the group, a reference is taken.
+ * @return the value set with a reference count of 1.
+ */
+neu_tag_values_t *neu_tag_values_new(const char *driver, const char *group,
+                                     neu_tag_names_t *names);
+neu_tag_values_t *neu_tag_values_ref(neu_tag_values_t *values);
+void              neu_tag_values_unref(neu_tag_values_t *values);
+const char *      neu_tag_values_driver(const neu_tag_values_t *values);
+const char *      neu_tag_values_group(const neu_tag_values_t *values);
+
+/**
+ * @brief Append the value of a tag. String, bytes and pointer payloads are
+ * copied, the caller keeps the ownership of value->value.ptr.ptr. Values may
+ * only be appended before the value set is shared.
+ *
+ * @param[in] index index of the tag in the name table.
+ * @param[in] value the value.
+ * @param[in] metas the metas, only the leading named ones are kept.
+ * @param[in] n_meta size of metas.
+ * @return 0 on success, NEU_ERR_EINTERNAL on allocation failure.
+ */
+int neu_tag_values_push(neu_tag_values_t *values, uint32_t index,
+                        const neu_dvalue_t *value, const neu_tag_meta_t *metas,
+                        int n_meta);
+
+/**
+ * @brief Reserve room for n values. Without it the first push reserves one
+ * value per name, which suits full group reports.
+ *
+ * @return 0 on success, NEU_ERR_EINTERNAL on allocation failure.
+ */
+int neu_tag_values_reserve(neu_tag_values_t *values, uint32_t n);
+
+uint32_t    neu_tag_values_size(const neu_tag_values_t *values);
+const char *neu_tag_values_name(const neu_tag_values_t *values, uint32_t i);
+
+/**
+ * @brief Index in the name table of the i-th value.
+ */
+uint32_t neu_tag_values_index(const neu_tag_values_t *values, uint32_t i);
+
+/**
+ * @brief The name table of the value set, no reference is taken.
+ */
+neu_tag_names_t *neu_tag_values_names(const neu_tag_values_t *values);
+
+/**
+ * @brief Get the i-th value. A pointer value is returned as NEU_TYPE_PTR
+ * referencing the internal buffer, it must not be freed.
+ */
+void neu_tag_values_get(const neu_tag_values_t *values, uint32_t i,
+                        neu_dvalue_t *value);
+
+/**
+ * @brief Get the metas of the i-th value.
+ *
+ * @return the number of metas, 0 if the value has none.
+ */
+int neu_tag_values_metas(const neu_tag_values_t *values, uint32_t i,
+                         const neu_tag_meta_t **metas);
+
+/**
+ * @brief Fill a json tag with the i-th value, strings and bytes reference the
+ * internal buffer. tag_json->metas is allocated when the value has metas and
+ * must be freed by the caller.
+ */
+void neu_tag_values_to_json(const neu_tag_values_t *values, uint32_t i,
+                            neu_json_read_resp_tag_t *tag_json);
+
+/**
+ * @brief Same as neu_tag_values_to_json, but the metas are placed in the
+ * NEU_TAG_META_SIZE entries of metas provided by the caller, nothing is
+ * allocated.
+ */
+void neu_tag_values_fill_json(const neu_tag_values_t *values, uint32_t i,
+                              neu_json_read_resp_tag_t *tag_json,
+                              neu_json_tag_meta_t *     metas);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
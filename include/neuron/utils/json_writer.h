@@ -0,0 +1,100 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#ifndef NEURON_UTILS_JSON_WRITER_H
+#define NEURON_UTILS_JSON_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NEU_JSON_WRITER_DEPTH 16
+
+/** Streaming JSON writer.
+ *
+ * Appends compact JSON text to a growable buffer, separators are inserted
+ * automatically. The buffer is kept across neu_json_writer_reset, so a writer
+ * reused for messages of similar size stops allocating after the first one.
+ * A failed allocation or an unbalanced nesting marks the writer as failed,
+ * later writes are ignored and neu_json_writer_str returns NULL.
+ */
+typedef struct {
+    char * buf;
+    size_t len;
+    size_t cap;
+    bool   error;
+    bool   after_key;
+    int    depth;
+    bool   first[NEU_JSON_WRITER_DEPTH];
+} neu_json_writer_t;
+
+void neu_json_writer_init(neu_json_writer_t *w, size_t cap);
+void neu_json_writer_reset(neu_json_writer_t *w);
+void neu_json_writer_fini(neu_json_writer_t *w);
+
+/**
+ * @brief The text written so far, NUL terminated and owned by the writer.
+ *
+ * @return NULL if the writer failed.
+ */
+const char *neu_json_writer_str(neu_json_writer_t *w);
+size_t      neu_json_writer_len(const neu_json_writer_t *w);
+
+/**
+ * @brief Hand the buffer over to the caller, who frees it. The writer is
+ * reset and allocates a buffer of the same capacity on the next write.
+ *
+ * @return NULL if the writer failed.
+ */
+char *neu_json_writer_detach(neu_json_writer_t *w);
+
+void neu_json_writer_object_begin(neu_json_writer_t *w);
+void neu_json_writer_object_end(neu_json_writer_t *w);
+void neu_json_writer_array_begin(neu_json_writer_t *w);
+void neu_json_writer_array_end(neu_json_writer_t *w);
+
+void neu_json_writer_key(neu_json_writer_t *w, const char *key);
+void neu_json_writer_string(neu_json_writer_t *w, const char *str);
+void neu_json_writer_int(neu_json_writer_t *w, int64_t value);
+void neu_json_writer_bool(neu_json_writer_t *w, bool value);
+void neu_json_writer_null(neu_json_writer_t *w);
+
+/**
+ * @brief Write a real number.
+ *
+ * The text is not the one jansson dumps for the same value: without a
+ * precision jansson prints 16 significant digits, so 0.1 + 0.2 is 0.3 there
+ * and 0.30000000000000004 here, and it writes exponents without the plus
+ * sign. The text written here always reads back as the same double.
+ *
+ * @param[in] precision Digits after the decimal point, trailing zeros are
+ *                      dropped. 0 writes the shortest text that reads back
+ *                      as the same double. NaN and infinity are written as
+ *                      null.
+ */
+void neu_json_writer_real(neu_json_writer_t *w, double value, int precision);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,12 +24,27 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#define NEU_JWT_CACHE_SIZE 64
 
 int  neu_jwt_init(const char *dir_path);
 int  neu_jwt_new(char **token);
 int  neu_jwt_validate(char *b_token);
 void neu_jwt_destroy();
 
+/**
+ * @brief Forget all verified tokens, the next validation of each token runs
+ * the signature check again. Done on every key reload.
+ */
+void neu_jwt_cache_invalidate();
+
+/**
+ * @brief Number of validations answered from the verified token cache and
+ * number of validations that had to verify the signature.
+ */
+void neu_jwt_cache_stats(uint64_t *hits, uint64_t *misses);
+
 #ifdef __cplusplus
 }
 #endif
@@ -81,17 +81,16 @@ int json_encode_read_resp_tags(void *json_object, void *param)
         return -1;
     }
 
-    utarray_foreach(trans_data->tags, neu_resp_tag_value_meta_t *, tag_value)
-    {
+    for (uint32_t i = 0; i < neu_tag_values_size(trans_data->values); i++) {
         neu_json_read_resp_tag_t json_tag = { 0 };
 
-        neu_tag_value_to_json(tag_value, &json_tag);
+        neu_tag_values_to_json(trans_data->values, i, &json_tag);
 
         neu_json_elem_t tag_elem = {
             .name      = json_tag.name,
             .t         = json_tag.t,
             .v         = json_tag.value,
-            .precision = tag_value->value.precision,
+            .precision = json_tag.precision,
         };
 
         if (json_tag.n_meta > 0) {
@@ -0,0 +1,272 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <string.h>
+
+#include "json/neu_json_rw.h"
+
+#include "msgpack_rw.h"
+
+typedef struct {
+    uint8_t *buf; // NULL when sizing
+    size_t   len;
+} writer_t;
+
+static inline void put(writer_t *w, const void *data, size_t n)
+{
+    if (w->buf != NULL) {
+        memcpy(w->buf + w->len, data, n);
+    }
+    w->len += n;
+}
+
+static inline void put_u8(writer_t *w, uint8_t v)
+{
+    put(w, &v, 1);
+}
+
+// code followed by the n low bytes of v, big endian
+static void put_code(writer_t *w, uint8_t code, uint64_t v, int n)
+{
+    uint8_t b[9] = { code };
+
+    for (int i = 0; i < n; i++) {
+        b[1 + i] = (uint8_t)(v >> (8 * (n - 1 - i)));
+    }
+    put(w, b, 1 + n);
+}
+
+static void write_int(writer_t *w, int64_t v)
+{
+    if (v >= 0) {
+        if (v < 128) {
+            put_u8(w, (uint8_t) v);
+        } else if (v <= UINT8_MAX) {
+            put_code(w, 0xcc, v, 1);
+        } else if (v <= UINT16_MAX) {
+            put_code(w, 0xcd, v, 2);
+        } else if (v <= UINT32_MAX) {
+            put_code(w, 0xce, v, 4);
+        } else {
+            put_code(w, 0xcf, v, 8);
+        }
+    } else if (v >= -32) {
+        put_u8(w, (uint8_t) v);
+    } else if (v >= INT8_MIN) {
+        put_code(w, 0xd0, (uint64_t) v, 1);
+    } else if (v >= INT16_MIN) {
+        put_code(w, 0xd1, (uint64_t) v, 2);
+    } else if (v >= INT32_MIN) {
+        put_code(w, 0xd2, (uint64_t) v, 4);
+    } else {
+        put_code(w, 0xd3, (uint64_t) v, 8);
+    }
+}
+
+static void write_double(writer_t *w, double v)
+{
+    uint64_t bits = 0;
+
+    memcpy(&bits, &v, sizeof(bits));
+    put_code(w, 0xcb, bits, 8);
+}
+
+static void write_str(writer_t *w, const char *str)
+{
+    size_t n = strlen(str);
+
+    if (n < 32) {
+        put_u8(w, 0xa0 | (uint8_t) n);
+    } else if (n <= UINT8_MAX) {
+        put_code(w, 0xd9, n, 1);
+    } else if (n <= UINT16_MAX) {
+        put_code(w, 0xda, n, 2);
+    } else {
+        put_code(w, 0xdb, n, 4);
+    }
+    put(w, str, n);
+}
+
+static void write_bin(writer_t *w, const uint8_t *bytes, size_t n)
+{
+    if (n <= UINT8_MAX) {
+        put_code(w, 0xc4, n, 1);
+    } else if (n <= UINT16_MAX) {
+        put_code(w, 0xc5, n, 2);
+    } else {
+        put_code(w, 0xc6, n, 4);
+    }
+    put(w, bytes, n);
+}
+
+static void write_map(writer_t *w, uint32_t n)
+{
+    if (n < 16) {
+        put_u8(w, 0x80 | (uint8_t) n);
+    } else if (n <= UINT16_MAX) {
+        put_code(w, 0xde, n, 2);
+    } else {
+        put_code(w, 0xdf, n, 4);
+    }
+}
+
+// map32 header whose count is only known once the entries are written
+static size_t begin_map(writer_t *w)
+{
+    size_t at = w->len;
+
+    put_code(w, 0xdf, 0, 4);
+    return at;
+}
+
+static void end_map(writer_t *w, size_t at, uint32_t n)
+{
+    writer_t header = { .buf = w->buf, .len = at };
+
+    put_code(&header, 0xdf, n, 4);
+}
+
+// what json_realp prints with precision decimals
+static double round_to(double v, uint8_t precision)
+{
+    static const double scales[] = { 1e0, 1e1, 1e2,  1e3,  1e4,  1e5,
+                                     1e6, 1e7, 1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15 };
+    double              scaled   = 0;
+
+    if (precision == 0 || precision >= sizeof(scales) / sizeof(scales[0])) {
+        return v;
+    }
+
+    scaled = v * scales[precision];
+    if (scaled <= -9e15 || scaled >= 9e15) {
+        return v;
+    }
+
+    return (double) (int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5) /
+        scales[precision];
+}
+
+static void write_value(writer_t *w, enum neu_json_type t,
+                        const union neu_json_value *v, uint8_t precision)
+{
+    switch (t) {
+    case NEU_JSON_BIT:
+        write_int(w, v->val_bit);
+        break;
+    case NEU_JSON_INT:
+        write_int(w, v->val_int);
+        break;
+    case NEU_JSON_STR:
+        write_str(w, v->val_str);
+        break;
+    case NEU_JSON_DOUBLE:
+        write_double(w, round_to(v->val_double, precision));
+        break;
+    case NEU_JSON_FLOAT:
+        write_double(w,
+                     precision == 0 ? neu_json_format_float(v->val_float)
+                                    : round_to(v->val_float, precision));
+        break;
+    case NEU_JSON_BOOL:
+        put_u8(w, v->val_bool ? 0xc3 : 0xc2);
+        break;
+    case NEU_JSON_BYTES:
+        write_bin(w, v->val_bytes.bytes, v->val_bytes.length);
+        break;
+    default:
+        put_u8(w, 0xc0);
+        break;
+    }
+}
+
+// the values, or the errors, of the message
+static uint32_t write_tags(writer_t *w, const neu_tag_values_t *values,
+                           bool errors)
+{
+    neu_json_tag_meta_t metas[NEU_TAG_META_SIZE];
+    uint32_t            n = 0;
+
+    for (uint32_t i = 0; i < neu_tag_values_size(values); i++) {
+        neu_json_read_resp_tag_t tag = { 0 };
+
+        neu_tag_values_fill_json(values, i, &tag, metas);
+        if ((tag.error != 0) == errors) {
+            write_str(w, tag.name);
+            write_value(w, tag.t, &tag.value, tag.precision);
+            n += 1;
+        }
+    }
+
+    return n;
+}
+
+static uint32_t write_metas(writer_t *w, const neu_tag_values_t *values)
+{
+    neu_json_tag_meta_t metas[NEU_TAG_META_SIZE];
+    uint32_t            n = 0;
+
+    for (uint32_t i = 0; i < neu_tag_values_size(values); i++) {
+        neu_json_read_resp_tag_t tag = { 0 };
+
+        neu_tag_values_fill_json(values, i, &tag, metas);
+        if (tag.n_meta == 0) {
+            continue;
+        }
+
+        write_str(w, tag.name);
+        write_map(w, tag.n_meta);
+        for (int k = 0; k < tag.n_meta; k++) {
+            write_str(w, metas[k].name);
+            write_value(w, metas[k].t, &metas[k].value, 0);
+        }
+        n += 1;
+    }
+
+    return n;
+}
+
+size_t msgpack_encode_read_resp(const neu_reqresp_trans_data_t *trans_data,
+                                uint64_t timestamp, uint8_t *buf)
+{
+    writer_t w  = { .buf = buf };
+    size_t   at = 0;
+
+    write_map(&w, 6);
+    write_str(&w, "node_name");
+    write_str(&w, trans_data->driver);
+    write_str(&w, "group_name");
+    write_str(&w, trans_data->group);
+    write_str(&w, "timestamp");
+    write_int(&w, (int64_t) timestamp);
+
+    write_str(&w, "values");
+    at = begin_map(&w);
+    end_map(&w, at, write_tags(&w, trans_data->values, false));
+
+    write_str(&w, "errors");
+    at = begin_map(&w);
+    end_map(&w, at, write_tags(&w, trans_data->values, true));
+
+    write_str(&w, "metas");
+    at = begin_map(&w);
+    end_map(&w, at, write_metas(&w, trans_data->values));
+
+    return w.len;
+}
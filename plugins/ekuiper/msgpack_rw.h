@@ -0,0 +1,54 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_EKUIPER_MSGPACK_RW_H
+#define NEURON_PLUGIN_EKUIPER_MSGPACK_RW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "neuron.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encode a trans data message to MessagePack, with the same map as
+ * json_encode_read_resp:
+ *
+ * { "node_name": "node0", "group_name": "grp0", "timestamp": 1649776722631,
+ *   "values": { "tag0": 0 }, "errors": { "tag1": 3000 },
+ *   "metas": { "tag0": { "m": 1 } } }
+ *
+ * Floats are float64, bytes are bin and the nested maps are map32.
+ *
+ * @param[in] trans_data the message.
+ * @param[in] timestamp the timestamp field.
+ * @param[out] buf where the message is written, NULL to only get its size.
+ * @return the size of the message.
+ */
+size_t msgpack_encode_read_resp(const neu_reqresp_trans_data_t *trans_data,
+                                uint64_t timestamp, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
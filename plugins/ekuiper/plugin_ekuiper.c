@@ -82,6 +82,7 @@ static int ekuiper_plugin_init(neu_plugin_t *plugin, bool load)
     (void) load;
     int      rv       = 0;
     nng_aio *recv_aio = NULL;
+    nng_aio *send_aio = NULL;
 
     plugin->mtx = NULL;
     rv          = nng_mtx_alloc(&plugin->mtx);
@@ -98,7 +99,17 @@ static int ekuiper_plugin_init(neu_plugin_t *plugin, bool load)
         return rv;
     }
 
+    rv = nng_aio_alloc(&send_aio, send_data_callback, plugin);
+    if (rv < 0) {
+        plog_error(plugin, "cannot allocate send_aio: %s", nng_strerror(rv));
+        nng_aio_free(recv_aio);
+        nng_mtx_free(plugin->mtx);
+        plugin->mtx = NULL;
+        return rv;
+    }
+
     plugin->recv_aio = recv_aio;
+    plugin->send_aio = send_aio;
 
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_TRANS_DATA_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_TRANS_DATA_30S, 30000);
@@ -106,6 +117,8 @@ static int ekuiper_plugin_init(neu_plugin_t *plugin, bool load)
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_30S, 30000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_60S, 60000);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_QUEUE_DEPTH, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_QUEUE_DROPS_TOTAL, 0);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_30S, 30000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_60S, 60000);
@@ -126,6 +139,12 @@ static int ekuiper_plugin_uninit(neu_plugin_t *plugin)
 
     nng_close(plugin->sock);
     nng_aio_free(plugin->recv_aio);
+    // waits for the send callback, which drops the queue on close
+    nng_aio_free(plugin->send_aio);
+    for (uint32_t i = 0; i < plugin->send_len; i++) {
+        nng_msg_free(plugin->send_queue[(plugin->send_head + i) %
+                                        EKUIPER_SEND_QUEUE_SIZE]);
+    }
     nng_mtx_free(plugin->mtx);
     free(plugin->host);
     free(plugin->url);
@@ -205,11 +224,12 @@ static int ekuiper_plugin_stop(neu_plugin_t *plugin)
 }
 
 static int parse_config(neu_plugin_t *plugin, const char *setting,
-                        char **host_p, uint16_t *port_p)
+                        char **host_p, uint16_t *port_p, int *format_p)
 {
     char *          err_param = NULL;
     neu_json_elem_t host      = { .name = "host", .t = NEU_JSON_STR };
     neu_json_elem_t port      = { .name = "port", .t = NEU_JSON_INT };
+    neu_json_elem_t format    = { .name = "format", .t = NEU_JSON_INT };
 
     if (0 != neu_parse_param(setting, &err_param, 2, &host, &port)) {
         plog_error(plugin, "parsing setting fail, key: `%s`", err_param);
@@ -234,10 +254,23 @@ static int parse_config(neu_plugin_t *plugin, const char *setting,
         goto error;
     }
 
-    *host_p = host.v.val_str;
-    *port_p = port.v.val_int;
+    // format, optional
+    if (0 != neu_parse_param(setting, NULL, 1, &format)) {
+        format.v.val_int = EKUIPER_FORMAT_JSON;
+    } else if (EKUIPER_FORMAT_JSON != format.v.val_int &&
+               EKUIPER_FORMAT_MSGPACK != format.v.val_int) {
+        plog_error(plugin, "setting invalid format: %" PRIi64,
+                   format.v.val_int);
+        goto error;
+    }
+
+    *host_p   = host.v.val_str;
+    *port_p   = port.v.val_int;
+    *format_p = format.v.val_int;
 
-    plog_notice(plugin, "config host:%s port:%" PRIu16, *host_p, *port_p);
+    plog_notice(plugin, "config host:%s port:%" PRIu16 " format:%s", *host_p,
+                *port_p,
+                EKUIPER_FORMAT_MSGPACK == *format_p ? "msgpack" : "json");
 
     return 0;
 
@@ -249,12 +282,13 @@ error:
 
 static int ekuiper_plugin_config(neu_plugin_t *plugin, const char *setting)
 {
-    int      rv   = 0;
-    char *   url  = NULL;
-    char *   host = NULL;
-    uint16_t port = 0;
+    int      rv     = 0;
+    char *   url    = NULL;
+    char *   host   = NULL;
+    uint16_t port   = 0;
+    int      format = EKUIPER_FORMAT_JSON;
 
-    if (0 != parse_config(plugin, setting, &host, &port)) {
+    if (0 != parse_config(plugin, setting, &host, &port, &format)) {
         rv = NEU_ERR_NODE_SETTING_INVALID;
         goto error;
     }
@@ -288,9 +322,10 @@ static int ekuiper_plugin_config(neu_plugin_t *plugin, const char *setting)
 
     free(plugin->host);
     free(plugin->url);
-    plugin->host = host;
-    plugin->port = port;
-    plugin->url  = url;
+    plugin->host   = host;
+    plugin->port   = port;
+    plugin->url    = url;
+    plugin->format = format;
 
     return rv;
 
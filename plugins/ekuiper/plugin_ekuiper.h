@@ -32,6 +32,14 @@
 extern "C" {
 #endif
 
+// messages waiting while one is being sent, newer ones are dropped
+#define EKUIPER_SEND_QUEUE_SIZE 256
+
+typedef enum {
+    EKUIPER_FORMAT_JSON    = 0,
+    EKUIPER_FORMAT_MSGPACK = 1,
+} ekuiper_format_e;
+
 struct neu_plugin {
     neu_plugin_common_t common;
     nng_socket          sock;
@@ -42,6 +50,15 @@ struct neu_plugin {
     char *              host;
     uint16_t            port;
     char *              url;
+    ekuiper_format_e    format;
+
+    // guarded by mtx, send_aio belongs to whoever set sending
+    nng_aio *send_aio;
+    bool     sending;
+    size_t   send_bytes;
+    nng_msg *send_queue[EKUIPER_SEND_QUEUE_SIZE];
+    uint32_t send_head;
+    uint32_t send_len;
 };
 
 #ifdef __cplusplus
@@ -24,16 +24,17 @@
 #include "json/neu_json_rw.h"
 
 #include "json_rw.h"
+#include "msgpack_rw.h"
 #include "read_write.h"
 
 static int send_write_tag_req(neu_plugin_t *plugin, neu_json_write_req_t *req);
 static int send_write_tags_req(neu_plugin_t *             plugin,
                                neu_json_write_tags_req_t *req);
 
-void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
+static nng_msg *encode_json(neu_plugin_t *            plugin,
+                            neu_reqresp_trans_data_t *trans_data)
 {
-    int rv = 0;
-
+    int              rv       = 0;
     char *           json_str = NULL;
     json_read_resp_t resp     = {
         .plugin     = plugin,
@@ -42,7 +43,7 @@ void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
     rv = neu_json_encode_by_fn(&resp, json_encode_read_resp, &json_str);
     if (0 != rv) {
         plog_error(plugin, "fail encode trans data to json");
-        return;
+        return NULL;
     }
 
     nng_msg *msg      = NULL;
@@ -51,30 +52,144 @@ void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
     if (0 != rv) {
         plog_error(plugin, "nng cannot allocate msg");
         free(json_str);
-        return;
+        return NULL;
     }
 
     memcpy(nng_msg_body(msg), json_str, json_len); // no null byte
     plog_debug(plugin, ">> %s", json_str);
     free(json_str);
-    rv = nng_sendmsg(plugin->sock, msg,
-                     NNG_FLAG_NONBLOCK); // TODO: use aio to send message
+    return msg;
+}
+
+// sized first, then written straight into the message body
+static nng_msg *encode_msgpack(neu_plugin_t *            plugin,
+                               neu_reqresp_trans_data_t *trans_data)
+{
+    nng_msg *msg  = NULL;
+    uint64_t ts   = global_timestamp;
+    size_t   size = msgpack_encode_read_resp(trans_data, ts, NULL);
+
+    if (0 != nng_msg_alloc(&msg, size)) {
+        plog_error(plugin, "nng cannot allocate msg");
+        return NULL;
+    }
+
+    msgpack_encode_read_resp(trans_data, ts, nng_msg_body(msg));
+    plog_debug(plugin, ">> %zu bytes msgpack node:%s group:%s", size,
+               trans_data->driver, trans_data->group);
+    return msg;
+}
+
+static void update_send_metrics(neu_plugin_t *plugin, int rv, size_t len)
+{
     if (0 == rv) {
         NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSGS_TOTAL, 1, NULL);
-        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_5S, json_len,
-                                 NULL);
-        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_30S, json_len,
-                                 NULL);
-        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_60S, json_len,
-                                 NULL);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_5S, len, NULL);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_30S, len, NULL);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_BYTES_60S, len, NULL);
     } else {
         plog_error(plugin, "nng cannot send msg: %s", nng_strerror(rv));
-        nng_msg_free(msg);
         NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 1,
                                  NULL);
     }
 }
 
+/*
+ * One message is in flight on send_aio at a time, the others wait in
+ * send_queue. When eKuiper does not keep up, the socket buffer and then the
+ * queue fill up, the queue depth shows it and new messages are dropped rather
+ * than blocking the adapter.
+ */
+static void send_msg(neu_plugin_t *plugin, nng_msg *msg)
+{
+    uint32_t depth = 0;
+
+    nng_mtx_lock(plugin->mtx);
+    if (!plugin->sending) {
+        plugin->sending    = true;
+        plugin->send_bytes = nng_msg_len(msg);
+        nng_mtx_unlock(plugin->mtx);
+
+        nng_aio_set_msg(plugin->send_aio, msg);
+        nng_send_aio(plugin->sock, plugin->send_aio);
+        return;
+    }
+
+    if (EKUIPER_SEND_QUEUE_SIZE == plugin->send_len) {
+        nng_mtx_unlock(plugin->mtx);
+
+        plog_warn(plugin, "send queue full, drop msg");
+        nng_msg_free(msg);
+        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_QUEUE_DROPS_TOTAL, 1,
+                                 NULL);
+        return;
+    }
+
+    plugin->send_queue[(plugin->send_head + plugin->send_len) %
+                       EKUIPER_SEND_QUEUE_SIZE] = msg;
+    depth = ++plugin->send_len;
+    nng_mtx_unlock(plugin->mtx);
+
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_QUEUE_DEPTH, depth, NULL);
+}
+
+void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data)
+{
+    nng_msg *msg = EKUIPER_FORMAT_MSGPACK == plugin->format
+        ? encode_msgpack(plugin, trans_data)
+        : encode_json(plugin, trans_data);
+
+    if (NULL != msg) {
+        send_msg(plugin, msg);
+    }
+}
+
+void send_data_callback(void *arg)
+{
+    neu_plugin_t *plugin  = arg;
+    nng_msg *     msg     = NULL;
+    uint32_t      dropped = 0;
+    int           rv      = nng_aio_result(plugin->send_aio);
+
+    if (0 != rv) {
+        nng_msg_free(nng_aio_get_msg(plugin->send_aio));
+        nng_aio_set_msg(plugin->send_aio, NULL);
+    }
+    update_send_metrics(plugin, rv, plugin->send_bytes);
+
+    nng_mtx_lock(plugin->mtx);
+    if (NNG_ECLOSED == rv || NNG_ECANCELED == rv) {
+        // the socket is gone, so are the messages for it
+        for (; plugin->send_len > 0; --plugin->send_len, ++dropped) {
+            nng_msg_free(plugin->send_queue[plugin->send_head]);
+            plugin->send_head =
+                (plugin->send_head + 1) % EKUIPER_SEND_QUEUE_SIZE;
+        }
+    }
+
+    if (0 == plugin->send_len) {
+        plugin->sending = false;
+    } else {
+        msg               = plugin->send_queue[plugin->send_head];
+        plugin->send_head = (plugin->send_head + 1) % EKUIPER_SEND_QUEUE_SIZE;
+        plugin->send_len -= 1;
+        plugin->send_bytes = nng_msg_len(msg);
+    }
+    uint32_t depth = plugin->send_len;
+    nng_mtx_unlock(plugin->mtx);
+
+    if (dropped > 0) {
+        NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_MSG_ERRORS_TOTAL,
+                                 dropped, NULL);
+    }
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_SEND_QUEUE_DEPTH, depth, NULL);
+
+    if (NULL != msg) {
+        nng_aio_set_msg(plugin->send_aio, msg);
+        nng_send_aio(plugin->sock, plugin->send_aio);
+    }
+}
+
 void recv_data_callback(void *arg)
 {
     int               rv       = 0;
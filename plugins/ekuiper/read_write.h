@@ -31,6 +31,7 @@ extern "C" {
 
 void send_data(neu_plugin_t *plugin, neu_reqresp_trans_data_t *trans_data);
 
+void send_data_callback(void *arg);
 void recv_data_callback(void *arg);
 
 #ifdef __cplusplus
@@ -56,9 +56,18 @@ typedef enum modbus_function {
     MODBUS_WRITE_S_HOLD_REG_ERR = 0x86,
     MODBUS_WRITE_M_HOLD_REG_ERR = 0x90,
     MODBUS_WRITE_M_COIL_ERR     = 0x8F,
-    MODBUS_DEVICE_ERR           = -2
+    MODBUS_DEVICE_ERR           = -2,
+    MODBUS_STALE_RESP           = -3,
+    MODBUS_ILLEGAL_ADDRESS      = -4
 } modbus_function_e;
 
+typedef enum modbus_exception {
+    MODBUS_EXCEPTION_ILLEGAL_FUNCTION   = 0x01,
+    MODBUS_EXCEPTION_ILLEGAL_ADDRESS    = 0x02,
+    MODBUS_EXCEPTION_ILLEGAL_VALUE      = 0x03,
+    MODBUS_EXCEPTION_SERVER_DEVICE_BUSY = 0x06,
+} modbus_exception_e;
+
 typedef enum modbus_area {
     MODBUS_AREA_COIL           = 0,
     MODBUS_AREA_INPUT          = 1,
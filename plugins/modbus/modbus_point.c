@@ -27,7 +27,11 @@ struct modbus_sort_ctx {
     uint16_t end;
 };
 
-static __thread uint16_t modbus_read_max_byte = 250;
+static __thread uint16_t  modbus_read_max_byte = 250;
+static __thread uint16_t  modbus_read_max_gap  = 0;
+static __thread UT_array *modbus_read_excludes = NULL;
+
+static UT_icd range_icd = { sizeof(modbus_range_t), NULL, NULL, NULL };
 
 static int  tag_cmp(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2);
 static bool tag_sort(neu_tag_sort_t *sort, void *tag, void *tag_to_be_sorted);
@@ -202,9 +206,12 @@ int modbus_write_tag_to_point(const neu_plugin_tag_value_t *tag,
     return ret;
 }
 
-modbus_read_cmd_sort_t *modbus_tag_sort(UT_array *tags, uint16_t max_byte)
+modbus_read_cmd_sort_t *modbus_tag_sort(UT_array *tags, uint16_t max_byte,
+                                        uint16_t max_gap, UT_array *excludes)
 {
     modbus_read_max_byte          = max_byte;
+    modbus_read_max_gap           = max_gap;
+    modbus_read_excludes          = excludes;
     neu_tag_sort_result_t *result = neu_tag_sort(tags, tag_sort, tag_cmp);
 
     modbus_read_cmd_sort_t *sort_result =
@@ -212,7 +219,7 @@ modbus_read_cmd_sort_t *modbus_tag_sort(UT_array *tags, uint16_t max_byte)
     sort_result->n_cmd = result->n_sort;
     sort_result->cmd   = calloc(result->n_sort, sizeof(modbus_read_cmd_t));
 
-    for (uint16_t i = 0; i < result->n_sort; i++) {
+    for (uint32_t i = 0; i < result->n_sort; i++) {
         modbus_point_t *tag =
             *(modbus_point_t **) utarray_front(result->sorts[i].tags);
         struct modbus_sort_ctx *ctx = result->sorts[i].info.context;
@@ -291,7 +298,7 @@ modbus_write_cmd_sort_t *modbus_write_tags_sort(UT_array *tags)
         calloc(1, sizeof(modbus_write_cmd_sort_t));
     sort_result->n_cmd = result->n_sort;
     sort_result->cmd   = calloc(result->n_sort, sizeof(modbus_write_cmd_t));
-    for (uint16_t i = 0; i < result->n_sort; i++) {
+    for (uint32_t i = 0; i < result->n_sort; i++) {
         modbus_point_write_t *tag =
             *(modbus_point_write_t **) utarray_front(result->sorts[i].tags);
         struct modbus_sort_ctx *ctx = result->sorts[i].info.context;
@@ -342,7 +349,7 @@ modbus_write_cmd_sort_t *modbus_write_tags_sort(UT_array *tags)
 
 void modbus_tag_sort_free(modbus_read_cmd_sort_t *cs)
 {
-    for (uint16_t i = 0; i < cs->n_cmd; i++) {
+    for (uint32_t i = 0; i < cs->n_cmd; i++) {
         utarray_free(cs->cmd[i].tags);
     }
 
@@ -350,6 +357,59 @@ void modbus_tag_sort_free(modbus_read_cmd_sort_t *cs)
     free(cs);
 }
 
+UT_icd *modbus_range_icd()
+{
+    return &range_icd;
+}
+
+int modbus_read_cmd_exclude_gaps(const modbus_read_cmd_t *cmd,
+                                 UT_array *               excludes)
+{
+    uint32_t cursor = cmd->start_address;
+    int      n_gap  = 0;
+
+    utarray_foreach(cmd->tags, modbus_point_t **, p_tag)
+    {
+        uint32_t end = (*p_tag)->start_address + (*p_tag)->n_register;
+
+        if ((*p_tag)->start_address > cursor) {
+            modbus_range_t range = {
+                .slave_id = cmd->slave_id,
+                .area     = cmd->area,
+                .start    = cursor,
+                .end      = (*p_tag)->start_address,
+            };
+
+            utarray_push_back(excludes, &range);
+            n_gap += 1;
+        }
+
+        if (end > cursor) {
+            cursor = end;
+        }
+    }
+
+    return n_gap;
+}
+
+static bool range_excluded(uint8_t slave_id, modbus_area_e area,
+                           uint32_t start, uint32_t end)
+{
+    if (modbus_read_excludes == NULL) {
+        return false;
+    }
+
+    utarray_foreach(modbus_read_excludes, modbus_range_t *, range)
+    {
+        if (range->slave_id == slave_id && range->area == area &&
+            range->start < end && start < range->end) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static int tag_cmp(neu_tag_sort_elem_t *tag1, neu_tag_sort_elem_t *tag2)
 {
     modbus_point_t *p_t1 = (modbus_point_t *) tag1->tag;
@@ -406,33 +466,38 @@ static bool tag_sort(neu_tag_sort_t *sort, void *tag, void *tag_to_be_sorted)
         return false;
     }
 
-    if (t2->start_address > ctx->end) {
+    if ((uint32_t) t2->start_address > ctx->end + modbus_read_max_gap) {
         return false;
     }
 
+    // reading through unused registers is cheaper than another request,
+    // unless the device is known to reject them
+    if (t2->start_address > ctx->end &&
+        range_excluded(t1->slave_id, t1->area, ctx->end, t2->start_address)) {
+        return false;
+    }
+
+    uint32_t end = t2->start_address + t2->n_register;
+    if (end < ctx->end) {
+        end = ctx->end;
+    }
+
     switch (t1->area) {
     case MODBUS_AREA_COIL:
     case MODBUS_AREA_INPUT:
-        if ((ctx->end - ctx->start + 7) / 8 >= modbus_read_max_byte) {
+        if ((end - ctx->start + 7) / 8 >= modbus_read_max_byte) {
             return false;
         }
         break;
     case MODBUS_AREA_INPUT_REGISTER:
-    case MODBUS_AREA_HOLD_REGISTER: {
-        uint16_t now_bytes = (ctx->end - ctx->start) * 2;
-        uint16_t add_now   = now_bytes + t2->n_register * 2;
-        if (add_now >= modbus_read_max_byte) {
+    case MODBUS_AREA_HOLD_REGISTER:
+        if ((end - ctx->start) * 2 >= modbus_read_max_byte) {
             return false;
         }
-
         break;
     }
-    }
-
-    if (t2->start_address + t2->n_register > ctx->end) {
-        ctx->end = t2->start_address + t2->n_register;
-    }
 
+    ctx->end = end;
     return true;
 }
 
@@ -38,6 +38,7 @@ typedef struct modbus_point {
     neu_type_e                type;
     neu_datatag_addr_option_u option;
     char                      name[NEU_TAG_NAME_LEN];
+    neu_tag_handle_t          handle;
 } modbus_point_t;
 
 typedef struct modbus_point_write {
@@ -56,10 +57,14 @@ typedef struct modbus_read_cmd {
     uint16_t      n_register;
 
     UT_array *tags; // modbus_point_t ptr;
+
+    // rejected with illegal address, its gaps are probed once after the scan
+    bool rejected;
+    bool probed;
 } modbus_read_cmd_t;
 
 typedef struct modbus_read_cmd_sort {
-    uint16_t           n_cmd;
+    uint32_t           n_cmd;
     modbus_read_cmd_t *cmd;
 } modbus_read_cmd_sort_t;
 
@@ -75,14 +80,50 @@ typedef struct modbus_write_cmd {
 } modbus_write_cmd_t;
 
 typedef struct modbus_write_cmd_sort {
-    uint16_t            n_cmd;
+    uint32_t            n_cmd;
     modbus_write_cmd_t *cmd;
 } modbus_write_cmd_sort_t;
 
-modbus_read_cmd_sort_t * modbus_tag_sort(UT_array *tags, uint16_t max_byte);
+// registers [start, end) a device refuses to serve
+typedef struct modbus_range {
+    uint8_t       slave_id;
+    modbus_area_e area;
+    uint16_t      start;
+    uint16_t      end;
+} modbus_range_t;
+
+/**
+ * @brief Plan the read commands of a group.
+ *
+ * Tags of the same slave and area are read by one command as long as the
+ * unused registers between them are no more than max_gap, the response fits
+ * in max_byte and no register of excludes is read through.
+ *
+ * @param[in] tags modbus_point_t pointers of the group.
+ * @param[in] max_byte Maximum data bytes of one response.
+ * @param[in] max_gap Maximum unused registers read through, 0 reads only
+ *                    contiguous tags together.
+ * @param[in] excludes modbus_range_t array of ranges never read through,
+ *                     could be NULL.
+ * @return the read commands.
+ */
+modbus_read_cmd_sort_t * modbus_tag_sort(UT_array *tags, uint16_t max_byte,
+                                         uint16_t max_gap, UT_array *excludes);
 modbus_write_cmd_sort_t *modbus_write_tags_sort(UT_array *tags);
 void                     modbus_tag_sort_free(modbus_read_cmd_sort_t *cs);
 
+UT_icd *modbus_range_icd();
+
+/**
+ * @brief Record the unused registers a read command reads through.
+ *
+ * @param[in] cmd The read command rejected by the device.
+ * @param[out] excludes modbus_range_t array the gaps are appended to.
+ * @return number of gaps appended, 0 if the command only reads its tags.
+ */
+int modbus_read_cmd_exclude_gaps(const modbus_read_cmd_t *cmd,
+                                 UT_array *               excludes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,10 +23,23 @@
 
 #include "modbus_req.h"
 
+#define MODBUS_TCP_ADU_MAX 260
+
 struct modbus_group_data {
     UT_array *              tags;
     char *                  group;
     modbus_read_cmd_sort_t *cmd_sort;
+    uint32_t                plan_version;
+};
+
+/* a read command sent in pipelined mode, waiting for its response */
+struct modbus_inflight {
+    uint32_t cmd;
+    uint16_t seq;
+    uint16_t response_size;
+    uint16_t retries;
+    uint64_t send_ms;
+    bool     busy;
 };
 
 struct modbus_write_tags_data {
@@ -40,6 +53,8 @@ static int  process_protocol_buf(neu_plugin_t *plugin, uint8_t slave_id,
 static int  process_protocol_buf_test(neu_plugin_t *plugin, void *req,
                                       modbus_point_t *point,
                                       uint16_t        response_size);
+static int  valid_modbus_tcp_response(neu_plugin_t *plugin, uint8_t *recv_buf,
+                                      uint16_t response_size);
 
 void modbus_conn_connected(void *data, int fd)
 {
@@ -120,7 +135,7 @@ int modbus_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes)
 }
 
 int modbus_stack_read_retry(neu_plugin_t *plugin, struct modbus_group_data *gd,
-                            uint16_t i, uint16_t j, uint16_t *response_size,
+                            uint32_t i, uint16_t j, uint16_t *response_size,
                             uint64_t *read_tms)
 {
     struct timespec t3 = { .tv_sec = plugin->retry_interval / 1000,
@@ -137,9 +152,10 @@ int modbus_stack_read_retry(neu_plugin_t *plugin, struct modbus_group_data *gd,
 }
 
 void handle_modbus_error(neu_plugin_t *plugin, struct modbus_group_data *gd,
-                         uint16_t cmd_index, int error_code,
+                         uint32_t cmd_index, int error_code,
                          const char *error_message)
 {
+    plugin->cmd_idx = cmd_index;
     modbus_value_handle(plugin, gd->cmd_sort->cmd[cmd_index].slave_id, 0, NULL,
                         error_code);
     if (error_message) {
@@ -149,9 +165,107 @@ void handle_modbus_error(neu_plugin_t *plugin, struct modbus_group_data *gd,
     }
 }
 
+void modbus_set_max_gap(neu_plugin_t *plugin, uint16_t max_gap)
+{
+    if (__atomic_load_n(&plugin->max_gap, __ATOMIC_RELAXED) != max_gap) {
+        __atomic_store_n(&plugin->max_gap, max_gap, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&plugin->plan_version, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void reject_cmd(struct modbus_group_data *gd, uint32_t cmd_index)
+{
+    gd->cmd_sort->cmd[cmd_index].rejected = true;
+}
+
+/*
+ * read one gap alone, returns 1 if the device rejects it too, -1 if the
+ * connection is lost
+ */
+static int probe_gap(neu_plugin_t *plugin, const modbus_range_t *gap)
+{
+    uint16_t response_size = 0;
+    int      ret           = modbus_stack_read(
+        plugin->stack, gap->slave_id, gap->area, gap->start,
+        gap->end - gap->start, &response_size, false);
+    if (ret <= 0) {
+        return -1;
+    }
+
+    // skip late responses of expired pipelined reads
+    do {
+        ret = process_protocol_buf(plugin, gap->slave_id, response_size);
+    } while (ret == -4);
+
+    if (ret == -1) {
+        return -1;
+    }
+
+    return ret == -3 ? 1 : 0;
+}
+
+/*
+ * an illegal address exception does not tell whether a gap or a tag of the
+ * command is missing on the device, so only the gaps the device rejects when
+ * read alone are excluded. A command is probed once per plan.
+ */
+static void probe_rejected_gaps(neu_plugin_t *            plugin,
+                                struct modbus_group_data *gd)
+{
+    UT_array *gaps       = NULL;
+    int       n_excluded = 0;
+
+    utarray_new(gaps, modbus_range_icd());
+    plugin->probe = true;
+
+    for (uint32_t i = 0; i < gd->cmd_sort->n_cmd; i++) {
+        modbus_read_cmd_t *cmd = &gd->cmd_sort->cmd[i];
+
+        if (!cmd->rejected || cmd->probed) {
+            continue;
+        }
+
+        utarray_clear(gaps);
+        modbus_read_cmd_exclude_gaps(cmd, gaps);
+
+        utarray_foreach(gaps, modbus_range_t *, gap)
+        {
+            int ret = probe_gap(plugin, gap);
+            if (ret < 0) {
+                plog_error(plugin, "probe %hhu!%hu failed, disconnect",
+                           gap->slave_id, gap->start);
+                neu_conn_disconnect(plugin->conn);
+                goto out;
+            }
+
+            if (ret > 0) {
+                if (plugin->excludes == NULL) {
+                    utarray_new(plugin->excludes, modbus_range_icd());
+                }
+                utarray_push_back(plugin->excludes, gap);
+                n_excluded += 1;
+                plog_warn(plugin,
+                          "illegal address in %hhu!%hu, n register: %hu, stop "
+                          "reading through it",
+                          gap->slave_id, gap->start, gap->end - gap->start);
+            }
+        }
+
+        cmd->probed = true;
+    }
+
+out:
+    plugin->probe = false;
+    utarray_free(gaps);
+
+    if (n_excluded > 0) {
+        __atomic_add_fetch(&plugin->plan_version, 1, __ATOMIC_RELEASE);
+    }
+}
+
 void finalize_modbus_read_result(neu_plugin_t *            plugin,
                                  struct modbus_group_data *gd,
-                                 uint16_t cmd_index, int ret_r, int ret_buf,
+                                 uint32_t cmd_index, int ret_r, int ret_buf,
                                  uint64_t read_tms, int64_t *rtt)
 {
     if (ret_r <= 0) {
@@ -180,6 +294,13 @@ void finalize_modbus_read_result(neu_plugin_t *            plugin,
                                 "modbus device response error");
             *rtt = neu_time_ms() - read_tms;
             break;
+        case -3:
+            reject_cmd(gd, cmd_index);
+            handle_modbus_error(plugin, gd, cmd_index,
+                                NEU_ERR_PLUGIN_READ_FAILURE,
+                                "modbus illegal data address");
+            *rtt = neu_time_ms() - read_tms;
+            break;
         default:
             break;
         }
@@ -189,7 +310,7 @@ void finalize_modbus_read_result(neu_plugin_t *            plugin,
 }
 
 void check_modbus_read_result(neu_plugin_t *            plugin,
-                              struct modbus_group_data *gd, uint16_t cmd_index,
+                              struct modbus_group_data *gd, uint32_t cmd_index,
                               int64_t *rtt)
 {
     uint16_t response_size = 0;
@@ -227,6 +348,233 @@ void check_modbus_read_result(neu_plugin_t *            plugin,
                                 rtt);
 }
 
+int modbus_match_seq(void *ctx, uint16_t seq, uint8_t *slave_id)
+{
+    neu_plugin_t *            plugin = (neu_plugin_t *) ctx;
+    struct modbus_group_data *gd =
+        (struct modbus_group_data *) plugin->plugin_group_data;
+
+    if (plugin->probe) {
+        return seq == modbus_stack_last_read_seq(plugin->stack) ? 0 : -1;
+    }
+
+    if (plugin->inflight == NULL) {
+        return 0;
+    }
+
+    for (uint16_t i = 0; i < plugin->n_inflight; i++) {
+        struct modbus_inflight *f = &plugin->inflight[i];
+
+        if (f->busy && f->seq == seq) {
+            plugin->cmd_idx = f->cmd;
+            plugin->matched = f;
+            *slave_id       = gd->cmd_sort->cmd[f->cmd].slave_id;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int pipeline_send(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                         struct modbus_inflight *f)
+{
+    modbus_read_cmd_t *cmd = &gd->cmd_sort->cmd[f->cmd];
+
+    plugin->cmd_idx = f->cmd;
+    int ret = modbus_stack_read(plugin->stack, cmd->slave_id, cmd->area,
+                                cmd->start_address, cmd->n_register,
+                                &f->response_size, false);
+
+    f->seq     = modbus_stack_last_read_seq(plugin->stack);
+    f->send_ms = neu_time_ms();
+    // also when the send failed, pipeline_fail then fails it with the others
+    f->busy = true;
+    return ret;
+}
+
+static void cmd_error(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                      uint32_t cmd_index, int error)
+{
+    utarray_foreach(gd->cmd_sort->cmd[cmd_index].tags, modbus_point_t **,
+                    p_tag)
+    {
+        neu_dvalue_t dvalue = { 0 };
+        dvalue.type         = NEU_TYPE_ERROR;
+        dvalue.value.i32    = error;
+        plugin->common.adapter_callbacks->driver.update(
+            plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
+    }
+}
+
+/*
+ * the connection is lost, the commands in flight and the ones not sent yet
+ * get no response in this scan, the values already received are kept
+ */
+static void pipeline_fail(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                          uint32_t next, int error)
+{
+    for (uint16_t i = 0; i < plugin->n_inflight; i++) {
+        struct modbus_inflight *f = &plugin->inflight[i];
+
+        if (f->busy) {
+            f->busy = false;
+            cmd_error(plugin, gd, f->cmd, error);
+        }
+    }
+
+    for (uint32_t i = next; i < gd->cmd_sort->n_cmd; i++) {
+        cmd_error(plugin, gd, i, error);
+    }
+}
+
+/*
+ * receive one response and hand it to the command carrying its transaction
+ * id, returns 0 if nothing arrived within the connection timeout, -1 if the
+ * stream can not be decoded any more
+ */
+static int pipeline_recv(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                         int64_t *rtt)
+{
+    uint8_t recv_buf[MODBUS_TCP_ADU_MAX] = { 0 };
+    int     total =
+        valid_modbus_tcp_response(plugin, recv_buf, sizeof(recv_buf));
+    if (total <= 0) {
+        return total;
+    }
+
+    plog_recv_protocol(plugin, recv_buf, total);
+
+    neu_protocol_unpack_buf_t pbuf = { 0 };
+    neu_protocol_unpack_buf_init(&pbuf, recv_buf, total);
+
+    plugin->matched = NULL;
+    int ret         = modbus_stack_recv(plugin->stack, 0, &pbuf);
+    if (ret == MODBUS_STALE_RESP) {
+        plog_debug(plugin, "drop response of an expired modbus request");
+        return 1;
+    }
+
+    struct modbus_inflight *f = plugin->matched;
+    if (f == NULL) {
+        return -1;
+    }
+
+    f->busy = false;
+    *rtt    = neu_time_ms() - f->send_ms;
+
+    if (ret == MODBUS_DEVICE_ERR) {
+        handle_modbus_error(plugin, gd, f->cmd, NEU_ERR_PLUGIN_READ_FAILURE,
+                            "modbus device response error");
+        return 1;
+    }
+
+    if (ret == MODBUS_ILLEGAL_ADDRESS) {
+        reject_cmd(gd, f->cmd);
+        handle_modbus_error(plugin, gd, f->cmd, NEU_ERR_PLUGIN_READ_FAILURE,
+                            "modbus illegal data address");
+        return 1;
+    }
+
+    return ret < 0 || total != f->response_size ? -1 : 1;
+}
+
+static int pipeline_expire(neu_plugin_t *plugin, struct modbus_group_data *gd,
+                           bool all)
+{
+    uint64_t now = neu_time_ms();
+
+    for (uint16_t i = 0; i < plugin->n_inflight; i++) {
+        struct modbus_inflight *f = &plugin->inflight[i];
+
+        if (!f->busy || (!all && now - f->send_ms < plugin->timeout)) {
+            continue;
+        }
+
+        if (f->retries < plugin->max_retries) {
+            f->retries += 1;
+            plog_notice(plugin, "Resend read req. Times:%hu", f->retries);
+            if (pipeline_send(plugin, gd, f) <= 0) {
+                return -1;
+            }
+        } else {
+            f->busy = false;
+            handle_modbus_error(plugin, gd, f->cmd,
+                                NEU_ERR_PLUGIN_DEVICE_NOT_RESPONSE,
+                                "no modbus response received");
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * keep up to max_inflight read commands outstanding and match the responses
+ * by transaction id, so a scan costs about n_cmd / max_inflight round trips
+ */
+static void modbus_pipeline_read(neu_plugin_t *            plugin,
+                                 struct modbus_group_data *gd, int64_t *rtt)
+{
+    uint32_t n_cmd = gd->cmd_sort->n_cmd;
+    uint16_t window =
+        n_cmd < plugin->max_inflight ? n_cmd : plugin->max_inflight;
+    uint32_t next = 0;
+
+    if (window == 0) {
+        return;
+    }
+
+    plugin->inflight   = calloc(window, sizeof(struct modbus_inflight));
+    plugin->n_inflight = window;
+
+    while (true) {
+        uint16_t n_busy = 0;
+
+        for (uint16_t i = 0; i < window; i++) {
+            struct modbus_inflight *f = &plugin->inflight[i];
+
+            if (!f->busy && next < n_cmd) {
+                *f = (struct modbus_inflight) { .cmd = next++ };
+                if (pipeline_send(plugin, gd, f) <= 0) {
+                    plog_error(plugin, "send message failed, skip, in flight: "
+                                       "%hu, not sent: %" PRIu32,
+                               n_busy, n_cmd - next);
+                    goto disconnect;
+                }
+            }
+            n_busy += f->busy;
+        }
+
+        if (n_busy == 0) {
+            break;
+        }
+
+        int ret = pipeline_recv(plugin, gd, rtt);
+        if (ret < 0) {
+            plog_error(plugin, "modbus message error, skip, in flight: %hu",
+                       n_busy);
+            goto disconnect;
+        }
+
+        // nothing arrived for a whole timeout, everything in flight is overdue
+        if (pipeline_expire(plugin, gd, ret == 0) != 0) {
+            goto disconnect;
+        }
+    }
+
+    goto out;
+
+disconnect:
+    pipeline_fail(plugin, gd, next, NEU_ERR_PLUGIN_DISCONNECTED);
+    *rtt = NEU_METRIC_LAST_RTT_MS_MAX;
+    neu_conn_disconnect(plugin->conn);
+out:
+    free(plugin->inflight);
+    plugin->inflight   = NULL;
+    plugin->n_inflight = 0;
+    plugin->matched    = NULL;
+}
+
 void update_metrics_after_read(neu_plugin_t *plugin, int64_t rtt,
                                neu_plugin_group_t *group,
                                neu_conn_state_t *  state)
@@ -242,6 +590,7 @@ void update_metrics_after_read(neu_plugin_t *plugin, int64_t rtt,
     update_metric(plugin->common.adapter, NEU_METRIC_RECV_BYTES,
                   state->recv_bytes, NULL);
     update_metric(plugin->common.adapter, NEU_METRIC_LAST_RTT_MS, rtt, NULL);
+    update_metric(plugin->common.adapter, NEU_METRIC_RTT_MS, rtt, NULL);
     update_metric(plugin->common.adapter, NEU_METRIC_GROUP_LAST_SEND_MSGS,
                   gd->cmd_sort->n_cmd, group->group_name);
 }
@@ -252,6 +601,9 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
     neu_conn_state_t          state = { 0 };
     struct modbus_group_data *gd    = NULL;
     int64_t                   rtt   = NEU_METRIC_LAST_RTT_MS_MAX;
+    uint32_t                  plan_version =
+        __atomic_load_n(&plugin->plan_version, __ATOMIC_ACQUIRE);
+    uint16_t max_gap = __atomic_load_n(&plugin->max_gap, __ATOMIC_RELAXED);
 
     if (group->user_data == NULL) {
         gd = calloc(1, sizeof(struct modbus_group_data));
@@ -268,18 +620,36 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
                 plog_error(plugin, "invalid tag: %s, address: %s", tag->name,
                            tag->address);
             }
+            p->handle = plugin->common.adapter_callbacks->driver.resolve_tag(
+                plugin->common.adapter, group->group_name, tag->name);
 
             utarray_push_back(gd->tags, &p);
         }
 
-        gd->group    = strdup(group->group_name);
-        gd->cmd_sort = modbus_tag_sort(gd->tags, max_byte);
+        gd->group        = strdup(group->group_name);
+        gd->plan_version = plan_version;
+        gd->cmd_sort =
+            modbus_tag_sort(gd->tags, max_byte, max_gap, plugin->excludes);
+    }
+
+    gd = (struct modbus_group_data *) group->user_data;
+    if (gd->plan_version != plan_version) {
+        modbus_tag_sort_free(gd->cmd_sort);
+        gd->plan_version = plan_version;
+        gd->cmd_sort =
+            modbus_tag_sort(gd->tags, max_byte, max_gap, plugin->excludes);
     }
 
-    gd                        = (struct modbus_group_data *) group->user_data;
     plugin->plugin_group_data = gd;
 
-    for (uint16_t i = 0; i < gd->cmd_sort->n_cmd; i++) {
+    if (plugin->protocol == MODBUS_PROTOCOL_TCP && plugin->max_inflight > 1) {
+        modbus_pipeline_read(plugin, gd, &rtt);
+        probe_rejected_gaps(plugin, gd);
+        update_metrics_after_read(plugin, rtt, group, &state);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < gd->cmd_sort->n_cmd; i++) {
         plugin->cmd_idx = i;
         check_modbus_read_result(plugin, gd, i, &rtt);
 
@@ -292,6 +662,7 @@ int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
         }
     }
 
+    probe_rejected_gaps(plugin, gd);
     update_metrics_after_read(plugin, rtt, group, &state);
     return 0;
 }
@@ -302,27 +673,30 @@ int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
     neu_plugin_t *            plugin = (neu_plugin_t *) ctx;
     struct modbus_group_data *gd =
         (struct modbus_group_data *) plugin->plugin_group_data;
+
+    if (plugin->probe) {
+        return 0;
+    }
+
     uint16_t start_address = gd->cmd_sort->cmd[plugin->cmd_idx].start_address;
     uint16_t n_register    = gd->cmd_sort->cmd[plugin->cmd_idx].n_register;
 
     if (error == NEU_ERR_PLUGIN_DISCONNECTED) {
         neu_dvalue_t dvalue = { 0 };
 
+        // a pipelined read keeps the values it got, pipeline_fail reports
+        // the commands left
+        if (plugin->inflight != NULL) {
+            return 0;
+        }
+
         dvalue.type      = NEU_TYPE_ERROR;
         dvalue.value.i32 = error;
         plugin->common.adapter_callbacks->driver.update(
             plugin->common.adapter, gd->group, NULL, dvalue);
         return 0;
     } else if (error != NEU_ERR_SUCCESS) {
-        utarray_foreach(gd->cmd_sort->cmd[plugin->cmd_idx].tags,
-                        modbus_point_t **, p_tag)
-        {
-            neu_dvalue_t dvalue = { 0 };
-            dvalue.type         = NEU_TYPE_ERROR;
-            dvalue.value.i32    = error;
-            plugin->common.adapter_callbacks->driver.update(
-                plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
-        }
+        cmd_error(plugin, gd, plugin->cmd_idx, error);
         return 0;
     }
 
@@ -419,8 +793,14 @@ int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
             }
         }
 
-        plugin->common.adapter_callbacks->driver.update(
-            plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
+        if (dvalue.type == NEU_TYPE_ERROR ||
+            !neu_tag_handle_valid((*p_tag)->handle)) {
+            plugin->common.adapter_callbacks->driver.update(
+                plugin->common.adapter, gd->group, (*p_tag)->name, dvalue);
+        } else {
+            plugin->common.adapter_callbacks->driver.update_by_handle(
+                plugin->common.adapter, (*p_tag)->handle, dvalue, NULL, 0);
+        }
     }
     return 0;
 }
@@ -726,7 +1106,7 @@ int modbus_write_tags(neu_plugin_t *plugin, void *req, UT_array *tags)
         utarray_push_back(gtags->tags, &p);
     }
     gtags->cmd_sort = modbus_write_tags_sort(gtags->tags);
-    for (uint16_t i = 0; i < gtags->cmd_sort->n_cmd; i++) {
+    for (uint32_t i = 0; i < gtags->cmd_sort->n_cmd; i++) {
         ret = write_modbus_points(plugin, &gtags->cmd_sort->cmd[i], req);
         if (ret <= 0) {
             rv = 1;
@@ -748,7 +1128,7 @@ int modbus_write_tags(neu_plugin_t *plugin, void *req, UT_array *tags)
             plugin->common.adapter, req, NEU_ERR_PLUGIN_DISCONNECTED);
     }
 
-    for (uint16_t i = 0; i < gtags->cmd_sort->n_cmd; i++) {
+    for (uint32_t i = 0; i < gtags->cmd_sort->n_cmd; i++) {
         utarray_free(gtags->cmd_sort->cmd[i].tags);
         free(gtags->cmd_sort->cmd[i].bytes);
     }
@@ -806,6 +1186,12 @@ static int process_received_data(neu_plugin_t *plugin, uint8_t *recv_buf,
     if (ret == MODBUS_DEVICE_ERR) {
         return -2;
     }
+    if (ret == MODBUS_ILLEGAL_ADDRESS) {
+        return -3;
+    }
+    if (ret == MODBUS_STALE_RESP) {
+        return -4;
+    }
     return recv_size == expected_size ? ret : -1;
 }
 
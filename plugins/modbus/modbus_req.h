@@ -23,6 +23,11 @@
 
 #include "modbus_stack.h"
 
+#define MODBUS_MAX_INFLIGHT 64
+#define MODBUS_MAX_GAP 120
+
+struct modbus_inflight;
+
 struct neu_plugin {
     neu_plugin_common_t common;
 
@@ -30,7 +35,7 @@ struct neu_plugin {
     modbus_stack_t *stack;
 
     void *   plugin_group_data;
-    uint16_t cmd_idx;
+    uint32_t cmd_idx;
 
     neu_event_io_t *tcp_server_io;
     bool            is_server;
@@ -43,6 +48,20 @@ struct neu_plugin {
     uint16_t interval;
     uint16_t retry_interval;
     uint16_t max_retries;
+    uint16_t timeout;
+    uint16_t max_inflight;
+    uint16_t max_gap;
+
+    // ranges the device rejected, groups replan when plan_version changes.
+    // max_gap and plan_version are set from driver_config too, access them
+    // atomically
+    UT_array *excludes;
+    uint32_t  plan_version;
+    bool      probe; // reading a gap alone, its values are dropped
+
+    struct modbus_inflight *inflight;
+    uint16_t                n_inflight;
+    struct modbus_inflight *matched;
 };
 
 void modbus_conn_connected(void *data, int fd);
@@ -52,11 +71,13 @@ void modbus_tcp_server_stop(void *data, int fd);
 int  modbus_tcp_server_io_callback(enum neu_event_io_type type, int fd,
                                    void *usr_data);
 
-int modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
-                       uint16_t max_byte);
+void modbus_set_max_gap(neu_plugin_t *plugin, uint16_t max_gap);
+int  modbus_group_timer(neu_plugin_t *plugin, neu_plugin_group_t *group,
+                        uint16_t max_byte);
 int modbus_send_msg(void *ctx, uint16_t n_byte, uint8_t *bytes);
 int modbus_value_handle(void *ctx, uint8_t slave_id, uint16_t n_byte,
                         uint8_t *bytes, int error);
+int modbus_match_seq(void *ctx, uint16_t seq, uint8_t *slave_id);
 int modbus_write(neu_plugin_t *plugin, void *req, neu_datatag_t *tag,
                  neu_value_u value, bool response);
 int modbus_write_tag(neu_plugin_t *plugin, void *req, neu_datatag_t *tag,
@@ -123,6 +123,10 @@ static int driver_uninit(neu_plugin_t *plugin)
         modbus_stack_destroy(plugin->stack);
     }
 
+    if (plugin->excludes) {
+        utarray_free(plugin->excludes);
+    }
+
     neu_event_close(plugin->events);
 
     plog_notice(plugin, "%s uninit success", plugin->common.name);
@@ -167,6 +171,7 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
     neu_json_elem_t max_retries = { .name = "max_retries", .t = NEU_JSON_INT };
     neu_json_elem_t retry_interval = { .name = "retry_interval",
                                        .t    = NEU_JSON_INT };
+    neu_json_elem_t max_gap        = { .name = "max_gap", .t = NEU_JSON_INT };
 
     ret = neu_parse_param((char *) config, &err_param, 3, &link, &timeout,
                           &interval);
@@ -208,9 +213,22 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
         retry_interval.v.val_int = 0;
     }
 
+    ret = neu_parse_param((char *) config, &err_param, 1, &max_gap);
+    if (ret != 0) {
+        free(err_param);
+        max_gap.v.val_int = 0;
+    }
+    if (max_gap.v.val_int < 0 || max_gap.v.val_int > MODBUS_MAX_GAP) {
+        plog_error(plugin, "config: %s, set max_gap error", config);
+        free(device.v.val_str);
+        free(host.v.val_str);
+        return -1;
+    }
+
     param.log              = plugin->common.log;
     plugin->max_retries    = max_retries.v.val_int;
     plugin->retry_interval = retry_interval.v.val_int;
+    modbus_set_max_gap(plugin, max_gap.v.val_int);
 
     if (link.v.val_int == 0) {
         param.type = NEU_CONN_TTY_CLIENT;
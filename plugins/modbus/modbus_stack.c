@@ -28,6 +28,7 @@ struct modbus_stack {
     modbus_stack_send       send_fn;
     modbus_stack_value      value_fn;
     modbus_stack_write_resp write_resp;
+    modbus_stack_match      match_fn;
 
     modbus_protocol_e protocol;
     uint16_t          read_seq;
@@ -62,6 +63,16 @@ void modbus_stack_destroy(modbus_stack_t *stack)
     free(stack);
 }
 
+void modbus_stack_set_match(modbus_stack_t *stack, modbus_stack_match match_fn)
+{
+    stack->match_fn = match_fn;
+}
+
+uint16_t modbus_stack_last_read_seq(modbus_stack_t *stack)
+{
+    return stack->read_seq - 1;
+}
+
 int modbus_stack_recv(modbus_stack_t *stack, uint8_t slave_id,
                       neu_protocol_unpack_buf_t *buf)
 {
@@ -77,6 +88,11 @@ int modbus_stack_recv(modbus_stack_t *stack, uint8_t slave_id,
         if (ret <= 0) {
             return -1;
         }
+
+        if (stack->match_fn != NULL &&
+            stack->match_fn(stack->ctx, header.seq, &slave_id) < 0) {
+            return MODBUS_STALE_RESP;
+        }
     }
 
     ret = modbus_code_unwrap(buf, &code);
@@ -145,13 +161,16 @@ int modbus_stack_recv(modbus_stack_t *stack, uint8_t slave_id,
         break;
     }
     case MODBUS_READ_COIL_ERR:
-        return MODBUS_DEVICE_ERR;
     case MODBUS_READ_INPUT_ERR:
-        return MODBUS_DEVICE_ERR;
     case MODBUS_READ_HOLD_REG_ERR:
+    case MODBUS_READ_INPUT_REG_ERR: {
+        uint8_t *exception = neu_protocol_unpack_buf(buf, 1);
+        if (exception != NULL &&
+            *exception == MODBUS_EXCEPTION_ILLEGAL_ADDRESS) {
+            return MODBUS_ILLEGAL_ADDRESS;
+        }
         return MODBUS_DEVICE_ERR;
-    case MODBUS_READ_INPUT_REG_ERR:
-        return MODBUS_DEVICE_ERR;
+    }
     case MODBUS_WRITE_S_COIL_ERR:
         return MODBUS_DEVICE_ERR;
     case MODBUS_WRITE_S_HOLD_REG_ERR:
@@ -32,6 +32,9 @@ typedef int (*modbus_stack_send)(void *ctx, uint16_t n_byte, uint8_t *bytes);
 typedef int (*modbus_stack_value)(void *ctx, uint8_t slave_id, uint16_t n_byte,
                                   uint8_t *bytes, int error);
 typedef int (*modbus_stack_write_resp)(void *ctx, void *req, int error);
+/* resolve the transaction id of a response to the request it answers,
+ * returns -1 if no outstanding request carries that id */
+typedef int (*modbus_stack_match)(void *ctx, uint16_t seq, uint8_t *slave_id);
 
 typedef enum modbus_protocol {
     MODBUS_PROTOCOL_TCP = 1,
@@ -43,6 +46,9 @@ modbus_stack_t *modbus_stack_create(void *ctx, modbus_protocol_e protocol,
                                     modbus_stack_value      value_fn,
                                     modbus_stack_write_resp write_resp);
 void            modbus_stack_destroy(modbus_stack_t *stack);
+void            modbus_stack_set_match(modbus_stack_t *   stack,
+                                       modbus_stack_match match_fn);
+uint16_t        modbus_stack_last_read_seq(modbus_stack_t *stack);
 
 int modbus_stack_recv(modbus_stack_t *stack, uint8_t slave_id,
                       neu_protocol_unpack_buf_t *buf);
@@ -110,6 +110,7 @@ static int driver_init(neu_plugin_t *plugin, bool load)
     plugin->stack    = modbus_stack_create((void *) plugin, MODBUS_PROTOCOL_TCP,
                                         modbus_send_msg, modbus_value_handle,
                                         modbus_write_resp);
+    modbus_stack_set_match(plugin->stack, modbus_match_seq);
 
     plog_notice(plugin, "%s init success", plugin->common.name);
     return 0;
@@ -126,6 +127,10 @@ static int driver_uninit(neu_plugin_t *plugin)
         modbus_stack_destroy(plugin->stack);
     }
 
+    if (plugin->excludes) {
+        utarray_free(plugin->excludes);
+    }
+
     neu_event_close(plugin->events);
 
     plog_notice(plugin, "%s uninit success", plugin->common.name);
@@ -162,6 +167,9 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
     neu_json_elem_t  max_retries = { .name = "max_retries", .t = NEU_JSON_INT };
     neu_json_elem_t  retry_interval = { .name = "retry_interval",
                                        .t    = NEU_JSON_INT };
+    neu_json_elem_t  max_inflight   = { .name = "max_inflight",
+                                     .t    = NEU_JSON_INT };
+    neu_json_elem_t  max_gap        = { .name = "max_gap", .t = NEU_JSON_INT };
 
     ret = neu_parse_param((char *) config, &err_param, 5, &port, &host, &mode,
                           &timeout, &interval);
@@ -175,10 +183,12 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
         return -1;
     }
 
-    if (timeout.v.val_int <= 0) {
+    // also the per request timeout of pipelined reads, kept in 16 bits
+    if (timeout.v.val_int <= 0 || timeout.v.val_int > UINT16_MAX) {
         plog_error(plugin, "config: %s, set timeout error: %s", config,
                    err_param);
         free(err_param);
+        free(host.v.val_str);
         return -1;
     }
 
@@ -190,10 +200,36 @@ static int driver_config(neu_plugin_t *plugin, const char *config)
         retry_interval.v.val_int = 0;
     }
 
+    ret = neu_parse_param((char *) config, &err_param, 1, &max_inflight);
+    if (ret != 0) {
+        free(err_param);
+        max_inflight.v.val_int = 1;
+    }
+    if (max_inflight.v.val_int < 1 ||
+        max_inflight.v.val_int > MODBUS_MAX_INFLIGHT) {
+        plog_error(plugin, "config: %s, set max_inflight error", config);
+        free(host.v.val_str);
+        return -1;
+    }
+
+    ret = neu_parse_param((char *) config, &err_param, 1, &max_gap);
+    if (ret != 0) {
+        free(err_param);
+        max_gap.v.val_int = 0;
+    }
+    if (max_gap.v.val_int < 0 || max_gap.v.val_int > MODBUS_MAX_GAP) {
+        plog_error(plugin, "config: %s, set max_gap error", config);
+        free(host.v.val_str);
+        return -1;
+    }
+
     param.log              = plugin->common.log;
     plugin->interval       = interval.v.val_int;
     plugin->max_retries    = max_retries.v.val_int;
     plugin->retry_interval = retry_interval.v.val_int;
+    plugin->timeout        = timeout.v.val_int;
+    plugin->max_inflight   = max_inflight.v.val_int;
+    modbus_set_max_gap(plugin, max_gap.v.val_int);
 
     if (mode.v.val_int == 1) {
         param.type                           = NEU_CONN_TCP_SERVER;
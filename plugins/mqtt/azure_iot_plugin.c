@@ -174,6 +174,7 @@ static int azure_parse_config(neu_plugin_t *plugin, const char *setting,
     config->cache_mem_size      = 0;
     config->cache_disk_size     = 0;
     config->cache_sync_interval = NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT;
+    config->cache_replay_rate   = NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT;
     config->host                = host.v.val_str;
     config->port                = 8883;
     config->username            = username;
@@ -0,0 +1,216 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/uthash.h"
+
+#include "mqtt_batch.h"
+
+typedef struct {
+    char *         topic;
+    char *         buf; // `[` and the messages so far, room for `]` and `\0`
+    size_t         len;
+    size_t         cap;
+    uint32_t       n_msg;
+    UT_hash_handle hh;
+} batch_entry_t;
+
+typedef struct {
+    const char *topic;
+    char *      payload;
+    size_t      len;
+    uint32_t    n_msg;
+} batch_payload_t;
+
+struct mqtt_batch {
+    pthread_mutex_t       mtx;
+    size_t                limit;
+    batch_entry_t *       entries;
+    mqtt_batch_flush_cb_t cb;
+    void *                ctx;
+};
+
+mqtt_batch_t *mqtt_batch_new(size_t limit, mqtt_batch_flush_cb_t cb,
+                             void *ctx)
+{
+    mqtt_batch_t *batch = calloc(1, sizeof(mqtt_batch_t));
+    if (NULL == batch) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&batch->mtx, NULL);
+    batch->limit = limit;
+    batch->cb    = cb;
+    batch->ctx   = ctx;
+    return batch;
+}
+
+void mqtt_batch_free(mqtt_batch_t *batch)
+{
+    batch_entry_t *e = NULL, *tmp = NULL;
+
+    if (NULL == batch) {
+        return;
+    }
+
+    HASH_ITER(hh, batch->entries, e, tmp)
+    {
+        HASH_DEL(batch->entries, e);
+        free(e->topic);
+        free(e->buf);
+        free(e);
+    }
+
+    pthread_mutex_destroy(&batch->mtx);
+    free(batch);
+}
+
+static batch_entry_t *get_entry(mqtt_batch_t *batch, const char *topic)
+{
+    batch_entry_t *e = NULL;
+
+    HASH_FIND_STR(batch->entries, topic, e);
+    if (NULL != e) {
+        return e;
+    }
+
+    e = calloc(1, sizeof(batch_entry_t));
+    if (NULL == e) {
+        return NULL;
+    }
+
+    e->topic = strdup(topic);
+    if (NULL == e->topic) {
+        free(e);
+        return NULL;
+    }
+
+    HASH_ADD_KEYPTR(hh, batch->entries, e->topic, strlen(e->topic), e);
+    return e;
+}
+
+// closes the array and takes it out of the entry
+static batch_payload_t detach(batch_entry_t *e)
+{
+    batch_payload_t p = {
+        .topic   = e->topic,
+        .payload = e->buf,
+        .len     = e->len + 1,
+        .n_msg   = e->n_msg,
+    };
+
+    e->buf[e->len]     = ']';
+    e->buf[e->len + 1] = '\0';
+
+    e->buf   = NULL;
+    e->len   = 0;
+    e->cap   = 0;
+    e->n_msg = 0;
+    return p;
+}
+
+static int append(batch_entry_t *e, const char *msg, size_t len)
+{
+    // `[` or `,`, the message, then `]` and `\0` on detach
+    size_t need = e->len + 1 + len + 2;
+
+    if (need > e->cap) {
+        size_t cap = e->cap > 0 ? e->cap : 256;
+        while (cap < need) {
+            cap *= 2;
+        }
+
+        char *buf = realloc(e->buf, cap);
+        if (NULL == buf) {
+            return -1;
+        }
+        e->buf = buf;
+        e->cap = cap;
+    }
+
+    e->buf[e->len++] = 0 == e->n_msg ? '[' : ',';
+    memcpy(e->buf + e->len, msg, len);
+    e->len += len;
+    e->n_msg += 1;
+    return 0;
+}
+
+int mqtt_batch_add(mqtt_batch_t *batch, const char *topic, const char *msg,
+                   size_t len)
+{
+    batch_payload_t full[2] = { 0 };
+    int             n_full  = 0;
+    int             rv      = 0;
+
+    pthread_mutex_lock(&batch->mtx);
+    batch_entry_t *e = get_entry(batch, topic);
+    if (NULL == e) {
+        pthread_mutex_unlock(&batch->mtx);
+        return -1;
+    }
+
+    // the pending messages go first if the new one does not fit with them
+    if (e->n_msg > 0 && e->len + 1 + len + 1 > batch->limit) {
+        full[n_full++] = detach(e);
+    }
+
+    rv = append(e, msg, len);
+    if (0 == rv && e->len + 1 >= batch->limit) {
+        full[n_full++] = detach(e);
+    }
+    pthread_mutex_unlock(&batch->mtx);
+
+    for (int i = 0; i < n_full; i++) {
+        batch->cb(batch->ctx, full[i].topic, full[i].payload, full[i].len,
+                  full[i].n_msg);
+    }
+
+    return rv;
+}
+
+void mqtt_batch_flush(mqtt_batch_t *batch)
+{
+    batch_entry_t *  e        = NULL;
+    batch_payload_t *payloads = NULL;
+    uint32_t         n        = 0;
+
+    pthread_mutex_lock(&batch->mtx);
+    payloads = calloc(HASH_COUNT(batch->entries) + 1, sizeof(*payloads));
+    if (NULL == payloads) {
+        pthread_mutex_unlock(&batch->mtx);
+        return;
+    }
+
+    for (e = batch->entries; NULL != e; e = e->hh.next) {
+        if (e->n_msg > 0) {
+            payloads[n++] = detach(e);
+        }
+    }
+    pthread_mutex_unlock(&batch->mtx);
+
+    for (uint32_t i = 0; i < n; i++) {
+        batch->cb(batch->ctx, payloads[i].topic, payloads[i].payload,
+                  payloads[i].len, payloads[i].n_msg);
+    }
+
+    free(payloads);
+}
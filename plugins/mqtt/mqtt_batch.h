@@ -0,0 +1,62 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef NEURON_PLUGIN_MQTT_BATCH_H
+#define NEURON_PLUGIN_MQTT_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Upload messages waiting to be published, per topic. Messages of a topic
+ * are joined into a JSON array which is handed to the flush callback once it
+ * reaches the size limit or on mqtt_batch_flush. All functions are thread
+ * safe, the callback is called without the batch locked and owns payload.
+ */
+typedef struct mqtt_batch mqtt_batch_t;
+
+typedef void (*mqtt_batch_flush_cb_t)(void *ctx, const char *topic,
+                                      char *payload, size_t len,
+                                      uint32_t n_msg);
+
+mqtt_batch_t *mqtt_batch_new(size_t limit, mqtt_batch_flush_cb_t cb,
+                             void *ctx);
+// pending messages are dropped
+void mqtt_batch_free(mqtt_batch_t *batch);
+
+/**
+ * @brief Append a message, the message is copied.
+ *
+ * @return 0 on success, -1 on allocation failure.
+ */
+int mqtt_batch_add(mqtt_batch_t *batch, const char *topic, const char *msg,
+                   size_t len);
+
+// flush the pending messages of every topic
+void mqtt_batch_flush(mqtt_batch_t *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -126,7 +126,8 @@ static int parse_cache_params(neu_plugin_t *plugin, const char *setting,
                               neu_json_elem_t *offline_cache,
                               neu_json_elem_t *cache_mem_size,
                               neu_json_elem_t *cache_disk_size,
-                              neu_json_elem_t *cache_sync_interval)
+                              neu_json_elem_t *cache_sync_interval,
+                              neu_json_elem_t *cache_replay_rate)
 {
     int   ret          = 0;
     char *err_param    = NULL;
@@ -144,6 +145,7 @@ static int parse_cache_params(neu_plugin_t *plugin, const char *setting,
         cache_mem_size->v.val_int      = 0;
         cache_disk_size->v.val_int     = 0;
         cache_sync_interval->v.val_int = NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT;
+        cache_replay_rate->v.val_int   = NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT;
         return 0;
     }
 
@@ -208,6 +210,57 @@ static int parse_cache_params(neu_plugin_t *plugin, const char *setting,
         cache_sync_interval->v.val_int = NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT;
     }
 
+    // cache-replay-rate, optional
+    ret = neu_parse_param(setting, NULL, 1, cache_replay_rate);
+    if (0 == ret) {
+        if (cache_replay_rate->v.val_int < NEU_MQTT_CACHE_REPLAY_RATE_MIN ||
+            NEU_MQTT_CACHE_REPLAY_RATE_MAX < cache_replay_rate->v.val_int) {
+            plog_error(plugin, "setting invalid cache replay rate: %" PRIi64,
+                       cache_replay_rate->v.val_int);
+            return -1;
+        }
+    } else {
+        cache_replay_rate->v.val_int = NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT;
+    }
+
+    return 0;
+}
+
+static int parse_batch_params(neu_plugin_t *plugin, const char *setting,
+                              neu_json_elem_t *batch_interval,
+                              neu_json_elem_t *batch_size,
+                              neu_json_elem_t *compression)
+{
+    // batch-interval, optional, batching disabled by default
+    if (0 != neu_parse_param(setting, NULL, 1, batch_interval)) {
+        batch_interval->v.val_int = 0;
+    } else if (batch_interval->v.val_int < 0 ||
+               MQTT_BATCH_INTERVAL_MAX < batch_interval->v.val_int) {
+        plog_error(plugin, "setting invalid batch interval: %" PRIi64,
+                   batch_interval->v.val_int);
+        return -1;
+    }
+
+    // batch-size, optional
+    if (0 != neu_parse_param(setting, NULL, 1, batch_size)) {
+        batch_size->v.val_int = MQTT_BATCH_SIZE_DEFAULT;
+    } else if (batch_size->v.val_int < MQTT_BATCH_SIZE_MIN ||
+               MQTT_BATCH_SIZE_MAX < batch_size->v.val_int) {
+        plog_error(plugin, "setting invalid batch size: %" PRIi64,
+                   batch_size->v.val_int);
+        return -1;
+    }
+
+    // compression, optional
+    if (0 != neu_parse_param(setting, NULL, 1, compression)) {
+        compression->v.val_int = MQTT_COMPRESSION_NONE;
+    } else if (MQTT_COMPRESSION_NONE != compression->v.val_int &&
+               MQTT_COMPRESSION_DEFLATE != compression->v.val_int) {
+        plog_error(plugin, "setting invalid compression: %" PRIi64,
+                   compression->v.val_int);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -246,6 +299,14 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
                                         .t    = NEU_JSON_INT };
     neu_json_elem_t cache_sync_interval = { .name = "cache-sync-interval",
                                             .t    = NEU_JSON_INT };
+    neu_json_elem_t cache_replay_rate   = { .name = "cache-replay-rate",
+                                          .t    = NEU_JSON_INT };
+    neu_json_elem_t batch_interval      = { .name = "batch-interval",
+                                       .t    = NEU_JSON_INT };
+    neu_json_elem_t batch_size          = { .name = "batch-size",
+                                   .t    = NEU_JSON_INT };
+    neu_json_elem_t compression         = { .name = "compression",
+                                    .t    = NEU_JSON_INT };
     neu_json_elem_t host                = { .name = "host", .t = NEU_JSON_STR };
     neu_json_elem_t port                = { .name = "port", .t = NEU_JSON_INT };
     neu_json_elem_t username = { .name = "username", .t = NEU_JSON_STR };
@@ -306,7 +367,15 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
 
     // offline cache
     ret = parse_cache_params(plugin, setting, &offline_cache, &cache_mem_size,
-                             &cache_disk_size, &cache_sync_interval);
+                             &cache_disk_size, &cache_sync_interval,
+                             &cache_replay_rate);
+    if (0 != ret) {
+        goto error;
+    }
+
+    // upload batching and compression
+    ret = parse_batch_params(plugin, setting, &batch_interval, &batch_size,
+                             &compression);
     if (0 != ret) {
         goto error;
     }
@@ -349,6 +418,10 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
     config->cache_mem_size      = cache_mem_size.v.val_int * MB;
     config->cache_disk_size     = cache_disk_size.v.val_int * MB;
     config->cache_sync_interval = cache_sync_interval.v.val_int;
+    config->cache_replay_rate   = cache_replay_rate.v.val_int;
+    config->batch_interval      = batch_interval.v.val_int;
+    config->batch_size          = batch_size.v.val_int;
+    config->compression         = compression.v.val_int;
     config->host                = host.v.val_str;
     config->port                = port.v.val_int;
     config->username            = username.v.val_str;
@@ -372,6 +445,12 @@ int mqtt_config_parse(neu_plugin_t *plugin, const char *setting,
                 config->cache_disk_size);
     plog_notice(plugin, "config cache-sync-interval : %zu",
                 config->cache_sync_interval);
+    plog_notice(plugin, "config cache-replay-rate : %zu",
+                config->cache_replay_rate);
+    plog_notice(plugin, "config batch-interval  : %zu", config->batch_interval);
+    plog_notice(plugin, "config batch-size      : %zu", config->batch_size);
+    plog_notice(plugin, "config compression     : %s",
+                mqtt_compression_str(config->compression));
     plog_notice(plugin, "config host            : %s", config->host);
     plog_notice(plugin, "config port            : %" PRIu16, config->port);
 
@@ -47,6 +47,31 @@ static inline const char *mqtt_upload_format_str(mqtt_upload_format_e f)
     }
 }
 
+// upload batching window in milliseconds, 0 to publish every report at once
+#define MQTT_BATCH_INTERVAL_MAX 60000
+
+// size in bytes at which a batch is published before the window ends
+#define MQTT_BATCH_SIZE_MIN 1024
+#define MQTT_BATCH_SIZE_MAX (1024 * 1024)
+#define MQTT_BATCH_SIZE_DEFAULT (64 * 1024)
+
+typedef enum {
+    MQTT_COMPRESSION_NONE    = 0,
+    MQTT_COMPRESSION_DEFLATE = 1,
+} mqtt_compression_e;
+
+static inline const char *mqtt_compression_str(mqtt_compression_e c)
+{
+    switch (c) {
+    case MQTT_COMPRESSION_NONE:
+        return "none";
+    case MQTT_COMPRESSION_DEFLATE:
+        return "deflate";
+    default:
+        return NULL;
+    }
+}
+
 typedef struct {
     char *               client_id;           // client id
     neu_mqtt_qos_e       qos;                 // message QoS
@@ -57,6 +82,10 @@ typedef struct {
     size_t               cache_mem_size;      // cache memory size in bytes
     size_t               cache_disk_size;     // cache disk size in bytes
     size_t               cache_sync_interval; // cache sync interval
+    size_t               cache_replay_rate;   // cached messages per second
+    size_t               batch_interval;      // upload batch window in ms
+    size_t               batch_size;          // upload batch limit in bytes
+    mqtt_compression_e   compression;         // upload payload compression
     char *               host;                // broker host
     uint16_t             port;                // broker port
     char *               username;            // user name
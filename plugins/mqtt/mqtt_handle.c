@@ -17,6 +17,8 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 
+#include <zlib.h>
+
 #include "connection/mqtt_client.h"
 #include "errcodes.h"
 #include "utils/asprintf.h"
@@ -51,42 +53,40 @@ static int tag_values_to_json(UT_array *tags, neu_json_read_resp_t *json)
     return 0;
 }
 
+static void fill_trans_tag(void *ctx, int index, neu_json_read_resp_tag_t *tag,
+                           neu_json_tag_meta_t *metas)
+{
+    neu_tag_values_fill_json((neu_tag_values_t *) ctx, index, tag, metas);
+}
+
 char *generate_upload_json(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
                            mqtt_upload_format_e format)
 {
-    char *                   json_str = NULL;
-    neu_json_read_periodic_t header   = { .group     = (char *) data->group,
+    neu_json_writer_t *      w      = &plugin->upload_writer;
+    int                      n_tag  = neu_tag_values_size(data->values);
+    neu_json_read_periodic_t header = { .group     = (char *) data->group,
                                         .node      = (char *) data->driver,
                                         .timestamp = global_timestamp };
-    neu_json_read_resp_t     json     = { 0 };
 
-    if (0 != tag_values_to_json(data->tags, &json)) {
-        plog_error(plugin, "tag_values_to_json fail");
+    if (MQTT_UPLOAD_FORMAT_VALUES != format &&
+        MQTT_UPLOAD_FORMAT_TAGS != format) {
+        plog_warn(plugin, "invalid upload format: %d", format);
         return NULL;
     }
 
+    // the writer keeps the size of the last message, so each upload is
+    // encoded into a single right sized allocation handed over to publish
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_write_read_periodic(w, &header);
     if (MQTT_UPLOAD_FORMAT_VALUES == format) { // values
-        neu_json_encode_with_mqtt(&json, neu_json_encode_read_resp1, &header,
-                                  neu_json_encode_read_periodic_resp,
-                                  &json_str);
-    } else if (MQTT_UPLOAD_FORMAT_TAGS == format) { // tags
-        neu_json_encode_with_mqtt(&json, neu_json_encode_read_resp, &header,
-                                  neu_json_encode_read_periodic_resp,
-                                  &json_str);
-    } else {
-        plog_warn(plugin, "invalid upload format: %d", format);
-    }
-
-    for (int i = 0; i < json.n_tag; i++) {
-        if (json.tags[i].n_meta > 0) {
-            free(json.tags[i].metas);
-        }
+        neu_json_write_read_resp1(w, n_tag, fill_trans_tag, data->values);
+    } else { // tags
+        neu_json_write_read_resp(w, n_tag, fill_trans_tag, data->values);
     }
+    neu_json_writer_object_end(w);
 
-    if (json.tags) {
-        free(json.tags);
-    }
-    return json_str;
+    return neu_json_writer_detach(w);
 }
 
 static char *generate_read_resp_json(neu_plugin_t *         plugin,
@@ -483,6 +483,60 @@ end:
     return rv;
 }
 
+// zlib stream of payload, NULL on failure
+static char *deflate_payload(const char *payload, size_t len, size_t *z_len)
+{
+    uLongf bound = compressBound(len);
+    char * buf   = malloc(bound);
+
+    if (NULL == buf) {
+        return NULL;
+    }
+
+    if (Z_OK !=
+        compress2((Bytef *) buf, &bound, (const Bytef *) payload, len,
+                  Z_DEFAULT_COMPRESSION)) {
+        free(buf);
+        return NULL;
+    }
+
+    *z_len = bound;
+    return buf;
+}
+
+// publish n_msg group reports, payload is compressed as configured and its
+// ownership moved
+static int publish_upload(neu_plugin_t *plugin, const char *topic,
+                          char *payload, size_t len, uint32_t n_msg)
+{
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_UPLOAD_BATCH_MSGS, n_msg,
+                             NULL);
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_UPLOAD_RAW_BYTES_TOTAL, len,
+                             NULL);
+
+    if (MQTT_COMPRESSION_DEFLATE == plugin->config.compression) {
+        size_t z_len = 0;
+        char * z     = deflate_payload(payload, len, &z_len);
+        if (NULL != z) {
+            free(payload);
+            payload = z;
+            len     = z_len;
+        } else {
+            plog_warn(plugin, "deflate fail, publish uncompressed");
+        }
+    }
+
+    NEU_PLUGIN_UPDATE_METRIC(plugin, NEU_METRIC_UPLOAD_WIRE_BYTES_TOTAL, len,
+                             NULL);
+    return publish(plugin, plugin->config.qos, (char *) topic, payload, len);
+}
+
+void handle_batch_flush(void *ctx, const char *topic, char *payload,
+                        size_t len, uint32_t n_msg)
+{
+    publish_upload((neu_plugin_t *) ctx, topic, payload, len, n_msg);
+}
+
 int handle_trans_data(neu_plugin_t *            plugin,
                       neu_reqresp_trans_data_t *trans_data)
 {
@@ -513,10 +567,23 @@ int handle_trans_data(neu_plugin_t *            plugin,
         return NEU_ERR_EINTERNAL;
     }
 
-    char *         topic = route->topic;
-    neu_mqtt_qos_e qos   = plugin->config.qos;
-    rv       = publish(plugin, qos, topic, json_str, strlen(json_str));
-    json_str = NULL;
+    pthread_mutex_lock(&plugin->batch_mtx);
+    if (NULL != plugin->batch) {
+        // published by the batch timer, or now if the batch is full
+        rv = mqtt_batch_add(plugin->batch, route->topic, json_str,
+                            strlen(json_str));
+        pthread_mutex_unlock(&plugin->batch_mtx);
+        free(json_str);
+        if (0 != rv) {
+            plog_error(plugin, "batch upload to topic:%s fail", route->topic);
+            return NEU_ERR_EINTERNAL;
+        }
+        return 0;
+    }
+    pthread_mutex_unlock(&plugin->batch_mtx);
+
+    // json_str ownership moved
+    rv = publish_upload(plugin, route->topic, json_str, strlen(json_str), 1);
 
     return rv;
 }
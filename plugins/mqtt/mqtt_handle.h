@@ -48,6 +48,10 @@ char *generate_upload_json(neu_plugin_t *plugin, neu_reqresp_trans_data_t *data,
 int   handle_trans_data(neu_plugin_t *            plugin,
                         neu_reqresp_trans_data_t *trans_data);
 
+// mqtt_batch_flush_cb_t of the upload batch, ctx is the plugin
+void handle_batch_flush(void *ctx, const char *topic, char *payload,
+                        size_t len, uint32_t n_msg);
+
 int handle_subscribe_group(neu_plugin_t *plugin, neu_req_subscribe_t *sub_info);
 int handle_update_subscribe(neu_plugin_t *       plugin,
                             neu_req_subscribe_t *sub_info);
@@ -26,7 +26,9 @@ extern "C" {
 
 #include "connection/mqtt_client.h"
 #include "neuron.h"
+#include "utils/json_writer.h"
 
+#include "mqtt_batch.h"
 #include "mqtt_config.h"
 
 typedef struct {
@@ -51,6 +53,12 @@ struct neu_plugin {
     char *              read_resp_topic;
     char *              upload_topic;
     route_entry_t *     route_tbl;
+    neu_json_writer_t   upload_writer;
+    neu_events_t *      events;      // runs batch_timer
+    neu_event_timer_t * batch_timer; // flushes batch every batch-interval
+    // batch is swapped by a reconfiguration while uploads are added to it
+    pthread_mutex_t     batch_mtx;
+    mqtt_batch_t *      batch; // NULL when batching is disabled
 
     int (*parse_config)(neu_plugin_t *plugin, const char *setting,
                         mqtt_config_t *config);
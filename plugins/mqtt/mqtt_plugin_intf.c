@@ -47,6 +47,85 @@ static void disconnect_cb(void *data)
                 neu_plugin_module.module_name);
 }
 
+static int batch_timer_cb(void *data)
+{
+    neu_plugin_t *plugin = data;
+
+    pthread_mutex_lock(&plugin->batch_mtx);
+    if (NULL != plugin->batch) {
+        mqtt_batch_flush(plugin->batch);
+    }
+    pthread_mutex_unlock(&plugin->batch_mtx);
+    return 0;
+}
+
+// batch uploads per topic if the config has a batch interval
+static int start_batch(neu_plugin_t *plugin, const mqtt_config_t *config)
+{
+    if (0 == config->batch_interval) {
+        return 0;
+    }
+
+    if (NULL == plugin->events) {
+        plugin->events = neu_event_new();
+        if (NULL == plugin->events) {
+            return -1;
+        }
+    }
+
+    mqtt_batch_t *batch =
+        mqtt_batch_new(config->batch_size, handle_batch_flush, plugin);
+    if (NULL == batch) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&plugin->batch_mtx);
+    plugin->batch = batch;
+    pthread_mutex_unlock(&plugin->batch_mtx);
+
+    neu_event_timer_param_t param = {
+        .second      = config->batch_interval / 1000,
+        .millisecond = config->batch_interval % 1000,
+        .usr_data    = plugin,
+        .cb          = batch_timer_cb,
+        .type        = NEU_EVENT_TIMER_NOBLOCK,
+    };
+
+    plugin->batch_timer = neu_event_add_timer(plugin->events, param);
+    if (NULL == plugin->batch_timer) {
+        pthread_mutex_lock(&plugin->batch_mtx);
+        plugin->batch = NULL;
+        pthread_mutex_unlock(&plugin->batch_mtx);
+        mqtt_batch_flush(batch);
+        mqtt_batch_free(batch);
+        return -1;
+    }
+
+    return 0;
+}
+
+// publish what is pending with the current config and stop batching
+static void stop_batch(neu_plugin_t *plugin)
+{
+    mqtt_batch_t *batch = NULL;
+
+    if (NULL != plugin->batch_timer) {
+        neu_event_del_timer(plugin->events, plugin->batch_timer);
+        plugin->batch_timer = NULL;
+    }
+
+    // uploads after this are published at once, none is added to batch
+    pthread_mutex_lock(&plugin->batch_mtx);
+    batch         = plugin->batch;
+    plugin->batch = NULL;
+    pthread_mutex_unlock(&plugin->batch_mtx);
+
+    if (NULL != batch) {
+        mqtt_batch_flush(batch);
+        mqtt_batch_free(batch);
+    }
+}
+
 neu_plugin_t *mqtt_plugin_open(void)
 {
     neu_plugin_t *plugin = (neu_plugin_t *) calloc(1, sizeof(neu_plugin_t));
@@ -62,6 +141,7 @@ int mqtt_plugin_close(neu_plugin_t *plugin)
     const char *name = neu_plugin_module.module_name;
     plog_notice(plugin, "success to free plugin:%s", name);
 
+    neu_json_writer_fini(&plugin->upload_writer);
     free(plugin);
     return NEU_ERR_SUCCESS;
 }
@@ -70,6 +150,8 @@ int mqtt_plugin_init(neu_plugin_t *plugin, bool load)
 {
     (void) load;
 
+    pthread_mutex_init(&plugin->batch_mtx, NULL);
+
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_CACHED_MSGS_NUM, 0);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_TRANS_DATA_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_TRANS_DATA_30S, 30000);
@@ -77,6 +159,9 @@ int mqtt_plugin_init(neu_plugin_t *plugin, bool load)
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_30S, 30000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_SEND_BYTES_60S, 60000);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_UPLOAD_BATCH_MSGS, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_UPLOAD_RAW_BYTES_TOTAL, 0);
+    NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_UPLOAD_WIRE_BYTES_TOTAL, 0);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_5S, 5000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_30S, 30000);
     NEU_PLUGIN_REGISTER_METRIC(plugin, NEU_METRIC_RECV_BYTES_60S, 60000);
@@ -94,6 +179,12 @@ int mqtt_plugin_init(neu_plugin_t *plugin, bool load)
 
 int mqtt_plugin_uninit(neu_plugin_t *plugin)
 {
+    stop_batch(plugin);
+    if (plugin->events) {
+        neu_event_close(plugin->events);
+        plugin->events = NULL;
+    }
+
     mqtt_config_fini(&plugin->config);
     if (plugin->client) {
         neu_mqtt_client_close(plugin->client);
@@ -109,6 +200,7 @@ int mqtt_plugin_uninit(neu_plugin_t *plugin)
     plugin->upload_topic = NULL;
 
     route_tbl_free(plugin->route_tbl);
+    pthread_mutex_destroy(&plugin->batch_mtx);
 
     plog_notice(plugin, "uninitialize plugin `%s` success",
                 neu_plugin_module.module_name);
@@ -169,6 +261,13 @@ static int config_mqtt_client(neu_plugin_t *plugin, neu_mqtt_client_t *client,
         return -1;
     }
 
+    rv = neu_mqtt_client_set_cache_replay_rate(client,
+                                               config->cache_replay_rate);
+    if (0 != rv) {
+        plog_error(plugin, "neu_mqtt_client_set_cache_replay_rate fail");
+        return -1;
+    }
+
     if (NULL != config->username) {
         rv = neu_mqtt_client_set_user(client, config->username,
                                       config->password);
@@ -259,6 +358,9 @@ int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
         return NEU_ERR_NODE_SETTING_INVALID;
     }
 
+    // pending uploads go out with the settings they were batched under
+    stop_batch(plugin);
+
     if (NULL == plugin->client) {
         plugin->client = neu_mqtt_client_new(NEU_MQTT_VERSION_V311);
         if (NULL == plugin->client) {
@@ -300,12 +402,19 @@ int mqtt_plugin_config(neu_plugin_t *plugin, const char *setting)
     }
     memmove(&plugin->config, &config, sizeof(config));
 
+    if (0 != start_batch(plugin, &plugin->config)) {
+        plog_error(plugin, "start upload batching fail, publish at once");
+    }
+
     plog_notice(plugin, "config plugin `%s` success", plugin_name);
     return 0;
 
 error:
     plog_error(plugin, "config plugin `%s` fail", plugin_name);
     mqtt_config_fini(&config);
+    if (0 != start_batch(plugin, &plugin->config)) {
+        plog_error(plugin, "start upload batching fail, publish at once");
+    }
     return rv;
 }
 
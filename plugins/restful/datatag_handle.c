@@ -16,9 +16,13 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
+#include <inttypes.h>
 #include <stdlib.h>
 
+#include <nng/supplemental/http/http.h>
+
 #include "parser/neu_json_tag.h"
+#include "parser/neu_tag_import.h"
 #include "plugin.h"
 #include "utils/log.h"
 #include "json/neu_json_error.h"
@@ -192,6 +196,104 @@ void handle_add_gtags_resp(nng_aio *aio, neu_resp_add_tag_t *resp)
     free(result);
 }
 
+static void import_tags_response(nng_aio *aio, uint32_t index, int error)
+{
+    neu_json_import_tags_res_t res    = { .index = index, .error = error };
+    char *                     result = NULL;
+
+    neu_json_encode_by_fn(&res, neu_json_encode_import_tags_resp, &result);
+    neu_http_response(aio, error, result);
+    free(result);
+}
+
+void handle_import_tags(nng_aio *aio)
+{
+    neu_plugin_t *          plugin                    = neu_rest_get_plugin();
+    char                    node[NEU_NODE_NAME_LEN]   = { 0 };
+    char                    group[NEU_GROUP_NAME_LEN] = { 0 };
+    uintmax_t               interval = NEU_DEFAULT_GROUP_INTERVAL;
+    const char *            type     = NULL;
+    void *                  body     = NULL;
+    size_t                  len      = 0;
+    neu_tag_import_t *      imp      = NULL;
+    neu_tag_import_format_e format   = NEU_TAG_IMPORT_JSON;
+    int                     ret      = 0;
+    neu_req_import_tag_t    cmd      = { 0 };
+    neu_reqresp_head_t      header   = {
+        .ctx  = aio,
+        .type = NEU_REQ_IMPORT_TAG,
+    };
+
+    NEU_VALIDATE_JWT(aio);
+
+    if (neu_http_get_param_str(aio, "node", node, sizeof(node)) <= 0 ||
+        neu_http_get_param_str(aio, "group", group, sizeof(group)) <= 0) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_PARAM_IS_WRONG, {
+            neu_http_response(aio, NEU_ERR_PARAM_IS_WRONG, result_error);
+        })
+        return;
+    }
+
+    if (NULL != neu_http_get_param(aio, "interval", NULL) &&
+        (0 != neu_http_get_param_uintmax(aio, "interval", &interval) ||
+         interval < NEU_DEFAULT_GROUP_INTERVAL || interval > UINT32_MAX)) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_GROUP_PARAMETER_INVALID, {
+            neu_http_response(aio, NEU_ERR_GROUP_PARAMETER_INVALID,
+                              result_error);
+        })
+        return;
+    }
+
+    type = neu_http_get_header(aio, (char *) "Content-Type");
+    if (NULL != type && NULL != strstr(type, "csv")) {
+        format = NEU_TAG_IMPORT_CSV;
+    }
+
+    // parse straight from the request buffer, no copy of the body is made
+    nng_http_req_get_data(nng_aio_get_input(aio, 0), &body, &len);
+    imp = neu_tag_import_new(format);
+    if (NULL == imp) {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        })
+        return;
+    }
+
+    ret = neu_tag_import_feed(imp, body, len);
+    if (0 == ret) {
+        ret = neu_tag_import_finish(imp);
+    }
+    if (0 != ret) {
+        nlog_notice("import %s:%s, tag %" PRIu32 " is malformed", node, group,
+                    neu_tag_import_count(imp));
+        import_tags_response(aio, neu_tag_import_count(imp), ret);
+        neu_tag_import_free(imp);
+        return;
+    }
+
+    strcpy(cmd.driver, node);
+    strcpy(cmd.group, group);
+    cmd.interval = interval;
+    cmd.tags     = neu_tag_import_take(imp, &cmd.n_tag);
+    neu_tag_import_free(imp);
+
+    ret = neu_plugin_op(plugin, header, &cmd);
+    if (ret != 0) {
+        for (uint32_t i = 0; i < cmd.n_tag; i++) {
+            neu_tag_fini(&cmd.tags[i]);
+        }
+        free(cmd.tags);
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_IS_BUSY, {
+            neu_http_response(aio, NEU_ERR_IS_BUSY, result_error);
+        });
+    }
+}
+
+void handle_import_tags_resp(nng_aio *aio, neu_resp_import_tag_t *resp)
+{
+    import_tags_response(aio, resp->index, resp->error);
+}
+
 void handle_del_tags(nng_aio *aio)
 {
     neu_plugin_t *plugin = neu_rest_get_plugin();
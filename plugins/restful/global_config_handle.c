@@ -1197,7 +1197,7 @@ static int add_tag(context_t *ctx, neu_json_add_tags_req_t *data)
     return ret;
 
 error:
-    for (int j = 0; j < i && j < cmd.n_tag; ++j) {
+    for (int j = 0; j < i; ++j) {
         neu_tag_fini(&cmd.tags[j]);
     }
     free(cmd.tags);
@@ -58,6 +58,9 @@ static struct neu_http_handler cors_handler[] = {
     {
         .url = "/api/v2/gtags",
     },
+    {
+        .url = "/api/v2/tags/import",
+    },
     {
         .url = "/api/v2/group",
     },
@@ -173,6 +176,12 @@ static struct neu_http_handler rest_handlers[] = {
         .url           = "/api/v2/gtags",
         .value.handler = handle_add_gtags,
     },
+    {
+        .method        = NEU_HTTP_METHOD_POST,
+        .type          = NEU_HTTP_HANDLER_FUNCTION,
+        .url           = "/api/v2/tags/import",
+        .value.handler = handle_import_tags,
+    },
     {
         .method        = NEU_HTTP_METHOD_PUT,
         .type          = NEU_HTTP_HANDLER_FUNCTION,
@@ -28,6 +28,7 @@
 #include "utils/http.h"
 #include "utils/http_handler.h"
 #include "utils/log.h"
+#include "utils/neu_jwt.h"
 
 #include "metric_handle.h"
 
@@ -165,6 +166,59 @@ static inline void gen_global_metrics(const neu_metrics_t *metrics,
             metrics->north_nodes, metrics->north_running_nodes,
             metrics->north_disconnected_nodes, metrics->south_nodes,
             metrics->south_running_nodes, metrics->south_disconnected_nodes);
+
+    uint64_t jwt_hits = 0, jwt_misses = 0;
+    neu_jwt_cache_stats(&jwt_hits, &jwt_misses);
+    fprintf(stream,
+            "# HELP jwt_cache_hits_total Tokens validated from the cache\n"
+            "# TYPE jwt_cache_hits_total counter\n"
+            "jwt_cache_hits_total %" PRIu64 "\n"
+            "# HELP jwt_cache_misses_total Tokens validated by signature\n"
+            "# TYPE jwt_cache_misses_total counter\n"
+            "jwt_cache_misses_total %" PRIu64 "\n",
+            jwt_hits, jwt_misses);
+}
+
+// sample lines of an entry, the caller holds the node lock
+static void gen_entry_samples(neu_metric_entry_t *e, const char *node,
+                              const char *group, FILE *stream)
+{
+    const char *sep = NULL != group ? "\",group=\"" : "";
+    uint64_t    cum = 0;
+
+    group = NULL != group ? group : "";
+
+    if (neu_metric_type_is_rolling_counter(e->type)) {
+        // force clean stale value
+        e->value = neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
+    }
+
+    if (!neu_metric_type_is_histogram(e->type)) {
+        fprintf(stream, "%s{node=\"%s%s%s\"} %" PRIu64 "\n", e->name, node, sep,
+                group, neu_metric_entry_value(e));
+        return;
+    }
+
+    for (int i = 0; i < NEU_METRIC_HISTOGRAM_BUCKETS; ++i) {
+        cum += __atomic_load_n(&e->hist->buckets[i], __ATOMIC_RELAXED);
+        if (i < NEU_METRIC_HISTOGRAM_BUCKETS - 1) {
+            fprintf(stream,
+                    "%s_bucket{node=\"%s%s%s\",le=\"%" PRIu64 "\"} %" PRIu64
+                    "\n",
+                    e->name, node, sep, group, neu_metric_histogram_bounds[i],
+                    cum);
+        } else {
+            fprintf(stream,
+                    "%s_bucket{node=\"%s%s%s\",le=\"+Inf\"} %" PRIu64 "\n",
+                    e->name, node, sep, group, cum);
+        }
+    }
+
+    // count is taken from the buckets to stay consistent with them
+    fprintf(stream, "%s_sum{node=\"%s%s%s\"} %" PRIu64 "\n", e->name, node, sep,
+            group, __atomic_load_n(&e->hist->sum, __ATOMIC_RELAXED));
+    fprintf(stream, "%s_count{node=\"%s%s%s\"} %" PRIu64 "\n", e->name, node,
+            sep, group, cum);
 }
 
 static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
@@ -181,14 +235,9 @@ static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
     pthread_mutex_lock(&node_metrics->lock);
     HASH_LOOP(hh, node_metrics->entries, e)
     {
-        if (neu_metric_type_is_rolling_counter(e->type)) {
-            // force clean stale value
-            e->value = neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-        }
-        fprintf(stream,
-                "# HELP %s %s\n# TYPE %s %s\n%s{node=\"%s\"} %" PRIu64 "\n",
-                e->name, e->help, e->name, neu_metric_type_str(e->type),
-                e->name, node_metrics->name, e->value);
+        fprintf(stream, "# HELP %s %s\n# TYPE %s %s\n", e->name, e->help,
+                e->name, neu_metric_type_str(e->type));
+        gen_entry_samples(e, node_metrics->name, NULL, stream);
     }
 
     neu_group_metrics_t *g = NULL;
@@ -196,16 +245,9 @@ static inline void gen_single_node_metrics(neu_node_metrics_t *node_metrics,
     {
         HASH_LOOP(hh, g->entries, e)
         {
-            if (neu_metric_type_is_rolling_counter(e->type)) {
-                // force clean stale value
-                e->value =
-                    neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-            }
-            fprintf(stream,
-                    "# HELP %s %s\n# TYPE %s %s\n%s{node=\"%s\",group=\"%s\"} "
-                    "%" PRIu64 "\n",
-                    e->name, e->help, e->name, neu_metric_type_str(e->type),
-                    e->name, node_metrics->name, g->name, e->value);
+            fprintf(stream, "# HELP %s %s\n# TYPE %s %s\n", e->name, e->help,
+                    e->name, neu_metric_type_str(e->type));
+            gen_entry_samples(e, node_metrics->name, g->name, stream);
         }
     }
     pthread_mutex_unlock(&node_metrics->lock);
@@ -278,14 +320,7 @@ static void gen_all_node_metrics(neu_metrics_t *metrics, int type_filter,
             pthread_mutex_lock(&n->lock);
             HASH_FIND_STR(n->entries, r->name, e);
             if (e) {
-                if (neu_metric_type_is_rolling_counter(e->type)) {
-                    // force clean stale value
-                    e->value =
-                        neu_rolling_counter_inc(e->rcnt, global_timestamp, 0);
-                }
-                fprintf(stream, "%s{node=\"%s\"} %" PRIu64 "\n", e->name,
-                        n->name, e->value);
-
+                gen_entry_samples(e, n->name, NULL, stream);
                 pthread_mutex_unlock(&n->lock);
                 continue;
             }
@@ -294,14 +329,7 @@ static void gen_all_node_metrics(neu_metrics_t *metrics, int type_filter,
             {
                 HASH_FIND_STR(g->entries, r->name, e);
                 if (e) {
-                    if (neu_metric_type_is_rolling_counter(e->type)) {
-                        // force clean stale value
-                        e->value = neu_rolling_counter_inc(e->rcnt,
-                                                           global_timestamp, 0);
-                    }
-                    fprintf(stream,
-                            "%s{node=\"%s\",group=\"%s\"} %" PRIu64 "\n",
-                            e->name, n->name, g->name, e->value);
+                    gen_entry_samples(e, n->name, g->name, stream);
                 }
             }
             pthread_mutex_unlock(&n->lock);
@@ -116,6 +116,8 @@ void handle_read_paginate(nng_aio *aio)
             cmd.current_page = req->current_page;
             cmd.page_size    = req->page_size;
             cmd.is_error     = req->is_error;
+            cmd.by_cursor    = req->cursor >= 0;
+            cmd.cursor       = cmd.by_cursor ? (uint64_t) req->cursor : 0;
             req->node        = NULL;
             req->group       = NULL;
             ret              = neu_plugin_op(plugin, header, &cmd);
@@ -470,30 +472,36 @@ void handle_write_gtags(nng_aio *aio)
         })
 }
 
-void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp)
+static void fill_read_tag(void *ctx, int index, neu_json_read_resp_tag_t *tag,
+                          neu_json_tag_meta_t *metas)
 {
-    neu_json_read_resp_t api_res = { 0 };
-    char *               result  = NULL;
-    int                  index   = 0;
-
-    api_res.n_tag = utarray_len(resp->tags);
-    api_res.tags  = calloc(api_res.n_tag, sizeof(neu_json_read_resp_tag_t));
+    UT_array *                 tags      = (UT_array *) ctx;
+    neu_resp_tag_value_meta_t *tag_value =
+        (neu_resp_tag_value_meta_t *) utarray_eltptr(tags, (unsigned) index);
 
-    utarray_foreach(resp->tags, neu_resp_tag_value_meta_t *, tag_value)
-    {
-        neu_tag_value_to_json(tag_value, &api_res.tags[index]);
-        index += 1;
-    }
+    neu_tag_value_fill_json(tag_value, tag, metas);
+}
 
-    neu_json_encode_by_fn(&api_res, neu_json_encode_read_resp, &result);
-    for (int i = 0; i < api_res.n_tag; i++) {
-        if (api_res.tags[i].n_meta > 0) {
-            free(api_res.tags[i].metas);
-        }
+void handle_read_resp(nng_aio *aio, neu_resp_read_group_t *resp)
+{
+    neu_json_writer_t w      = { 0 };
+    const char *      result = NULL;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_object_begin(&w);
+    neu_json_write_read_resp(&w, utarray_len(resp->tags), fill_read_tag,
+                             resp->tags);
+    neu_json_writer_object_end(&w);
+
+    result = neu_json_writer_str(&w);
+    if (result != NULL) {
+        neu_http_ok(aio, (char *) result);
+    } else {
+        NEU_JSON_RESPONSE_ERROR(NEU_ERR_EINTERNAL, {
+            neu_http_response(aio, NEU_ERR_EINTERNAL, result_error);
+        });
     }
-    neu_http_ok(aio, result);
-    free(api_res.tags);
-    free(result);
+    neu_json_writer_fini(&w);
 }
 
 void handle_read_paginate_resp(nng_aio *                       aio,
@@ -611,6 +619,8 @@ void handle_read_paginate_resp(nng_aio *                       aio,
     api_res.meta.current_page = resp->current_page;
     api_res.meta.page_size    = resp->page_size;
     api_res.meta.total        = total_tags;
+    api_res.meta.by_cursor    = resp->by_cursor;
+    api_res.meta.next_cursor  = resp->next_cursor;
 
     neu_json_encode_by_fn(&api_res, neu_json_encode_read_paginate_resp,
                           &result);
@@ -19,7 +19,7 @@
 #include <assert.h>
 #include <memory.h>
 #include <netinet/in.h>
-#include <pthread.h>
+#include <stdlib.h>
 
 #include <neuron.h>
 
@@ -27,39 +27,88 @@
 
 #include "modbus_s.h"
 
-struct modbus_register {
-    pthread_mutex_t mutex;
-    neu_value8_u    input[65536];
-    neu_value16_u   input_register[65536];
-    neu_value8_u    coil[65536];
-    neu_value16_u   hold_register[65536];
+// the largest modbus tcp request, a write of 123 registers
+#define TCP_REQ_LEN_MAX 260
+
+struct modbus_slave {
+    uint8_t * coil;
+    uint8_t * input;
+    uint16_t *hold_register;
+    uint16_t *input_register;
 };
 
-static bool                   simulate_error = false;
-static struct modbus_register rtu_registers[3];
-static struct modbus_register tcp_registers[3];
+static bool                 simulate_error = false;
+static modbus_s_config_t    config         = { 0 };
+static struct modbus_slave *slaves         = NULL;
+
+// next address to change and the remainder of the change rate in thousandths
+static uint32_t change_cursor = 0;
+static uint64_t change_carry  = 0;
 
-static int  modbus_read(struct modbus_register *reg, uint8_t function,
+static int  modbus_read(struct modbus_slave *slave, uint8_t function,
                         struct modbus_address *address, uint8_t *value);
-static void modbus_write(struct modbus_register *reg, uint8_t function,
+static void modbus_write(struct modbus_slave *slave, uint8_t function,
                          struct modbus_address *address,
                          struct modbus_data *data, uint8_t *value);
 
-void modbus_s_init()
+int modbus_s_init(const modbus_s_config_t *cfg)
 {
-    for (int i = 0; i < 3; i++) {
-        for (int k = 0; k < 65536; k += 2) {
-            rtu_registers[i].input[k].value = 0;
-            tcp_registers[i].input[k].value = 0;
-        }
-        for (int k = 0; k < 65536; k++) {
-            rtu_registers[i].input_register[k].value = 0;
-            tcp_registers[i].input_register[k].value = 0;
+    modbus_s_config_t c = {
+        .n_slave    = MODBUS_S_SLAVES_DEFAULT,
+        .n_register = MODBUS_S_REGISTERS_MAX,
+    };
+
+    if (cfg != NULL) {
+        c = *cfg;
+    }
+
+    if (c.n_slave == 0 || c.n_slave > MODBUS_S_SLAVES_MAX ||
+        c.n_register == 0 || c.n_register > MODBUS_S_REGISTERS_MAX ||
+        c.exception_rate < 0 || c.exception_rate > 1) {
+        return -1;
+    }
+
+    modbus_s_fini();
+
+    slaves = calloc(c.n_slave, sizeof(struct modbus_slave));
+    if (slaves == NULL) {
+        return -1;
+    }
+    config = c;
+
+    for (int i = 0; i < c.n_slave; i++) {
+        slaves[i].coil           = calloc(c.n_register, sizeof(uint8_t));
+        slaves[i].input          = calloc(c.n_register, sizeof(uint8_t));
+        slaves[i].hold_register  = calloc(c.n_register, sizeof(uint16_t));
+        slaves[i].input_register = calloc(c.n_register, sizeof(uint16_t));
+
+        if (slaves[i].coil == NULL || slaves[i].input == NULL ||
+            slaves[i].hold_register == NULL ||
+            slaves[i].input_register == NULL) {
+            modbus_s_fini();
+            return -1;
         }
+    }
+
+    change_cursor = 0;
+    change_carry  = 0;
+    return 0;
+}
+
+void modbus_s_fini()
+{
+    if (slaves == NULL) {
+        return;
+    }
 
-        pthread_mutex_init(&rtu_registers[i].mutex, NULL);
-        pthread_mutex_init(&tcp_registers[i].mutex, NULL);
+    for (int i = 0; i < config.n_slave; i++) {
+        free(slaves[i].coil);
+        free(slaves[i].input);
+        free(slaves[i].hold_register);
+        free(slaves[i].input_register);
     }
+    free(slaves);
+    slaves = NULL;
 }
 
 void modbus_s_simulate_error(bool b)
@@ -67,6 +116,93 @@ void modbus_s_simulate_error(bool b)
     simulate_error = b;
 }
 
+void modbus_s_change_values(int64_t elapsed_ms)
+{
+    uint64_t n = 0;
+
+    if (slaves == NULL || config.change_rate == 0 || elapsed_ms <= 0) {
+        return;
+    }
+
+    change_carry += (uint64_t) config.change_rate * elapsed_ms;
+    n = change_carry / 1000;
+    change_carry %= 1000;
+    if (n > config.n_register) {
+        n = config.n_register;
+    }
+
+    for (int s = 0; s < config.n_slave; s++) {
+        uint32_t k = change_cursor;
+
+        for (uint64_t i = 0; i < n; i++) {
+            slaves[s].input_register[k] += 1;
+            slaves[s].input[k] ^= 1;
+            k = k + 1 == config.n_register ? 0 : k + 1;
+        }
+    }
+
+    change_cursor = (change_cursor + n) % config.n_register;
+}
+
+static struct modbus_slave *find_slave(uint8_t slave_id)
+{
+    if (slaves == NULL || slave_id == 0 || slave_id > config.n_slave) {
+        return NULL;
+    }
+
+    return &slaves[slave_id - 1];
+}
+
+// exception code the request is answered with, 0 if none, room is the number
+// of bytes available for the values read
+static uint8_t request_exception(struct modbus_code *   code,
+                                 struct modbus_address *address,
+                                 struct modbus_data *data, int room)
+{
+    uint32_t start = ntohs(address->start_address);
+    uint32_t n     = 0;
+
+    switch (code->function) {
+    case MODBUS_READ_COIL:
+    case MODBUS_READ_INPUT:
+        n = ntohs(address->n_reg);
+        if (n == 0 || (int) (n / 8 + 1) > room) {
+            return MODBUS_EXCEPTION_ILLEGAL_VALUE;
+        }
+        break;
+    case MODBUS_READ_HOLD_REG:
+    case MODBUS_READ_INPUT_REG:
+        n = ntohs(address->n_reg);
+        if (n == 0 || (int) (n * 2) > room) {
+            return MODBUS_EXCEPTION_ILLEGAL_VALUE;
+        }
+        break;
+    case MODBUS_WRITE_S_COIL:
+    case MODBUS_WRITE_S_HOLD_REG:
+        n = 1;
+        break;
+    case MODBUS_WRITE_M_COIL:
+        n = ntohs(address->n_reg);
+        break;
+    case MODBUS_WRITE_M_HOLD_REG:
+        n = (data->n_byte + 1) / 2;
+        break;
+    default:
+        return 0;
+    }
+
+    if (start + n > config.n_register) {
+        return MODBUS_EXCEPTION_ILLEGAL_ADDRESS;
+    }
+
+    if (config.exception_rate > 0 &&
+        (double) rand() / ((double) RAND_MAX + 1) < config.exception_rate) {
+        return MODBUS_EXCEPTION_SERVER_DEVICE_BUSY;
+    }
+
+    return 0;
+}
+
 ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
                          int res_mlen, int *res_len)
 {
@@ -74,6 +210,8 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     struct modbus_address *address = (struct modbus_address *) &code[1];
     struct modbus_data *   data    = (struct modbus_data *) &address[1];
     uint8_t *              value   = (uint8_t *) &data[1];
+    struct modbus_slave *  slave   = NULL;
+    uint8_t                except  = 0;
     int                    len     = 0;
     int use_len = sizeof(struct modbus_code) + sizeof(struct modbus_address);
 
@@ -86,11 +224,14 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     static int start_address_8000_counter = 0;
     static int start_address_8001_counter = 0;
 
+    *res_len = 0;
+
     if (req_len < sizeof(struct modbus_code)) {
         return 0;
     }
 
-    if (code->slave_id != 1 && code->slave_id != 2 && code->slave_id != 3) {
+    slave = find_slave(code->slave_id);
+    if (slave == NULL) {
         return -1;
     }
 
@@ -115,6 +256,10 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
         break;
     case MODBUS_WRITE_M_HOLD_REG:
     case MODBUS_WRITE_M_COIL:
+        if (req_len < sizeof(struct modbus_code) +
+                sizeof(struct modbus_address) + sizeof(struct modbus_data)) {
+            return 0;
+        }
         if (req_len < sizeof(struct modbus_code) +
                 sizeof(struct modbus_address) + sizeof(struct modbus_data) +
                 data->n_byte + 2) {
@@ -122,11 +267,24 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
         }
         use_len += sizeof(struct modbus_data) + data->n_byte + 2;
         break;
+    default:
+        return -1;
     }
 
     memcpy(res, req, sizeof(struct modbus_code));
     *res_len = sizeof(struct modbus_code);
 
+    except = request_exception(code, address, data,
+                               res_mlen - *res_len -
+                                   (int) sizeof(struct modbus_data) - 2);
+    if (except != 0) {
+        res_code->function |= 0x80;
+        res_data->n_byte = except;
+        *res_len += sizeof(struct modbus_data);
+        crc = (uint16_t *) res_value;
+        goto crc;
+    }
+
     switch (code->function) {
     case MODBUS_READ_COIL:
     case MODBUS_READ_INPUT:
@@ -135,28 +293,27 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
         if (simulate_error && ntohs(address->start_address) == 7999) {
             ++start_address_8000_counter;
             if (start_address_8000_counter % 2 == 1) {
-                return -2;
+                *res_len = 0;
+                return use_len;
             }
         }
 
         if (simulate_error && ntohs(address->start_address) == 8004) {
             ++start_address_8001_counter;
             if (start_address_8001_counter % 3 != 0) {
-                return -2;
+                *res_len = 0;
+                return use_len;
             }
         }
 
         if (simulate_error && ntohs(address->start_address) == 8999) {
             res_code->function += 0x80;
-            len              = modbus_read(&rtu_registers[code->slave_id - 1],
-                              res_code->function, address, res_value);
-            res_data->n_byte = len;
-            crc              = (uint16_t *) (res_value + len);
+            res_data->n_byte = 0;
+            crc              = (uint16_t *) res_value;
             break;
         }
 
-        len = modbus_read(&rtu_registers[code->slave_id - 1], code->function,
-                          address, res_value);
+        len = modbus_read(slave, code->function, address, res_value);
         *res_len += sizeof(struct modbus_data);
         *res_len += len;
 
@@ -168,18 +325,16 @@ ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     case MODBUS_WRITE_M_COIL:
     case MODBUS_WRITE_S_HOLD_REG:
     case MODBUS_WRITE_M_HOLD_REG:
-        modbus_write(&rtu_registers[code->slave_id - 1], code->function,
-                     address, data, value);
+        modbus_write(slave, code->function, address, data, value);
         *res_address = *address;
 
         *res_len += sizeof(struct modbus_address);
 
         crc = (uint16_t *) &res_address[1];
         break;
-    default:
-        return -1;
     }
 
+crc:
     *crc = 0x1001;
     *res_len += 2;
 
@@ -196,6 +351,9 @@ ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     struct modbus_address *address = (struct modbus_address *) &code[1];
     struct modbus_data *   data    = (struct modbus_data *) &address[1];
     uint8_t *              value   = (uint8_t *) &data[1];
+    struct modbus_slave *  slave   = NULL;
+    uint16_t               pdu_len = 0;
+    uint8_t                except  = 0;
     int                    len     = 0;
 
     struct modbus_header * res_header  = (struct modbus_header *) res;
@@ -207,19 +365,31 @@ ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     static int start_address_8000_counter = 0;
     static int start_address_8001_counter = 0;
 
+    *res_len = 0;
+
     if (req_len < sizeof(struct modbus_header)) {
         return 0;
     }
 
-    if (req_len < sizeof(struct modbus_header) + ntohs(header->len)) {
+    pdu_len = ntohs(header->len);
+    if (header->protocol != 0x0000 || pdu_len > TCP_REQ_LEN_MAX ||
+        pdu_len < sizeof(struct modbus_code) + sizeof(struct modbus_address)) {
+        return -1;
+    }
+
+    if (req_len < sizeof(struct modbus_header) + pdu_len) {
         return 0;
     }
 
-    if (header->protocol != 0x0000) {
+    if ((code->function == MODBUS_WRITE_M_HOLD_REG ||
+         code->function == MODBUS_WRITE_M_COIL) &&
+        pdu_len < sizeof(struct modbus_code) + sizeof(struct modbus_address) +
+                sizeof(struct modbus_data) + data->n_byte) {
         return -1;
     }
 
-    if (code->slave_id != 1 && code->slave_id != 2 && code->slave_id != 3) {
+    slave = find_slave(code->slave_id);
+    if (slave == NULL) {
         return -1;
     }
 
@@ -227,40 +397,51 @@ ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     *res_len        = sizeof(struct modbus_header) + sizeof(struct modbus_code);
     res_header->len = sizeof(struct modbus_code);
 
+    except = request_exception(code, address, data,
+                               res_mlen - *res_len -
+                                   (int) sizeof(struct modbus_data));
+    if (except != 0) {
+        res_code->function |= 0x80;
+        res_data->n_byte = except;
+        *res_len += sizeof(struct modbus_data);
+        res_header->len += sizeof(struct modbus_data);
+        res_header->len = htons(res_header->len);
+        return sizeof(struct modbus_header) + pdu_len;
+    }
+
     switch (code->function) {
     case MODBUS_READ_COIL:
     case MODBUS_READ_INPUT:
     case MODBUS_READ_HOLD_REG:
     case MODBUS_READ_INPUT_REG:
-        nlog_info("read register: slave: %d, function: %d, address: %d, n "
-                  "register: %d\n",
-                  code->slave_id, code->function, ntohs(address->start_address),
-                  ntohs(address->n_reg));
+        nlog_debug("read register: slave: %d, function: %d, address: %d, n "
+                   "register: %d",
+                   code->slave_id, code->function,
+                   ntohs(address->start_address), ntohs(address->n_reg));
 
         if (simulate_error && ntohs(address->start_address) == 7999) {
             ++start_address_8000_counter;
             if (start_address_8000_counter % 2 == 1) {
-                return -2;
+                *res_len = 0;
+                return sizeof(struct modbus_header) + pdu_len;
             }
         }
 
         if (simulate_error && ntohs(address->start_address) == 8004) {
             ++start_address_8001_counter;
             if (start_address_8001_counter % 3 != 0) {
-                return -2;
+                *res_len = 0;
+                return sizeof(struct modbus_header) + pdu_len;
             }
         }
 
         if (simulate_error && ntohs(address->start_address) == 8999) {
             res_code->function += 0x80;
-            len              = modbus_read(&tcp_registers[code->slave_id - 1],
-                              res_code->function, address, res_value);
-            res_data->n_byte = len;
+            res_data->n_byte = 0;
             break;
         }
 
-        len = modbus_read(&tcp_registers[code->slave_id - 1], code->function,
-                          address, res_value);
+        len = modbus_read(slave, code->function, address, res_value);
         *res_len += sizeof(struct modbus_data);
         *res_len += len;
 
@@ -275,15 +456,14 @@ ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
     case MODBUS_WRITE_M_COIL:
     case MODBUS_WRITE_S_HOLD_REG:
     case MODBUS_WRITE_M_HOLD_REG:
-        nlog_info(
+        nlog_debug(
             "write register: slave: %d, function: %d, address: %d, n: %d, "
-            "nbyte: %d\n",
+            "nbyte: %d",
             code->slave_id, code->function, ntohs(address->start_address),
             code->function != MODBUS_WRITE_S_HOLD_REG ? ntohs(address->n_reg)
                                                       : 1,
             code->function != MODBUS_WRITE_S_HOLD_REG ? data->n_byte : 2);
-        modbus_write(&tcp_registers[code->slave_id - 1], code->function,
-                     address, data, value);
+        modbus_write(slave, code->function, address, data, value);
         *res_address = *address;
 
         *res_len += sizeof(struct modbus_address);
@@ -297,133 +477,88 @@ ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
 
     res_header->len = htons(res_header->len);
 
-    return sizeof(struct modbus_header) + ntohs(header->len);
+    return sizeof(struct modbus_header) + pdu_len;
 }
 
-static int modbus_read(struct modbus_register *reg, uint8_t function,
+static int modbus_read(struct modbus_slave *slave, uint8_t function,
                        struct modbus_address *address, uint8_t *value)
 {
-    int len = 0;
+    uint16_t start = ntohs(address->start_address);
+    uint16_t n     = ntohs(address->n_reg);
+    int      len   = 0;
 
-    pthread_mutex_lock(&reg->mutex);
     switch (function) {
     case MODBUS_READ_COIL:
-    case MODBUS_READ_INPUT:
-        len = ntohs(address->n_reg) / 8;
-        if (ntohs(address->n_reg) % 8 != 0) {
+    case MODBUS_READ_INPUT: {
+        uint8_t *bits = function == MODBUS_READ_COIL ? slave->coil
+                                                     : slave->input;
+
+        len = n / 8;
+        if (n % 8 != 0) {
             len += 1;
         }
 
-        memset(value, 0, ntohs(address->n_reg) / 8 + 1);
-        for (int i = 0; i < ntohs(address->n_reg); i++) {
-            if (function == MODBUS_READ_COIL) {
-                value[i / 8] |=
-                    reg->coil[ntohs(address->start_address) + i].value
-                    << (i % 8);
-            } else {
-                value[i / 8] |=
-                    reg->input[ntohs(address->start_address) + i].value
-                    << (i % 8);
-            }
-
-            nlog_info("read coil/input: %d, i: %d\n", value[i / 8], i);
+        memset(value, 0, n / 8 + 1);
+        for (int i = 0; i < n; i++) {
+            value[i / 8] |= bits[start + i] << (i % 8);
         }
 
         break;
+    }
     case MODBUS_READ_HOLD_REG:
     case MODBUS_READ_INPUT_REG: {
-        len = ntohs(address->n_reg) * 2;
+        uint16_t *regs = function == MODBUS_READ_HOLD_REG
+            ? slave->hold_register
+            : slave->input_register;
 
-        uint16_t *byte = (uint16_t *) value;
+        len = n * 2;
+        for (int i = 0; i < n; i++) {
+            uint16_t v = htons(regs[start + i]);
 
-        for (int i = 0; i < ntohs(address->n_reg); i++) {
-            if (function == MODBUS_READ_HOLD_REG) {
-                byte[i] =
-                    htons(reg->hold_register[ntohs(address->start_address) + i]
-                              .value);
-            } else {
-                byte[i] =
-                    htons(reg->input_register[ntohs(address->start_address) + i]
-                              .value);
-            }
-
-            nlog_info("read hold/input register: %X, i:%d\n", byte[i], i);
+            memcpy(value + i * 2, &v, sizeof(v));
         }
 
         break;
     }
-    case MODBUS_READ_COIL_ERR:
-    case MODBUS_READ_INPUT_ERR:
-    case MODBUS_READ_HOLD_REG_ERR:
-    case MODBUS_READ_INPUT_REG_ERR: {
-        len = 0;
-
-        nlog_info("modbus device read err");
-        break;
-    }
-
     default:
         assert(1 != 0);
     }
 
-    pthread_mutex_unlock(&reg->mutex);
     return len;
 }
-static void modbus_write(struct modbus_register *reg, uint8_t function,
+
+static void modbus_write(struct modbus_slave *slave, uint8_t function,
                          struct modbus_address *address,
                          struct modbus_data *data, uint8_t *value)
 {
-    pthread_mutex_lock(&reg->mutex);
+    uint16_t start = ntohs(address->start_address);
+
     switch (function) {
     case MODBUS_WRITE_S_COIL:
-        if (address->n_reg > 0) {
-            reg->coil[ntohs(address->start_address)].value = 1;
-        } else {
-            reg->coil[ntohs(address->start_address)].value = 0;
-        }
+        slave->coil[start] = address->n_reg > 0 ? 1 : 0;
         break;
     case MODBUS_WRITE_M_COIL:
         for (int i = 0; i < ntohs(address->n_reg); i++) {
-            uint8_t x = (value[i / 8] >> (i % 8)) & 0x1;
-
-            nlog_info("write coil byte: %d, %d\n", x, i);
-            if (x > 0) {
-                reg->coil[ntohs(address->start_address) + i].value = 1;
-            } else {
-                reg->coil[ntohs(address->start_address) + i].value = 0;
-            }
+            slave->coil[start + i] = (value[i / 8] >> (i % 8)) & 0x1;
         }
         break;
     case MODBUS_WRITE_S_HOLD_REG:
-        reg->hold_register[ntohs(address->start_address)].value = 0;
-
-        reg->hold_register[ntohs(address->start_address)].value |=
-            *(uint8_t *) &((struct modbus_data *) &address->n_reg)[0] << 8;
-        reg->hold_register[ntohs(address->start_address)].value |=
-            *(uint8_t *) &((struct modbus_data *) &address->n_reg)[1];
+        // the value takes the place of the register number
+        slave->hold_register[start] = ntohs(address->n_reg);
         break;
     case MODBUS_WRITE_M_HOLD_REG:
-        for (int i = 0; i < data->n_byte; i++) {
-            reg->hold_register[ntohs(address->start_address) + i / 2].value = 0;
-        }
-
         for (int i = 0; i < data->n_byte; i++) {
             if (i % 2 == 0) {
-                reg->hold_register[ntohs(address->start_address) + i / 2]
-                    .value |= value[i] << 8;
+                slave->hold_register[start + i / 2] = value[i] << 8;
             } else {
-                reg->hold_register[ntohs(address->start_address) + i / 2]
-                    .value |= value[i];
+                slave->hold_register[start + i / 2] |= value[i];
             }
-            nlog_info("write hold register address: %d, byte: %X\n",
-                      ntohs(address->start_address) + i / 2,
-                      reg->hold_register[ntohs(address->start_address) + i / 2]
-                          .value);
+            nlog_debug("write hold register address: %d, byte: %X",
+                       start + i / 2, slave->hold_register[start + i / 2]);
         }
 
         break;
     default:
         assert(1 != 0);
     }
-    pthread_mutex_unlock(&reg->mutex);
-}
\ No newline at end of file
+}
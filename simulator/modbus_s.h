@@ -23,13 +23,45 @@
 #include <stdint.h>
 #include <stdio.h>
 
-void modbus_s_init();
+#define MODBUS_S_SLAVES_DEFAULT 3
+#define MODBUS_S_SLAVES_MAX 247
+#define MODBUS_S_REGISTERS_MAX 65536
+
+typedef struct {
+    uint16_t n_slave;        // slaves 1 to n_slave
+    uint32_t n_register;     // registers of each area of a slave
+    double   exception_rate; // ratio of requests answered with an exception
+    uint32_t change_rate;    // input values of a slave changed per second
+} modbus_s_config_t;
+
+/**
+ * Initialize the slaves, with 3 slaves of 65536 registers if config is NULL.
+ * Requests beyond the configured registers are answered with the illegal
+ * address exception. None of the functions here is thread safe.
+ *
+ * @return 0 on success, -1 on invalid config or allocation failure.
+ */
+int  modbus_s_init(const modbus_s_config_t *config);
+void modbus_s_fini();
 
 void modbus_s_simulate_error(bool b);
 
+/**
+ * Change input registers and discrete inputs of every slave, round robin
+ * over the addresses at the configured change rate.
+ */
+void modbus_s_change_values(int64_t elapsed_ms);
+
+/**
+ * Handle the request at the start of req.
+ *
+ * @return length of the request consumed, 0 if the request is incomplete, -1
+ *         on a malformed request. *res_len is 0 if the device simulates no
+ *         response.
+ */
 ssize_t modbus_s_rtu_req(uint8_t *req, uint16_t req_len, uint8_t *res,
                          int res_mlen, int *res_len);
 ssize_t modbus_s_tcp_req(uint8_t *req, uint16_t req_len, uint8_t *res,
                          int res_mlen, int *res_len);
 
-#endif
\ No newline at end of file
+#endif
@@ -16,292 +16,667 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <memory.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "neuron.h"
 
 #include "modbus_s.h"
 
+#define BUFFER_SIZE 4096
+#define RESPONSE_SIZE 20000
+#define EPOLL_EVENTS 256
+#define CHANGE_INTERVAL_MS 100
+
 zlog_category_t *neuron           = NULL;
-neu_events_t *   events           = NULL;
-neu_event_io_t * tcp_server_event = NULL;
-neu_conn_t *     conn             = NULL;
 int64_t          global_timestamp = 0;
-bool             exiting          = false;
-
-static void start_listen(void *data, int fd);
-static void stop_listen(void *data, int fd);
-static void connected(void *data, int fd);
-static void disconnected(void *data, int fd);
-static int  new_client(enum neu_event_io_type type, int fd, void *usr_data);
-static int  recv_msg(enum neu_event_io_type type, int fd, void *usr_data);
-static bool mode_tcp = true;
-
-struct client_event {
-    neu_event_io_t *client;
-    int             fd;
-    void *          user_data;
+
+static volatile sig_atomic_t exiting = 0;
+
+struct client {
+    int      fd;
+    uint32_t len;
+    uint8_t  buf[BUFFER_SIZE]; // bytes received and not handled yet
+
+    uint8_t *out; // bytes not accepted by the socket yet
+    uint32_t out_len;
+    uint32_t out_cap;
+    bool     out_watched;
+
+    int64_t  last_due; // keeps the responses of a client in order
+    uint32_t n_pending;
+    bool     closed;
+};
+
+// response delayed by the simulated latency
+struct response {
+    int64_t        due;
+    uint64_t       seq;
+    struct client *client;
+    int            len;
+    uint8_t        data[];
 };
 
-struct client_event c_events[10] = { 0 };
+struct simulator {
+    bool     mode_tcp;
+    uint32_t latency_ms;
+    uint32_t jitter_ms;
+
+    int epfd;
+    int listen_fd;
+
+    // min heap of responses ordered by due time then sequence
+    struct response **heap;
+    size_t            heap_len;
+    size_t            heap_cap;
+    uint64_t          seq;
 
-struct cycle_buf {
-    uint16_t len;
-    uint8_t  buf[4096];
+    uint64_t n_client;
+    uint64_t n_request;
 };
 
-static int add_client(int fd, neu_event_io_t *client, void *user_data)
+static int64_t now_ms()
 {
-    for (uint32_t i = 0; i < sizeof(c_events) / sizeof(struct client_event);
-         i++) {
-        if (c_events[i].fd == 0) {
-            c_events[i].client    = client;
-            c_events[i].fd        = fd;
-            c_events[i].user_data = user_data;
-            return 0;
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sig_handler(int sig)
+{
+    (void) sig;
+    exiting = 1;
+}
+
+static inline bool response_before(struct response *a, struct response *b)
+{
+    return a->due < b->due || (a->due == b->due && a->seq < b->seq);
+}
+
+static int heap_push(struct simulator *sim, struct response *r)
+{
+    size_t i = sim->heap_len;
+
+    if (sim->heap_len == sim->heap_cap) {
+        size_t            cap  = sim->heap_cap > 0 ? sim->heap_cap * 2 : 64;
+        struct response **heap = realloc(sim->heap, cap * sizeof(*heap));
+
+        if (heap == NULL) {
+            return -1;
         }
+        sim->heap     = heap;
+        sim->heap_cap = cap;
+    }
+
+    while (i > 0 && response_before(r, sim->heap[(i - 1) / 2])) {
+        sim->heap[i] = sim->heap[(i - 1) / 2];
+        i            = (i - 1) / 2;
     }
+    sim->heap[i] = r;
+    sim->heap_len += 1;
 
-    return -1;
+    return 0;
 }
 
-static neu_event_io_t *del_client(int fd)
+static struct response *heap_pop(struct simulator *sim)
 {
-    for (uint32_t i = 0; i < sizeof(c_events) / sizeof(struct client_event);
-         i++) {
-        if (c_events[i].fd == fd) {
-            c_events[i].fd = 0;
-            return c_events[i].client;
+    struct response *top  = sim->heap[0];
+    struct response *last = sim->heap[--sim->heap_len];
+    size_t           i    = 0;
+
+    while (2 * i + 1 < sim->heap_len) {
+        size_t c = 2 * i + 1;
+
+        if (c + 1 < sim->heap_len &&
+            response_before(sim->heap[c + 1], sim->heap[c])) {
+            c += 1;
         }
+        if (!response_before(sim->heap[c], last)) {
+            break;
+        }
+        sim->heap[i] = sim->heap[c];
+        i            = c;
+    }
+    if (sim->heap_len > 0) {
+        sim->heap[i] = last;
     }
 
-    return NULL;
+    return top;
 }
 
-static void sig_handler(int sig)
+static void client_free(struct client *client)
 {
-    exiting = true;
-    (void) sig;
-    for (uint32_t i = 0; i < sizeof(c_events) / sizeof(struct client_event);
-         i++) {
-        if (c_events[i].fd > 0) {
-            neu_event_del_io(events, c_events[i].client);
+    free(client->out);
+    free(client);
+}
+
+static void client_close(struct simulator *sim, struct client *client)
+{
+    epoll_ctl(sim->epfd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    nlog_info("close client: fd: %d", client->fd);
+
+    // freed once the pending responses are dropped
+    client->closed = true;
+    if (client->n_pending == 0) {
+        client_free(client);
+    }
+}
+
+static void client_watch_out(struct simulator *sim, struct client *client,
+                             bool out)
+{
+    struct epoll_event ev = {
+        .events   = EPOLLIN | (out ? EPOLLOUT : 0),
+        .data.ptr = client,
+    };
+
+    if (client->out_watched != out) {
+        epoll_ctl(sim->epfd, EPOLL_CTL_MOD, client->fd, &ev);
+        client->out_watched = out;
+    }
+}
+
+// returns -1 if the client is gone
+static int client_flush(struct simulator *sim, struct client *client)
+{
+    uint32_t sent = 0;
+
+    while (sent < client->out_len) {
+        ssize_t n = send(client->fd, client->out + sent,
+                         client->out_len - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
         }
+        sent += n;
     }
 
-    nlog_warn("recv sig: %d\n", sig);
-    neu_conn_destory(conn);
-    neu_event_close(events);
-    exit(0);
+    memmove(client->out, client->out + sent, client->out_len - sent);
+    client->out_len -= sent;
+    client_watch_out(sim, client, client->out_len > 0);
+
+    return 0;
 }
 
-int main(int argc, char *argv[])
+static int client_send(struct simulator *sim, struct client *client,
+                       const uint8_t *data, int len)
 {
-    if (argc != 4) {
-        printf("./modbus_simulator rtu/tcp port ip_v4/ip_v6\n");
-        return -1;
+    if (client->out_len + len > client->out_cap) {
+        uint32_t cap = client->out_cap > 0 ? client->out_cap : BUFFER_SIZE;
+        uint8_t *out = NULL;
+
+        while (client->out_len + len > cap) {
+            cap *= 2;
+        }
+        out = realloc(client->out, cap);
+        if (out == NULL) {
+            return -1;
+        }
+        client->out     = out;
+        client->out_cap = cap;
     }
 
-    if (strncmp(argv[1], "tcp", strlen("tcp")) == 0) {
-        mode_tcp = true;
-    } else if (strncmp(argv[1], "rtu", strlen("rtu")) == 0) {
-        mode_tcp = false;
-    } else {
-        printf("./modbus_simulator rtu/tcp port\n");
-        return -1;
+    memcpy(client->out + client->out_len, data, len);
+    client->out_len += len;
+
+    // the socket is being watched for writability, keep the order
+    if (client->out_len > (uint32_t) len) {
+        return 0;
     }
 
-    int port = atoi(argv[2]);
-    if (port <= 1024) {
-        printf("port <= 1024\n");
-        return -1;
+    return client_flush(sim, client);
+}
+
+static int64_t response_delay(struct simulator *sim)
+{
+    int64_t delay = sim->latency_ms;
+
+    if (sim->jitter_ms > 0) {
+        delay += rand() % (2 * (int64_t) sim->jitter_ms + 1) - sim->jitter_ms;
     }
 
-    bool mode_ipv6 = false;
-    if (strncmp(argv[3], "ip_v6", strlen("ip_v6")) == 0) {
-        mode_ipv6 = true;
-    } else if (strncmp(argv[3], "ip_v4", strlen("ip_v4")) == 0) {
-        mode_ipv6 = false;
-    } else {
-        printf("./modbus_simulator rtu/tcp port ip_v4/ip_v6\n");
-        return -1;
+    return delay > 0 ? delay : 0;
+}
+
+static int respond(struct simulator *sim, struct client *client,
+                   const uint8_t *data, int len)
+{
+    int64_t          due = now_ms() + response_delay(sim);
+    struct response *r   = NULL;
+
+    if (due <= client->last_due) {
+        due = client->last_due;
     }
 
-    zlog_init("./config/dev.conf");
-    neuron = zlog_get_category("neuron");
-    modbus_s_init();
-    modbus_s_simulate_error(true);
-    neu_conn_param_t param = {
-        .log                            = neuron,
-        .type                           = NEU_CONN_TCP_SERVER,
-        .params.tcp_server.ip           = mode_ipv6 ? "::" : "0.0.0.0",
-        .params.tcp_server.port         = (uint16_t) port,
-        .params.tcp_server.timeout      = 0,
-        .params.tcp_server.max_link     = 10,
-        .params.tcp_server.start_listen = start_listen,
-        .params.tcp_server.stop_listen  = stop_listen,
-    };
+    if (due <= now_ms() && client->n_pending == 0) {
+        return client_send(sim, client, data, len);
+    }
 
-    events = neu_event_new();
-    conn   = neu_conn_new(&param, NULL, connected, disconnected);
+    r = malloc(sizeof(*r) + len);
+    if (r == NULL) {
+        return -1;
+    }
 
-    signal(SIGINT, sig_handler);
-    signal(SIGTERM, sig_handler);
-    signal(SIGABRT, sig_handler);
+    r->due    = due;
+    r->seq    = sim->seq++;
+    r->client = client;
+    r->len    = len;
+    memcpy(r->data, data, len);
 
-    while (1) {
-        sleep(10);
+    if (heap_push(sim, r) != 0) {
+        free(r);
+        return -1;
     }
 
+    client->last_due = due;
+    client->n_pending += 1;
+
     return 0;
 }
 
-static void start_listen(void *data, int fd)
+static void send_due_responses(struct simulator *sim, int64_t now)
 {
-    neu_event_io_param_t io_event = {
-        .fd       = fd,
-        .usr_data = data,
-        .cb       = new_client,
-    };
+    while (sim->heap_len > 0 && sim->heap[0]->due <= now) {
+        struct response *r      = heap_pop(sim);
+        struct client *  client = r->client;
+
+        client->n_pending -= 1;
+        if (client->closed) {
+            if (client->n_pending == 0) {
+                client_free(client);
+            }
+        } else if (client_send(sim, client, r->data, r->len) != 0) {
+            client_close(sim, client);
+        }
 
-    tcp_server_event = neu_event_add_io(events, io_event);
-    nlog_info("start listen....\n");
+        free(r);
+    }
 }
 
-static void stop_listen(void *data, int fd)
+// returns -1 if the client is to be closed
+static int handle_requests(struct simulator *sim, struct client *client)
 {
-    (void) data;
-    (void) fd;
+    uint8_t res[RESPONSE_SIZE] = { 0 };
+    int     res_len            = 0;
+    ssize_t used               = 0;
+
+    while (client->len > 0) {
+        if (sim->mode_tcp) {
+            used = modbus_s_tcp_req(client->buf, client->len, res, sizeof(res),
+                                    &res_len);
+        } else {
+            used = modbus_s_rtu_req(client->buf, client->len, res, sizeof(res),
+                                    &res_len);
+        }
 
-    neu_event_del_io(events, tcp_server_event);
-    nlog_info("stop listen....fd: %d\n", fd);
-}
+        if (used < 0) {
+            nlog_warn("recv msg parse fail, close client: %d", client->fd);
+            return -1;
+        }
 
-static void connected(void *data, int fd)
-{
-    (void) data;
-    (void) fd;
-    return;
+        if (used == 0) {
+            // a partial request must fit in the buffer
+            return client->len < sizeof(client->buf) ? 0 : -1;
+        }
+
+        sim->n_request += 1;
+        memmove(client->buf, client->buf + used, client->len - used);
+        client->len -= used;
+
+        if (res_len == 0) {
+            nlog_info("recv modbus address for retry_test, no response");
+            continue;
+        }
+
+        if (respond(sim, client, res, res_len) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
 }
 
-static void disconnected(void *data, int fd)
+static void client_readable(struct simulator *sim, struct client *client)
 {
-    (void) data;
-    (void) fd;
+    while (true) {
+        ssize_t n = recv(client->fd, client->buf + client->len,
+                         sizeof(client->buf) - client->len, 0);
+
+        if (n > 0) {
+            client->len += n;
+            if (handle_requests(sim, client) != 0) {
+                client_close(sim, client);
+                return;
+            }
+            continue;
+        }
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
 
-    return;
+        client_close(sim, client);
+        return;
+    }
 }
 
-static int new_client(enum neu_event_io_type type, int fd, void *usr_data)
+static void accept_clients(struct simulator *sim)
 {
-    switch (type) {
-    case NEU_EVENT_IO_READ: {
-        int client_fd = neu_conn_tcp_server_accept(conn);
-        if (client_fd > 0) {
-            struct cycle_buf *   buf = calloc(1, sizeof(struct cycle_buf));
-            neu_event_io_param_t io  = {
-                .fd       = client_fd,
-                .usr_data = (void *) buf,
-                .cb       = recv_msg,
-            };
-
-            neu_event_io_t *client = neu_event_add_io(events, io);
-
-            add_client(fd, client, buf);
-            nlog_info("accept new client: fd: %d\n", client_fd);
+    while (true) {
+        int                client = accept(sim->listen_fd, NULL, NULL);
+        int                one    = 1;
+        struct client *    c      = NULL;
+        struct epoll_event ev     = { .events = EPOLLIN };
+
+        if (client < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                nlog_warn("accept fail: %s", strerror(errno));
+            }
+            return;
         }
 
-        break;
-    }
+        c = calloc(1, sizeof(*c));
+        if (c == NULL) {
+            close(client);
+            continue;
+        }
 
-    case NEU_EVENT_IO_CLOSED:
-    case NEU_EVENT_IO_HUP: {
-        neu_event_del_io(events, tcp_server_event);
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        c->fd       = client;
+        ev.data.ptr = c;
+        if (epoll_ctl(sim->epfd, EPOLL_CTL_ADD, client, &ev) != 0) {
+            close(client);
+            free(c);
+            continue;
+        }
 
-        free(usr_data);
-        close(fd);
-        break;
-    }
+        sim->n_client += 1;
+        nlog_info("accept new client: fd: %d", client);
     }
-    return 0;
 }
 
-static int recv_msg(enum neu_event_io_type type, int fd, void *usr_data)
+static int listen_on(bool ipv6, uint16_t port)
 {
-    if (exiting) {
-        return 0;
+    int one = 1;
+    int fd  = socket(ipv6 ? AF_INET6 : AF_INET,
+                    SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0) {
+        return -1;
     }
 
-    switch (type) {
-    case NEU_EVENT_IO_READ: {
-        struct cycle_buf *buf        = (struct cycle_buf *) usr_data;
-        ssize_t           len        = 0;
-        uint8_t           res[20000] = { 0 };
-        int               res_len    = 0;
-
-        len = neu_conn_tcp_server_recv(conn, fd, buf->buf + buf->len,
-                                       sizeof(buf->buf) - buf->len);
-        if (len > 0) {
-            buf->len += len;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (ipv6) {
+        struct sockaddr_in6 addr = {
+            .sin6_family = AF_INET6,
+            .sin6_port   = htons(port),
+            .sin6_addr   = in6addr_any,
+        };
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
         }
-        if (mode_tcp) {
-            len = modbus_s_tcp_req(buf->buf, buf->len, res, sizeof(res),
-                                   &res_len);
-        } else {
-            len = modbus_s_rtu_req(buf->buf, buf->len, res, sizeof(res),
-                                   &res_len);
+    } else {
+        struct sockaddr_in addr = {
+            .sin_family      = AF_INET,
+            .sin_port        = htons(port),
+            .sin_addr.s_addr = htonl(INADDR_ANY),
+        };
+        if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void run(struct simulator *sim)
+{
+    struct epoll_event events[EPOLL_EVENTS];
+    int64_t            last_change = now_ms();
+    int64_t            last_stats  = last_change;
+    uint64_t           last_req    = 0;
+
+    while (!exiting) {
+        int64_t now     = now_ms();
+        int     timeout = CHANGE_INTERVAL_MS;
+        int     n       = 0;
+
+        if (sim->heap_len > 0) {
+            int64_t wait = sim->heap[0]->due - now;
+            timeout      = wait < timeout ? (wait > 0 ? (int) wait : 0)
+                                     : timeout;
         }
 
-        neu_msleep(2);
+        n = epoll_wait(sim->epfd, events, EPOLL_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            nlog_error("epoll wait fail: %s", strerror(errno));
+            break;
+        }
 
-        if (len == -1) {
-            neu_event_io_t *io = del_client(fd);
+        for (int i = 0; i < n; i++) {
+            struct client *client = events[i].data.ptr;
 
-            if (io != NULL) {
-                neu_event_del_io(events, io);
+            if (client == NULL) {
+                accept_clients(sim);
+                continue;
             }
 
-            free(usr_data);
-            neu_conn_tcp_server_close_client(conn, fd);
-            printf("recv msg parse fail, close client: %d\n", fd);
-        } else if (len == -2) {
-            if (exiting) {
-                return 0;
+            if ((events[i].events & EPOLLOUT) &&
+                client_flush(sim, client) != 0) {
+                client_close(sim, client);
+                continue;
             }
-            neu_conn_tcp_server_send(conn, fd, NULL, 0);
-            printf("recv modbus adrress for retry_test, continue wait msg\n");
-        } else if (len > 0) {
-            if (exiting) {
-                return 0;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                client_readable(sim, client);
             }
-            memmove(buf->buf, buf->buf + len, buf->len - len);
-            buf->len -= len;
+        }
 
-            neu_conn_tcp_server_send(conn, fd, res, res_len);
-        } else {
-            printf("recv part modbus msg, continue wait msg\n");
+        now = now_ms();
+        send_due_responses(sim, now);
+
+        if (now - last_change >= CHANGE_INTERVAL_MS) {
+            modbus_s_change_values(now - last_change);
+            last_change = now;
         }
 
-        break;
+        if (now - last_stats >= 10000) {
+            nlog_notice("clients: %" PRIu64 ", requests/s: %" PRIu64,
+                        sim->n_client,
+                        (sim->n_request - last_req) * 1000 /
+                            (now - last_stats));
+            last_req   = sim->n_request;
+            last_stats = now;
+        }
     }
-    case NEU_EVENT_IO_CLOSED:
-    case NEU_EVENT_IO_HUP: {
-        neu_event_io_t *io = del_client(fd);
+}
+
+static inline void usage(const char *prog)
+{
+    // clang-format off
+    const char *text =
+    "USAGE:\n"
+    "    %s [OPTIONS] rtu/tcp port ip_v4/ip_v6\n\n"
+    "OPTIONS:\n"
+    "    -s, --slaves N          number of slaves from 1 (default 3, max 247)\n"
+    "    -r, --registers N       registers of each area (default 65536)\n"
+    "    -l, --latency MS        response latency in milliseconds (default 2)\n"
+    "    -j, --jitter MS         uniform response jitter in milliseconds\n"
+    "    -x, --exception-rate R  ratio of requests answered with an\n"
+    "                            exception, from 0 to 1\n"
+    "    -c, --change-rate N     input values of a slave changed per second\n"
+    "    -n, --no-error          disable the errors simulated for tests\n"
+    "    -h, --help              show this help message\n"
+    "\n";
+    // clang-format on
+
+    fprintf(stderr, text, prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct simulator   sim    = { .latency_ms = 2, .listen_fd = -1 };
+    modbus_s_config_t  config = {
+        .n_slave    = MODBUS_S_SLAVES_DEFAULT,
+        .n_register = MODBUS_S_REGISTERS_MAX,
+    };
+    bool               sim_error = true;
+    bool               mode_ipv6 = false;
+    int                port      = 0;
+    struct epoll_event ev        = { .events = EPOLLIN, .data.ptr = NULL };
+
+    struct option long_options[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "slaves", required_argument, NULL, 's' },
+        { "registers", required_argument, NULL, 'r' },
+        { "latency", required_argument, NULL, 'l' },
+        { "jitter", required_argument, NULL, 'j' },
+        { "exception-rate", required_argument, NULL, 'x' },
+        { "change-rate", required_argument, NULL, 'c' },
+        { "no-error", no_argument, NULL, 'n' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    int c            = 0;
+    int option_index = 0;
 
-        if (io != NULL) {
-            neu_event_del_io(events, io);
+    while ((c = getopt_long(argc, argv, "hs:r:l:j:x:c:n", long_options,
+                            &option_index)) != -1) {
+        switch (c) {
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        case 's':
+            config.n_slave = atoi(optarg);
+            break;
+        case 'r':
+            config.n_register = atoi(optarg);
+            break;
+        case 'l':
+            sim.latency_ms = atoi(optarg);
+            break;
+        case 'j':
+            sim.jitter_ms = atoi(optarg);
+            break;
+        case 'x':
+            config.exception_rate = atof(optarg);
+            break;
+        case 'c':
+            config.change_rate = atoi(optarg);
+            break;
+        case 'n':
+            sim_error = false;
+            break;
+        case '?':
+        default:
+            usage(argv[0]);
+            return -1;
         }
+    }
+
+    if (argc - optind != 3) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    if (strncmp(argv[optind], "tcp", strlen("tcp")) == 0) {
+        sim.mode_tcp = true;
+    } else if (strncmp(argv[optind], "rtu", strlen("rtu")) == 0) {
+        sim.mode_tcp = false;
+    } else {
+        usage(argv[0]);
+        return -1;
+    }
+
+    port = atoi(argv[optind + 1]);
+    if (port <= 1024 || port > 65535) {
+        printf("port <= 1024\n");
+        return -1;
+    }
+
+    if (strncmp(argv[optind + 2], "ip_v6", strlen("ip_v6")) == 0) {
+        mode_ipv6 = true;
+    } else if (strncmp(argv[optind + 2], "ip_v4", strlen("ip_v4")) == 0) {
+        mode_ipv6 = false;
+    } else {
+        usage(argv[0]);
+        return -1;
+    }
+
+    zlog_init("./config/dev.conf");
+    neuron = zlog_get_category("neuron");
 
-        free(usr_data);
-        neu_conn_tcp_server_close_client(conn, fd);
-        break;
+    if (modbus_s_init(&config) != 0) {
+        printf("invalid slaves, registers or exception rate\n");
+        return -1;
     }
+    modbus_s_simulate_error(sim_error);
+
+    sim.listen_fd = listen_on(mode_ipv6, (uint16_t) port);
+    sim.epfd      = epoll_create1(EPOLL_CLOEXEC);
+    if (sim.listen_fd < 0 || sim.epfd < 0 ||
+        epoll_ctl(sim.epfd, EPOLL_CTL_ADD, sim.listen_fd, &ev) != 0) {
+        printf("listen on port %d fail: %s\n", port, strerror(errno));
+        modbus_s_fini();
+        return -1;
     }
 
+    signal(SIGINT, sig_handler);
+    signal(SIGTERM, sig_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    nlog_notice("start listen, slaves: %d, registers: %" PRIu32
+                ", latency: %" PRIu32 "ms, jitter: %" PRIu32 "ms",
+                config.n_slave, config.n_register, sim.latency_ms,
+                sim.jitter_ms);
+    run(&sim);
+    nlog_warn("exiting");
+
+    // responses still pending hold the clients
+    while (sim.heap_len > 0) {
+        struct response *r = heap_pop(&sim);
+
+        if (--r->client->n_pending == 0 && r->client->closed) {
+            client_free(r->client);
+        }
+        free(r);
+    }
+    free(sim.heap);
+    close(sim.listen_fd);
+    close(sim.epfd);
+    modbus_s_fini();
+
     return 0;
-}
\ No newline at end of file
+}
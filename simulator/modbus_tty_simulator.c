@@ -79,7 +79,17 @@ static int slave_io_cb(enum neu_event_io_type type, int fd, void *usr_data)
     ret = modbus_s_rtu_req(recv_buf.buf, recv_buf.len, res_buf.buf, BUFFER_SIZE,
                            &res_buf.len);
 
-    if (ret == -2) {
+    if (ret == 0) {
+        return 0;
+    }
+
+    recv_buf.len = 0;
+    if (ret < 0) {
+        nlog_warn("recv msg parse fail");
+        return 0;
+    }
+
+    if (res_buf.len == 0) {
         printf("recv modbus adrress for retry_test, continue wait msg\n");
         return 0;
     }
@@ -92,8 +102,6 @@ static int slave_io_cb(enum neu_event_io_type type, int fd, void *usr_data)
         return -1;
     }
 
-    recv_buf.len = 0;
-
     return 0;
 }
 
@@ -253,7 +261,7 @@ int main(int argc, char *argv[])
 
     zlog_init("./config/dev.conf");
     neuron = zlog_get_category("neuron");
-    modbus_s_init();
+    modbus_s_init(NULL);
     modbus_s_simulate_error(sim);
     neu_conn_param_t param = {
         .log                       = neuron,
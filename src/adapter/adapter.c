@@ -35,7 +35,9 @@
 #include "adapter_internal.h"
 #include "base/msg_internal.h"
 #include "driver/driver_internal.h"
+#include "driver/scan.h"
 #include "errcodes.h"
+#include "json/json.h"
 #include "persist/persist.h"
 #include "plugin.h"
 #include "storage.h"
@@ -43,6 +45,8 @@
 static void *adapter_consumer(void *arg);
 static int   adapter_trans_data(enum neu_event_io_type type, int fd,
                                 void *usr_data);
+static int   adapter_trans_inbox(enum neu_event_io_type type, int fd,
+                                 void *usr_data);
 static int   adapter_loop(enum neu_event_io_type type, int fd, void *usr_data);
 static int   adapter_command(neu_adapter_t *adapter, neu_reqresp_head_t header,
                              void *data);
@@ -80,6 +84,7 @@ static __thread int create_adapter_error = 0;
                     NEU_NODE_RUNNING_STATE_INIT);            \
     REGISTER_METRIC(adapter, NEU_METRIC_LAST_RTT_MS,         \
                     NEU_METRIC_LAST_RTT_MS_MAX);             \
+    REGISTER_METRIC(adapter, NEU_METRIC_RTT_MS, 0);          \
     REGISTER_METRIC(adapter, NEU_METRIC_SEND_BYTES, 0);      \
     REGISTER_METRIC(adapter, NEU_METRIC_RECV_BYTES, 0);      \
     REGISTER_METRIC(adapter, NEU_METRIC_TAGS_TOTAL, 0);      \
@@ -93,7 +98,10 @@ static __thread int create_adapter_error = 0;
                     NEU_NODE_RUNNING_STATE_INIT);                  \
     REGISTER_METRIC(adapter, NEU_METRIC_SEND_MSGS_TOTAL, 0);       \
     REGISTER_METRIC(adapter, NEU_METRIC_SEND_MSG_ERRORS_TOTAL, 0); \
-    REGISTER_METRIC(adapter, NEU_METRIC_RECV_MSGS_TOTAL, 0);
+    REGISTER_METRIC(adapter, NEU_METRIC_RECV_MSGS_TOTAL, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_MSG_QUEUE_DEPTH, 0);       \
+    REGISTER_METRIC(adapter, NEU_METRIC_MSG_QUEUE_DROPS_TOTAL, 0); \
+    REGISTER_METRIC(adapter, NEU_METRIC_MSG_QUEUE_LAST_LATENCY_US, 0);
 
 int neu_adapter_error()
 {
@@ -105,15 +113,110 @@ void neu_adapter_set_error(int error)
     create_adapter_error = error;
 }
 
+static void update_msg_q_metrics(neu_adapter_t *adapter, uint32_t latency_us,
+                                 uint64_t *drops)
+{
+    adapter_msg_q_stats_t stats = { 0 };
+
+    if (NULL == adapter->metrics) {
+        return;
+    }
+
+    adapter_msg_q_stats(adapter->msg_q, &stats);
+    adapter_update_metric(adapter, NEU_METRIC_MSG_QUEUE_DEPTH, stats.depth,
+                          NULL);
+    adapter_update_metric(adapter, NEU_METRIC_MSG_QUEUE_LAST_LATENCY_US,
+                          latency_us, NULL);
+    if (stats.drops != *drops) {
+        adapter_update_metric(adapter, NEU_METRIC_MSG_QUEUE_DROPS_TOTAL,
+                              stats.drops - *drops, NULL);
+        *drops = stats.drops;
+    }
+}
+
+// the app setting may carry "queue_policy", absent means the default
+static int parse_queue_policy(const char *            setting,
+                              adapter_msg_q_policy_e *policy)
+{
+    void *          root = NULL;
+    neu_json_elem_t elem = {
+        .name      = "queue_policy",
+        .t         = NEU_JSON_STR,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+
+    *policy = ADAPTER_MSG_Q_DROP_NEWEST;
+    if (setting == NULL || (root = neu_json_decode_new(setting)) == NULL) {
+        return 0;
+    }
+
+    int rv = neu_json_decode_by_json(root, 1, &elem);
+    if (rv == 0 && elem.v.val_str != NULL) {
+        rv = adapter_msg_q_policy_parse(elem.v.val_str, policy);
+    }
+
+    free(elem.v.val_str);
+    neu_json_decode_free(root);
+    return rv;
+}
+
+// the driver setting may carry "scan_workers" and "scan_policy", absent
+// means the default. More than one worker is only taken by plugins putting
+// groups on lanes, the others read every group on one lane.
+static int parse_scan_setting(const char *setting, bool lanes, int *n_worker,
+                              neu_scan_policy_e *policy)
+{
+    int max_worker = lanes ? NEU_SCAN_WORKERS_MAX : 1;
+    void *          root     = NULL;
+    neu_json_elem_t elems[2] = {
+        {
+            .name      = "scan_workers",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "scan_policy",
+            .t         = NEU_JSON_STR,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+    };
+
+    *n_worker = NEU_SCAN_WORKERS_DEFAULT;
+    *policy   = NEU_SCAN_POLICY_TIMER;
+    if (setting == NULL || (root = neu_json_decode_new(setting)) == NULL) {
+        return 0;
+    }
+
+    int rv = neu_json_decode_by_json(root, NEU_JSON_ELEM_SIZE(elems), elems);
+    if (rv == 0 && elems[0].v.val_int != 0) {
+        if (elems[0].v.val_int < 1 || elems[0].v.val_int > max_worker) {
+            rv = -1;
+        } else {
+            *n_worker = (int) elems[0].v.val_int;
+        }
+    }
+    if (rv == 0 && elems[1].v.val_str != NULL) {
+        rv = neu_scan_policy_parse(elems[1].v.val_str, policy);
+    }
+
+    free(elems[1].v.val_str);
+    neu_json_decode_free(root);
+    return rv;
+}
+
 static void *adapter_consumer(void *arg)
 {
     neu_adapter_t *adapter = (neu_adapter_t *) arg;
+    uint64_t       drops   = 0;
 
     while (1) {
-        neu_msg_t *         msg    = NULL;
-        uint32_t            n      = adapter_msg_q_pop(adapter->msg_q, &msg);
+        neu_msg_t *msg        = NULL;
+        uint32_t   latency_us = 0;
+        uint32_t   n = adapter_msg_q_pop(adapter->msg_q, &msg, &latency_us);
         neu_reqresp_head_t *header = neu_msg_get_header(msg);
 
+        update_msg_q_metrics(adapter, latency_us, &drops);
+
         nlog_debug("adapter(%s) recv msg from: %s %p, type: %s, %u",
                    adapter->name, header->sender, header->ctx,
                    neu_reqresp_type_string(header->type), n);
@@ -138,10 +241,13 @@ static inline zlog_category_t *get_log_category(const char *node)
 
 neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
 {
-    int                  rv      = 0;
-    int                  init_rv = 0;
-    neu_adapter_t *      adapter = NULL;
-    neu_event_io_param_t param   = { 0 };
+    int                    rv       = 0;
+    int                    init_rv  = 0;
+    neu_adapter_t *        adapter  = NULL;
+    neu_event_io_param_t   param    = { 0 };
+    adapter_msg_q_policy_e policy   = ADAPTER_MSG_Q_DROP_NEWEST;
+    int                    n_worker = NEU_SCAN_WORKERS_DEFAULT;
+    neu_scan_policy_e      scan     = NEU_SCAN_POLICY_TIMER;
 
     switch (info->module->type) {
     case NEU_NA_TYPE_DRIVER:
@@ -224,6 +330,7 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
             REGISTER_DRIVER_METRICS(adapter);
         }
         neu_adapter_driver_init((neu_adapter_driver_t *) adapter);
+        adapter->outbox = adapter_msg_outbox_new(adapter->name);
         break;
     case NEU_NA_TYPE_APP: {
         adapter->msg_q = adapter_msg_q_new(adapter->name, 1024);
@@ -247,6 +354,14 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
 
         adapter->trans_data_io = neu_event_add_io(adapter->events, param);
 
+        adapter->inbox = adapter_msg_inbox_new(adapter->name, port, 1024);
+        if (adapter->inbox != NULL) {
+            param.cb = adapter_trans_inbox;
+            param.fd = adapter_msg_inbox_fd(adapter->inbox);
+
+            adapter->inbox_io = neu_event_add_io(adapter->events, param);
+        }
+
         if (adapter->module->display) {
             REGISTER_APP_METRICS(adapter);
         }
@@ -273,6 +388,18 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
         if (adapter->module->intf_funs->setting(adapter->plugin,
                                                 adapter->setting) == 0) {
             adapter->state = NEU_NODE_RUNNING_STATE_READY;
+            if (adapter->msg_q != NULL &&
+                parse_queue_policy(adapter->setting, &policy) == 0) {
+                adapter_msg_q_set_policy(adapter->msg_q, policy);
+            }
+            if (info->module->type == NEU_NA_TYPE_DRIVER &&
+                parse_scan_setting(
+                    adapter->setting,
+                    info->module->intf_funs->driver.group_lane != NULL,
+                    &n_worker, &scan) == 0) {
+                neu_adapter_driver_set_scan((neu_adapter_driver_t *) adapter,
+                                            n_worker, scan);
+            }
         } else {
             free(adapter->setting);
             adapter->setting = NULL;
@@ -299,6 +426,9 @@ neu_adapter_t *neu_adapter_create(neu_adapter_info_t *info, bool load)
             neu_adapter_driver_destroy((neu_adapter_driver_t *) adapter);
         } else {
             neu_event_del_io(adapter->events, adapter->trans_data_io);
+            if (adapter->inbox_io != NULL) {
+                neu_event_del_io(adapter->events, adapter->inbox_io);
+            }
         }
         neu_event_del_io(adapter->events, adapter->control_io);
 
@@ -496,6 +626,11 @@ static int adapter_command(neu_adapter_t *adapter, neu_reqresp_head_t header,
         strcpy(pheader->receiver, cmd->driver);
         break;
     }
+    case NEU_REQ_IMPORT_TAG: {
+        neu_req_import_tag_t *cmd = (neu_req_import_tag_t *) data;
+        strcpy(pheader->receiver, cmd->driver);
+        break;
+    }
     case NEU_REQ_UPDATE_NODE:
     case NEU_REQ_NODE_CTL:
     case NEU_REQ_GET_NODE_STATE:
@@ -576,6 +711,28 @@ static int adapter_response(neu_adapter_t *adapter, neu_reqresp_head_t *header,
     return ret;
 }
 
+// port of an abstract "\0neuron-<port>" address, 0 if it is not one
+static inline uint16_t addr_port(const struct sockaddr_un *addr)
+{
+    static const char prefix[] = "neuron-";
+    const char *      p        = &addr->sun_path[1];
+    uint32_t          port     = 0;
+
+    if (addr->sun_path[0] != '\0' ||
+        memcmp(p, prefix, sizeof(prefix) - 1) != 0) {
+        return 0;
+    }
+
+    for (p += sizeof(prefix) - 1; *p >= '0' && *p <= '9'; p++) {
+        port = port * 10 + (*p - '0');
+        if (port > UINT16_MAX) {
+            return 0;
+        }
+    }
+
+    return (uint16_t) port;
+}
+
 static int adapter_responseto(neu_adapter_t *     adapter,
                               neu_reqresp_head_t *header, void *data,
                               struct sockaddr_un dst)
@@ -589,7 +746,18 @@ static int adapter_responseto(neu_adapter_t *     adapter,
     neu_reqresp_head_t *pheader = neu_msg_get_header(msg);
     strcpy(pheader->sender, adapter->name);
 
-    int ret = neu_send_msg_to(adapter->control_fd, &dst, msg);
+    int ret = NEU_ERR_NODE_NOT_EXIST;
+    if (adapter->outbox != NULL) {
+        ret = adapter_msg_outbox_send(adapter->outbox, addr_port(&dst), msg);
+    }
+    if (ret == NEU_ERR_SUCCESS) {
+        return 0;
+    } else if (ret != NEU_ERR_NODE_NOT_EXIST) {
+        neu_msg_free(msg);
+        return ret;
+    }
+
+    ret = neu_send_msg_to(adapter->control_fd, &dst, msg);
     if (0 != ret) {
         nlog_error("adapter: %s send responseto %s failed, ret: %d, errno: %d",
                    adapter->name, neu_reqresp_type_string(header->type), ret,
@@ -600,6 +768,38 @@ static int adapter_responseto(neu_adapter_t *     adapter,
     return ret;
 }
 
+static void trans_data_push(neu_adapter_t *adapter, neu_msg_t *msg)
+{
+    if (adapter_msg_q_push(adapter->msg_q, msg) < 0) {
+        neu_reqresp_head_t *header = neu_msg_get_header(msg);
+
+        nlog_warn("adapter: %s trans data msg q is full, drop msg",
+                  adapter->name);
+        neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
+        neu_msg_free(msg);
+    }
+}
+
+static int adapter_trans_inbox(enum neu_event_io_type type, int fd,
+                               void *usr_data)
+{
+    neu_adapter_t *adapter = (neu_adapter_t *) usr_data;
+    neu_msg_t *    msg     = NULL;
+
+    if (type != NEU_EVENT_IO_READ) {
+        nlog_warn("adapter: %s recv close, exit loop, fd: %d", adapter->name,
+                  fd);
+        return 0;
+    }
+
+    adapter_msg_inbox_ack(adapter->inbox);
+    while ((msg = adapter_msg_inbox_pop(adapter->inbox)) != NULL) {
+        trans_data_push(adapter, msg);
+    }
+
+    return 0;
+}
+
 static int adapter_trans_data(enum neu_event_io_type type, int fd,
                               void *usr_data)
 {
@@ -633,12 +833,7 @@ static int adapter_trans_data(enum neu_event_io_type type, int fd,
     }
 
     if (header->type == NEU_REQRESP_TRANS_DATA) {
-        if (adapter_msg_q_push(adapter->msg_q, msg) < 0) {
-            nlog_warn("adapter: %s trans data msg q is full, drop msg",
-                      adapter->name);
-            neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
-            neu_msg_free(msg);
-        }
+        trans_data_push(adapter, msg);
         return 0;
     }
 
@@ -677,6 +872,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_req_subscribe_t *cmd = (neu_req_subscribe_t *) &header[1];
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
             neu_adapter_driver_subscribe((neu_adapter_driver_t *) adapter, cmd);
+            free(cmd->params);
         } else {
             adapter->module->intf_funs->request(
                 adapter->plugin, (neu_reqresp_head_t *) header, &header[1]);
@@ -696,7 +892,19 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_msg_free(msg);
         break;
     }
-    case NEU_REQ_UPDATE_SUBSCRIBE_GROUP:
+    case NEU_REQ_UPDATE_SUBSCRIBE_GROUP: {
+        neu_req_subscribe_t *cmd = (neu_req_subscribe_t *) &header[1];
+        if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
+            neu_adapter_driver_update_subscribe(
+                (neu_adapter_driver_t *) adapter, cmd);
+            free(cmd->params);
+        } else {
+            adapter->module->intf_funs->request(
+                adapter->plugin, (neu_reqresp_head_t *) header, &header[1]);
+        }
+        neu_msg_free(msg);
+        break;
+    }
     case NEU_RESP_GET_DRIVER_GROUP:
     case NEU_REQRESP_NODE_DELETED:
     case NEU_RESP_GET_SUB_DRIVER_TAGS:
@@ -708,6 +916,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
     case NEU_RESP_GET_SUBSCRIBE_GROUP:
     case NEU_RESP_ADD_TAG:
     case NEU_RESP_ADD_GTAG:
+    case NEU_RESP_IMPORT_TAG:
     case NEU_RESP_UPDATE_TAG:
     case NEU_RESP_GET_TAG:
     case NEU_RESP_GET_NODE:
@@ -854,7 +1063,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             pthread_mutex_lock(&adapter->metrics->lock);
             neu_metric_entry_t *e = NULL;
             HASH_FIND_STR(adapter->metrics->entries, NEU_METRIC_LAST_RTT_MS, e);
-            resp->rtt = NULL != e ? e->value : 0;
+            resp->rtt = NULL != e ? neu_metric_entry_value(e) : 0;
             pthread_mutex_unlock(&adapter->metrics->lock);
         }
         resp->state  = neu_adapter_get_state(adapter);
@@ -1016,7 +1225,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_resp_error_t   error = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 nlog_notice("del tag node:%s group:%s tag:%s", cmd->driver,
                             cmd->group, cmd->tags[i]);
                 int ret = neu_adapter_driver_del_tag(
@@ -1033,7 +1242,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             error.error = NEU_ERR_GROUP_NOT_ALLOW;
         }
 
-        for (uint16_t i = 0; i < cmd->n_tag; i++) {
+        for (uint32_t i = 0; i < cmd->n_tag; i++) {
             free(cmd->tags[i]);
         }
         free(cmd->tags);
@@ -1048,7 +1257,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         neu_resp_add_tag_t resp = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 int ret = neu_adapter_driver_validate_tag(
                     (neu_adapter_driver_t *) adapter, cmd->group,
                     &cmd->tags[i]);
@@ -1073,7 +1282,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             }
         }
 
-        for (int i = 0; i < resp.index; i++) {
+        for (uint32_t i = 0; i < resp.index; i++) {
             int ret = neu_adapter_driver_add_tag(
                 (neu_adapter_driver_t *) adapter, cmd->group, &cmd->tags[i],
                 NEU_DEFAULT_GROUP_INTERVAL);
@@ -1092,7 +1301,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
                                      resp.index);
         }
 
-        for (uint16_t i = 0; i < cmd->n_tag; i++) {
+        for (uint32_t i = 0; i < cmd->n_tag; i++) {
             neu_tag_fini(&cmd->tags[i]);
         }
         free(cmd->tags);
@@ -1112,7 +1321,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             if (neu_adapter_validate_gtags(adapter, cmd, &resp) == 0 &&
                 neu_adapter_try_add_gtags(adapter, cmd, &resp) == 0 &&
                 neu_adapter_add_gtags(adapter, cmd, &resp) == 0) {
-                for (int i = 0; i < cmd->n_group; i++) {
+                for (uint32_t i = 0; i < cmd->n_group; i++) {
                     adapter_storage_add_tags(cmd->driver, cmd->groups[i].group,
                                              cmd->groups[i].tags,
                                              cmd->groups[i].n_tag);
@@ -1120,7 +1329,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             }
         }
 
-        for (int i = 0; i < cmd->n_group; i++) {
+        for (uint32_t i = 0; i < cmd->n_group; i++) {
             for (int j = 0; j < cmd->groups[i].n_tag; j++) {
                 neu_tag_fini(&cmd->groups[i].tags[j]);
             }
@@ -1133,13 +1342,56 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
         reply(adapter, header, &resp);
         break;
     }
+    case NEU_REQ_IMPORT_TAG: {
+        neu_req_import_tag_t *cmd    = (neu_req_import_tag_t *) &header[1];
+        neu_resp_import_tag_t resp   = { 0 };
+        neu_adapter_driver_t *driver = (neu_adapter_driver_t *) adapter;
+
+        if (adapter->module->type != NEU_NA_TYPE_DRIVER) {
+            resp.error = NEU_ERR_GROUP_NOT_ALLOW;
+        } else {
+            resp.error = neu_adapter_driver_validate_tags(
+                driver, cmd->group, cmd->tags, cmd->n_tag, &resp.index);
+        }
+
+        if (resp.error == 0) {
+            resp.error = neu_adapter_driver_try_add_tag(driver, cmd->group,
+                                                        cmd->tags, cmd->n_tag);
+            if (resp.error == 0) {
+                resp.error = neu_adapter_driver_add_tags(
+                    driver, cmd->group, cmd->tags, cmd->n_tag, cmd->interval,
+                    &resp.index);
+                if (resp.error != 0) {
+                    neu_adapter_driver_try_del_tag(driver, cmd->n_tag);
+                }
+            } else {
+                resp.index = 0;
+            }
+        }
+
+        if (resp.error == 0) {
+            // one transaction for the whole batch
+            adapter_storage_add_tags(cmd->driver, cmd->group, cmd->tags,
+                                     cmd->n_tag);
+        }
+
+        for (uint32_t i = 0; i < cmd->n_tag; i++) {
+            neu_tag_fini(&cmd->tags[i]);
+        }
+        free(cmd->tags);
+
+        neu_msg_exchange(header);
+        header->type = NEU_RESP_IMPORT_TAG;
+        reply(adapter, header, &resp);
+        break;
+    }
     case NEU_REQ_UPDATE_TAG: {
         neu_req_update_tag_t *cmd  = (neu_req_update_tag_t *) &header[1];
         neu_resp_update_tag_t resp = { 0 };
 
         if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
 
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 int ret = neu_adapter_driver_validate_tag(
                     (neu_adapter_driver_t *) adapter, cmd->group,
                     &cmd->tags[i]);
@@ -1165,7 +1417,7 @@ static int adapter_loop(enum neu_event_io_type type, int fd, void *usr_data)
             resp.error = NEU_ERR_GROUP_NOT_ALLOW;
         }
 
-        for (uint16_t i = 0; i < cmd->n_tag; i++) {
+        for (uint32_t i = 0; i < cmd->n_tag; i++) {
             neu_tag_fini(&cmd->tags[i]);
         }
         free(cmd->tags);
@@ -1268,7 +1520,7 @@ int neu_adapter_validate_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
         return NEU_ERR_GROUP_MAX_GROUPS;
     }
 
-    for (int group_index = 0; group_index < cmd->n_group; group_index++) {
+    for (uint32_t group_index = 0; group_index < cmd->n_group; group_index++) {
         neu_gdatatag_t *current_group = &cmd->groups[group_index];
         for (int tag_index = 0; tag_index < current_group->n_tag; tag_index++) {
             int validation_result = neu_adapter_driver_validate_tag(
@@ -1289,13 +1541,13 @@ int neu_adapter_validate_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
 int neu_adapter_try_add_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
                               neu_resp_add_tag_t *resp)
 {
-    for (int group_index = 0; group_index < cmd->n_group; group_index++) {
+    for (uint32_t group_index = 0; group_index < cmd->n_group; group_index++) {
         int add_result = neu_adapter_driver_try_add_tag(
             (neu_adapter_driver_t *) adapter, cmd->groups[group_index].group,
             cmd->groups[group_index].tags, cmd->groups[group_index].n_tag);
         if (add_result != 0) {
-            for (int added_groups_count = 0; added_groups_count < group_index;
-                 added_groups_count++) {
+            for (uint32_t added_groups_count = 0;
+                 added_groups_count < group_index; added_groups_count++) {
                 neu_adapter_driver_try_del_tag(
                     (neu_adapter_driver_t *) adapter,
                     cmd->groups[added_groups_count].n_tag);
@@ -1311,7 +1563,7 @@ int neu_adapter_try_add_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
 int neu_adapter_add_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
                           neu_resp_add_tag_t *resp)
 {
-    for (int group_index = 0; group_index < cmd->n_group; group_index++) {
+    for (uint32_t group_index = 0; group_index < cmd->n_group; group_index++) {
         // ensure group created`
         neu_adapter_driver_add_group((neu_adapter_driver_t *) adapter,
                                      cmd->groups[group_index].group,
@@ -1327,8 +1579,8 @@ int neu_adapter_add_gtags(neu_adapter_t *adapter, neu_req_add_gtag_t *cmd,
                 cmd->groups[group_index].interval);
 
             if (add_tag_result != 0) {
-                for (int added_group_index = 0; added_group_index < group_index;
-                     added_group_index++) {
+                for (uint32_t added_group_index = 0;
+                     added_group_index < group_index; added_group_index++) {
                     for (int added_tag_index = 0;
                          added_tag_index < cmd->groups[added_group_index].n_tag;
                          added_tag_index++) {
@@ -1380,6 +1632,12 @@ void neu_adapter_destroy(neu_adapter_t *adapter)
         neu_node_metrics_free(adapter->metrics);
     }
 
+    if (adapter->inbox != NULL) {
+        adapter_msg_inbox_free(adapter->inbox);
+    }
+    if (adapter->outbox != NULL) {
+        adapter_msg_outbox_free(adapter->outbox);
+    }
     if (adapter->consumer_tid != 0) {
         pthread_cancel(adapter->consumer_tid);
     }
@@ -1418,6 +1676,10 @@ int neu_adapter_uninit(neu_adapter_t *adapter)
     adapter->module->intf_funs->uninit(adapter->plugin);
 
     neu_event_del_io(adapter->events, adapter->control_io);
+    if (adapter->inbox_io != NULL) {
+        neu_event_del_io(adapter->events, adapter->inbox_io);
+        adapter->inbox_io = NULL;
+    }
 
     if (adapter->module->type == NEU_NA_TYPE_DRIVER) {
         neu_adapter_driver_destroy((neu_adapter_driver_t *) adapter);
@@ -1509,6 +1771,21 @@ int neu_adapter_set_setting(neu_adapter_t *adapter, const char *setting)
     int rv = -1;
 
     const neu_plugin_intf_funs_t *intf_funs;
+    adapter_msg_q_policy_e        policy   = ADAPTER_MSG_Q_DROP_NEWEST;
+    int                           n_worker = NEU_SCAN_WORKERS_DEFAULT;
+    neu_scan_policy_e             scan     = NEU_SCAN_POLICY_TIMER;
+    bool driver = adapter->module->type == NEU_NA_TYPE_DRIVER;
+    bool lanes  = driver && adapter->module->intf_funs->driver.group_lane;
+
+    if (adapter->msg_q != NULL && parse_queue_policy(setting, &policy) != 0) {
+        nlog_warn("adapter: %s invalid queue policy", adapter->name);
+        return NEU_ERR_NODE_SETTING_INVALID;
+    }
+
+    if (driver && parse_scan_setting(setting, lanes, &n_worker, &scan) != 0) {
+        nlog_warn("adapter: %s invalid scan setting", adapter->name);
+        return NEU_ERR_NODE_SETTING_INVALID;
+    }
 
     intf_funs = adapter->module->intf_funs;
     rv        = intf_funs->setting(adapter->plugin, setting);
@@ -1517,6 +1794,13 @@ int neu_adapter_set_setting(neu_adapter_t *adapter, const char *setting)
             free(adapter->setting);
         }
         adapter->setting = strdup(setting);
+        if (adapter->msg_q != NULL) {
+            adapter_msg_q_set_policy(adapter->msg_q, policy);
+        }
+        if (driver) {
+            neu_adapter_driver_set_scan((neu_adapter_driver_t *) adapter,
+                                        n_worker, scan);
+        }
 
         if (adapter->state == NEU_NODE_RUNNING_STATE_INIT) {
             adapter->state = NEU_NODE_RUNNING_STATE_READY;
@@ -1587,6 +1871,26 @@ int neu_adapter_update_group_metric(neu_adapter_t *adapter,
                                    n);
 }
 
+neu_metric_entry_t *neu_adapter_metric_handle(neu_adapter_t *adapter,
+                                              const char *   group_name,
+                                              const char *   name)
+{
+    if (NULL == adapter->metrics) {
+        return NULL;
+    }
+
+    return neu_node_metrics_find(adapter->metrics, group_name, name);
+}
+
+void neu_adapter_update_metric_by_handle(neu_adapter_t *     adapter,
+                                         neu_metric_entry_t *handle,
+                                         uint64_t            n)
+{
+    if (NULL != handle) {
+        neu_node_metrics_update_entry(adapter->metrics, handle, n);
+    }
+}
+
 int neu_adapter_metric_update_group_name(neu_adapter_t *adapter,
                                          const char *   group_name,
                                          const char *   new_group_name)
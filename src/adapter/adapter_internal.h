@@ -27,6 +27,7 @@
 #include "adapter_info.h"
 #include "core/manager.h"
 #include "msg_q.h"
+#include "msg_ring.h"
 
 struct neu_adapter {
     char *name;
@@ -49,6 +50,11 @@ struct neu_adapter {
     adapter_msg_q_t *msg_q;
     pthread_t        consumer_tid;
 
+    // in-process trans data from the drivers, the socket is the fallback
+    adapter_msg_inbox_t * inbox;
+    neu_event_io_t *      inbox_io;
+    adapter_msg_outbox_t *outbox;
+
     uint16_t trans_data_port;
 
     neu_events_t *events;
@@ -110,6 +116,13 @@ int  neu_adapter_register_group_metric(neu_adapter_t *adapter,
 int  neu_adapter_update_group_metric(neu_adapter_t *adapter,
                                      const char *   group_name,
                                      const char *metric_name, uint64_t n);
+// handle of a node metric, or of a group metric if group_name is not NULL
+neu_metric_entry_t *neu_adapter_metric_handle(neu_adapter_t *adapter,
+                                              const char *   group_name,
+                                              const char *   name);
+void neu_adapter_update_metric_by_handle(neu_adapter_t *     adapter,
+                                         neu_metric_entry_t *handle,
+                                         uint64_t            n);
 int  neu_adapter_metric_update_group_name(neu_adapter_t *adapter,
                                           const char *   group_name,
                                           const char *   new_group_name);
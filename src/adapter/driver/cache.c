@@ -16,12 +16,12 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
-
 #include <assert.h>
 #include <math.h>
 #include <pthread.h>
 #include <string.h>
 
+#include "utils/utextend.h"
 #include "utils/uthash.h"
 
 #include "define.h"
@@ -29,104 +29,342 @@
 
 #include "cache.h"
 
-typedef struct {
-    char group[NEU_GROUP_NAME_LEN];
-    char tag[NEU_TAG_NAME_LEN];
-} tkey_t;
+// entries are stored in fixed chunks of pointers that never move, so a
+// handle can be turned into an entry without holding any cache-wide lock
+#define CACHE_CHUNK_BITS 10
+#define CACHE_CHUNK_SIZE (1 << CACHE_CHUNK_BITS)
+#define CACHE_CHUNK_MAX 4096
+#define CACHE_SHARD_NUM 64
 
 struct elem {
-    int64_t timestamp;
-    bool    changed;
+    int64_t  timestamp;
+    bool     changed;
+    bool     used;
+    uint32_t generation;
 
     neu_dvalue_t value;
 
     neu_tag_meta_t metas[NEU_TAG_META_SIZE];
+};
+
+// (group, tag) -> entry index, only touched when tags are added or deleted
+struct index {
+    int32_t idx;
 
-    tkey_t         key;
     UT_hash_handle hh;
+    size_t         klen;
+    char           key[];
 };
 
-struct neu_driver_cache {
+struct shard {
     pthread_mutex_t mtx;
+} __attribute__((aligned(64)));
 
-    struct elem *table;
+struct neu_driver_cache {
+    pthread_rwlock_t rwlock;
+
+    struct index *table;
+    struct elem **chunks[CACHE_CHUNK_MAX];
+    int32_t       n_elem;
+    UT_array *    free_handles;
+
+    struct shard shards[CACHE_SHARD_NUM];
 };
 
-// static void update_tag_error(neu_driver_cache_t *cache, const char *group,
-// const char *tag, int64_t timestamp, int error);
+static inline size_t to_key(char *key, const char *group, const char *tag)
+{
+    size_t g_len = strlen(group);
+    size_t t_len = strlen(tag);
+
+    memcpy(key, group, g_len + 1);
+    memcpy(key + g_len + 1, tag, t_len);
 
-inline static tkey_t to_key(const char *group, const char *tag)
+    return g_len + 1 + t_len;
+}
+
+static inline struct elem *get_elem(neu_driver_cache_t *cache, int32_t idx)
 {
-    tkey_t key = { 0 };
+    return cache->chunks[idx >> CACHE_CHUNK_BITS][idx & (CACHE_CHUNK_SIZE - 1)];
+}
 
-    strcpy(key.group, group);
-    strcpy(key.tag, tag);
+static inline pthread_mutex_t *get_mtx(neu_driver_cache_t *cache, int32_t idx)
+{
+    return &cache->shards[idx % CACHE_SHARD_NUM].mtx;
+}
 
-    return key;
+static inline bool valid_idx(neu_driver_cache_t *cache, int32_t idx)
+{
+    return idx >= 0 && idx < __atomic_load_n(&cache->n_elem, __ATOMIC_ACQUIRE);
+}
+
+static inline void free_value(struct elem *elem)
+{
+    if (elem->value.type == NEU_TYPE_PTR) {
+        if (elem->value.value.ptr.ptr != NULL) {
+            free(elem->value.value.ptr.ptr);
+            elem->value.value.ptr.ptr = NULL;
+        }
+    }
+}
+
+// must be called with the write lock held, returns -1 when the cache is full
+static int32_t alloc_idx(neu_driver_cache_t *cache)
+{
+    int32_t idx = -1;
+
+    if (utarray_len(cache->free_handles) > 0) {
+        idx = *(int32_t *) utarray_back(cache->free_handles);
+        utarray_pop_back(cache->free_handles);
+        return idx;
+    }
+
+    if (cache->n_elem >= CACHE_CHUNK_MAX * CACHE_CHUNK_SIZE) {
+        return -1;
+    }
+
+    idx = cache->n_elem;
+    if (cache->chunks[idx >> CACHE_CHUNK_BITS] == NULL) {
+        cache->chunks[idx >> CACHE_CHUNK_BITS] =
+            calloc(CACHE_CHUNK_SIZE, sizeof(struct elem *));
+    }
+    cache->chunks[idx >> CACHE_CHUNK_BITS][idx & (CACHE_CHUNK_SIZE - 1)] =
+        calloc(1, sizeof(struct elem));
+    // publish the entry before the index becomes reachable
+    __atomic_store_n(&cache->n_elem, idx + 1, __ATOMIC_RELEASE);
+
+    return idx;
+}
+
+// must be called with either lock held
+static inline struct index *find_index(neu_driver_cache_t *cache,
+                                       const char *group, const char *tag)
+{
+    char          key[NEU_GROUP_NAME_LEN + NEU_TAG_NAME_LEN] = { 0 };
+    size_t        klen                                        = 0;
+    struct index *index                                       = NULL;
+
+    if (group == NULL || tag == NULL) {
+        return NULL;
+    }
+
+    klen = to_key(key, group, tag);
+    HASH_FIND(hh, cache->table, key, klen, index);
+
+    return index;
 }
 
 neu_driver_cache_t *neu_driver_cache_new()
 {
     neu_driver_cache_t *cache = calloc(1, sizeof(neu_driver_cache_t));
+    UT_icd              icd   = { sizeof(int32_t), NULL, NULL, NULL };
 
-    pthread_mutex_init(&cache->mtx, NULL);
+    pthread_rwlock_init(&cache->rwlock, NULL);
+    for (int i = 0; i < CACHE_SHARD_NUM; i++) {
+        pthread_mutex_init(&cache->shards[i].mtx, NULL);
+    }
+    utarray_new(cache->free_handles, &icd);
 
     return cache;
 }
 
 void neu_driver_cache_destroy(neu_driver_cache_t *cache)
 {
-    struct elem *elem = NULL;
-    struct elem *tmp  = NULL;
+    struct index *index = NULL;
+    struct index *tmp   = NULL;
 
-    pthread_mutex_lock(&cache->mtx);
-    HASH_ITER(hh, cache->table, elem, tmp)
+    pthread_rwlock_wrlock(&cache->rwlock);
+    HASH_ITER(hh, cache->table, index, tmp)
     {
-        HASH_DEL(cache->table, elem);
-        if (elem->value.type == NEU_TYPE_PTR) {
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-                elem->value.value.ptr.ptr = NULL;
+        HASH_DEL(cache->table, index);
+        free(index);
+    }
+
+    for (int i = 0; i < CACHE_CHUNK_MAX && cache->chunks[i] != NULL; i++) {
+        for (int j = 0; j < CACHE_CHUNK_SIZE; j++) {
+            struct elem *elem = cache->chunks[i][j];
+            if (elem != NULL) {
+                free_value(elem);
+                free(elem);
             }
         }
-        free(elem);
+        free(cache->chunks[i]);
     }
-    pthread_mutex_unlock(&cache->mtx);
+    utarray_free(cache->free_handles);
+    pthread_rwlock_unlock(&cache->rwlock);
 
-    pthread_mutex_destroy(&cache->mtx);
+    pthread_rwlock_destroy(&cache->rwlock);
+    for (int i = 0; i < CACHE_SHARD_NUM; i++) {
+        pthread_mutex_destroy(&cache->shards[i].mtx);
+    }
 
     free(cache);
 }
 
-// void neu_driver_cache_error(neu_driver_cache_t *cache, const char *group,
-// const char *tag, int64_t timestamp, int32_t error)
-//{
-// update_tag_error(cache, group, tag, timestamp, error);
-//}
-
 void neu_driver_cache_add(neu_driver_cache_t *cache, const char *group,
                           const char *tag, neu_dvalue_t value)
 {
-    struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
+    struct index *index = NULL;
 
-    pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
+    pthread_rwlock_wrlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
 
-    if (elem == NULL) {
-        elem = calloc(1, sizeof(struct elem));
+    if (index == NULL) {
+        int32_t idx = alloc_idx(cache);
+        if (idx < 0) {
+            pthread_rwlock_unlock(&cache->rwlock);
+            return;
+        }
 
-        strcpy(elem->key.group, group);
-        strcpy(elem->key.tag, tag);
+        index = calloc(1, sizeof(struct index) + NEU_GROUP_NAME_LEN +
+                           NEU_TAG_NAME_LEN);
+        index->idx  = idx;
+        index->klen = to_key(index->key, group, tag);
 
-        HASH_ADD(hh, cache->table, key, sizeof(tkey_t), elem);
+        HASH_ADD_KEYPTR(hh, cache->table, index->key, index->klen, index);
     }
 
+    struct elem *elem = get_elem(cache, index->idx);
+
+    pthread_mutex_lock(get_mtx(cache, index->idx));
+    free_value(elem);
+    memset(elem->metas, 0, sizeof(elem->metas));
+    elem->used      = true;
     elem->timestamp = 0;
     elem->changed   = false;
     elem->value     = value;
+    pthread_mutex_unlock(get_mtx(cache, index->idx));
+
+    pthread_rwlock_unlock(&cache->rwlock);
+}
+
+neu_driver_cache_handle_t neu_driver_cache_find(neu_driver_cache_t *cache,
+                                                const char *        group,
+                                                const char *        tag)
+{
+    neu_driver_cache_handle_t handle = {
+        .index = NEU_TAG_HANDLE_INVALID_INDEX,
+    };
+    struct index *index = NULL;
+
+    pthread_rwlock_rdlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
+    if (index != NULL) {
+        // the generation only moves under the write lock
+        handle.index      = index->idx;
+        handle.generation = get_elem(cache, index->idx)->generation;
+    }
+    pthread_rwlock_unlock(&cache->rwlock);
+
+    return handle;
+}
+
+static bool value_changed(const neu_dvalue_t *old, const neu_dvalue_t *value)
+{
+    if (old->type != value->type) {
+        return true;
+    }
+
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_BIT:
+    case NEU_TYPE_BOOL:
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_LWORD:
+        return memcmp(&old->value, &value->value, sizeof(value->value)) != 0;
+    case NEU_TYPE_BYTES:
+        return old->value.bytes.length != value->value.bytes.length ||
+            memcmp(old->value.bytes.bytes, value->value.bytes.bytes,
+                   value->value.bytes.length) != 0;
+    case NEU_TYPE_PTR:
+        return old->value.ptr.length != value->value.ptr.length ||
+            memcmp(old->value.ptr.ptr, value->value.ptr.ptr,
+                   value->value.ptr.length) != 0;
+    case NEU_TYPE_FLOAT:
+        if (old->precision == 0) {
+            return old->value.f32 != value->value.f32;
+        }
+        return fabs(old->value.f32 - value->value.f32) >
+            pow(0.1, old->precision);
+    case NEU_TYPE_DOUBLE:
+        if (old->precision == 0) {
+            return old->value.d64 != value->value.d64;
+        }
+        return fabs(old->value.d64 - value->value.d64) >
+            pow(0.1, old->precision);
+    case NEU_TYPE_ERROR:
+        return true;
+    }
+
+    return false;
+}
+
+// must be called with the shard lock held
+static void update_elem(struct elem *elem, int64_t timestamp,
+                        neu_dvalue_t value, neu_tag_meta_t *metas, int n_meta,
+                        bool change)
+{
+    elem->timestamp = timestamp;
+    if (value_changed(&elem->value, &value) || change) {
+        elem->changed = true;
+    }
+
+    if (elem->value.type == NEU_TYPE_PTR && value.type != NEU_TYPE_PTR) {
+        free_value(elem);
+    }
+
+    elem->value.type = value.type;
+    if (elem->value.type == NEU_TYPE_PTR) {
+        elem->value.value.ptr.length = value.value.ptr.length;
+        elem->value.value.ptr.type   = value.value.ptr.type;
+        if (elem->value.value.ptr.ptr != NULL) {
+            free(elem->value.value.ptr.ptr);
+        }
+        elem->value.value.ptr.ptr = calloc(1, value.value.ptr.length);
+        memcpy(elem->value.value.ptr.ptr, value.value.ptr.ptr,
+               value.value.ptr.length);
+    } else {
+        elem->value.value = value.value;
+    }
+
+    memset(elem->metas, 0, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
+    for (int i = 0; i < n_meta && i < NEU_TAG_META_SIZE; i++) {
+        memcpy(&elem->metas[i], &metas[i], sizeof(neu_tag_meta_t));
+    }
+}
+
+int neu_driver_cache_update_by_handle(neu_driver_cache_t *      cache,
+                                      neu_driver_cache_handle_t handle,
+                                      int64_t timestamp, neu_dvalue_t value,
+                                      neu_tag_meta_t *metas, int n_meta,
+                                      bool change)
+{
+    int ret = -1;
+
+    if (!valid_idx(cache, handle.index)) {
+        return ret;
+    }
+
+    struct elem *elem = get_elem(cache, handle.index);
+
+    pthread_mutex_lock(get_mtx(cache, handle.index));
+    if (elem->used && elem->generation == handle.generation) {
+        update_elem(elem, timestamp, value, metas, n_meta, change);
+        ret = 0;
+    }
+    pthread_mutex_unlock(get_mtx(cache, handle.index));
 
-    pthread_mutex_unlock(&cache->mtx);
+    return ret;
 }
 
 void neu_driver_cache_update_change(neu_driver_cache_t *cache,
@@ -135,114 +373,18 @@ void neu_driver_cache_update_change(neu_driver_cache_t *cache,
                                     neu_tag_meta_t *metas, int n_meta,
                                     bool change)
 {
-    struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
-
-    pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
-    if (elem != NULL) {
-        elem->timestamp = timestamp;
-        if (elem->value.type != value.type) {
-            elem->changed = true;
-        } else {
-            switch (value.type) {
-            case NEU_TYPE_INT8:
-            case NEU_TYPE_UINT8:
-            case NEU_TYPE_INT16:
-            case NEU_TYPE_UINT16:
-            case NEU_TYPE_INT32:
-            case NEU_TYPE_UINT32:
-            case NEU_TYPE_INT64:
-            case NEU_TYPE_UINT64:
-            case NEU_TYPE_BIT:
-            case NEU_TYPE_BOOL:
-            case NEU_TYPE_STRING:
-            case NEU_TYPE_TIME:
-            case NEU_TYPE_DATA_AND_TIME:
-            case NEU_TYPE_WORD:
-            case NEU_TYPE_DWORD:
-            case NEU_TYPE_LWORD:
-                if (memcmp(&elem->value.value, &value.value,
-                           sizeof(value.value)) != 0) {
-                    elem->changed = true;
-                }
-                break;
-            case NEU_TYPE_BYTES:
-                if (elem->value.value.bytes.length !=
-                    value.value.bytes.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcpy(elem->value.value.bytes.bytes,
-                               value.value.bytes.bytes,
-                               value.value.bytes.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_PTR: {
-                if (elem->value.value.ptr.length != value.value.ptr.length) {
-                    elem->changed = true;
-                } else {
-                    if (memcmp(elem->value.value.ptr.ptr, value.value.ptr.ptr,
-                               value.value.ptr.length) != 0) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            }
-            case NEU_TYPE_FLOAT:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.f32 != value.value.f32;
-                } else {
-                    if (fabs(elem->value.value.f32 - value.value.f32) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-                break;
-            case NEU_TYPE_DOUBLE:
-                if (elem->value.precision == 0) {
-                    elem->changed = elem->value.value.d64 != value.value.d64;
-                } else {
-                    if (fabs(elem->value.value.d64 - value.value.d64) >
-                        pow(0.1, elem->value.precision)) {
-                        elem->changed = true;
-                    }
-                }
-
-                break;
-            case NEU_TYPE_ERROR:
-                elem->changed = true;
-                break;
-            }
-        }
+    struct index *index = NULL;
 
-        if (change) {
-            elem->changed = true;
-        }
-
-        elem->value.type = value.type;
-        if (elem->value.type == NEU_TYPE_PTR) {
-            elem->value.value.ptr.length = value.value.ptr.length;
-            elem->value.value.ptr.type   = value.value.ptr.type;
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-            }
-            elem->value.value.ptr.ptr = calloc(1, value.value.ptr.length);
-            memcpy(elem->value.value.ptr.ptr, value.value.ptr.ptr,
-                   value.value.ptr.length);
-        } else {
-            elem->value.value = value.value;
-        }
+    pthread_rwlock_rdlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
+    if (index != NULL) {
+        struct elem *elem = get_elem(cache, index->idx);
 
-        memset(elem->metas, 0, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
-        for (int i = 0; i < n_meta; i++) {
-            memcpy(&elem->metas[i], &metas[i], sizeof(neu_tag_meta_t));
-        }
+        pthread_mutex_lock(get_mtx(cache, index->idx));
+        update_elem(elem, timestamp, value, metas, n_meta, change);
+        pthread_mutex_unlock(get_mtx(cache, index->idx));
     }
-
-    pthread_mutex_unlock(&cache->mtx);
+    pthread_rwlock_unlock(&cache->rwlock);
 }
 
 void neu_driver_cache_update(neu_driver_cache_t *cache, const char *group,
@@ -254,85 +396,141 @@ void neu_driver_cache_update(neu_driver_cache_t *cache, const char *group,
                                    n_meta, false);
 }
 
-int neu_driver_cache_meta_get(neu_driver_cache_t *cache, const char *group,
-                              const char *tag, neu_driver_cache_value_t *value,
-                              neu_tag_meta_t *metas, int n_meta)
+// must be called with the shard lock held
+static void copy_elem(struct elem *elem, neu_driver_cache_value_t *value,
+                      neu_tag_meta_t *metas, int n_meta)
 {
-    struct elem *elem = NULL;
-    int          ret  = -1;
-    tkey_t       key  = to_key(group, tag);
-
-    pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
-
-    if (elem != NULL) {
-        value->timestamp       = elem->timestamp;
-        value->value.type      = elem->value.type;
-        value->value.precision = elem->value.precision;
-
-        assert(n_meta <= NEU_TAG_META_SIZE);
-        memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
-
-        switch (elem->value.type) {
-        case NEU_TYPE_INT8:
-        case NEU_TYPE_UINT8:
-        case NEU_TYPE_BIT:
-            value->value.value.u8 = elem->value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_WORD:
-            value->value.value.u16 = elem->value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_DWORD:
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_ERROR:
-            value->value.value.u32 = elem->value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_LWORD:
-            value->value.value.u64 = elem->value.value.u64;
-            break;
-        case NEU_TYPE_BOOL:
-            value->value.value.boolean = elem->value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-        case NEU_TYPE_TIME:
-        case NEU_TYPE_DATA_AND_TIME:
-            memcpy(value->value.value.str, elem->value.value.str,
-                   sizeof(elem->value.value.str));
-            break;
-        case NEU_TYPE_BYTES:
-            value->value.value.bytes.length = elem->value.value.bytes.length;
-            memcpy(value->value.value.bytes.bytes,
-                   elem->value.value.bytes.bytes,
-                   elem->value.value.bytes.length);
-            break;
-        case NEU_TYPE_PTR:
-            value->value.value.ptr.length = elem->value.value.ptr.length;
-            value->value.value.ptr.type   = elem->value.value.ptr.type;
-            value->value.value.ptr.ptr =
-                calloc(1, elem->value.value.ptr.length);
-            memcpy(value->value.value.ptr.ptr, elem->value.value.ptr.ptr,
-                   elem->value.value.ptr.length);
-            break;
-        }
+    value->timestamp       = elem->timestamp;
+    value->value.type      = elem->value.type;
+    value->value.precision = elem->value.precision;
+
+    assert(n_meta <= NEU_TAG_META_SIZE);
+    memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
+
+    switch (elem->value.type) {
+    case NEU_TYPE_INT8:
+    case NEU_TYPE_UINT8:
+    case NEU_TYPE_BIT:
+        value->value.value.u8 = elem->value.value.u8;
+        break;
+    case NEU_TYPE_INT16:
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_WORD:
+        value->value.value.u16 = elem->value.value.u16;
+        break;
+    case NEU_TYPE_INT32:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_ERROR:
+        value->value.value.u32 = elem->value.value.u32;
+        break;
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_LWORD:
+        value->value.value.u64 = elem->value.value.u64;
+        break;
+    case NEU_TYPE_BOOL:
+        value->value.value.boolean = elem->value.value.boolean;
+        break;
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+        memcpy(value->value.value.str, elem->value.value.str,
+               sizeof(elem->value.value.str));
+        break;
+    case NEU_TYPE_BYTES:
+        value->value.value.bytes.length = elem->value.value.bytes.length;
+        memcpy(value->value.value.bytes.bytes, elem->value.value.bytes.bytes,
+               elem->value.value.bytes.length);
+        break;
+    case NEU_TYPE_PTR:
+        value->value.value.ptr.length = elem->value.value.ptr.length;
+        value->value.value.ptr.type   = elem->value.value.ptr.type;
+        value->value.value.ptr.ptr    = calloc(1, elem->value.value.ptr.length);
+        memcpy(value->value.value.ptr.ptr, elem->value.value.ptr.ptr,
+               elem->value.value.ptr.length);
+        break;
+    }
 
-        for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
-            if (strlen(elem->metas[i].name) > 0) {
-                memcpy(&value->metas[i], &elem->metas[i],
-                       sizeof(neu_tag_meta_t));
-            }
+    for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
+        if (strlen(elem->metas[i].name) > 0) {
+            memcpy(&value->metas[i], &elem->metas[i], sizeof(neu_tag_meta_t));
         }
+    }
+}
+
+static int meta_get_by_handle(neu_driver_cache_t *      cache,
+                              neu_driver_cache_handle_t handle,
+                              neu_driver_cache_value_t *value,
+                              neu_tag_meta_t *metas, int n_meta,
+                              bool only_changed)
+{
+    int ret = -1;
+
+    if (!valid_idx(cache, handle.index)) {
+        return ret;
+    }
+
+    struct elem *elem = get_elem(cache, handle.index);
 
+    pthread_mutex_lock(get_mtx(cache, handle.index));
+    if (elem->used && elem->generation == handle.generation &&
+        (!only_changed || elem->changed)) {
+        copy_elem(elem, value, metas, n_meta);
+        if (only_changed && elem->value.type != NEU_TYPE_ERROR) {
+            elem->changed = false;
+        }
         ret = 0;
     }
+    pthread_mutex_unlock(get_mtx(cache, handle.index));
 
-    pthread_mutex_unlock(&cache->mtx);
+    return ret;
+}
+
+static int meta_get_by_index(neu_driver_cache_t *cache, struct index *index,
+                             neu_driver_cache_value_t *value,
+                             neu_tag_meta_t *metas, int n_meta,
+                             bool only_changed)
+{
+    neu_driver_cache_handle_t handle = {
+        .index      = index->idx,
+        .generation = get_elem(cache, index->idx)->generation,
+    };
+
+    return meta_get_by_handle(cache, handle, value, metas, n_meta,
+                              only_changed);
+}
+
+int neu_driver_cache_meta_get_by_handle(neu_driver_cache_t *      cache,
+                                        neu_driver_cache_handle_t handle,
+                                        neu_driver_cache_value_t *value,
+                                        neu_tag_meta_t *metas, int n_meta)
+{
+    return meta_get_by_handle(cache, handle, value, metas, n_meta, false);
+}
+
+int neu_driver_cache_meta_get_changed_by_handle(
+    neu_driver_cache_t *cache, neu_driver_cache_handle_t handle,
+    neu_driver_cache_value_t *value, neu_tag_meta_t *metas, int n_meta)
+{
+    return meta_get_by_handle(cache, handle, value, metas, n_meta, true);
+}
+
+int neu_driver_cache_meta_get(neu_driver_cache_t *cache, const char *group,
+                              const char *tag, neu_driver_cache_value_t *value,
+                              neu_tag_meta_t *metas, int n_meta)
+{
+    struct index *index = NULL;
+    int           ret   = -1;
+
+    pthread_rwlock_rdlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
+    if (index != NULL) {
+        ret = meta_get_by_index(cache, index, value, metas, n_meta, false);
+    }
+    pthread_rwlock_unlock(&cache->rwlock);
 
     return ret;
 }
@@ -342,84 +540,15 @@ int neu_driver_cache_meta_get_changed(neu_driver_cache_t *cache,
                                       neu_driver_cache_value_t *value,
                                       neu_tag_meta_t *metas, int n_meta)
 {
-    struct elem *elem = NULL;
-    int          ret  = -1;
-    tkey_t       key  = to_key(group, tag);
-
-    pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
-
-    if (elem != NULL && elem->changed) {
-        value->timestamp       = elem->timestamp;
-        value->value.type      = elem->value.type;
-        value->value.precision = elem->value.precision;
-
-        assert(n_meta <= NEU_TAG_META_SIZE);
-        memcpy(metas, elem->metas, sizeof(neu_tag_meta_t) * NEU_TAG_META_SIZE);
-
-        switch (elem->value.type) {
-        case NEU_TYPE_INT8:
-        case NEU_TYPE_UINT8:
-        case NEU_TYPE_BIT:
-            value->value.value.u8 = elem->value.value.u8;
-            break;
-        case NEU_TYPE_INT16:
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_WORD:
-            value->value.value.u16 = elem->value.value.u16;
-            break;
-        case NEU_TYPE_INT32:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_ERROR:
-        case NEU_TYPE_DWORD:
-            value->value.value.u32 = elem->value.value.u32;
-            break;
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_LWORD:
-            value->value.value.u64 = elem->value.value.u64;
-            break;
-        case NEU_TYPE_BOOL:
-            value->value.value.boolean = elem->value.value.boolean;
-            break;
-        case NEU_TYPE_STRING:
-        case NEU_TYPE_TIME:
-        case NEU_TYPE_DATA_AND_TIME:
-            memcpy(value->value.value.str, elem->value.value.str,
-                   sizeof(elem->value.value.str));
-            break;
-        case NEU_TYPE_BYTES:
-            value->value.value.bytes.length = elem->value.value.bytes.length;
-            memcpy(value->value.value.bytes.bytes,
-                   elem->value.value.bytes.bytes,
-                   elem->value.value.bytes.length);
-            break;
-        case NEU_TYPE_PTR:
-            value->value.value.ptr.length = elem->value.value.ptr.length;
-            value->value.value.ptr.type   = elem->value.value.ptr.type;
-            value->value.value.ptr.ptr =
-                calloc(1, elem->value.value.ptr.length);
-            memcpy(value->value.value.ptr.ptr, elem->value.value.ptr.ptr,
-                   elem->value.value.ptr.length);
-            break;
-        }
+    struct index *index = NULL;
+    int           ret   = -1;
 
-        for (int i = 0; i < NEU_TAG_META_SIZE; i++) {
-            if (strlen(elem->metas[i].name) > 0) {
-                memcpy(&value->metas[i], &elem->metas[i],
-                       sizeof(neu_tag_meta_t));
-            }
-        }
-
-        if (elem->value.type != NEU_TYPE_ERROR) {
-            elem->changed = false;
-        }
-        ret = 0;
+    pthread_rwlock_rdlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
+    if (index != NULL) {
+        ret = meta_get_by_index(cache, index, value, metas, n_meta, true);
     }
-
-    pthread_mutex_unlock(&cache->mtx);
+    pthread_rwlock_unlock(&cache->rwlock);
 
     return ret;
 }
@@ -427,22 +556,26 @@ int neu_driver_cache_meta_get_changed(neu_driver_cache_t *cache,
 void neu_driver_cache_del(neu_driver_cache_t *cache, const char *group,
                           const char *tag)
 {
-    struct elem *elem = NULL;
-    tkey_t       key  = to_key(group, tag);
-
-    pthread_mutex_lock(&cache->mtx);
-    HASH_FIND(hh, cache->table, &key, sizeof(tkey_t), elem);
-
-    if (elem != NULL) {
-        HASH_DEL(cache->table, elem);
-        if (elem->value.type == NEU_TYPE_PTR) {
-            if (elem->value.value.ptr.ptr != NULL) {
-                free(elem->value.value.ptr.ptr);
-                elem->value.value.ptr.ptr = NULL;
-            }
-        }
-        free(elem);
+    struct index *index = NULL;
+
+    pthread_rwlock_wrlock(&cache->rwlock);
+    index = find_index(cache, group, tag);
+
+    if (index != NULL) {
+        struct elem *elem = get_elem(cache, index->idx);
+
+        HASH_DEL(cache->table, index);
+
+        pthread_mutex_lock(get_mtx(cache, index->idx));
+        free_value(elem);
+        elem->used = false;
+        // handles resolved before the delete must not reach the next tag
+        elem->generation += 1;
+        pthread_mutex_unlock(get_mtx(cache, index->idx));
+
+        utarray_push_back(cache->free_handles, &index->idx);
+        free(index);
     }
 
-    pthread_mutex_unlock(&cache->mtx);
+    pthread_rwlock_unlock(&cache->rwlock);
 }
@@ -22,10 +22,20 @@
 
 #include <stdint.h>
 
+#include "adapter.h"
 #include "type.h"
 
 typedef struct neu_driver_cache neu_driver_cache_t;
 
+/**
+ * A cache handle is the index of a (group, tag) entry plus the generation of
+ * the entry. It is resolved once by neu_driver_cache_find, so the hot path
+ * skips the name lookup and only locks the entry's shard. Deleting the entry
+ * bumps the generation, a stale handle is then rejected even after the index
+ * is reused by another tag.
+ */
+typedef neu_tag_handle_t neu_driver_cache_handle_t;
+
 neu_driver_cache_t *neu_driver_cache_new();
 void                neu_driver_cache_destroy(neu_driver_cache_t *cache);
 
@@ -44,6 +54,16 @@ void neu_driver_cache_update_change(neu_driver_cache_t *cache,
 void neu_driver_cache_del(neu_driver_cache_t *cache, const char *group,
                           const char *tag);
 
+neu_driver_cache_handle_t neu_driver_cache_find(neu_driver_cache_t *cache,
+                                                const char *        group,
+                                                const char *        tag);
+// returns -1 without updating anything if the handle is stale
+int neu_driver_cache_update_by_handle(neu_driver_cache_t *      cache,
+                                      neu_driver_cache_handle_t handle,
+                                      int64_t timestamp, neu_dvalue_t value,
+                                      neu_tag_meta_t *metas, int n_meta,
+                                      bool change);
+
 typedef struct {
     neu_dvalue_t   value;
     int64_t        timestamp;
@@ -57,5 +77,12 @@ int neu_driver_cache_meta_get_changed(neu_driver_cache_t *cache,
                                       const char *group, const char *tag,
                                       neu_driver_cache_value_t *value,
                                       neu_tag_meta_t *metas, int n_meta);
+int neu_driver_cache_meta_get_by_handle(neu_driver_cache_t *      cache,
+                                        neu_driver_cache_handle_t handle,
+                                        neu_driver_cache_value_t *value,
+                                        neu_tag_meta_t *metas, int n_meta);
+int neu_driver_cache_meta_get_changed_by_handle(
+    neu_driver_cache_t *cache, neu_driver_cache_handle_t handle,
+    neu_driver_cache_value_t *value, neu_tag_meta_t *metas, int n_meta);
 
 #endif
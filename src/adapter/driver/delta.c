@@ -0,0 +1,401 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json/json.h"
+#include "utils/log.h"
+#include "utils/uthash.h"
+
+#include "define.h"
+#include "tag.h"
+
+#include "delta.h"
+
+typedef struct {
+    char           name[NEU_TAG_NAME_LEN];
+    double         deadband;
+    UT_hash_handle hh;
+} delta_deadband_t;
+
+typedef struct {
+    bool     reported;
+    uint8_t  type;
+    double   deadband;
+    double   number;  // numeric value for the deadband check
+    uint64_t digest;  // value bits, or hash of a variable length value
+    uint64_t quality; // hash of the metas
+} delta_tag_t;
+
+struct neu_report_delta {
+    int64_t           keyframe; // ms
+    double            deadband;
+    delta_deadband_t *deadbands;
+
+    neu_tag_names_t *names;
+    delta_tag_t *    tags;
+    int64_t          keyframe_ts;
+
+    uint32_t *changed;
+    uint32_t  changed_cap;
+};
+
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static bool value_number(const neu_dvalue_t *value, double *number)
+{
+    switch (value->type) {
+    case NEU_TYPE_INT8:
+        *number = value->value.i8;
+        return true;
+    case NEU_TYPE_UINT8:
+        *number = value->value.u8;
+        return true;
+    case NEU_TYPE_INT16:
+        *number = value->value.i16;
+        return true;
+    case NEU_TYPE_WORD:
+    case NEU_TYPE_UINT16:
+        *number = value->value.u16;
+        return true;
+    case NEU_TYPE_INT32:
+        *number = value->value.i32;
+        return true;
+    case NEU_TYPE_DWORD:
+    case NEU_TYPE_UINT32:
+        *number = value->value.u32;
+        return true;
+    case NEU_TYPE_INT64:
+        *number = (double) value->value.i64;
+        return true;
+    case NEU_TYPE_LWORD:
+    case NEU_TYPE_UINT64:
+        *number = (double) value->value.u64;
+        return true;
+    case NEU_TYPE_FLOAT:
+        *number = value->value.f32;
+        return true;
+    case NEU_TYPE_DOUBLE:
+        *number = value->value.d64;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint64_t value_digest(const neu_dvalue_t *value)
+{
+    switch (value->type) {
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+        return hash_bytes(FNV_OFFSET, value->value.str,
+                          strnlen(value->value.str, NEU_VALUE_SIZE));
+    case NEU_TYPE_BYTES:
+        return hash_bytes(FNV_OFFSET, value->value.bytes.bytes,
+                          value->value.bytes.length);
+    case NEU_TYPE_PTR:
+        return hash_bytes(FNV_OFFSET + value->value.ptr.type,
+                          value->value.ptr.ptr, value->value.ptr.length);
+    default:
+        // neu_tag_values_get zeroes the value before copying the scalar bits
+        return value->value.u64;
+    }
+}
+
+static uint64_t metas_digest(const neu_tag_meta_t *metas, int n_meta)
+{
+    uint64_t hash = FNV_OFFSET;
+
+    for (int i = 0; i < n_meta; i++) {
+        neu_dvalue_t value = metas[i].value;
+
+        hash = hash_bytes(hash, metas[i].name, strlen(metas[i].name));
+        hash = hash_bytes(hash, &value.type, sizeof(value.type));
+        if (value.type == NEU_TYPE_PTR) {
+            hash = hash_bytes(hash, value.value.ptr.ptr,
+                              value.value.ptr.length);
+        } else {
+            hash = hash_bytes(hash, &value.value, sizeof(value.value));
+        }
+    }
+
+    return hash;
+}
+
+static int parse_deadbands(neu_report_delta_t *delta, void *json)
+{
+    neu_json_elem_t elem = {
+        .name      = "deadbands",
+        .t         = NEU_JSON_OBJECT,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+
+    if (neu_json_decode_by_json(json, 1, &elem) != 0) {
+        return -1;
+    }
+    if (elem.v.val_object == NULL) {
+        return 0;
+    }
+
+    int n = neu_json_decode_array_size_by_json(json, "deadbands");
+    for (int i = 0; i < n; i++) {
+        neu_json_elem_t elems[] = {
+            {
+                .name = "name",
+                .t    = NEU_JSON_STR,
+            },
+            {
+                .name = "deadband",
+                .t    = NEU_JSON_DOUBLE,
+            },
+        };
+
+        if (neu_json_decode_array_by_json(json, "deadbands", i,
+                                          NEU_JSON_ELEM_SIZE(elems),
+                                          elems) != 0) {
+            free(elems[0].v.val_str);
+            return -1;
+        }
+
+        delta_deadband_t *find = NULL;
+        HASH_FIND_STR(delta->deadbands, elems[0].v.val_str, find);
+        if (find == NULL) {
+            find = calloc(1, sizeof(delta_deadband_t));
+            strncpy(find->name, elems[0].v.val_str, sizeof(find->name) - 1);
+            HASH_ADD_STR(delta->deadbands, name, find);
+        }
+        find->deadband = fabs(elems[1].v.val_double);
+        free(elems[0].v.val_str);
+    }
+
+    return 0;
+}
+
+neu_report_delta_t *neu_report_delta_new(const char *params)
+{
+    neu_report_delta_t *delta = NULL;
+    void *              root  = NULL;
+    neu_json_elem_t     elem  = {
+        .name      = "delta",
+        .t         = NEU_JSON_OBJECT,
+        .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+    };
+    neu_json_elem_t elems[] = {
+        {
+            .name      = "keyframe",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+        {
+            .name      = "deadband",
+            .t         = NEU_JSON_DOUBLE,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+        },
+    };
+
+    if (params == NULL || (root = neu_json_decode_new(params)) == NULL) {
+        return NULL;
+    }
+
+    if (neu_json_decode_by_json(root, 1, &elem) != 0 ||
+        elem.v.val_object == NULL) {
+        neu_json_decode_free(root);
+        return NULL;
+    }
+
+    if (neu_json_decode_by_json(elem.v.val_object, NEU_JSON_ELEM_SIZE(elems),
+                                elems) != 0 ||
+        elems[0].v.val_int < 0) {
+        nlog_warn("invalid delta report params: %s", params);
+        neu_json_decode_free(root);
+        return NULL;
+    }
+
+    delta           = calloc(1, sizeof(neu_report_delta_t));
+    delta->keyframe = elems[0].v.val_int * 1000;
+    delta->deadband = fabs(elems[1].v.val_double);
+
+    if (parse_deadbands(delta, elem.v.val_object) != 0) {
+        nlog_warn("invalid delta report deadbands: %s", params);
+        neu_report_delta_free(delta);
+        delta = NULL;
+    }
+
+    neu_json_decode_free(root);
+    return delta;
+}
+
+void neu_report_delta_free(neu_report_delta_t *delta)
+{
+    delta_deadband_t *el = NULL, *tmp = NULL;
+
+    if (delta == NULL) {
+        return;
+    }
+
+    HASH_ITER(hh, delta->deadbands, el, tmp)
+    {
+        HASH_DEL(delta->deadbands, el);
+        free(el);
+    }
+
+    neu_tag_names_unref(delta->names);
+    free(delta->tags);
+    free(delta->changed);
+    free(delta);
+}
+
+// the tags of the group changed, the state is rebuilt for the new name table
+static int delta_reset(neu_report_delta_t *delta, neu_tag_names_t *names)
+{
+    uint32_t     n    = neu_tag_names_size(names);
+    delta_tag_t *tags = calloc(n + 1, sizeof(delta_tag_t));
+
+    if (tags == NULL) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        delta_deadband_t *find = NULL;
+
+        HASH_FIND_STR(delta->deadbands, neu_tag_names_get(names, i), find);
+        tags[i].deadband = find != NULL ? find->deadband : delta->deadband;
+    }
+
+    neu_tag_names_unref(delta->names);
+    free(delta->tags);
+    delta->names = neu_tag_names_ref(names);
+    delta->tags  = tags;
+    return 0;
+}
+
+static bool tag_changed(delta_tag_t *tag, const neu_dvalue_t *value,
+                        uint64_t quality, bool keyframe)
+{
+    double   number  = 0;
+    bool     numeric = value_number(value, &number);
+    uint64_t digest  = value_digest(value);
+    bool     changed = keyframe || !tag->reported;
+
+    if (!changed) {
+        if (tag->type != value->type || tag->quality != quality) {
+            changed = true;
+        } else if (tag->digest != digest) {
+            // NaN never compares within the deadband
+            changed = !numeric || tag->deadband <= 0 ||
+                !(fabs(number - tag->number) <= tag->deadband);
+        }
+    }
+
+    if (changed) {
+        tag->reported = true;
+        tag->type     = value->type;
+        tag->number   = number;
+        tag->digest   = digest;
+        tag->quality  = quality;
+    }
+
+    return changed;
+}
+
+neu_tag_values_t *neu_report_delta_filter(neu_report_delta_t *delta,
+                                          neu_tag_values_t *  values,
+                                          int64_t             now)
+{
+    neu_tag_names_t *names    = neu_tag_values_names(values);
+    uint32_t         n_value  = neu_tag_values_size(values);
+    uint32_t         n_change = 0;
+    bool             keyframe = false;
+
+    if (names != delta->names) {
+        if (delta_reset(delta, names) != 0) {
+            return neu_tag_values_ref(values);
+        }
+        keyframe = true;
+    }
+
+    if (delta->keyframe > 0 && now - delta->keyframe_ts >= delta->keyframe) {
+        keyframe = true;
+    }
+    if (keyframe) {
+        delta->keyframe_ts = now;
+    }
+
+    if (n_value > delta->changed_cap) {
+        uint32_t *changed = realloc(delta->changed, n_value * sizeof(uint32_t));
+        if (changed == NULL) {
+            return neu_tag_values_ref(values);
+        }
+        delta->changed     = changed;
+        delta->changed_cap = n_value;
+    }
+
+    for (uint32_t i = 0; i < n_value; i++) {
+        const neu_tag_meta_t *metas  = NULL;
+        neu_dvalue_t          value  = { 0 };
+        int                   n_meta = neu_tag_values_metas(values, i, &metas);
+
+        neu_tag_values_get(values, i, &value);
+        if (tag_changed(&delta->tags[neu_tag_values_index(values, i)], &value,
+                        metas_digest(metas, n_meta), keyframe)) {
+            delta->changed[n_change++] = i;
+        }
+    }
+
+    if (n_change == 0) {
+        return NULL;
+    }
+    if (n_change == n_value) {
+        return neu_tag_values_ref(values);
+    }
+
+    neu_tag_values_t *report = neu_tag_values_new(
+        neu_tag_values_driver(values), neu_tag_values_group(values), names);
+    if (report == NULL) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < n_change; i++) {
+        const neu_tag_meta_t *metas  = NULL;
+        neu_dvalue_t          value  = { 0 };
+        uint32_t              v      = delta->changed[i];
+        int                   n_meta = neu_tag_values_metas(values, v, &metas);
+
+        neu_tag_values_get(values, v, &value);
+        neu_tag_values_push(report, neu_tag_values_index(values, v), &value,
+                            metas, n_meta);
+    }
+
+    return report;
+}
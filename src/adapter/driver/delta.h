@@ -0,0 +1,69 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_DELTA_H_
+#define _NEU_DRIVER_DELTA_H_
+
+#include <stdint.h>
+
+#include "tag_values.h"
+
+/**
+ * Change-only reporting state of one subscription. It is enabled by a
+ * "delta" object in the subscription params:
+ *
+ * {
+ *     "delta": {
+ *         "keyframe": 60,
+ *         "deadband": 0.1,
+ *         "deadbands": [{"name": "tag1", "deadband": 2.5}]
+ *     }
+ * }
+ *
+ * keyframe is the full report period in seconds, 0 only sends a full report
+ * after subscribing or when the tags of the group change. deadband is the
+ * default absolute deadband of the numeric tags, deadbands overrides it per
+ * tag. A tag is reported when its type, error code or metas changed, or when
+ * its value moved away from the last reported value by more than the
+ * deadband.
+ */
+typedef struct neu_report_delta neu_report_delta_t;
+
+/**
+ * @brief Parse the subscription params.
+ *
+ * @return NULL when params do not enable delta reporting.
+ */
+neu_report_delta_t *neu_report_delta_new(const char *params);
+void                neu_report_delta_free(neu_report_delta_t *delta);
+
+/**
+ * @brief Select the values to report to the subscription and record them
+ * as reported.
+ *
+ * @param[in] values the full report of the group.
+ * @param[in] now timestamp in milliseconds.
+ * @return a value set owned by the caller, values itself with one more
+ * reference on a full report, or NULL when nothing changed.
+ */
+neu_tag_values_t *neu_report_delta_filter(neu_report_delta_t *delta,
+                                          neu_tag_values_t *  values,
+                                          int64_t             now);
+
+#endif
@@ -17,11 +17,13 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 #include <assert.h>
+#include <errno.h>
 #include <float.h>
 #include <math.h>
 #include <netinet/in.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #define EPSILON 1e-9
 
@@ -34,42 +36,78 @@
 #include "adapter/storage.h"
 #include "base/group.h"
 #include "cache.h"
+#include "delta.h"
 #include "driver_internal.h"
 #include "errcodes.h"
+#include "scan.h"
 #include "tag.h"
+#include "write_merge.h"
 
 typedef struct to_be_write_tag {
     bool           single;
+    const char *   group;
     neu_datatag_t *tag;
     neu_value_u    value;
     UT_array *     tvs;
     void *         req;
 } to_be_write_tag_t;
 
+// single tag writes handed to the plugin as one write_tags call, the
+// response is fanned out to every request
 typedef struct {
-    char               app[NEU_NODE_NAME_LEN];
-    struct sockaddr_un addr;
+    neu_reqresp_head_t  head;
+    neu_reqresp_head_t *self;
+    UT_array *          reqs;
+
+    UT_hash_handle hh;
+} write_batch_t;
+
+#define WRITE_BATCH_MAX 64
+
+typedef struct {
+    char                app[NEU_NODE_NAME_LEN];
+    struct sockaddr_un  addr;
+    neu_report_delta_t *delta; // NULL reports all the tags every interval
 } sub_app_t;
 
+static void sub_app_dtor(void *elt)
+{
+    neu_report_delta_free(((sub_app_t *) elt)->delta);
+}
+
 typedef struct group {
     char *name;
 
     int64_t         timestamp;
     neu_group_t *   group;
     UT_array *      static_tags;
-    UT_array *      wt_tags;
-    pthread_mutex_t wt_mtx;
 
     neu_event_timer_t *report;
-    neu_event_timer_t *read;
-    neu_event_timer_t *write;
+    neu_scan_job_t *   read;
 
     UT_array *      apps; // sub_app_t array
     pthread_mutex_t apps_mtx;
 
+    // cache handles of the report snapshot tags, resolved again once the
+    // snapshot or the cache entries (cache_epoch) change
+    pthread_mutex_t            report_mtx;
+    neu_group_tags_t *         report_tags;
+    neu_driver_cache_handle_t *report_handles;
+    uint32_t                   report_epoch;
+    uint32_t                   cache_epoch;
+
     neu_plugin_group_t    grp;
     neu_adapter_driver_t *driver;
 
+    // metric handles, resolved once the group metrics are registered
+    neu_metric_entry_t *last_timer_ms;
+    neu_metric_entry_t *timer_ms;
+    neu_metric_entry_t *last_scan_delay_ms;
+    neu_metric_entry_t *scan_overruns_total;
+    neu_metric_entry_t *scan_skipped_total;
+    neu_metric_entry_t *scan_jitter_ms;
+    neu_metric_entry_t *scan_interval_ms;
+
     UT_hash_handle hh;
 } group_t;
 
@@ -77,17 +115,32 @@ struct neu_adapter_driver {
     neu_adapter_t adapter;
 
     neu_driver_cache_t *cache;
-    neu_events_t *      driver_events;
+    // group reads and writes, see scan.h
+    neu_scan_pool_t *scan;
+
+    // metric handles updated on every tag value, NULL if not registered
+    neu_metric_entry_t *tag_reads_total;
+    neu_metric_entry_t *tag_read_errors_total;
 
     size_t        tag_cnt;
     struct group *groups;
+
+    // pending writes of all the groups, handed to the plugin by write_job
+    // on the default lane
+    neu_scan_job_t *write_job;
+    pthread_mutex_t wt_mtx;
+    UT_array *      wt_tags;
+    UT_array *      wt_spare;
+
+    pthread_mutex_t batch_mtx;
+    write_batch_t * batches;
 };
 
 static void report_to_app(neu_adapter_driver_t *driver, group_t *group,
-                          struct sockaddr_un dst);
+                          sub_app_t *app);
 static int  report_callback(void *usr_data);
-static int  read_callback(void *usr_data);
-static int  write_callback(void *usr_data);
+static void read_callback(void *usr_data, const neu_scan_run_t *run);
+static void write_callback(void *usr_data, const neu_scan_run_t *run);
 static void read_group(int64_t timestamp, int64_t timeout,
                        neu_tag_cache_type_e cache_type,
                        neu_driver_cache_t *cache, const char *group,
@@ -96,10 +149,19 @@ static void read_group_paginate(int64_t timestamp, int64_t timeout,
                                 neu_tag_cache_type_e cache_type,
                                 neu_driver_cache_t *cache, const char *group,
                                 UT_array *tags, UT_array *tag_values);
+static void read_report_tag(bool sub, int64_t timestamp, int64_t timeout,
+                            neu_tag_cache_type_e      cache_type,
+                            neu_driver_cache_t *      cache,
+                            neu_driver_cache_handle_t handle,
+                            const neu_datatag_t *tag, uint32_t index,
+                            neu_tag_values_t *values);
 static void read_report_group(bool sub, int64_t timestamp, int64_t timeout,
-                              neu_tag_cache_type_e cache_type,
-                              neu_driver_cache_t *cache, const char *group,
-                              UT_array *tags, UT_array *tag_values);
+                              neu_tag_cache_type_e             cache_type,
+                              neu_driver_cache_t *             cache,
+                              const neu_driver_cache_handle_t *handles,
+                              UT_array *tags, neu_tag_values_t *values);
+static void report_values(neu_adapter_driver_t *driver, UT_array *apps,
+                          neu_tag_values_t *values, bool delta);
 static void update(neu_adapter_t *adapter, const char *group, const char *tag,
                    neu_dvalue_t value);
 static void update_im(neu_adapter_t *adapter, const char *group,
@@ -108,9 +170,15 @@ static void update_im(neu_adapter_t *adapter, const char *group,
 static void update_with_meta(neu_adapter_t *adapter, const char *group,
                              const char *tag, neu_dvalue_t value,
                              neu_tag_meta_t *metas, int n_meta);
+static neu_tag_handle_t resolve_tag(neu_adapter_t *adapter, const char *group,
+                                    const char *tag);
+static int  update_by_handle(neu_adapter_t *adapter, neu_tag_handle_t handle,
+                             neu_dvalue_t value, neu_tag_meta_t *metas,
+                             int n_meta);
 static void write_response(neu_adapter_t *adapter, void *r, neu_error error);
 static group_t *   find_group(neu_adapter_driver_t *driver, const char *name);
-static void        store_write_tag(group_t *group, to_be_write_tag_t *tag);
+static void store_write_tag(neu_adapter_driver_t *driver,
+                            to_be_write_tag_t *   tag);
 static inline void start_group_timer(neu_adapter_driver_t *driver,
                                      group_t *             grp);
 static inline void stop_group_timer(neu_adapter_driver_t *driver, group_t *grp);
@@ -152,10 +220,37 @@ static void format_tag_value(neu_dvalue_t *value)
     value->value.d64 *= negative;
 }
 
+static write_batch_t *take_write_batch(neu_adapter_driver_t *driver,
+                                       neu_reqresp_head_t *  req)
+{
+    write_batch_t *batch = NULL;
+
+    pthread_mutex_lock(&driver->batch_mtx);
+    HASH_FIND_PTR(driver->batches, &req, batch);
+    if (batch != NULL) {
+        HASH_DEL(driver->batches, batch);
+    }
+    pthread_mutex_unlock(&driver->batch_mtx);
+
+    return batch;
+}
+
 static void write_response(neu_adapter_t *adapter, void *r, neu_error error)
 {
     neu_reqresp_head_t *req    = (neu_reqresp_head_t *) r;
     neu_resp_error_t    nerror = { .error = error };
+    write_batch_t *     batch  =
+        take_write_batch((neu_adapter_driver_t *) adapter, req);
+
+    if (batch != NULL) {
+        utarray_foreach(batch->reqs, void **, orig)
+        {
+            write_response(adapter, *orig, error);
+        }
+        utarray_free(batch->reqs);
+        free(batch);
+        return;
+    }
 
     if (NEU_REQ_WRITE_TAG == req->type) {
         neu_req_write_tag_fini((neu_req_write_tag_t *) &req[1]);
@@ -188,9 +283,11 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
     }
 
     if (value.type == NEU_TYPE_ERROR && tag == NULL) {
-        group_t *g = find_group(driver, group);
-        if (g != NULL) {
-            UT_array *tags      = neu_group_get_read_tag(g->group);
+        group_t *         g        = find_group(driver, group);
+        neu_group_tags_t *snapshot =
+            g != NULL ? neu_group_get_read_tags(g->group) : NULL;
+        if (snapshot != NULL) {
+            UT_array *tags      = neu_group_tags_array(snapshot);
             uint64_t  err_count = 0;
 
             utarray_foreach(tags, neu_datatag_t *, t)
@@ -202,18 +299,21 @@ static void update_with_meta(neu_adapter_t *adapter, const char *group,
                                         global_timestamp, value, NULL, 0);
                 ++err_count;
             }
-            update_metric(&driver->adapter, NEU_METRIC_TAG_READS_TOTAL,
-                          err_count, NULL);
-            update_metric(&driver->adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL,
-                          err_count, NULL);
-            utarray_free(tags);
+            neu_adapter_update_metric_by_handle(
+                &driver->adapter, driver->tag_reads_total, err_count);
+            neu_adapter_update_metric_by_handle(
+                &driver->adapter, driver->tag_read_errors_total, err_count);
+            neu_group_tags_unref(snapshot);
         }
     } else {
         neu_driver_cache_update(driver->cache, group, tag, global_timestamp,
                                 value, metas, n_meta);
-        update_metric(&driver->adapter, NEU_METRIC_TAG_READS_TOTAL, 1, NULL);
-        update_metric(&driver->adapter, NEU_METRIC_TAG_READ_ERRORS_TOTAL,
-                      NEU_TYPE_ERROR == value.type, NULL);
+        neu_adapter_update_metric_by_handle(&driver->adapter,
+                                            driver->tag_reads_total, 1);
+        if (NEU_TYPE_ERROR == value.type) {
+            neu_adapter_update_metric_by_handle(
+                &driver->adapter, driver->tag_read_errors_total, 1);
+        }
     }
     nlog_debug(
         "update driver: %s, group: %s, tag: %s, type: %s, timestamp: %" PRId64
@@ -235,21 +335,29 @@ static void update_im(neu_adapter_t *adapter, const char *group,
 
     neu_driver_cache_update_change(driver->cache, group, tag, global_timestamp,
                                    value, metas, n_meta, true);
-    driver->adapter.cb_funs.update_metric(&driver->adapter,
-                                          NEU_METRIC_TAG_READS_TOTAL, 1, NULL);
+    neu_adapter_update_metric_by_handle(&driver->adapter,
+                                        driver->tag_reads_total, 1);
     if (value.type == NEU_TYPE_ERROR) {
         return;
     }
 
-    UT_array *tags = neu_adapter_driver_get_ptag(driver, group, tag);
-    if (tags == NULL) {
+    group_t *         find     = find_group(driver, group);
+    neu_group_tags_t *snapshot = NULL;
+    if (find == NULL) {
         return;
     }
-    neu_datatag_t *first = utarray_front(tags);
 
-    if (first == NULL ||
-        !neu_tag_attribute_test(first, NEU_ATTRIBUTE_SUBSCRIBE)) {
-        utarray_free(tags);
+    snapshot = neu_group_get_read_tags(find->group);
+    if (snapshot == NULL) {
+        return;
+    }
+
+    // read from the shared snapshot, the tag and the names are not copied
+    uint32_t             index = 0;
+    const neu_datatag_t *t     = neu_group_tags_find(snapshot, tag, &index);
+
+    if (t == NULL || !neu_tag_attribute_test(t, NEU_ATTRIBUTE_SUBSCRIBE)) {
+        neu_group_tags_unref(snapshot);
         nlog_debug("update immediately, driver: %s, "
                    "group: %s, tag: %s, type: %s, "
                    "timestamp: %" PRId64,
@@ -264,71 +372,28 @@ static void update_im(neu_adapter_t *adapter, const char *group,
                driver->adapter.name, group, tag, neu_type_string(value.type),
                global_timestamp);
 
-    neu_reqresp_head_t header = {
-        .type = NEU_REQRESP_TRANS_DATA,
-    };
-    neu_reqresp_trans_data_t *data =
-        calloc(1, sizeof(neu_reqresp_trans_data_t));
-
-    data->driver = strdup(driver->adapter.name);
-    data->group  = strdup(group);
-    utarray_new(data->tags, neu_resp_tag_value_meta_icd());
-
-    read_report_group(true, global_timestamp, 0,
-                      neu_adapter_get_tag_cache_type(&driver->adapter),
-                      driver->cache, group, tags, data->tags);
+    neu_tag_values_t *values = neu_tag_values_new(
+        driver->adapter.name, group, neu_group_tags_names(snapshot));
+    if (values == NULL || neu_tag_values_reserve(values, 1) != 0) {
+        neu_tag_values_unref(values);
+        neu_group_tags_unref(snapshot);
+        return;
+    }
 
-    if (utarray_len(data->tags) > 0) {
-        group_t *find = NULL;
-        HASH_FIND_STR(driver->groups, group, find);
-        if (find != NULL) {
-            pthread_mutex_lock(&find->apps_mtx);
-
-            if (utarray_len(find->apps) > 0) {
-                data->ctx = calloc(1, sizeof(neu_reqresp_trans_data_ctx_t));
-                data->ctx->index = utarray_len(find->apps);
-                pthread_mutex_init(&data->ctx->mtx, NULL);
-
-                utarray_foreach(find->apps, sub_app_t *, app)
-                {
-                    if (driver->adapter.cb_funs.responseto(
-                            &driver->adapter, &header, data, app->addr) != 0) {
-                        neu_trans_data_free(data);
-                    }
-                }
-            } else {
-                utarray_foreach(data->tags, neu_resp_tag_value_meta_t *,
-                                tag_value)
-                {
-                    if (tag_value->value.type == NEU_TYPE_PTR) {
-                        free(tag_value->value.value.ptr.ptr);
-                    }
-                }
-                utarray_free(data->tags);
-                free(data->group);
-                free(data->driver);
-            }
+    read_report_tag(true, global_timestamp, 0,
+                    neu_adapter_get_tag_cache_type(&driver->adapter),
+                    driver->cache,
+                    neu_driver_cache_find(driver->cache, group, tag), t, index,
+                    values);
 
-            pthread_mutex_unlock(&find->apps_mtx);
-        } else {
-            utarray_foreach(data->tags, neu_resp_tag_value_meta_t *, tag_value)
-            {
-                if (tag_value->value.type == NEU_TYPE_PTR) {
-                    free(tag_value->value.value.ptr.ptr);
-                }
-            }
-            utarray_free(data->tags);
-            free(data->group);
-            free(data->driver);
-        }
-    } else {
-        utarray_free(data->tags);
-        free(data->group);
-        free(data->driver);
+    if (neu_tag_values_size(values) > 0) {
+        pthread_mutex_lock(&find->apps_mtx);
+        report_values(driver, find->apps, values, false);
+        pthread_mutex_unlock(&find->apps_mtx);
     }
 
-    utarray_free(tags);
-    free(data);
+    neu_tag_values_unref(values);
+    neu_group_tags_unref(snapshot);
 }
 
 static void update(neu_adapter_t *adapter, const char *group, const char *tag,
@@ -337,6 +402,40 @@ static void update(neu_adapter_t *adapter, const char *group, const char *tag,
     update_with_meta(adapter, group, tag, value, NULL, 0);
 }
 
+static neu_tag_handle_t resolve_tag(neu_adapter_t *adapter, const char *group,
+                                    const char *tag)
+{
+    neu_adapter_driver_t *driver = (neu_adapter_driver_t *) adapter;
+
+    return neu_driver_cache_find(driver->cache, group, tag);
+}
+
+static int update_by_handle(neu_adapter_t *adapter, neu_tag_handle_t handle,
+                            neu_dvalue_t value, neu_tag_meta_t *metas,
+                            int n_meta)
+{
+    neu_adapter_driver_t *driver = (neu_adapter_driver_t *) adapter;
+
+    // the tag was deleted after the plugin resolved the handle, the slot may
+    // belong to another tag already
+    if (neu_driver_cache_update_by_handle(driver->cache, handle,
+                                          global_timestamp, value, metas,
+                                          n_meta, false) != 0) {
+        nlog_debug("driver: %s, drop update of stale handle %" PRId32
+                   "/%" PRIu32,
+                   driver->adapter.name, handle.index, handle.generation);
+        return NEU_ERR_TAG_NOT_EXIST;
+    }
+
+    neu_adapter_update_metric_by_handle(&driver->adapter,
+                                        driver->tag_reads_total, 1);
+    if (NEU_TYPE_ERROR == value.type) {
+        neu_adapter_update_metric_by_handle(
+            &driver->adapter, driver->tag_read_errors_total, 1);
+    }
+    return NEU_ERR_SUCCESS;
+}
+
 static void scan_tags_response(neu_adapter_t *adapter, void *r,
                                neu_resp_scan_tags_t *resp_scan)
 {
@@ -368,27 +467,86 @@ neu_adapter_driver_t *neu_adapter_driver_create()
     neu_adapter_driver_t *driver = calloc(1, sizeof(neu_adapter_driver_t));
 
     driver->cache                                     = neu_driver_cache_new();
-    driver->driver_events                             = neu_event_new();
+    driver->scan = neu_scan_pool_new(NEU_SCAN_WORKERS_DEFAULT);
     driver->adapter.cb_funs.driver.update             = update;
     driver->adapter.cb_funs.driver.write_response     = write_response;
     driver->adapter.cb_funs.driver.update_im          = update_im;
     driver->adapter.cb_funs.driver.update_with_meta   = update_with_meta;
+    driver->adapter.cb_funs.driver.resolve_tag        = resolve_tag;
+    driver->adapter.cb_funs.driver.update_by_handle   = update_by_handle;
     driver->adapter.cb_funs.driver.scan_tags_response = scan_tags_response;
     driver->adapter.cb_funs.driver.test_read_tag_response =
         test_read_tag_response;
 
+    UT_icd icd = { sizeof(to_be_write_tag_t), NULL, NULL, NULL };
+
+    pthread_mutex_init(&driver->wt_mtx, NULL);
+    pthread_mutex_init(&driver->batch_mtx, NULL);
+    utarray_new(driver->wt_tags, &icd);
+    utarray_new(driver->wt_spare, &icd);
+
+    driver->write_job =
+        neu_scan_pool_add(driver->scan, NEU_SCAN_LANE_DEFAULT, 0,
+                          NEU_EVENT_TIMER_NOBLOCK, write_callback, driver);
+
     return driver;
 }
 
+static void free_write_tag(to_be_write_tag_t *wtag)
+{
+    if (wtag->single) {
+        neu_tag_free(wtag->tag);
+    } else {
+        utarray_foreach(wtag->tvs, neu_plugin_tag_value_t *, tv)
+        {
+            neu_tag_free(tv->tag);
+        }
+        utarray_free(wtag->tvs);
+    }
+}
+
 void neu_adapter_driver_destroy(neu_adapter_driver_t *driver)
 {
-    neu_event_close(driver->driver_events);
+    write_batch_t *batch = NULL, *tmp = NULL;
+
+    neu_scan_pool_free(driver->scan);
     neu_driver_cache_destroy(driver->cache);
+
+    utarray_foreach(driver->wt_tags, to_be_write_tag_t *, wtag)
+    {
+        free_write_tag(wtag);
+    }
+    utarray_free(driver->wt_tags);
+    utarray_free(driver->wt_spare);
+    pthread_mutex_destroy(&driver->wt_mtx);
+
+    HASH_ITER(hh, driver->batches, batch, tmp)
+    {
+        HASH_DEL(driver->batches, batch);
+        utarray_free(batch->reqs);
+        free(batch);
+    }
+    pthread_mutex_destroy(&driver->batch_mtx);
+}
+
+int neu_adapter_driver_set_scan(neu_adapter_driver_t *driver, int n_worker,
+                                int policy)
+{
+    neu_scan_pool_set_policy(driver->scan, (neu_scan_policy_e) policy);
+    if (neu_scan_pool_workers(driver->scan) == n_worker) {
+        return 0;
+    }
+
+    nlog_notice("driver: %s scan workers: %d", driver->adapter.name, n_worker);
+    return neu_scan_pool_set_workers(driver->scan, n_worker);
 }
 
 int neu_adapter_driver_init(neu_adapter_driver_t *driver)
 {
-    (void) driver;
+    driver->tag_reads_total = neu_adapter_metric_handle(
+        &driver->adapter, NULL, NEU_METRIC_TAG_READS_TOTAL);
+    driver->tag_read_errors_total = neu_adapter_metric_handle(
+        &driver->adapter, NULL, NEU_METRIC_TAG_READ_ERRORS_TOTAL);
 
     return 0;
 }
@@ -410,15 +568,13 @@ int neu_adapter_driver_uninit(neu_adapter_driver_t *driver)
         free(el->name);
         utarray_free(el->grp.tags);
 
-        utarray_foreach(el->wt_tags, to_be_write_tag_t *, tag)
-        {
-            neu_tag_free(tag->tag);
-        }
-
         utarray_free(el->static_tags);
-        utarray_free(el->wt_tags);
         utarray_free(el->apps);
+        neu_group_tags_unref(el->report_tags);
+        free(el->report_handles);
         neu_group_destroy(el->group);
+        pthread_mutex_destroy(&el->apps_mtx);
+        pthread_mutex_destroy(&el->report_mtx);
         free(el);
     }
 
@@ -428,6 +584,9 @@ int neu_adapter_driver_uninit(neu_adapter_driver_t *driver)
 static inline void start_group_timer(neu_adapter_driver_t *driver, group_t *grp)
 {
     uint32_t interval = neu_group_get_interval(grp->group);
+    uint32_t lane     = NEU_SCAN_LANE_DEFAULT;
+
+    const neu_plugin_intf_funs_t *intf_funs = driver->adapter.module->intf_funs;
 
     neu_event_timer_param_t param = {
         .second      = interval / 1000,
@@ -436,9 +595,12 @@ static inline void start_group_timer(neu_adapter_driver_t *driver, group_t *grp)
         .type        = NEU_EVENT_TIMER_NOBLOCK,
     };
 
-    param.type = driver->adapter.module->timer_type;
-    param.cb   = read_callback;
-    grp->read  = neu_event_add_timer(driver->driver_events, param);
+    if (intf_funs->driver.group_lane != NULL) {
+        lane = intf_funs->driver.group_lane(driver->adapter.plugin, &grp->grp);
+    }
+    grp->read = neu_scan_pool_add(driver->scan, lane, interval,
+                                  driver->adapter.module->timer_type,
+                                  read_callback, (void *) grp);
 
     struct timespec t1 = {
         .tv_sec  = 0,
@@ -447,14 +609,8 @@ static inline void start_group_timer(neu_adapter_driver_t *driver, group_t *grp)
     struct timespec t2 = { 0 };
     nanosleep(&t1, &t2);
 
-    param.type  = NEU_EVENT_TIMER_NOBLOCK;
     param.cb    = report_callback;
     grp->report = neu_adapter_add_timer((neu_adapter_t *) driver, param);
-
-    param.second      = 0;
-    param.millisecond = 3;
-    param.cb          = write_callback;
-    grp->write        = neu_event_add_timer(driver->driver_events, param);
 }
 
 void neu_adapter_driver_start_group_timer(neu_adapter_driver_t *driver)
@@ -480,13 +636,9 @@ static inline void stop_group_timer(neu_adapter_driver_t *driver, group_t *grp)
         grp->report = NULL;
     }
     if (grp->read) {
-        neu_event_del_timer(driver->driver_events, grp->read);
+        neu_scan_pool_del(driver->scan, grp->read);
         grp->read = NULL;
     }
-    if (grp->write) {
-        neu_event_del_timer(driver->driver_events, grp->write);
-        grp->write = NULL;
-    }
 }
 
 void neu_adapter_driver_stop_group_timer(neu_adapter_driver_t *driver)
@@ -589,7 +741,12 @@ void neu_adapter_driver_read_group_paginate(neu_adapter_driver_t *driver,
     neu_group_t *                  group = g->group;
     UT_array *                     tags;
 
-    if (cmd->is_error != true && cmd->current_page > 0 && cmd->page_size > 0) {
+    if (cmd->is_error != true && cmd->by_cursor) {
+        tags = neu_group_query_read_tag_cursor(
+            group, cmd->name, cmd->desc, cmd->cursor, cmd->page_size,
+            &resp.next_cursor, &resp.total_count);
+    } else if (cmd->is_error != true && cmd->current_page > 0 &&
+               cmd->page_size > 0) {
         tags = neu_group_query_read_tag_paginate(
             group, cmd->name, cmd->desc, cmd->current_page, cmd->page_size,
             &resp.total_count);
@@ -672,6 +829,7 @@ void neu_adapter_driver_read_group_paginate(neu_adapter_driver_t *driver,
     resp.current_page = cmd->current_page;
     resp.page_size    = cmd->page_size;
     resp.is_error     = cmd->is_error;
+    resp.by_cursor    = cmd->by_cursor;
     cmd->driver       = NULL; // ownership moved
     cmd->group        = NULL; // ownership moved
 
@@ -1105,14 +1263,13 @@ void neu_adapter_driver_write_tags(neu_adapter_driver_t *driver,
     wtag.req               = (void *) req;
     wtag.tvs               = tags;
 
-    store_write_tag(g, &wtag);
+    store_write_tag(driver, &wtag);
 }
 
 void neu_adapter_driver_write_gtags(neu_adapter_driver_t *driver,
                                     neu_reqresp_head_t *  req)
 {
-    neu_req_write_gtags_t *cmd     = (neu_req_write_gtags_t *) &req[1];
-    group_t *              first_g = NULL;
+    neu_req_write_gtags_t *cmd = (neu_req_write_gtags_t *) &req[1];
 
     if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
         driver->adapter.cb_funs.driver.write_response(
@@ -1134,10 +1291,6 @@ void neu_adapter_driver_write_gtags(neu_adapter_driver_t *driver,
                 &driver->adapter, req, NEU_ERR_GROUP_NOT_EXIST);
             return;
         }
-
-        if (first_g == NULL) {
-            first_g = g;
-        }
     }
 
     UT_array *tags = NULL;
@@ -1227,7 +1380,7 @@ void neu_adapter_driver_write_gtags(neu_adapter_driver_t *driver,
     wtag.req               = (void *) req;
     wtag.tvs               = tags;
 
-    store_write_tag(first_g, &wtag);
+    store_write_tag(driver, &wtag);
 }
 
 void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
@@ -1296,10 +1449,11 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
             to_be_write_tag_t wtag = { 0 };
             wtag.single            = true;
             wtag.req               = (void *) req;
+            wtag.group             = cmd->group;
             wtag.value             = cmd->value.value;
             wtag.tag               = neu_tag_dup(tag);
 
-            store_write_tag(g, &wtag);
+            store_write_tag(driver, &wtag);
         }
 
         neu_tag_free(tag);
@@ -1313,8 +1467,7 @@ void neu_adapter_driver_write_tag(neu_adapter_driver_t *driver,
 int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
                                  uint32_t interval)
 {
-    UT_icd   icd     = { sizeof(to_be_write_tag_t), NULL, NULL, NULL };
-    UT_icd   sub_icd = { sizeof(sub_app_t), NULL, NULL, NULL };
+    UT_icd   sub_icd = { sizeof(sub_app_t), NULL, NULL, sub_app_dtor };
     group_t *find    = NULL;
     int      ret     = NEU_ERR_GROUP_EXIST;
 
@@ -1322,10 +1475,9 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
     if (find == NULL) {
         find = calloc(1, sizeof(group_t));
 
-        pthread_mutex_init(&find->wt_mtx, NULL);
         pthread_mutex_init(&find->apps_mtx, NULL);
+        pthread_mutex_init(&find->report_mtx, NULL);
 
-        utarray_new(find->wt_tags, &icd);
         utarray_new(find->apps, &sub_icd);
 
         find->driver         = driver;
@@ -1336,10 +1488,6 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
         neu_group_split_static_tags(find->group, &find->static_tags,
                                     &find->grp.tags);
 
-        if (NEU_NODE_RUNNING_STATE_RUNNING == driver->adapter.state) {
-            start_group_timer(driver, find);
-        }
-
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_TAGS_TOTAL,
                               neu_group_tag_size(find->group));
@@ -1347,10 +1495,41 @@ int neu_adapter_driver_add_group(neu_adapter_driver_t *driver, const char *name,
                               NEU_METRIC_GROUP_LAST_SEND_MSGS, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_TIMER_MS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_TIMER_MS, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_ERROR_CODE, 0);
         REGISTER_GROUP_METRIC(&driver->adapter, find->name,
                               NEU_METRIC_GROUP_LAST_ERROR_TS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_LAST_SCAN_DELAY_MS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_SCAN_OVERRUNS_TOTAL, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_SCAN_SKIPPED_TOTAL, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_SCAN_JITTER_MS, 0);
+        REGISTER_GROUP_METRIC(&driver->adapter, find->name,
+                              NEU_METRIC_GROUP_SCAN_INTERVAL_MS, interval);
+        find->last_timer_ms = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_LAST_TIMER_MS);
+        find->timer_ms = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_TIMER_MS);
+        find->last_scan_delay_ms = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_LAST_SCAN_DELAY_MS);
+        find->scan_overruns_total = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_SCAN_OVERRUNS_TOTAL);
+        find->scan_skipped_total = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_SCAN_SKIPPED_TOTAL);
+        find->scan_jitter_ms = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_SCAN_JITTER_MS);
+        find->scan_interval_ms = neu_adapter_metric_handle(
+            &driver->adapter, find->name, NEU_METRIC_GROUP_SCAN_INTERVAL_MS);
+
+        // the scan workers use the metric handles from the first read on
+        if (NEU_NODE_RUNNING_STATE_RUNNING == driver->adapter.state) {
+            start_group_timer(driver, find);
+        }
 
         HASH_ADD_STR(driver->groups, name, find);
         ret = NEU_ERR_SUCCESS;
@@ -1460,30 +1639,18 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver, const char *name)
             neu_driver_cache_del(driver->cache, name, tag->name);
         }
 
-        utarray_foreach(find->wt_tags, to_be_write_tag_t *, tag)
-        {
-            if (tag->single) {
-                neu_tag_free(tag->tag);
-            } else {
-                utarray_foreach(tag->tvs, neu_plugin_tag_value_t *, tv)
-                {
-                    neu_tag_free(tv->tag);
-                }
-                utarray_free(tag->tvs);
-            }
-        }
-
         driver->tag_cnt -= neu_group_tag_size(find->group);
         driver->adapter.cb_funs.update_metric(
             &driver->adapter, NEU_METRIC_TAGS_TOTAL, driver->tag_cnt, NULL);
 
         utarray_free(find->static_tags);
         utarray_free(find->grp.tags);
-        utarray_free(find->wt_tags);
         utarray_free(find->apps);
+        neu_group_tags_unref(find->report_tags);
+        free(find->report_handles);
         neu_group_destroy(find->group);
-        pthread_mutex_destroy(&find->wt_mtx);
         pthread_mutex_destroy(&find->apps_mtx);
+        pthread_mutex_destroy(&find->report_mtx);
         free(find);
 
         neu_adapter_del_group_metrics(&driver->adapter, name);
@@ -1493,20 +1660,20 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver, const char *name)
     return ret;
 }
 
-uint16_t neu_adapter_driver_group_count(neu_adapter_driver_t *driver)
+uint32_t neu_adapter_driver_group_count(neu_adapter_driver_t *driver)
 {
-    u_int16_t num_groups = 0;
+    uint32_t num_groups = 0;
     if (driver && driver->groups) {
         num_groups = HASH_COUNT(driver->groups);
     }
     return num_groups;
 }
 
-uint16_t neu_adapter_driver_new_group_count(neu_adapter_driver_t *driver,
+uint32_t neu_adapter_driver_new_group_count(neu_adapter_driver_t *driver,
                                             neu_req_add_gtag_t *  cmd)
 {
-    uint16_t new_groups_count = 0;
-    for (int i = 0; i < cmd->n_group; i++) {
+    uint32_t new_groups_count = 0;
+    for (uint32_t i = 0; i < cmd->n_group; i++) {
         group_t *group_in_driver;
         HASH_FIND_STR(driver->groups, cmd->groups[i].group, group_in_driver);
         if (!group_in_driver) {
@@ -1593,11 +1760,8 @@ int neu_adapter_driver_try_del_tag(neu_adapter_driver_t *driver, int n_tag)
     return ret;
 }
 
-int neu_adapter_driver_validate_tag(neu_adapter_driver_t *driver,
-                                    const char *group, neu_datatag_t *tag)
+static int check_tag(const neu_datatag_t *tag)
 {
-    (void) group;
-
     if (strlen(tag->name) >= NEU_TAG_NAME_LEN) {
         return NEU_ERR_TAG_NAME_TOO_LONG;
     }
@@ -1641,8 +1805,21 @@ int neu_adapter_driver_validate_tag(neu_adapter_driver_t *driver,
         return NEU_ERR_TAG_ATTRIBUTE_NOT_SUPPORT;
     }
 
+    return NEU_ERR_SUCCESS;
+}
+
+int neu_adapter_driver_validate_tag(neu_adapter_driver_t *driver,
+                                    const char *group, neu_datatag_t *tag)
+{
+    (void) group;
+
+    int ret = check_tag(tag);
+    if (ret != NEU_ERR_SUCCESS) {
+        return ret;
+    }
+
     if (!neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC)) {
-        int ret = driver->adapter.module->intf_funs->driver.validate_tag(
+        ret = driver->adapter.module->intf_funs->driver.validate_tag(
             driver->adapter.plugin, tag);
         if (ret != NEU_ERR_SUCCESS) {
             return ret;
@@ -1654,6 +1831,119 @@ int neu_adapter_driver_validate_tag(neu_adapter_driver_t *driver,
     return NEU_ERR_SUCCESS;
 }
 
+// validate the run of non static tags with one plugin call if possible
+static int validate_plugin_tags(neu_adapter_driver_t *driver,
+                                neu_datatag_t *tags, uint32_t n_tag,
+                                uint32_t *index)
+{
+    const neu_plugin_intf_funs_t *intf = driver->adapter.module->intf_funs;
+
+    if (intf->driver.validate_tags != NULL) {
+        *index = 0;
+        return intf->driver.validate_tags(driver->adapter.plugin, tags, n_tag,
+                                          index);
+    }
+
+    for (*index = 0; *index < n_tag; *index += 1) {
+        int ret = intf->driver.validate_tag(driver->adapter.plugin,
+                                            &tags[*index]);
+        if (ret != NEU_ERR_SUCCESS) {
+            return ret;
+        }
+    }
+
+    return NEU_ERR_SUCCESS;
+}
+
+int neu_adapter_driver_validate_tags(neu_adapter_driver_t *driver,
+                                     const char *group, neu_datatag_t *tags,
+                                     uint32_t n_tag, uint32_t *index)
+{
+    uint32_t bad = 0;
+    int      ret = NEU_ERR_SUCCESS;
+
+    (void) group;
+
+    for (bad = 0; bad < n_tag; bad++) {
+        ret = check_tag(&tags[bad]);
+        if (ret != NEU_ERR_SUCCESS) {
+            break;
+        }
+    }
+
+    // an earlier plugin error wins over the first generic one
+    for (uint32_t i = 0; i < bad;) {
+        uint32_t end = i, k = 0;
+
+        if (neu_tag_attribute_test(&tags[i], NEU_ATTRIBUTE_STATIC)) {
+            i += 1;
+            continue;
+        }
+
+        while (end < bad &&
+               !neu_tag_attribute_test(&tags[end], NEU_ATTRIBUTE_STATIC)) {
+            end += 1;
+        }
+
+        int rv = validate_plugin_tags(driver, &tags[i], end - i, &k);
+        if (rv != NEU_ERR_SUCCESS) {
+            *index = i + k;
+            return rv;
+        }
+        i = end;
+    }
+
+    *index = bad;
+    if (ret != NEU_ERR_SUCCESS) {
+        return ret;
+    }
+
+    for (uint32_t i = 0; i < n_tag; i++) {
+        neu_datatag_parse_addr_option(&tags[i], &tags[i].option);
+    }
+
+    return NEU_ERR_SUCCESS;
+}
+
+int neu_adapter_driver_add_tags(neu_adapter_driver_t *driver, const char *group,
+                                neu_datatag_t *tags, uint32_t n_tag,
+                                uint32_t interval, uint32_t *index)
+{
+    int      ret     = NEU_ERR_SUCCESS;
+    bool     created = false;
+    group_t *find    = NULL;
+
+    HASH_FIND_STR(driver->groups, group, find);
+    if (find == NULL) {
+        if (neu_adapter_driver_group_count(driver) >= NEU_GROUP_MAX_PER_NODE) {
+            *index = 0;
+            return NEU_ERR_GROUP_MAX_GROUPS;
+        }
+        neu_adapter_driver_add_group(driver, group, interval);
+        adapter_storage_add_group(driver->adapter.name, group, interval);
+        HASH_FIND_STR(driver->groups, group, find);
+        created = true;
+    }
+    assert(find != NULL);
+
+    // one timestamp change, the group is synced once on the next read
+    ret = neu_group_add_tags(find->group, tags, n_tag, index);
+    if (ret != NEU_ERR_SUCCESS && created) {
+        // no tag was added, do not leave the group behind
+        neu_adapter_driver_del_group(driver, group);
+        adapter_storage_del_group(driver->adapter.name, group);
+    } else if (ret == NEU_ERR_SUCCESS) {
+        driver->tag_cnt += n_tag;
+        driver->adapter.cb_funs.update_metric(
+            &driver->adapter, NEU_METRIC_TAGS_TOTAL, driver->tag_cnt, NULL);
+        neu_adapter_update_group_metric(&driver->adapter, group,
+                                        NEU_METRIC_GROUP_TAGS_TOTAL,
+                                        neu_group_tag_size(find->group));
+    }
+
+    return ret;
+}
+
 int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
                                neu_datatag_t *tag, uint16_t interval)
 {
@@ -1814,85 +2104,125 @@ void neu_adapter_driver_get_value_tag(neu_adapter_driver_t *driver,
     }
 }
 
-UT_array *neu_adapter_driver_get_read_tag(neu_adapter_driver_t *driver,
-                                          const char *          group)
+static void report_to_sub(neu_adapter_driver_t *driver, sub_app_t *app,
+                          neu_tag_values_t *values)
 {
-    group_t * find = NULL;
-    UT_array *tags = NULL;
+    neu_reqresp_head_t header = {
+        .type = NEU_REQRESP_TRANS_DATA,
+    };
+    neu_reqresp_trans_data_t data = {
+        .driver = (char *) neu_tag_values_driver(values),
+        .group  = (char *) neu_tag_values_group(values),
+        .values = values,
+    };
 
-    HASH_FIND_STR(driver->groups, group, find);
-    if (find != NULL) {
-        tags = neu_group_get_read_tag(find->group);
+    // the message holds a reference of the snapshot, released by the
+    // consumer with neu_trans_data_free
+    neu_tag_values_ref(values);
+    if (driver->adapter.cb_funs.responseto(&driver->adapter, &header, &data,
+                                           app->addr) != 0) {
+        neu_tag_values_unref(values);
     }
-
-    return tags;
 }
 
-UT_array *neu_adapter_driver_get_ptag(neu_adapter_driver_t *driver,
-                                      const char *group, const char *tag)
+static void report_values(neu_adapter_driver_t *driver, UT_array *apps,
+                          neu_tag_values_t *values, bool delta)
 {
-    group_t * find = NULL;
-    UT_array *tags = NULL;
+    utarray_foreach(apps, sub_app_t *, app)
+    {
+        if (!delta || app->delta == NULL) {
+            report_to_sub(driver, app, values);
+            continue;
+        }
 
-    HASH_FIND_STR(driver->groups, group, find);
-    if (find != NULL) {
-        neu_datatag_t *t = neu_group_find_tag(find->group, tag);
-        if (t != NULL) {
-            utarray_new(tags, neu_tag_get_icd());
-            utarray_push_back(tags, t);
-            neu_tag_free(t);
+        neu_tag_values_t *changed =
+            neu_report_delta_filter(app->delta, values, global_timestamp);
+        if (changed != NULL) {
+            report_to_sub(driver, app, changed);
+            neu_tag_values_unref(changed);
         }
     }
-
-    return tags;
 }
 
-static void report_to_app(neu_adapter_driver_t *driver, group_t *group,
-                          struct sockaddr_un dst)
+// must be called with report_mtx held, takes over the snapshot reference
+static void resolve_report_handles(group_t *group, neu_group_tags_t *snapshot)
 {
-    neu_reqresp_head_t header = {
-        .type = NEU_REQRESP_TRANS_DATA,
-    };
+    uint32_t  epoch = __atomic_load_n(&group->cache_epoch, __ATOMIC_ACQUIRE);
+    UT_array *tags  = neu_group_tags_array(snapshot);
+
+    if (snapshot == group->report_tags && epoch == group->report_epoch) {
+        neu_group_tags_unref(snapshot);
+        return;
+    }
+
+    neu_group_tags_unref(group->report_tags);
+    free(group->report_handles);
+
+    // tags without a cache entry yet get an invalid handle and are reported
+    // as not ready until group_change adds them and bumps the epoch
+    group->report_handles = calloc(utarray_len(tags) + 1,
+                                   sizeof(neu_driver_cache_handle_t));
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        group->report_handles[utarray_eltidx(tags, tag)] =
+            neu_driver_cache_find(group->driver->cache, group->name,
+                                  tag->name);
+    }
+    group->report_tags  = snapshot;
+    group->report_epoch = epoch;
+}
 
-    UT_array *tags =
-        neu_adapter_driver_get_read_tag(group->driver, group->name);
+static neu_tag_values_t *read_report_values(group_t *group)
+{
+    neu_adapter_driver_t *driver   = group->driver;
+    neu_group_tags_t *    snapshot = neu_group_get_read_tags(group->group);
+    neu_tag_values_t *    values   = NULL;
 
-    neu_reqresp_trans_data_t *data =
-        calloc(1, sizeof(neu_reqresp_trans_data_t));
+    if (snapshot == NULL) {
+        return NULL;
+    }
 
-    data->driver = strdup(group->driver->adapter.name);
-    data->group  = strdup(group->name);
-    utarray_new(data->tags, neu_resp_tag_value_meta_icd());
+    pthread_mutex_lock(&group->report_mtx);
+    resolve_report_handles(group, snapshot);
 
-    read_group(global_timestamp,
-               neu_group_get_interval(group->group) *
-                   NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
-               neu_adapter_get_tag_cache_type(&driver->adapter), driver->cache,
-               group->name, tags, data->tags);
+    values = neu_tag_values_new(driver->adapter.name, group->name,
+                                neu_group_tags_names(group->report_tags));
+    if (values != NULL) {
+        read_report_group(false, global_timestamp,
+                          neu_group_get_interval(group->group) *
+                              NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
+                          neu_adapter_get_tag_cache_type(&driver->adapter),
+                          driver->cache, group->report_handles,
+                          neu_group_tags_array(group->report_tags), values);
+    }
+    pthread_mutex_unlock(&group->report_mtx);
 
-    nlog_info("report group: %s, all tags: %d, report tags: %d", group->name,
-              utarray_len(tags), utarray_len(data->tags));
-    if (utarray_len(data->tags) > 0) {
-        pthread_mutex_lock(&group->apps_mtx);
+    return values;
+}
 
-        data->ctx        = calloc(1, sizeof(neu_reqresp_trans_data_ctx_t));
-        data->ctx->index = 1;
+static void report_to_app(neu_adapter_driver_t *driver, group_t *group,
+                          sub_app_t *app)
+{
+    neu_tag_values_t *values = read_report_values(group);
 
-        pthread_mutex_init(&data->ctx->mtx, NULL);
+    if (values == NULL) {
+        return;
+    }
 
-        if (driver->adapter.cb_funs.responseto(&driver->adapter, &header, data,
-                                               dst) != 0) {
-            neu_trans_data_free(data);
+    nlog_info("report group: %s, all tags: %" PRIu32
+              ", report tags: %" PRIu32,
+              group->name, neu_tag_names_size(neu_tag_values_names(values)),
+              neu_tag_values_size(values));
+    if (neu_tag_values_size(values) > 0) {
+        if (app->delta != NULL) {
+            // the first report of a delta subscription is a full one
+            neu_tag_values_unref(
+                neu_report_delta_filter(app->delta, values, global_timestamp));
         }
-
-        pthread_mutex_unlock(&group->apps_mtx);
-    } else {
-        utarray_free(data->tags);
-        free(data->group);
-        free(data->driver);
+        report_to_sub(driver, app, values);
     }
-    utarray_free(tags);
-    free(data);
+
+    neu_tag_values_unref(values);
 }
 
 static int report_callback(void *usr_data)
@@ -1903,64 +2233,20 @@ static int report_callback(void *usr_data)
         return 0;
     }
 
-    neu_reqresp_head_t header = {
-        .type = NEU_REQRESP_TRANS_DATA,
-    };
-
-    UT_array *tags =
-        neu_adapter_driver_get_read_tag(group->driver, group->name);
-
-    neu_reqresp_trans_data_t *data =
-        calloc(1, sizeof(neu_reqresp_trans_data_t));
-
-    data->driver = strdup(group->driver->adapter.name);
-    data->group  = strdup(group->name);
-    utarray_new(data->tags, neu_resp_tag_value_meta_icd());
-
-    read_report_group(false, global_timestamp,
-                      neu_group_get_interval(group->group) *
-                          NEU_DRIVER_TAG_CACHE_EXPIRE_TIME,
-                      neu_adapter_get_tag_cache_type(&group->driver->adapter),
-                      group->driver->cache, group->name, tags, data->tags);
+    neu_tag_values_t *values = read_report_values(group);
+    if (values == NULL) {
+        return 0;
+    }
 
-    if (utarray_len(data->tags) > 0) {
+    if (neu_tag_values_size(values) > 0) {
         pthread_mutex_lock(&group->apps_mtx);
+        report_values(group->driver, group->apps, values, true);
+        pthread_mutex_unlock(&group->apps_mtx);
+    }
 
-        if (utarray_len(group->apps) > 0) {
-            data->ctx        = calloc(1, sizeof(neu_reqresp_trans_data_ctx_t));
-            data->ctx->index = utarray_len(group->apps);
-            pthread_mutex_init(&data->ctx->mtx, NULL);
-
-            utarray_foreach(group->apps, sub_app_t *, app)
-            {
-                if (group->driver->adapter.cb_funs.responseto(
-                        &group->driver->adapter, &header, data, app->addr) !=
-                    0) {
-                    neu_trans_data_free(data);
-                }
-            }
-        } else {
-            utarray_foreach(data->tags, neu_resp_tag_value_meta_t *, tag_value)
-            {
-                if (tag_value->value.type == NEU_TYPE_PTR) {
-                    free(tag_value->value.value.ptr.ptr);
-                }
-            }
-            utarray_free(data->tags);
-            free(data->group);
-            free(data->driver);
-        }
-
-        pthread_mutex_unlock(&group->apps_mtx);
-    } else {
-        utarray_free(data->tags);
-        free(data->group);
-        free(data->driver);
-    }
-    utarray_free(tags);
-    free(data);
-    return 0;
-}
+    neu_tag_values_unref(values);
+    return 0;
+}
 
 static void group_change(void *arg, int64_t timestamp, UT_array *static_tags,
                          UT_array *other_tags, uint32_t interval)
@@ -2008,6 +2294,8 @@ static void group_change(void *arg, int64_t timestamp, UT_array *static_tags,
         neu_driver_cache_add(group->driver->cache, group->name, tag->name,
                              value);
     }
+    // the report handles resolved before are stale now
+    __atomic_add_fetch(&group->cache_epoch, 1, __ATOMIC_RELEASE);
 
     neu_plugin_group_t grp = {
         .group_name = strdup(group->name),
@@ -2032,44 +2320,115 @@ static void group_change(void *arg, int64_t timestamp, UT_array *static_tags,
                 timestamp);
 }
 
-static int write_callback(void *usr_data)
+static void write_one(neu_adapter_driver_t *driver, to_be_write_tag_t *wtag)
 {
-    group_t *                group = (group_t *) usr_data;
-    neu_node_running_state_e state = group->driver->adapter.state;
-    if (state != NEU_NODE_RUNNING_STATE_RUNNING) {
-        return 0;
+    const neu_plugin_intf_funs_t *intf_funs = driver->adapter.module->intf_funs;
+
+    if (wtag->single) {
+        intf_funs->driver.write_tag(driver->adapter.plugin, (void *) wtag->req,
+                                    wtag->tag, wtag->value);
+    } else {
+        intf_funs->driver.write_tags(driver->adapter.plugin, (void *) wtag->req,
+                                     wtag->tvs);
     }
+    free_write_tag(wtag);
+}
 
-    pthread_mutex_lock(&group->wt_mtx);
-    utarray_foreach(group->wt_tags, to_be_write_tag_t *, wtag)
-    {
-        if (wtag->single) {
-            group->driver->adapter.module->intf_funs->driver.write_tag(
-                group->driver->adapter.plugin, (void *) wtag->req, wtag->tag,
-                wtag->value);
-            neu_tag_free(wtag->tag);
-        } else {
-            group->driver->adapter.module->intf_funs->driver.write_tags(
-                group->driver->adapter.plugin, (void *) wtag->req, wtag->tvs);
-            utarray_foreach(wtag->tvs, neu_plugin_tag_value_t *, tv)
-            {
-                neu_tag_free(tv->tag);
-            }
-            utarray_free(wtag->tvs);
+static void write_batch(neu_adapter_driver_t *driver, to_be_write_tag_t *wtags,
+                        unsigned n)
+{
+    const neu_plugin_intf_funs_t *intf_funs = driver->adapter.module->intf_funs;
+
+    neu_write_merge_t *merge = neu_write_merge_new();
+    write_batch_t *    batch = calloc(1, sizeof(write_batch_t));
+
+    utarray_new(batch->reqs, &ut_ptr_icd);
+    batch->head.type = NEU_REQ_WRITE_TAGS;
+    batch->self      = &batch->head;
+
+    for (unsigned i = 0; i < n; i++) {
+        utarray_push_back(batch->reqs, &wtags[i].req);
+        neu_write_merge_add(merge, wtags[i].group, wtags[i].tag,
+                            wtags[i].value);
+    }
+
+    pthread_mutex_lock(&driver->batch_mtx);
+    HASH_ADD_PTR(driver->batches, self, batch);
+    pthread_mutex_unlock(&driver->batch_mtx);
+
+    intf_funs->driver.write_tags(driver->adapter.plugin, (void *) batch->self,
+                                 neu_write_merge_tvs(merge));
+    neu_write_merge_free(merge);
+}
+
+static void write_callback(void *usr_data, const neu_scan_run_t *run)
+{
+    neu_adapter_driver_t *driver  = (neu_adapter_driver_t *) usr_data;
+    UT_array *            wt_tags = NULL;
+
+    (void) run;
+
+    pthread_mutex_lock(&driver->wt_mtx);
+    wt_tags          = driver->wt_tags;
+    driver->wt_tags  = driver->wt_spare;
+    driver->wt_spare = wt_tags;
+    pthread_mutex_unlock(&driver->wt_mtx);
+
+    to_be_write_tag_t *wtags = (to_be_write_tag_t *) utarray_front(wt_tags);
+    unsigned           len   = utarray_len(wt_tags);
+
+    if (driver->adapter.state != NEU_NODE_RUNNING_STATE_RUNNING) {
+        for (unsigned i = 0; i < len; i++) {
+            write_response(&driver->adapter, wtags[i].req,
+                           NEU_ERR_PLUGIN_NOT_RUNNING);
+            free_write_tag(&wtags[i]);
         }
+        utarray_clear(wt_tags);
+        return;
     }
-    utarray_clear(group->wt_tags);
-    pthread_mutex_unlock(&group->wt_mtx);
 
-    return 0;
+    // runs of single tag writes are coalesced into one write_tags call
+    for (unsigned i = 0, n_run = 1; i < len; i += n_run, n_run = 1) {
+        if (wtags[i].single &&
+            driver->adapter.module->intf_funs->driver.write_tags != NULL) {
+            while (i + n_run < len && n_run < WRITE_BATCH_MAX &&
+                   wtags[i + n_run].single) {
+                n_run += 1;
+            }
+        }
+
+        if (n_run > 1) {
+            write_batch(driver, &wtags[i], n_run);
+        } else {
+            write_one(driver, &wtags[i]);
+        }
+    }
+    utarray_clear(wt_tags);
 }
 
-static int read_callback(void *usr_data)
+static void read_callback(void *usr_data, const neu_scan_run_t *run)
 {
     group_t *                group = (group_t *) usr_data;
     neu_node_running_state_e state = group->driver->adapter.state;
+    int64_t                  spend = 0;
     if (state != NEU_NODE_RUNNING_STATE_RUNNING) {
-        return 0;
+        return;
+    }
+
+    // time spent waiting for the lane or a free worker
+    neu_adapter_update_metric_by_handle(&group->driver->adapter,
+                                        group->last_scan_delay_ms,
+                                        run->start - run->due);
+    neu_adapter_update_metric_by_handle(
+        &group->driver->adapter, group->scan_interval_ms, run->interval);
+    if (run->skipped > 0) {
+        neu_adapter_update_metric_by_handle(&group->driver->adapter,
+                                            group->scan_skipped_total,
+                                            run->skipped);
+    }
+    if (run->jitter >= 0) {
+        neu_adapter_update_metric_by_handle(
+            &group->driver->adapter, group->scan_jitter_ms, run->jitter);
     }
 
     if (neu_group_is_change(group->group, group->timestamp)) {
@@ -2078,8 +2437,7 @@ static int read_callback(void *usr_data)
     }
 
     if (group->grp.tags != NULL && utarray_len(group->grp.tags) > 0) {
-        int64_t spend = global_timestamp;
-
+        spend = global_timestamp;
         group->driver->adapter.module->intf_funs->driver.group_timer(
             group->driver->adapter.plugin, &group->grp);
 
@@ -2087,193 +2445,201 @@ static int read_callback(void *usr_data)
         nlog_debug("%s-%s timer: %" PRId64, group->driver->adapter.name,
                    group->name, spend);
 
-        neu_adapter_update_group_metric(&group->driver->adapter, group->name,
-                                        NEU_METRIC_GROUP_LAST_TIMER_MS, spend);
+        neu_adapter_update_metric_by_handle(&group->driver->adapter,
+                                            group->last_timer_ms, spend);
+        neu_adapter_update_metric_by_handle(&group->driver->adapter,
+                                            group->timer_ms, spend);
     }
 
-    return 0;
+    // the next read is late
+    if (run->start + spend > run->deadline) {
+        neu_adapter_update_metric_by_handle(&group->driver->adapter,
+                                            group->scan_overruns_total, 1);
+    }
 }
 
-static void read_report_group(bool sub, int64_t timestamp, int64_t timeout,
-                              neu_tag_cache_type_e cache_type,
-                              neu_driver_cache_t *cache, const char *group,
-                              UT_array *tags, UT_array *tag_values)
+static void read_report_tag(bool sub, int64_t timestamp, int64_t timeout,
+                            neu_tag_cache_type_e      cache_type,
+                            neu_driver_cache_t *      cache,
+                            neu_driver_cache_handle_t handle,
+                            const neu_datatag_t *tag, uint32_t index,
+                            neu_tag_values_t *values)
 {
-    utarray_foreach(tags, neu_datatag_t *, tag)
-    {
-        neu_driver_cache_value_t  value     = { 0 };
-        neu_resp_tag_value_meta_t tag_value = { 0 };
-
-        if (sub && neu_tag_attribute_test(tag, NEU_ATTRIBUTE_SUBSCRIBE)) {
-            if (neu_driver_cache_meta_get_changed(cache, group, tag->name,
-                                                  &value, tag_value.metas,
-                                                  NEU_TAG_META_SIZE) != 0) {
-                nlog_debug("tag: %s not changed", tag->name);
-                continue;
-            }
-        } else {
-            if (neu_driver_cache_meta_get(cache, group, tag->name, &value,
-                                          tag_value.metas,
-                                          NEU_TAG_META_SIZE) != 0) {
-                strcpy(tag_value.tag, tag->name);
-                tag_value.value.type      = NEU_TYPE_ERROR;
-                tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
+    neu_driver_cache_value_t value                    = { 0 };
+    neu_dvalue_t             tag_value                = { 0 };
+    neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = { 0 };
+
+    if (sub && neu_tag_attribute_test(tag, NEU_ATTRIBUTE_SUBSCRIBE)) {
+        if (neu_driver_cache_meta_get_changed_by_handle(
+                cache, handle, &value, metas, NEU_TAG_META_SIZE) != 0) {
+            nlog_debug("tag: %s not changed", tag->name);
+            return;
+        }
+    } else {
+        if (neu_driver_cache_meta_get_by_handle(cache, handle, &value, metas,
+                                                NEU_TAG_META_SIZE) != 0) {
+            tag_value.type      = NEU_TYPE_ERROR;
+            tag_value.value.i32 = NEU_ERR_PLUGIN_TAG_NOT_READY;
 
-                utarray_push_back(tag_values, &tag_value);
-                continue;
-            }
+            neu_tag_values_push(values, index, &tag_value, NULL, 0);
+            return;
         }
-        strcpy(tag_value.tag, tag->name);
+    }
 
-        tag_value.datatag.bias = tag->bias;
+    if (value.value.type == NEU_TYPE_ERROR) {
+        neu_tag_values_push(values, index, &value.value, metas,
+                            NEU_TAG_META_SIZE);
+        return;
+    }
 
-        if (value.value.type == NEU_TYPE_ERROR) {
-            tag_value.value = value.value;
+    if ((tag->type == NEU_TYPE_FLOAT && isnan(value.value.value.f32)) ||
+        (tag->type == NEU_TYPE_DOUBLE && isnan(value.value.value.d64))) {
+        tag_value.type      = NEU_TYPE_ERROR;
+        tag_value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
+        neu_tag_values_push(values, index, &tag_value, metas,
+                            NEU_TAG_META_SIZE);
+        return;
+    }
 
-            utarray_push_back(tag_values, &tag_value);
-            continue;
+    switch (tag->type) {
+    case NEU_TYPE_UINT16:
+    case NEU_TYPE_INT16:
+        switch (tag->option.value16.endian) {
+        case NEU_DATATAG_ENDIAN_B16:
+            value.value.value.u16 = htons(value.value.value.u16);
+            break;
+        case NEU_DATATAG_ENDIAN_L16:
+        default:
+            break;
         }
+        break;
+    case NEU_TYPE_FLOAT:
+    case NEU_TYPE_UINT32:
+    case NEU_TYPE_INT32:
+        switch (tag->option.value32.endian) {
+        case NEU_DATATAG_ENDIAN_LB32: {
+            uint16_t *v1 = (uint16_t *) value.value.value.bytes.bytes;
+            uint16_t *v2 = (uint16_t *) (value.value.value.bytes.bytes + 2);
 
-        if ((tag->type == NEU_TYPE_FLOAT && isnan(value.value.value.f32)) ||
-            (tag->type == NEU_TYPE_DOUBLE && isnan(value.value.value.d64))) {
-            tag_value.value.type      = NEU_TYPE_ERROR;
-            tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
-            utarray_push_back(tag_values, &tag_value);
-            continue;
+            neu_htons_p(v1);
+            neu_htons_p(v2);
+            break;
         }
+        case NEU_DATATAG_ENDIAN_BB32:
+            value.value.value.u32 = htonl(value.value.value.u32);
+            break;
+        case NEU_DATATAG_ENDIAN_BL32:
+            value.value.value.u32 = htonl(value.value.value.u32);
+            uint16_t *v1 = (uint16_t *) value.value.value.bytes.bytes;
+            uint16_t *v2 = (uint16_t *) (value.value.value.bytes.bytes + 2);
 
-        switch (tag->type) {
-        case NEU_TYPE_UINT16:
-        case NEU_TYPE_INT16:
-            switch (tag->option.value16.endian) {
-            case NEU_DATATAG_ENDIAN_B16:
-                value.value.value.u16 = htons(value.value.value.u16);
-                break;
-            case NEU_DATATAG_ENDIAN_L16:
-            default:
-                break;
-            }
+            neu_htons_p(v1);
+            neu_htons_p(v2);
             break;
-        case NEU_TYPE_FLOAT:
-        case NEU_TYPE_UINT32:
-        case NEU_TYPE_INT32:
-            switch (tag->option.value32.endian) {
-            case NEU_DATATAG_ENDIAN_LB32: {
-                uint16_t *v1 = (uint16_t *) value.value.value.bytes.bytes;
-                uint16_t *v2 = (uint16_t *) (value.value.value.bytes.bytes + 2);
+        case NEU_DATATAG_ENDIAN_LL32:
+        default:
+            break;
+        }
+        break;
+    case NEU_TYPE_DOUBLE:
+    case NEU_TYPE_INT64:
+    case NEU_TYPE_UINT64:
+        switch (tag->option.value64.endian) {
+        case NEU_DATATAG_ENDIAN_B64:
+            value.value.value.u64 = neu_htonll(value.value.value.u64);
+            break;
+        case NEU_DATATAG_ENDIAN_L64:
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
 
-                neu_htons_p(v1);
-                neu_htons_p(v2);
+    if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
+        !neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) &&
+        (timestamp - value.timestamp) > timeout && timeout > 0) {
+        tag_value.type      = NEU_TYPE_ERROR;
+        tag_value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
+    } else {
+        tag_value = value.value;
+
+        if (tag->decimal != 0 || tag->bias != 0) {
+            double decimal = tag->decimal != 0 ? tag->decimal : 1;
+            double bias    = tag->bias;
+
+            tag_value.type = NEU_TYPE_DOUBLE;
+            switch (tag->type) {
+            case NEU_TYPE_INT8:
+                tag_value.value.d64 =
+                    (double) tag_value.value.i8 * decimal + bias;
                 break;
-            }
-            case NEU_DATATAG_ENDIAN_BB32:
-                value.value.value.u32 = htonl(value.value.value.u32);
+            case NEU_TYPE_UINT8:
+                tag_value.value.d64 =
+                    (double) tag_value.value.u8 * decimal + bias;
                 break;
-            case NEU_DATATAG_ENDIAN_BL32:
-                value.value.value.u32 = htonl(value.value.value.u32);
-                uint16_t *v1 = (uint16_t *) value.value.value.bytes.bytes;
-                uint16_t *v2 = (uint16_t *) (value.value.value.bytes.bytes + 2);
-
-                neu_htons_p(v1);
-                neu_htons_p(v2);
+            case NEU_TYPE_INT16:
+                tag_value.value.d64 =
+                    (double) tag_value.value.i16 * decimal + bias;
                 break;
-            case NEU_DATATAG_ENDIAN_LL32:
-            default:
+            case NEU_TYPE_UINT16:
+                tag_value.value.d64 =
+                    (double) tag_value.value.u16 * decimal + bias;
                 break;
-            }
-            break;
-        case NEU_TYPE_DOUBLE:
-        case NEU_TYPE_INT64:
-        case NEU_TYPE_UINT64:
-            switch (tag->option.value64.endian) {
-            case NEU_DATATAG_ENDIAN_B64:
-                value.value.value.u64 = neu_htonll(value.value.value.u64);
+            case NEU_TYPE_INT32:
+                tag_value.value.d64 =
+                    (double) tag_value.value.i32 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT32:
+                tag_value.value.d64 =
+                    (double) tag_value.value.u32 * decimal + bias;
+                break;
+            case NEU_TYPE_INT64:
+                tag_value.value.d64 =
+                    (double) tag_value.value.i64 * decimal + bias;
+                break;
+            case NEU_TYPE_UINT64:
+                tag_value.value.d64 =
+                    (double) tag_value.value.u64 * decimal + bias;
+                break;
+            case NEU_TYPE_FLOAT:
+                tag_value.value.d64 =
+                    (double) tag_value.value.f32 * decimal + bias;
+                break;
+            case NEU_TYPE_DOUBLE:
+                tag_value.value.d64 =
+                    (double) tag_value.value.d64 * decimal + bias;
                 break;
-            case NEU_DATATAG_ENDIAN_L64:
             default:
+                tag_value.type = tag->type;
                 break;
             }
-            break;
-        default:
-            break;
         }
+        if (tag->precision == 0 && tag->bias == 0 &&
+            tag->type == NEU_TYPE_DOUBLE) {
+            format_tag_value(&tag_value);
+        }
+    }
 
-        if (cache_type != NEU_TAG_CACHE_TYPE_NEVER &&
-            !neu_tag_attribute_test(tag, NEU_ATTRIBUTE_STATIC) &&
-            (timestamp - value.timestamp) > timeout && timeout > 0) {
-            if (value.value.type == NEU_TYPE_PTR) {
-                free(value.value.value.ptr.ptr);
-            }
-            tag_value.value.type      = NEU_TYPE_ERROR;
-            tag_value.value.value.i32 = NEU_ERR_PLUGIN_TAG_VALUE_EXPIRED;
-        } else {
-            if (value.value.type == NEU_TYPE_PTR) {
-                tag_value.value.type             = NEU_TYPE_PTR;
-                tag_value.value.value.ptr.length = value.value.value.ptr.length;
-                tag_value.value.value.ptr.type   = value.value.value.ptr.type;
-                tag_value.value.value.ptr.ptr    = value.value.value.ptr.ptr;
-            } else {
-                tag_value.value = value.value;
-            }
-
-            if (tag->decimal != 0 || tag->bias != 0) {
-                double decimal = tag->decimal != 0 ? tag->decimal : 1;
-                double bias    = tag->bias;
+    neu_tag_values_push(values, index, &tag_value, metas, NEU_TAG_META_SIZE);
+    if (value.value.type == NEU_TYPE_PTR) {
+        free(value.value.value.ptr.ptr);
+    }
+}
 
-                tag_value.value.type = NEU_TYPE_DOUBLE;
-                switch (tag->type) {
-                case NEU_TYPE_INT8:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i8 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT8:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u8 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT16:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i16 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT16:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u16 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT32:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i32 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT32:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u32 * decimal + bias;
-                    break;
-                case NEU_TYPE_INT64:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.i64 * decimal + bias;
-                    break;
-                case NEU_TYPE_UINT64:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.u64 * decimal + bias;
-                    break;
-                case NEU_TYPE_FLOAT:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.f32 * decimal + bias;
-                    break;
-                case NEU_TYPE_DOUBLE:
-                    tag_value.value.value.d64 =
-                        (double) tag_value.value.value.d64 * decimal + bias;
-                    break;
-                default:
-                    tag_value.value.type = tag->type;
-                    break;
-                }
-            }
-            if (tag->precision == 0 && tag->bias == 0 &&
-                tag->type == NEU_TYPE_DOUBLE) {
-                format_tag_value(&tag_value.value);
-            }
-        }
+static void read_report_group(bool sub, int64_t timestamp, int64_t timeout,
+                              neu_tag_cache_type_e             cache_type,
+                              neu_driver_cache_t *             cache,
+                              const neu_driver_cache_handle_t *handles,
+                              UT_array *tags, neu_tag_values_t *values)
+{
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        uint32_t index = utarray_eltidx(tags, tag);
 
-        utarray_push_back(tag_values, &tag_value);
+        read_report_tag(sub, timestamp, timeout, cache_type, cache,
+                        handles[index], tag, index, values);
     }
 }
 
@@ -2612,11 +2978,20 @@ static void read_group_paginate(int64_t timestamp, int64_t timeout,
     }
 }
 
-static void store_write_tag(group_t *group, to_be_write_tag_t *tag)
+static void store_write_tag(neu_adapter_driver_t *driver,
+                            to_be_write_tag_t *   tag)
 {
-    pthread_mutex_lock(&group->wt_mtx);
-    utarray_push_back(group->wt_tags, tag);
-    pthread_mutex_unlock(&group->wt_mtx);
+    bool first = false;
+
+    pthread_mutex_lock(&driver->wt_mtx);
+    first = utarray_len(driver->wt_tags) == 0;
+    utarray_push_back(driver->wt_tags, tag);
+    pthread_mutex_unlock(&driver->wt_mtx);
+
+    // schedule the write job once per batch of pending writes
+    if (first) {
+        neu_scan_pool_trigger(driver->scan, driver->write_job);
+    }
 }
 
 void neu_adapter_driver_subscribe(neu_adapter_driver_t *driver,
@@ -2647,11 +3022,38 @@ void neu_adapter_driver_subscribe(neu_adapter_driver_t *driver,
     sub_app.addr.sun_family = AF_UNIX;
     snprintf(sub_app.addr.sun_path, sizeof(sub_app.addr.sun_path),
              "%cneuron-%" PRIu16, '\0', req->port);
+    sub_app.delta = neu_report_delta_new(req->params);
 
     utarray_push_back(find->apps, &sub_app);
+    report_to_app(driver, find, utarray_back(find->apps));
     pthread_mutex_unlock(&find->apps_mtx);
+}
 
-    report_to_app(driver, find, sub_app.addr);
+void neu_adapter_driver_update_subscribe(neu_adapter_driver_t *driver,
+                                         neu_req_subscribe_t * req)
+{
+    group_t *find = NULL;
+
+    HASH_FIND_STR(driver->groups, req->group, find);
+    if (find == NULL) {
+        nlog_warn("%s update sub group: %s not exist", driver->adapter.name,
+                  req->group);
+        return;
+    }
+
+    pthread_mutex_lock(&find->apps_mtx);
+    utarray_foreach(find->apps, sub_app_t *, app)
+    {
+        if (strcmp(app->app, req->app) == 0) {
+            neu_report_delta_free(app->delta);
+            app->delta = neu_report_delta_new(req->params);
+            if (app->delta != NULL) {
+                report_to_app(driver, find, app);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&find->apps_mtx);
 }
 
 void neu_adapter_driver_unsubscribe(neu_adapter_driver_t * driver,
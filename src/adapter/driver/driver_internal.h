@@ -28,6 +28,11 @@ void neu_adapter_driver_destroy(neu_adapter_driver_t *driver);
 int  neu_adapter_driver_init(neu_adapter_driver_t *driver);
 int  neu_adapter_driver_uninit(neu_adapter_driver_t *driver);
 
+// n_worker workers read the groups, 1 to NEU_SCAN_WORKERS_MAX and 1 for
+// plugins without group_lane, policy is a neu_scan_policy_e
+int neu_adapter_driver_set_scan(neu_adapter_driver_t *driver, int n_worker,
+                                int policy);
+
 void neu_adapter_driver_start_group_timer(neu_adapter_driver_t *driver);
 void neu_adapter_driver_stop_group_timer(neu_adapter_driver_t *driver);
 
@@ -55,8 +60,8 @@ int neu_adapter_driver_del_group(neu_adapter_driver_t *driver,
 int neu_adapter_driver_group_exist(neu_adapter_driver_t *driver,
                                    const char *          name);
 UT_array *neu_adapter_driver_get_group(neu_adapter_driver_t *driver);
-uint16_t  neu_adapter_driver_group_count(neu_adapter_driver_t *driver);
-uint16_t  neu_adapter_driver_new_group_count(neu_adapter_driver_t *driver,
+uint32_t  neu_adapter_driver_group_count(neu_adapter_driver_t *driver);
+uint32_t  neu_adapter_driver_new_group_count(neu_adapter_driver_t *driver,
                                              neu_req_add_gtag_t *  cmd);
 
 int neu_adapter_driver_try_del_tag(neu_adapter_driver_t *driver, int n_tag);
@@ -71,24 +76,31 @@ int neu_adapter_driver_validate_tag(neu_adapter_driver_t *driver,
 
 int neu_adapter_driver_add_tag(neu_adapter_driver_t *driver, const char *group,
                                neu_datatag_t *tag, uint16_t interval);
+
+// bulk variants, on failure *index is the first tag in error and no tag has
+// been added. Tags passed to add_tags must have been validated.
+int neu_adapter_driver_validate_tags(neu_adapter_driver_t *driver,
+                                     const char *group, neu_datatag_t *tags,
+                                     uint32_t n_tag, uint32_t *index);
+int neu_adapter_driver_add_tags(neu_adapter_driver_t *driver, const char *group,
+                                neu_datatag_t *tags, uint32_t n_tag,
+                                uint32_t interval, uint32_t *index);
 int neu_adapter_driver_del_tag(neu_adapter_driver_t *driver, const char *group,
                                const char *tag);
 int neu_adapter_driver_update_tag(neu_adapter_driver_t *driver,
                                   const char *group, neu_datatag_t *tag);
 int neu_adapter_driver_get_tag(neu_adapter_driver_t *driver, const char *group,
                                UT_array **tags);
-UT_array *neu_adapter_driver_get_ptag(neu_adapter_driver_t *driver,
-                                      const char *group, const char *tag);
-int       neu_adapter_driver_query_tag(neu_adapter_driver_t *driver,
-                                       const char *group, const char *name,
-                                       UT_array **tags);
-void      neu_adapter_driver_get_value_tag(neu_adapter_driver_t *driver,
-                                           const char *group, UT_array **tags);
-UT_array *neu_adapter_driver_get_read_tag(neu_adapter_driver_t *driver,
-                                          const char *          group);
+int  neu_adapter_driver_query_tag(neu_adapter_driver_t *driver,
+                                  const char *group, const char *name,
+                                  UT_array **tags);
+void neu_adapter_driver_get_value_tag(neu_adapter_driver_t *driver,
+                                      const char *group, UT_array **tags);
 
 void neu_adapter_driver_subscribe(neu_adapter_driver_t *driver,
                                   neu_req_subscribe_t * req);
+void neu_adapter_driver_update_subscribe(neu_adapter_driver_t *driver,
+                                         neu_req_subscribe_t * req);
 void neu_adapter_driver_unsubscribe(neu_adapter_driver_t * driver,
                                     neu_req_unsubscribe_t *req);
 
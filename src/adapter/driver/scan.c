@@ -0,0 +1,481 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/log.h"
+#include "utils/utlist.h"
+
+#include "scan.h"
+
+struct neu_scan_job {
+    uint32_t               lane;
+    int64_t                interval;
+    neu_event_timer_type_e type;
+    neu_scan_cb_t          cb;
+    void *                 usr_data;
+
+    // INT64_MAX when not scheduled, equal due times run in trigger order
+    int64_t  due;
+    uint64_t seq;
+
+    // interval in effect and run history for the next run
+    int64_t  effective;
+    int64_t  last_start;
+    uint32_t skipped;
+
+    bool      running;
+    pthread_t runner;
+    // triggered while running
+    bool again;
+    // removed by its own run, freed once the run returns
+    bool release;
+
+    struct neu_scan_job *prev, *next;
+};
+
+typedef struct {
+    neu_scan_pool_t *pool;
+    int              index;
+    bool             started;
+    pthread_t        thread;
+    neu_scan_job_t * running;
+} scan_worker_t;
+
+struct neu_scan_pool {
+    pthread_mutex_t mtx;
+    // a job got due, a lane got free or the workers changed
+    pthread_cond_t cond;
+    // a run ended
+    pthread_cond_t done;
+
+    int           n_worker;
+    scan_worker_t workers[NEU_SCAN_WORKERS_MAX];
+
+    neu_scan_policy_e policy;
+    // phases are relative to the creation of the pool
+    int64_t  epoch;
+    uint32_t n_phase;
+
+    uint64_t        seq;
+    neu_scan_job_t *jobs;
+};
+
+static inline int64_t monotonic_ms()
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool lane_busy(neu_scan_pool_t *pool, uint32_t lane)
+{
+    for (int i = 0; i < NEU_SCAN_WORKERS_MAX; i++) {
+        neu_scan_job_t *job = pool->workers[i].running;
+
+        if (job != NULL && job->lane == lane) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the due job to run first, or NULL and when the next job gets due
+static neu_scan_job_t *scan_pick(neu_scan_pool_t *pool, int64_t now,
+                                 int64_t *next)
+{
+    neu_scan_job_t *pick = NULL;
+    neu_scan_job_t *job  = NULL;
+
+    *next = INT64_MAX;
+    DL_FOREACH(pool->jobs, job)
+    {
+        if (job->running || job->due == INT64_MAX) {
+            continue;
+        }
+
+        if (job->due > now) {
+            if (job->due < *next) {
+                *next = job->due;
+            }
+            continue;
+        }
+
+        if (pick != NULL &&
+            (job->due > pick->due ||
+             (job->due == pick->due && job->seq > pick->seq))) {
+            continue;
+        }
+        // a worker is waked up again when the lane gets free
+        if (!lane_busy(pool, job->lane)) {
+            pick = job;
+        }
+    }
+
+    return pick;
+}
+
+static void scan_wait(neu_scan_pool_t *pool, int64_t until)
+{
+    struct timespec ts = { 0 };
+
+    if (until == INT64_MAX) {
+        pthread_cond_wait(&pool->cond, &pool->mtx);
+        return;
+    }
+
+    ts.tv_sec  = until / 1000;
+    ts.tv_nsec = (until % 1000) * 1000 * 1000;
+    pthread_cond_timedwait(&pool->cond, &pool->mtx, &ts);
+}
+
+// the golden ratio sequence spreads any number of consecutive jobs evenly
+static int64_t scan_phase(neu_scan_pool_t *pool, int64_t interval)
+{
+    uint64_t frac = (uint64_t) pool->n_phase++ * 2654435769u & 0xffffffff;
+
+    return (int64_t)(frac * (uint64_t) interval >> 32);
+}
+
+static int64_t scan_stretch(neu_scan_job_t *job, int64_t busy)
+{
+    // leave a quarter of headroom over the time the last run kept the lane
+    int64_t target = busy + busy / 4;
+
+    if (target > job->effective) {
+        if (target > job->interval * NEU_SCAN_STRETCH_MAX) {
+            target = job->interval * NEU_SCAN_STRETCH_MAX;
+        }
+        return target;
+    }
+
+    // halfway back each run
+    target = (job->effective + target) / 2;
+    return target > job->interval ? target : job->interval;
+}
+
+static void scan_reschedule(neu_scan_pool_t *pool, neu_scan_job_t *job,
+                            int64_t due, int64_t end)
+{
+    neu_scan_policy_e policy = pool->policy;
+
+    if (job->again) {
+        job->again = false;
+        job->due   = end;
+        job->seq   = pool->seq++;
+        return;
+    }
+
+    if (job->interval == 0) {
+        job->due = INT64_MAX;
+        return;
+    }
+
+    if (policy == NEU_SCAN_POLICY_TIMER) {
+        policy = job->type == NEU_EVENT_TIMER_BLOCK ? NEU_SCAN_POLICY_TIMER
+                                                    : NEU_SCAN_POLICY_SKIP;
+    }
+    if (policy != NEU_SCAN_POLICY_STRETCH) {
+        job->effective = job->interval;
+    }
+
+    switch (policy) {
+    case NEU_SCAN_POLICY_TIMER:
+        // the period starts over once the run ends
+        job->due = end + job->interval;
+        break;
+    case NEU_SCAN_POLICY_STRETCH:
+        job->effective = scan_stretch(job, end - due);
+        job->due       = due + job->effective;
+        if (job->due <= end) {
+            job->due = end + 1;
+        }
+        break;
+    case NEU_SCAN_POLICY_SKIP:
+    case NEU_SCAN_POLICY_PHASE:
+        job->due = due + job->interval;
+        if (job->due <= end) {
+            // skip the missed periods and keep the phase
+            int64_t missed = (end - job->due) / job->interval;
+            job->due += (missed + 1) * job->interval;
+            job->skipped += missed + 1;
+        }
+        break;
+    }
+
+    job->seq = pool->seq++;
+}
+
+static void *scan_worker(void *arg)
+{
+    scan_worker_t *  worker = (scan_worker_t *) arg;
+    neu_scan_pool_t *pool   = worker->pool;
+
+    pthread_mutex_lock(&pool->mtx);
+    while (worker->index < pool->n_worker) {
+        int64_t         now  = monotonic_ms();
+        int64_t         next = INT64_MAX;
+        neu_scan_job_t *job  = scan_pick(pool, now, &next);
+
+        if (job == NULL) {
+            scan_wait(pool, next);
+            continue;
+        }
+
+        neu_scan_run_t run = {
+            .due      = job->due,
+            .start    = now,
+            .deadline = job->interval > 0 ? job->due + job->effective
+                                          : INT64_MAX,
+            .interval = job->effective,
+            .skipped  = job->skipped,
+            .jitter   = -1,
+        };
+
+        if (job->interval > 0 && job->last_start > 0) {
+            run.jitter = now - job->last_start - job->interval;
+            run.jitter = run.jitter < 0 ? -run.jitter : run.jitter;
+        }
+
+        job->last_start = now;
+        job->skipped    = 0;
+        job->running    = true;
+        job->runner     = pthread_self();
+        job->due        = INT64_MAX;
+        worker->running = job;
+        pthread_mutex_unlock(&pool->mtx);
+
+        job->cb(job->usr_data, &run);
+
+        pthread_mutex_lock(&pool->mtx);
+        worker->running = NULL;
+        job->running    = false;
+        if (job->release) {
+            free(job);
+        } else {
+            scan_reschedule(pool, job, run.due, monotonic_ms());
+        }
+        pthread_cond_broadcast(&pool->cond);
+        pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+
+    return NULL;
+}
+
+neu_scan_pool_t *neu_scan_pool_new(int n_worker)
+{
+    pthread_condattr_t attr;
+    neu_scan_pool_t *  pool = calloc(1, sizeof(neu_scan_pool_t));
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&pool->mtx, NULL);
+    pthread_cond_init(&pool->cond, &attr);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_condattr_destroy(&attr);
+
+    for (int i = 0; i < NEU_SCAN_WORKERS_MAX; i++) {
+        pool->workers[i].pool  = pool;
+        pool->workers[i].index = i;
+    }
+    pool->epoch = monotonic_ms();
+
+    if (neu_scan_pool_set_workers(pool, n_worker) != 0) {
+        neu_scan_pool_free(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void neu_scan_pool_free(neu_scan_pool_t *pool)
+{
+    neu_scan_job_t *job = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&pool->mtx);
+    pool->n_worker = 0;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mtx);
+
+    for (int i = 0; i < NEU_SCAN_WORKERS_MAX; i++) {
+        if (pool->workers[i].started) {
+            pthread_join(pool->workers[i].thread, NULL);
+            pool->workers[i].started = false;
+        }
+    }
+
+    DL_FOREACH_SAFE(pool->jobs, job, tmp)
+    {
+        DL_DELETE(pool->jobs, job);
+        free(job);
+    }
+
+    pthread_mutex_destroy(&pool->mtx);
+    pthread_cond_destroy(&pool->cond);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
+}
+
+int neu_scan_pool_set_workers(neu_scan_pool_t *pool, int n_worker)
+{
+    if (n_worker < 1 || n_worker > NEU_SCAN_WORKERS_MAX) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->mtx);
+    pool->n_worker = n_worker;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mtx);
+
+    for (int i = 0; i < NEU_SCAN_WORKERS_MAX; i++) {
+        scan_worker_t *worker = &pool->workers[i];
+
+        if (i >= n_worker && worker->started) {
+            pthread_join(worker->thread, NULL);
+            worker->started = false;
+        } else if (i < n_worker && !worker->started) {
+            if (pthread_create(&worker->thread, NULL, scan_worker, worker) !=
+                0) {
+                nlog_error("create scan worker %d failed", i);
+                continue;
+            }
+            worker->started = true;
+        }
+    }
+
+    return 0;
+}
+
+int neu_scan_pool_workers(neu_scan_pool_t *pool)
+{
+    int n = 0;
+
+    pthread_mutex_lock(&pool->mtx);
+    n = pool->n_worker;
+    pthread_mutex_unlock(&pool->mtx);
+
+    return n;
+}
+
+int neu_scan_policy_parse(const char *str, neu_scan_policy_e *policy)
+{
+    if (strcmp(str, "timer") == 0) {
+        *policy = NEU_SCAN_POLICY_TIMER;
+    } else if (strcmp(str, "skip") == 0) {
+        *policy = NEU_SCAN_POLICY_SKIP;
+    } else if (strcmp(str, "phase") == 0) {
+        *policy = NEU_SCAN_POLICY_PHASE;
+    } else if (strcmp(str, "stretch") == 0) {
+        *policy = NEU_SCAN_POLICY_STRETCH;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+void neu_scan_pool_set_policy(neu_scan_pool_t *pool, neu_scan_policy_e policy)
+{
+    pthread_mutex_lock(&pool->mtx);
+    pool->policy = policy;
+    pthread_mutex_unlock(&pool->mtx);
+}
+
+neu_scan_job_t *neu_scan_pool_add(neu_scan_pool_t *pool, uint32_t lane,
+                                  uint32_t               interval,
+                                  neu_event_timer_type_e type, neu_scan_cb_t cb,
+                                  void *usr_data)
+{
+    neu_scan_job_t *job = calloc(1, sizeof(neu_scan_job_t));
+
+    if (job == NULL) {
+        return NULL;
+    }
+
+    job->lane      = lane;
+    job->interval  = interval;
+    job->effective = interval;
+    job->type      = type;
+    job->cb        = cb;
+    job->usr_data  = usr_data;
+    job->due       = INT64_MAX;
+
+    pthread_mutex_lock(&pool->mtx);
+    if (interval > 0 && pool->policy == NEU_SCAN_POLICY_PHASE) {
+        int64_t now = monotonic_ms();
+
+        // the first tick of the phase after now
+        job->due = pool->epoch + scan_phase(pool, interval);
+        if (job->due <= now) {
+            job->due += ((now - job->due) / interval + 1) * interval;
+        }
+        job->seq = pool->seq++;
+    } else if (interval > 0) {
+        job->due = monotonic_ms() + interval;
+        job->seq = pool->seq++;
+    }
+    DL_APPEND(pool->jobs, job);
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mtx);
+
+    return job;
+}
+
+void neu_scan_pool_del(neu_scan_pool_t *pool, neu_scan_job_t *job)
+{
+    pthread_mutex_lock(&pool->mtx);
+    DL_DELETE(pool->jobs, job);
+
+    if (job->running && pthread_equal(job->runner, pthread_self())) {
+        job->release = true;
+        pthread_mutex_unlock(&pool->mtx);
+        return;
+    }
+
+    while (job->running) {
+        pthread_cond_wait(&pool->done, &pool->mtx);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+
+    free(job);
+}
+
+void neu_scan_pool_trigger(neu_scan_pool_t *pool, neu_scan_job_t *job)
+{
+    int64_t now = monotonic_ms();
+
+    pthread_mutex_lock(&pool->mtx);
+    if (job->running) {
+        job->again = true;
+    } else if (job->due > now) {
+        job->due = now;
+        job->seq = pool->seq++;
+        pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+}
@@ -0,0 +1,130 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_SCAN_H_
+#define _NEU_DRIVER_SCAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event/event.h"
+
+/**
+ * Scan workers of a driver node.
+ *
+ * Jobs are group reads repeated every interval and on demand jobs such as
+ * the pending writes. Every job belongs to a lane, the jobs of one lane never
+ * run at the same time, so everything sent on one connection has to be on
+ * one lane. Jobs of different lanes run concurrently on the workers. Among
+ * the due jobs whose lane is free, the one due first runs first.
+ *
+ * A periodic job is not queued again while it runs, when its next run is
+ * due depends on the scan policy of the pool.
+ */
+typedef struct neu_scan_pool neu_scan_pool_t;
+typedef struct neu_scan_job  neu_scan_job_t;
+
+#define NEU_SCAN_WORKERS_DEFAULT 1
+#define NEU_SCAN_WORKERS_MAX 16
+
+// lane of the jobs of a plugin that does not tell the lanes apart
+#define NEU_SCAN_LANE_DEFAULT 0
+
+// the stretched interval is at most this many times the interval
+#define NEU_SCAN_STRETCH_MAX 8
+
+typedef enum {
+    // by the timer type of the job, the default: NEU_EVENT_TIMER_BLOCK
+    // starts the period over once the run ends, NEU_EVENT_TIMER_NOBLOCK
+    // works as NEU_SCAN_POLICY_SKIP
+    NEU_SCAN_POLICY_TIMER = 0,
+    // keep the phase, the periods missed by a late run are skipped
+    NEU_SCAN_POLICY_SKIP,
+    // as NEU_SCAN_POLICY_SKIP, and the jobs added are spread over their
+    // interval instead of all being due on the same tick
+    NEU_SCAN_POLICY_PHASE,
+    // the interval grows to fit the runs taking longer than it, and shrinks
+    // back once they are fast again
+    NEU_SCAN_POLICY_STRETCH,
+} neu_scan_policy_e;
+
+typedef struct {
+    // monotonic milliseconds
+    int64_t due;
+    int64_t start;
+    // when the next run of a periodic job is due, INT64_MAX otherwise
+    int64_t deadline;
+    // interval in effect, larger than the job interval when stretched
+    int64_t interval;
+    // periods of the job interval skipped since the previous run, only
+    // NEU_SCAN_POLICY_SKIP and NEU_SCAN_POLICY_PHASE skip periods
+    uint32_t skipped;
+    // distance between the interval and the time since the previous run
+    // started, -1 on the first run
+    int64_t jitter;
+} neu_scan_run_t;
+
+typedef void (*neu_scan_cb_t)(void *usr_data, const neu_scan_run_t *run);
+
+neu_scan_pool_t *neu_scan_pool_new(int n_worker);
+
+/**
+ * @brief Stop the workers once their current run ends and free the pool
+ * with its jobs.
+ */
+void neu_scan_pool_free(neu_scan_pool_t *pool);
+
+/**
+ * @brief Change the number of workers, the workers removed finish their
+ * current run first.
+ *
+ * @return 0 on success, -1 if n_worker is out of range.
+ */
+int neu_scan_pool_set_workers(neu_scan_pool_t *pool, int n_worker);
+int neu_scan_pool_workers(neu_scan_pool_t *pool);
+
+/**
+ * @brief Parse "timer", "skip", "phase" or "stretch".
+ */
+int  neu_scan_policy_parse(const char *str, neu_scan_policy_e *policy);
+void neu_scan_pool_set_policy(neu_scan_pool_t *pool, neu_scan_policy_e policy);
+
+/**
+ * @brief Add a job, first due one interval from now, or at its phase within
+ * the interval with NEU_SCAN_POLICY_PHASE.
+ *
+ * @param[in] interval milliseconds, 0 only runs on neu_scan_pool_trigger.
+ */
+neu_scan_job_t *neu_scan_pool_add(neu_scan_pool_t *pool, uint32_t lane,
+                                  uint32_t               interval,
+                                  neu_event_timer_type_e type, neu_scan_cb_t cb,
+                                  void *usr_data);
+
+/**
+ * @brief Remove a job. It waits for the current run of the job to end, unless
+ * called by the job itself, then the job is freed once it returns.
+ */
+void neu_scan_pool_del(neu_scan_pool_t *pool, neu_scan_job_t *job);
+
+/**
+ * @brief Make a job due now, or once more right after its current run.
+ */
+void neu_scan_pool_trigger(neu_scan_pool_t *pool, neu_scan_job_t *job);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <stdlib.h>
+#include <string.h>
+
+#include "write_merge.h"
+
+struct neu_write_merge {
+    UT_array *tvs;
+    // the group of every tag value, same index as tvs
+    UT_array *groups;
+};
+
+neu_write_merge_t *neu_write_merge_new(void)
+{
+    UT_icd icd = { sizeof(neu_plugin_tag_value_t), NULL, NULL, NULL };
+    neu_write_merge_t *merge = calloc(1, sizeof(neu_write_merge_t));
+
+    utarray_new(merge->tvs, &icd);
+    utarray_new(merge->groups, &ut_ptr_icd);
+    return merge;
+}
+
+void neu_write_merge_free(neu_write_merge_t *merge)
+{
+    utarray_foreach(merge->tvs, neu_plugin_tag_value_t *, tv)
+    {
+        neu_tag_free(tv->tag);
+    }
+    utarray_free(merge->tvs);
+    utarray_free(merge->groups);
+    free(merge);
+}
+
+void neu_write_merge_add(neu_write_merge_t *merge, const char *group,
+                         neu_datatag_t *tag, neu_value_u value)
+{
+    for (unsigned i = 0; i < utarray_len(merge->tvs); i++) {
+        neu_plugin_tag_value_t *tv =
+            (neu_plugin_tag_value_t *) utarray_eltptr(merge->tvs, i);
+        const char *g = *(const char **) utarray_eltptr(merge->groups, i);
+
+        if (strcmp(g, group) == 0 && strcmp(tv->tag->name, tag->name) == 0) {
+            neu_tag_free(tv->tag);
+            tv->tag   = tag;
+            tv->value = value;
+            return;
+        }
+    }
+
+    neu_plugin_tag_value_t tv = {
+        .tag   = tag,
+        .value = value,
+    };
+    utarray_push_back(merge->tvs, &tv);
+    utarray_push_back(merge->groups, &group);
+}
+
+UT_array *neu_write_merge_tvs(neu_write_merge_t *merge)
+{
+    return merge->tvs;
+}
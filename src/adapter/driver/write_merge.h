@@ -0,0 +1,56 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_DRIVER_WRITE_MERGE_H_
+#define _NEU_DRIVER_WRITE_MERGE_H_
+
+#include "utils/utarray.h"
+
+#include "plugin.h"
+#include "tag.h"
+
+/**
+ * Single tag writes merged into the tag values of one write_tags call. The
+ * pending writes are driver wide, so a tag is identified by its group and
+ * its name, the later write to the same tag wins.
+ */
+typedef struct neu_write_merge neu_write_merge_t;
+
+neu_write_merge_t *neu_write_merge_new(void);
+
+/**
+ * @brief Free the merge and the tags still in it.
+ */
+void neu_write_merge_free(neu_write_merge_t *merge);
+
+/**
+ * @brief Add a tag write, the merge takes the ownership of tag.
+ *
+ * @param[in] group the group of the tag, must outlive the merge.
+ */
+void neu_write_merge_add(neu_write_merge_t *merge, const char *group,
+                         neu_datatag_t *tag, neu_value_u value);
+
+/**
+ * @return the merged writes, an array of neu_plugin_tag_value_t owned by the
+ * merge.
+ */
+UT_array *neu_write_merge_tvs(neu_write_merge_t *merge);
+
+#endif
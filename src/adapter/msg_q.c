@@ -17,100 +17,366 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 #include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "utils/log.h"
-#include "utils/utextend.h"
+#include "utils/uthash.h"
+
+#include "define.h"
 
 #include "msg_q.h"
 
-struct item {
+// latest pending snapshot of one driver/group in coalesce mode
+struct slot {
+    // driver name followed by group name, zero padded
+    char key[NEU_NODE_NAME_LEN + NEU_GROUP_NAME_LEN];
+
+    neu_msg_t *latest;
+
+    UT_hash_handle hh;
+};
+
+// either a message or, in coalesce mode, a token for a slot
+struct cell {
+    size_t       seq;
     neu_msg_t *  msg;
-    struct item *prev, *next;
+    struct slot *slot;
+    int64_t      ts;
 };
 
 struct adapter_msg_q {
-    struct item *list;
-    uint32_t     max;
-    uint32_t     current;
     char *       name;
+    uint32_t     max;
+    size_t       mask;
+    struct cell *cells;
+
+    // bounded ring with per cell sequence numbers, dequeue is also done by
+    // producers when they evict the oldest message
+    size_t head __attribute__((aligned(64)));
+    size_t tail __attribute__((aligned(64)));
+
+    sem_t items __attribute__((aligned(64)));
 
-    pthread_mutex_t mtx;
-    pthread_cond_t  cond;
+    adapter_msg_q_policy_e policy;
+    uint64_t               drops;
+
+    pthread_rwlock_t slots_lock;
+    struct slot *    slots;
 };
 
+static inline int64_t now_us()
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static inline uint32_t depth(adapter_msg_q_t *q)
+{
+    // head first, tail can only have moved further since
+    size_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+
+    return (uint32_t)(tail - head);
+}
+
+static void drop_msg(adapter_msg_q_t *q, neu_msg_t *msg)
+{
+    neu_reqresp_head_t *header = neu_msg_get_header(msg);
+
+    neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
+    neu_msg_free(msg);
+    __atomic_add_fetch(&q->drops, 1, __ATOMIC_RELAXED);
+}
+
+static bool enqueue(adapter_msg_q_t *q, neu_msg_t *msg, struct slot *slot)
+{
+    struct cell *cell = NULL;
+    size_t       pos  = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+
+    while (true) {
+        cell          = &q->cells[pos & q->mask];
+        size_t   seq  = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->msg  = msg;
+    cell->slot = slot;
+    cell->ts   = now_us();
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    sem_post(&q->items);
+    return true;
+}
+
+static bool dequeue(adapter_msg_q_t *q, struct cell *out)
+{
+    struct cell *cell = NULL;
+    size_t       pos  = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+
+    while (true) {
+        cell          = &q->cells[pos & q->mask];
+        size_t   seq  = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t) seq - (intptr_t)(pos + 1);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    *out = *cell;
+    __atomic_store_n(&cell->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// a slot token carries whatever snapshot is the latest when it is taken
+static inline neu_msg_t *cell_take(struct cell *cell)
+{
+    if (cell->slot != NULL) {
+        return __atomic_exchange_n(&cell->slot->latest, NULL,
+                                   __ATOMIC_ACQ_REL);
+    }
+
+    return cell->msg;
+}
+
+static void evict_oldest(adapter_msg_q_t *q)
+{
+    struct cell cell = { 0 };
+
+    if (!dequeue(q, &cell)) {
+        // the consumer emptied the ring in between
+        return;
+    }
+
+    // the consumer may already be awake for this message, it will find
+    // the ring empty and wait again
+    sem_trywait(&q->items);
+
+    neu_msg_t *msg = cell_take(&cell);
+    if (msg != NULL) {
+        drop_msg(q, msg);
+    }
+}
+
+static struct slot *find_slot(adapter_msg_q_t *q, neu_msg_t *msg)
+{
+    neu_reqresp_head_t *      header = neu_msg_get_header(msg);
+    neu_reqresp_trans_data_t *data   = (neu_reqresp_trans_data_t *) &header[1];
+    struct slot *             slot   = NULL;
+    char key[NEU_NODE_NAME_LEN + NEU_GROUP_NAME_LEN] = { 0 };
+
+    if (data->driver == NULL || data->group == NULL) {
+        return NULL;
+    }
+
+    strncpy(key, data->driver, NEU_NODE_NAME_LEN - 1);
+    strncpy(key + NEU_NODE_NAME_LEN, data->group, NEU_GROUP_NAME_LEN - 1);
+
+    pthread_rwlock_rdlock(&q->slots_lock);
+    HASH_FIND(hh, q->slots, key, sizeof(key), slot);
+    pthread_rwlock_unlock(&q->slots_lock);
+
+    if (slot == NULL) {
+        pthread_rwlock_wrlock(&q->slots_lock);
+        HASH_FIND(hh, q->slots, key, sizeof(key), slot);
+        if (slot == NULL) {
+            slot = calloc(1, sizeof(struct slot));
+            memcpy(slot->key, key, sizeof(key));
+            HASH_ADD(hh, q->slots, key, sizeof(key), slot);
+        }
+        pthread_rwlock_unlock(&q->slots_lock);
+    }
+
+    return slot;
+}
+
+static int push_coalesce(adapter_msg_q_t *q, neu_msg_t *msg)
+{
+    struct slot *slot = find_slot(q, msg);
+    if (slot == NULL) {
+        return -1;
+    }
+
+    neu_msg_t *old = __atomic_exchange_n(&slot->latest, msg, __ATOMIC_ACQ_REL);
+    if (old != NULL) {
+        // a token for this slot is still queued and will pick up msg
+        drop_msg(q, old);
+        return 0;
+    }
+
+    if (!enqueue(q, NULL, slot)) {
+        // more pending groups than the queue can hold, no token refers
+        // to the slot so nobody else can have taken the message
+        old = __atomic_exchange_n(&slot->latest, NULL, __ATOMIC_ACQ_REL);
+        if (old != NULL) {
+            drop_msg(q, old);
+        }
+    }
+
+    return 0;
+}
+
 adapter_msg_q_t *adapter_msg_q_new(const char *name, uint32_t size)
 {
-    struct adapter_msg_q *q = calloc(1, sizeof(struct adapter_msg_q));
+    struct adapter_msg_q *q   = calloc(1, sizeof(struct adapter_msg_q));
+    size_t                cap = 2;
 
-    pthread_mutex_init(&q->mtx, NULL);
-    pthread_cond_init(&q->cond, NULL);
-    q->max     = size;
-    q->name    = strdup(name);
-    q->current = 0;
+    // capacity is rounded up to a power of two
+    while (cap < size) {
+        cap <<= 1;
+    }
+
+    q->name  = strdup(name);
+    q->max   = size;
+    q->mask  = cap - 1;
+    q->cells = calloc(cap, sizeof(struct cell));
+    for (size_t i = 0; i < cap; i++) {
+        q->cells[i].seq = i;
+    }
+
+    sem_init(&q->items, 0, 0);
+    pthread_rwlock_init(&q->slots_lock, NULL);
+    q->policy = ADAPTER_MSG_Q_DROP_NEWEST;
 
     return q;
 }
 
 void adapter_msg_q_free(adapter_msg_q_t *q)
 {
-    struct item *tmp = NULL, *elt = NULL;
-    nlog_warn("app: %s, drop %u msg", q->name, q->current);
-    pthread_mutex_destroy(&q->mtx);
-    pthread_cond_destroy(&q->cond);
+    struct cell  cell = { 0 };
+    struct slot *slot = NULL, *tmp = NULL;
+    uint32_t     n    = 0;
+
+    while (dequeue(q, &cell)) {
+        neu_msg_t *msg = cell_take(&cell);
+        if (msg != NULL) {
+            drop_msg(q, msg);
+            n += 1;
+        }
+    }
+    nlog_warn("app: %s, drop %u msg", q->name, n);
 
-    DL_FOREACH_SAFE(q->list, elt, tmp)
+    HASH_ITER(hh, q->slots, slot, tmp)
     {
-        DL_DELETE(q->list, elt);
-        neu_reqresp_head_t *header = neu_msg_get_header(elt->msg);
-        neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
-        neu_msg_free(elt->msg);
-        free(elt);
+        HASH_DEL(q->slots, slot);
+        free(slot);
     }
+
+    sem_destroy(&q->items);
+    pthread_rwlock_destroy(&q->slots_lock);
+    free(q->cells);
     free(q->name);
     free(q);
 }
 
+int adapter_msg_q_policy_parse(const char *str, adapter_msg_q_policy_e *policy)
+{
+    if (strcmp(str, "drop_newest") == 0) {
+        *policy = ADAPTER_MSG_Q_DROP_NEWEST;
+    } else if (strcmp(str, "drop_oldest") == 0) {
+        *policy = ADAPTER_MSG_Q_DROP_OLDEST;
+    } else if (strcmp(str, "coalesce") == 0) {
+        *policy = ADAPTER_MSG_Q_COALESCE;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+void adapter_msg_q_set_policy(adapter_msg_q_t *q, adapter_msg_q_policy_e policy)
+{
+    if (__atomic_exchange_n(&q->policy, policy, __ATOMIC_RELAXED) != policy) {
+        nlog_notice("app: %s, msg q policy: %d", q->name, policy);
+    }
+}
+
 int adapter_msg_q_push(adapter_msg_q_t *q, neu_msg_t *msg)
 {
-    int ret = -1;
-    pthread_mutex_lock(&q->mtx);
-    if (q->current < q->max) {
-        q->current += 1;
-        struct item *elt = calloc(1, sizeof(struct item));
-        elt->msg         = msg;
-        DL_APPEND(q->list, elt);
-        ret = 0;
+    switch (__atomic_load_n(&q->policy, __ATOMIC_RELAXED)) {
+    case ADAPTER_MSG_Q_COALESCE:
+        if (push_coalesce(q, msg) == 0) {
+            return 0;
+        }
+        break;
+    case ADAPTER_MSG_Q_DROP_OLDEST:
+        while (!enqueue(q, msg, NULL)) {
+            evict_oldest(q);
+        }
+        return 0;
+    case ADAPTER_MSG_Q_DROP_NEWEST:
+        break;
     }
-    pthread_mutex_unlock(&q->mtx);
 
-    if (ret == -1) {
-        nlog_warn("app: %s, msg q is full, %u(%u)", q->name, q->current,
-                  q->max);
-    } else {
-        pthread_cond_signal(&q->cond);
+    if (enqueue(q, msg, NULL)) {
+        return 0;
     }
 
-    return ret;
+    __atomic_add_fetch(&q->drops, 1, __ATOMIC_RELAXED);
+    nlog_warn("app: %s, msg q is full(%u)", q->name, q->max);
+    return -1;
 }
 
-uint32_t adapter_msg_q_pop(adapter_msg_q_t *q, neu_msg_t **p_data)
+uint32_t adapter_msg_q_pop(adapter_msg_q_t *q, neu_msg_t **p_data,
+                           uint32_t *latency_us)
 {
-    uint32_t ret = 0;
+    struct cell cell = { 0 };
+    neu_msg_t * msg  = NULL;
+
+    while (msg == NULL) {
+        if (sem_wait(&q->items) != 0) {
+            continue;
+        }
 
-    pthread_mutex_lock(&q->mtx);
-    while (q->current == 0) {
-        pthread_cond_wait(&q->cond, &q->mtx);
+        bool ok = false;
+        while (!(ok = dequeue(q, &cell)) && depth(q) > 0) {
+            // the oldest cell is claimed but not yet written, the post we
+            // consumed belongs to a later one
+            sched_yield();
+        }
+        // otherwise the message was evicted by a producer
+        if (ok) {
+            msg = cell_take(&cell);
+        }
     }
-    struct item *elt = DL_LAST(q->list);
 
-    if (elt != NULL) {
-        DL_DELETE(q->list, elt);
-        *p_data = elt->msg;
-        free(elt);
-        q->current -= 1;
-        ret = q->current;
+    if (latency_us != NULL) {
+        int64_t delta = now_us() - cell.ts;
+        *latency_us   = delta > UINT32_MAX ? UINT32_MAX : (uint32_t) delta;
     }
 
-    pthread_mutex_unlock(&q->mtx);
-    return ret;
+    *p_data = msg;
+    return depth(q);
+}
+
+void adapter_msg_q_stats(adapter_msg_q_t *q, adapter_msg_q_stats_t *stats)
+{
+    stats->depth = depth(q);
+    stats->drops = __atomic_load_n(&q->drops, __ATOMIC_RELAXED);
 }
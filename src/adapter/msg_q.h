@@ -25,12 +25,50 @@
 #include "base/msg_internal.h"
 #include "msg.h"
 
+/**
+ * What to do with trans data when the app consumer falls behind and the
+ * queue is full.
+ */
+typedef enum {
+    // reject the incoming message, the default
+    ADAPTER_MSG_Q_DROP_NEWEST = 0,
+    // evict the oldest queued message to make room
+    ADAPTER_MSG_Q_DROP_OLDEST,
+    // keep only the latest pending snapshot of each driver/group
+    ADAPTER_MSG_Q_COALESCE,
+} adapter_msg_q_policy_e;
+
+typedef struct {
+    uint32_t depth;
+    // messages dropped since the queue was created
+    uint64_t drops;
+} adapter_msg_q_stats_t;
+
 typedef struct adapter_msg_q adapter_msg_q_t;
 
 adapter_msg_q_t *adapter_msg_q_new(const char *name, uint32_t size);
 void             adapter_msg_q_free(adapter_msg_q_t *q);
 
-int      adapter_msg_q_push(adapter_msg_q_t *q, neu_msg_t *msg);
-uint32_t adapter_msg_q_pop(adapter_msg_q_t *q, neu_msg_t **p_data);
+int  adapter_msg_q_policy_parse(const char *            str,
+                                adapter_msg_q_policy_e *policy);
+void adapter_msg_q_set_policy(adapter_msg_q_t *      q,
+                              adapter_msg_q_policy_e policy);
+
+/**
+ * Multiple producers, single consumer. Returns 0 when the queue took
+ * ownership of msg (it may still be dropped later by the policy), or -1
+ * when the message was rejected and still belongs to the caller.
+ */
+int adapter_msg_q_push(adapter_msg_q_t *q, neu_msg_t *msg);
+
+/**
+ * Blocks until a message is available and pops the oldest one. latency_us
+ * is the time it spent in the queue, may be NULL. Returns the number of
+ * messages still queued.
+ */
+uint32_t adapter_msg_q_pop(adapter_msg_q_t *q, neu_msg_t **p_data,
+                           uint32_t *latency_us);
+
+void adapter_msg_q_stats(adapter_msg_q_t *q, adapter_msg_q_stats_t *stats);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,466 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "errcodes.h"
+#include "utils/log.h"
+#include "utils/uthash.h"
+
+#include "msg_ring.h"
+
+#define CACHE_LINE 64
+
+struct cell {
+    uint32_t   seq;
+    neu_msg_t *msg;
+};
+
+typedef struct ring {
+    // consumer index
+    uint32_t head __attribute__((aligned(CACHE_LINE)));
+    // producer index, the threads of one producer claim cells with a CAS
+    uint32_t tail __attribute__((aligned(CACHE_LINE)));
+
+    uint32_t     mask;
+    struct cell *cells;
+
+    uint16_t port;
+    // set once, by the inbox when it is freed and by the outbox when it is
+    // freed; the ring itself is freed when both dropped their reference
+    bool     closed;
+    bool     detached;
+    uint32_t ref;
+
+    adapter_msg_inbox_t *inbox;
+    struct ring *        retired_next;
+} ring_t;
+
+struct adapter_msg_inbox {
+    char *   name;
+    uint16_t port;
+    uint32_t size;
+    int      efd;
+    // the consumer and each ring, the eventfd outlives the consumer as long
+    // as a producer may still write it
+    uint32_t ref;
+
+    // set by the first producer after the consumer went idle
+    uint32_t pending;
+
+    // changed under registry_mtx, read by the consumer without it
+    ring_t * rings[ADAPTER_MSG_RING_MAX_PRODUCER];
+    uint32_t n_ring;
+    uint32_t next;
+
+    UT_hash_handle hh;
+};
+
+struct adapter_msg_outbox {
+    char *name;
+
+    // only taken to attach a ring, sends read the rings without it
+    pthread_mutex_t mtx;
+    ring_t *        rings[ADAPTER_MSG_RING_MAX_DEST];
+    uint32_t        n_ring;
+    // closed rings replaced by a newer one, a send may still be pushing
+    // into one, so they are kept until the outbox is freed
+    ring_t *retired;
+};
+
+// inboxes by port, also guards the ring arrays of the inboxes
+static pthread_mutex_t      registry_mtx = PTHREAD_MUTEX_INITIALIZER;
+static adapter_msg_inbox_t *inboxes      = NULL;
+
+static void inbox_unref(adapter_msg_inbox_t *inbox)
+{
+    if (__atomic_sub_fetch(&inbox->ref, 1, __ATOMIC_ACQ_REL) == 0) {
+        close(inbox->efd);
+        free(inbox->name);
+        free(inbox);
+    }
+}
+
+// must be called with registry_mtx held
+static ring_t *ring_new(adapter_msg_inbox_t *inbox)
+{
+    ring_t *ring = NULL;
+
+    if (posix_memalign((void **) &ring, CACHE_LINE, sizeof(ring_t)) != 0) {
+        return NULL;
+    }
+    memset(ring, 0, sizeof(ring_t));
+
+    ring->cells = calloc(inbox->size, sizeof(struct cell));
+    if (ring->cells == NULL) {
+        free(ring);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < inbox->size; i++) {
+        ring->cells[i].seq = i;
+    }
+
+    ring->mask  = inbox->size - 1;
+    ring->port  = inbox->port;
+    ring->inbox = inbox;
+    // one for the inbox, one for the outbox
+    ring->ref = 2;
+    __atomic_add_fetch(&inbox->ref, 1, __ATOMIC_RELAXED);
+    return ring;
+}
+
+static int ring_push(ring_t *ring, neu_msg_t *msg)
+{
+    struct cell *cell = NULL;
+    uint32_t     pos  = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+
+    while (true) {
+        cell          = &ring->cells[pos & ring->mask];
+        uint32_t seq  = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        int32_t  diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NEU_ERR_EINTERNAL;
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->msg = msg;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static bool ring_empty(ring_t *ring)
+{
+    struct cell *cell = &ring->cells[ring->head & ring->mask];
+
+    return __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != ring->head + 1;
+}
+
+static neu_msg_t *ring_pop(ring_t *ring)
+{
+    uint32_t     head = ring->head;
+    struct cell *cell = &ring->cells[head & ring->mask];
+    neu_msg_t *  msg  = NULL;
+
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != head + 1) {
+        return NULL;
+    }
+
+    msg = cell->msg;
+    __atomic_store_n(&cell->seq, head + ring->mask + 1, __ATOMIC_RELEASE);
+    ring->head = head + 1;
+    return msg;
+}
+
+static void ring_unref(ring_t *ring)
+{
+    neu_msg_t *msg = NULL;
+
+    if (__atomic_sub_fetch(&ring->ref, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    while ((msg = ring_pop(ring)) != NULL) {
+        neu_reqresp_head_t *header = neu_msg_get_header(msg);
+
+        neu_trans_data_free((neu_reqresp_trans_data_t *) &header[1]);
+        neu_msg_free(msg);
+    }
+
+    inbox_unref(ring->inbox);
+    free(ring->cells);
+    free(ring);
+}
+
+adapter_msg_inbox_t *adapter_msg_inbox_new(const char *name, uint16_t port,
+                                           uint32_t size)
+{
+    adapter_msg_inbox_t *inbox = calloc(1, sizeof(adapter_msg_inbox_t));
+    adapter_msg_inbox_t *find  = NULL;
+
+    if (inbox == NULL) {
+        return NULL;
+    }
+
+    inbox->size = 2;
+    while (inbox->size < size) {
+        inbox->size <<= 1;
+    }
+    inbox->port = port;
+    inbox->ref  = 1;
+    inbox->name = strdup(name);
+    inbox->efd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inbox->efd < 0 || inbox->name == NULL) {
+        nlog_error("app: %s, create msg inbox fail", name);
+        if (inbox->efd >= 0) {
+            close(inbox->efd);
+        }
+        free(inbox->name);
+        free(inbox);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&registry_mtx);
+    HASH_FIND(hh, inboxes, &port, sizeof(port), find);
+    if (find == NULL) {
+        HASH_ADD(hh, inboxes, port, sizeof(inbox->port), inbox);
+    }
+    pthread_mutex_unlock(&registry_mtx);
+
+    if (find != NULL) {
+        nlog_error("app: %s, msg inbox port %hu in use", name, port);
+        close(inbox->efd);
+        free(inbox->name);
+        free(inbox);
+        return NULL;
+    }
+
+    return inbox;
+}
+
+void adapter_msg_inbox_free(adapter_msg_inbox_t *inbox)
+{
+    pthread_mutex_lock(&registry_mtx);
+    HASH_DELETE(hh, inboxes, inbox);
+    for (uint32_t i = 0; i < inbox->n_ring; i++) {
+        // the producer attaches a ring of the next inbox on this port
+        __atomic_store_n(&inbox->rings[i]->closed, true, __ATOMIC_RELEASE);
+        ring_unref(inbox->rings[i]);
+    }
+    inbox->n_ring = 0;
+    pthread_mutex_unlock(&registry_mtx);
+
+    inbox_unref(inbox);
+}
+
+int adapter_msg_inbox_fd(adapter_msg_inbox_t *inbox)
+{
+    return inbox->efd;
+}
+
+void adapter_msg_inbox_ack(adapter_msg_inbox_t *inbox)
+{
+    eventfd_t value = 0;
+
+    eventfd_read(inbox->efd, &value);
+    // pairs with the fence in wake(): a message published after this point
+    // either is seen by the following pops, or wakes the inbox again
+    __atomic_store_n(&inbox->pending, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+// drop the drained rings of freed outboxes, so their slots can be reused
+static void reap_rings(adapter_msg_inbox_t *inbox)
+{
+    pthread_mutex_lock(&registry_mtx);
+    for (uint32_t i = 0; i < inbox->n_ring;) {
+        ring_t *ring = inbox->rings[i];
+
+        if (__atomic_load_n(&ring->detached, __ATOMIC_ACQUIRE) &&
+            ring_empty(ring)) {
+            inbox->rings[i] = inbox->rings[inbox->n_ring - 1];
+            __atomic_store_n(&inbox->n_ring, inbox->n_ring - 1,
+                             __ATOMIC_RELEASE);
+            ring_unref(ring);
+        } else {
+            i++;
+        }
+    }
+    inbox->next = 0;
+    pthread_mutex_unlock(&registry_mtx);
+}
+
+neu_msg_t *adapter_msg_inbox_pop(adapter_msg_inbox_t *inbox)
+{
+    uint32_t n        = __atomic_load_n(&inbox->n_ring, __ATOMIC_ACQUIRE);
+    bool     detached = false;
+
+    // round robin, so one busy producer does not starve the others
+    for (uint32_t i = 0; i < n; i++) {
+        ring_t *   ring = inbox->rings[(inbox->next + i) % n];
+        neu_msg_t *msg  = ring_pop(ring);
+
+        if (msg != NULL) {
+            inbox->next = (inbox->next + i + 1) % n;
+            return msg;
+        }
+        if (__atomic_load_n(&ring->detached, __ATOMIC_ACQUIRE)) {
+            detached = true;
+        }
+    }
+
+    if (detached) {
+        reap_rings(inbox);
+    }
+    return NULL;
+}
+
+static void wake(adapter_msg_inbox_t *inbox)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&inbox->pending, 1, __ATOMIC_RELAXED) == 0) {
+        eventfd_write(inbox->efd, 1);
+    }
+}
+
+adapter_msg_outbox_t *adapter_msg_outbox_new(const char *name)
+{
+    adapter_msg_outbox_t *outbox = calloc(1, sizeof(adapter_msg_outbox_t));
+
+    if (outbox == NULL) {
+        return NULL;
+    }
+
+    outbox->name = strdup(name);
+    if (outbox->name == NULL) {
+        free(outbox);
+        return NULL;
+    }
+    pthread_mutex_init(&outbox->mtx, NULL);
+
+    return outbox;
+}
+
+void adapter_msg_outbox_free(adapter_msg_outbox_t *outbox)
+{
+    for (uint32_t i = 0; i < outbox->n_ring; i++) {
+        ring_t *ring = outbox->rings[i];
+
+        // the consumer drops the ring once it has drained it
+        __atomic_store_n(&ring->detached, true, __ATOMIC_RELEASE);
+        wake(ring->inbox);
+        ring_unref(ring);
+    }
+
+    while (outbox->retired != NULL) {
+        ring_t *ring    = outbox->retired;
+        outbox->retired = ring->retired_next;
+        ring_unref(ring);
+    }
+
+    pthread_mutex_destroy(&outbox->mtx);
+    free(outbox->name);
+    free(outbox);
+}
+
+static ring_t *find_ring(adapter_msg_outbox_t *outbox, uint16_t port)
+{
+    uint32_t n = __atomic_load_n(&outbox->n_ring, __ATOMIC_ACQUIRE);
+
+    for (uint32_t i = 0; i < n; i++) {
+        ring_t *ring = __atomic_load_n(&outbox->rings[i], __ATOMIC_ACQUIRE);
+
+        if (ring->port == port) {
+            return ring;
+        }
+    }
+
+    return NULL;
+}
+
+static ring_t *attach_ring(adapter_msg_outbox_t *outbox, uint16_t port)
+{
+    adapter_msg_inbox_t *inbox = NULL;
+    ring_t *             ring  = NULL;
+    int                  slot  = -1;
+
+    pthread_mutex_lock(&outbox->mtx);
+    // another thread of the producer may have attached it meanwhile
+    for (uint32_t i = 0; i < outbox->n_ring; i++) {
+        if (outbox->rings[i]->port == port) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot >= 0 &&
+        !__atomic_load_n(&outbox->rings[slot]->closed, __ATOMIC_ACQUIRE)) {
+        ring = outbox->rings[slot];
+        pthread_mutex_unlock(&outbox->mtx);
+        return ring;
+    }
+    // a new destination takes the slot of a deleted app first
+    for (uint32_t i = 0; slot < 0 && i < outbox->n_ring; i++) {
+        if (__atomic_load_n(&outbox->rings[i]->closed, __ATOMIC_ACQUIRE)) {
+            slot = i;
+        }
+    }
+    if (slot < 0 && outbox->n_ring >= ADAPTER_MSG_RING_MAX_DEST) {
+        pthread_mutex_unlock(&outbox->mtx);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&registry_mtx);
+    HASH_FIND(hh, inboxes, &port, sizeof(port), inbox);
+    if (inbox != NULL && inbox->n_ring < ADAPTER_MSG_RING_MAX_PRODUCER &&
+        (ring = ring_new(inbox)) != NULL) {
+        inbox->rings[inbox->n_ring] = ring;
+        __atomic_store_n(&inbox->n_ring, inbox->n_ring + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&registry_mtx);
+
+    if (ring != NULL) {
+        if (slot >= 0) {
+            outbox->rings[slot]->retired_next = outbox->retired;
+            outbox->retired                   = outbox->rings[slot];
+            __atomic_store_n(&outbox->rings[slot], ring, __ATOMIC_RELEASE);
+        } else {
+            outbox->rings[outbox->n_ring] = ring;
+            __atomic_store_n(&outbox->n_ring, outbox->n_ring + 1,
+                             __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&outbox->mtx);
+
+    return ring;
+}
+
+int adapter_msg_outbox_send(adapter_msg_outbox_t *outbox, uint16_t port,
+                            neu_msg_t *msg)
+{
+    ring_t *ring = find_ring(outbox, port);
+    int     ret  = 0;
+
+    if (ring == NULL || __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE)) {
+        ring = attach_ring(outbox, port);
+        if (ring == NULL) {
+            return NEU_ERR_NODE_NOT_EXIST;
+        }
+    }
+
+    ret = ring_push(ring, msg);
+    if (ret == 0) {
+        wake(ring->inbox);
+    } else {
+        nlog_warn("%s to app: %s, msg ring is full", outbox->name,
+                  ring->inbox->name);
+    }
+
+    return ret;
+}
@@ -0,0 +1,102 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef ADAPTER_MSG_RING_H
+#define ADAPTER_MSG_RING_H
+
+#include <stdint.h>
+
+#include "base/msg_internal.h"
+
+/**
+ * In-process transport of trans data between adapters.
+ *
+ * An app registers an inbox under its trans data port. Every producer
+ * adapter owns an outbox, which gets its own ring into each inbox it sends
+ * to and keeps the ring pointer, so a send neither looks up nor locks
+ * anything. The threads of one producer push with a compare and swap on the
+ * ring tail, the consumer never takes a lock. All the rings of an inbox
+ * share one eventfd, it is only written when the inbox goes from idle to
+ * pending, so a burst of messages costs one wakeup.
+ *
+ * A ring is shared by its inbox and its outbox and freed when both let go
+ * of it: freeing the inbox closes it for the producer, freeing the outbox
+ * detaches it and the consumer drops it once it is drained.
+ *
+ * The abstract socket of the port stays the fallback for a destination
+ * without an inbox.
+ */
+typedef struct adapter_msg_inbox  adapter_msg_inbox_t;
+typedef struct adapter_msg_outbox adapter_msg_outbox_t;
+
+#define ADAPTER_MSG_RING_MAX_PRODUCER 256
+#define ADAPTER_MSG_RING_MAX_DEST 64
+
+/**
+ * @brief Create and register the inbox of a port.
+ *
+ * @param[in] size capacity of each ring, rounded up to a power of 2.
+ * @return NULL on failure or when the port is already registered.
+ */
+adapter_msg_inbox_t *adapter_msg_inbox_new(const char *name, uint16_t port,
+                                           uint32_t size);
+
+/**
+ * @brief Unregister the inbox and close its rings. The messages left in a
+ * ring are freed with the ring. Must not race with the consumer.
+ */
+void adapter_msg_inbox_free(adapter_msg_inbox_t *inbox);
+
+/**
+ * @brief The eventfd to poll for reading.
+ */
+int adapter_msg_inbox_fd(adapter_msg_inbox_t *inbox);
+
+/**
+ * @brief Consume the wakeup. The consumer then pops until
+ * adapter_msg_inbox_pop returns NULL.
+ */
+void adapter_msg_inbox_ack(adapter_msg_inbox_t *inbox);
+
+/**
+ * @brief Pop the next message of any ring. Rings whose outbox is freed are
+ * dropped here once they are drained.
+ */
+neu_msg_t *adapter_msg_inbox_pop(adapter_msg_inbox_t *inbox);
+
+adapter_msg_outbox_t *adapter_msg_outbox_new(const char *name);
+
+/**
+ * @brief Detach the rings of the outbox from their inboxes. Must not race
+ * with a send.
+ */
+void adapter_msg_outbox_free(adapter_msg_outbox_t *outbox);
+
+/**
+ * @brief Send a message to the inbox of port through the ring of outbox.
+ *
+ * @return 0 on success, the ring owns msg;
+ *         NEU_ERR_NODE_NOT_EXIST when no inbox is registered on port, or
+ *         either side has no room for another ring, use the socket instead;
+ *         NEU_ERR_EINTERNAL when the ring is full.
+ */
+int adapter_msg_outbox_send(adapter_msg_outbox_t *outbox, uint16_t port,
+                            neu_msg_t *msg);
+
+#endif
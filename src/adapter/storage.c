@@ -154,10 +154,28 @@ int adapter_load_group_and_tag(neu_adapter_driver_t *driver)
             continue;
         }
 
-        utarray_foreach(tags, neu_datatag_t *, tag)
-        {
-            neu_adapter_driver_add_tag(driver, p->name, tag, -1);
-            neu_adapter_driver_load_tag(driver, p->name, tag, 1);
+        // the tags are validated, added and synced to the plugin at once
+        neu_datatag_t *first = utarray_front(tags);
+        uint32_t       n_tag = utarray_len(tags);
+        uint32_t       index = 0;
+
+        int ret = neu_adapter_driver_validate_tags(driver, p->name, first,
+                                                   n_tag, &index);
+        if (0 == ret) {
+            ret = neu_adapter_driver_add_tags(driver, p->name, first, n_tag,
+                                              p->interval, &index);
+        }
+
+        if (0 == ret && n_tag > 0) {
+            neu_adapter_driver_load_tag(driver, p->name, first, n_tag);
+        } else if (0 != ret) {
+            nlog_warn("load %s:%s tag:%s fail, load tags one by one",
+                      adapter->name, p->name, first[index].name);
+            utarray_foreach(tags, neu_datatag_t *, tag)
+            {
+                neu_adapter_driver_add_tag(driver, p->name, tag, -1);
+                neu_adapter_driver_load_tag(driver, p->name, tag, 1);
+            }
         }
 
         utarray_free(tags);
@@ -29,10 +29,51 @@ typedef struct tag_elem {
     char *name;
 
     neu_datatag_t *tag;
+    uint64_t       seq; // order of addition, the order of the snapshots
 
     UT_hash_handle hh;
 } tag_elem_t;
 
+typedef struct {
+    const char *   name;
+    uint32_t       index;
+    UT_hash_handle hh;
+} snapshot_index_t;
+
+// snapshot indexes of the tags having a trigram in the name or description
+typedef struct {
+    uint32_t       gram;
+    uint32_t       n_tag;
+    uint32_t       cap;
+    uint32_t *     tags; // ascending
+    UT_hash_handle hh;
+} gram_index_t;
+
+typedef struct {
+    bool          built;
+    gram_index_t *grams;
+
+    // matches of the last filtered query, reused by its next pages
+    char *    name;
+    char *    desc;
+    uint32_t *matches;
+    uint32_t  n_match;
+} tags_search_t;
+
+struct neu_group_tags {
+    uint32_t         ref;
+    uint64_t         version;
+    UT_array *       tags;
+    uint64_t *       seqs; // seq of each tag, ascending
+    neu_tag_names_t *names;
+
+    snapshot_index_t *index; // by name, one block of utarray_len(tags)
+    snapshot_index_t *index_block;
+
+    pthread_mutex_t search_mtx;
+    tags_search_t   search; // built by the first filtered query
+};
+
 struct neu_group {
     char *name;
 
@@ -40,7 +81,11 @@ struct neu_group {
     uint32_t    interval;
 
     int64_t         timestamp;
+    uint64_t        version;
+    uint64_t        seq; // of the last added tag
     pthread_mutex_t mtx;
+
+    neu_group_tags_t *read_tags; // snapshot of version, or stale
 };
 
 static UT_array *to_array(tag_elem_t *tags);
@@ -73,6 +118,7 @@ void neu_group_destroy(neu_group_t *group)
     }
     pthread_mutex_unlock(&group->mtx);
 
+    neu_group_tags_unref(group->read_tags);
     pthread_mutex_destroy(&group->mtx);
     free(group->name);
     free(group);
@@ -112,8 +158,10 @@ void neu_group_set_interval(neu_group_t *group, uint32_t interval)
 int neu_group_update(neu_group_t *group, uint32_t interval)
 {
     if (group->interval != interval) {
+        pthread_mutex_lock(&group->mtx);
         group->interval = interval;
         update_timestamp(group);
+        pthread_mutex_unlock(&group->mtx);
     }
 
     return 0;
@@ -133,6 +181,7 @@ int neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag)
     el       = calloc(1, sizeof(tag_elem_t));
     el->name = strdup(tag->name);
     el->tag  = neu_tag_dup(tag);
+    el->seq  = ++group->seq;
 
     HASH_ADD_STR(group->tags, name, el);
     update_timestamp(group);
@@ -141,6 +190,55 @@ int neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag)
     return 0;
 }
 
+int neu_group_add_tags(neu_group_t *group, const neu_datatag_t *tags,
+                       uint32_t n_tag, uint32_t *index)
+{
+    tag_elem_t *el = NULL;
+    uint32_t    i  = 0;
+
+    pthread_mutex_lock(&group->mtx);
+    for (i = 0; i < n_tag; i++) {
+        HASH_FIND_STR(group->tags, tags[i].name, el);
+        if (el != NULL) {
+            break;
+        }
+
+        el       = calloc(1, sizeof(tag_elem_t));
+        el->name = strdup(tags[i].name);
+        el->tag  = neu_tag_dup(&tags[i]);
+        el->seq  = group->seq + 1 + i;
+        HASH_ADD_STR(group->tags, name, el);
+    }
+
+    if (i < n_tag) {
+        // conflict with an existing tag or one earlier in the batch
+        for (uint32_t j = 0; j < i; j++) {
+            HASH_FIND_STR(group->tags, tags[j].name, el);
+            HASH_DEL(group->tags, el);
+            free(el->name);
+            neu_tag_free(el->tag);
+            free(el);
+        }
+        pthread_mutex_unlock(&group->mtx);
+
+        if (index != NULL) {
+            *index = i;
+        }
+        return NEU_ERR_TAG_NAME_CONFLICT;
+    }
+
+    if (n_tag > 0) {
+        group->seq += n_tag;
+        update_timestamp(group);
+    }
+    pthread_mutex_unlock(&group->mtx);
+
+    if (index != NULL) {
+        *index = n_tag;
+    }
+    return NEU_ERR_SUCCESS;
+}
+
 int neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag)
 {
     tag_elem_t *el  = NULL;
@@ -209,34 +307,6 @@ filter_tags(tag_elem_t *tags,
     return array;
 }
 
-static inline UT_array *filter_tags_by_page(
-    tag_elem_t *tags, bool (*predicate)(const neu_datatag_t *, void *data),
-    void *data, int current_page, int page_size, int *total_count)
-{
-    tag_elem_t *el = NULL, *tmp = NULL;
-    UT_array *  array       = NULL;
-    int         count       = 0;
-    int         start_index = (current_page - 1) * page_size;
-    int         end_index   = start_index + page_size;
-
-    utarray_new(array, neu_tag_get_icd());
-    HASH_ITER(hh, tags, el, tmp)
-    {
-        if (predicate(el->tag, data)) {
-            if (count >= start_index && count < end_index) {
-                utarray_push_back(array, el->tag);
-            }
-            count++;
-        }
-    }
-
-    if (total_count) {
-        *total_count = count;
-    }
-
-    return array;
-}
-
 static inline bool is_readable(const neu_datatag_t *tag, void *data)
 {
     (void) data;
@@ -270,12 +340,6 @@ static inline bool match_query(const neu_datatag_t *tag, void *data)
         (!q->desc || description_contains(tag, q->desc));
 }
 
-static inline bool is_readable_and_match_query(const neu_datatag_t *tag,
-                                               void *               data)
-{
-    return is_readable(tag, NULL) && match_query(tag, data);
-}
-
 UT_array *neu_group_query_tag(neu_group_t *group, const char *name)
 {
     UT_array *array = NULL;
@@ -287,55 +351,444 @@ UT_array *neu_group_query_tag(neu_group_t *group, const char *name)
     return array;
 }
 
-UT_array *neu_group_query_read_tag(neu_group_t *group, const char *name,
-                                   const char *desc)
+static inline uint32_t gram_at(const char *str)
 {
-    UT_array *   array = NULL;
-    struct query q     = {
-        .name = (char *) name,
-        .desc = (char *) desc,
-    };
+    return (uint32_t)(uint8_t) str[0] << 16 | (uint32_t)(uint8_t) str[1] << 8 |
+        (uint32_t)(uint8_t) str[2];
+}
 
-    pthread_mutex_lock(&group->mtx);
-    array = filter_tags(group->tags, is_readable_and_match_query, &q);
-    pthread_mutex_unlock(&group->mtx);
+static int add_gram(tags_search_t *search, uint32_t gram, uint32_t index)
+{
+    gram_index_t *el = NULL;
+
+    HASH_FIND(hh, search->grams, &gram, sizeof(gram), el);
+    if (el == NULL) {
+        el = calloc(1, sizeof(gram_index_t));
+        if (el == NULL) {
+            return -1;
+        }
+        el->gram = gram;
+        HASH_ADD(hh, search->grams, gram, sizeof(gram), el);
+    } else if (el->tags[el->n_tag - 1] == index) {
+        return 0;
+    }
+
+    if (el->n_tag == el->cap) {
+        uint32_t  cap  = el->cap > 0 ? el->cap * 2 : 4;
+        uint32_t *tags = realloc(el->tags, cap * sizeof(uint32_t));
+        if (tags == NULL) {
+            return -1;
+        }
+        el->tags = tags;
+        el->cap  = cap;
+    }
+
+    el->tags[el->n_tag++] = index;
+    return 0;
+}
+
+static int add_grams(tags_search_t *search, const char *str, uint32_t index)
+{
+    size_t len = str != NULL ? strlen(str) : 0;
+
+    for (size_t i = 0; i + 3 <= len; i++) {
+        if (add_gram(search, gram_at(&str[i]), index) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void free_search(tags_search_t *search)
+{
+    gram_index_t *el = NULL, *tmp = NULL;
+
+    HASH_ITER(hh, search->grams, el, tmp)
+    {
+        HASH_DEL(search->grams, el);
+        free(el->tags);
+        free(el);
+    }
+
+    free(search->name);
+    free(search->desc);
+    free(search->matches);
+    memset(search, 0, sizeof(*search));
+}
+
+static int build_search(neu_group_tags_t *snapshot)
+{
+    tags_search_t *search = &snapshot->search;
+
+    for (uint32_t i = 0; i < utarray_len(snapshot->tags); i++) {
+        neu_datatag_t *tag = utarray_eltptr(snapshot->tags, i);
+
+        if (add_grams(search, tag->name, i) != 0 ||
+            add_grams(search, tag->description, i) != 0) {
+            free_search(search);
+            return -1;
+        }
+    }
+
+    search->built = true;
+    return 0;
+}
+
+// the shortest list of tags sharing a trigram with str, every tag containing
+// str is in it. -1 if str is too short to have any trigram.
+static int rarest_gram(const tags_search_t *search, const char *str,
+                       const uint32_t **tags, uint32_t *n_tag)
+{
+    size_t len = str != NULL ? strlen(str) : 0;
+
+    if (len < 3) {
+        return -1;
+    }
+
+    *tags  = NULL;
+    *n_tag = UINT32_MAX;
+    for (size_t i = 0; i + 3 <= len; i++) {
+        uint32_t      gram = gram_at(&str[i]);
+        gram_index_t *el   = NULL;
+
+        HASH_FIND(hh, search->grams, &gram, sizeof(gram), el);
+        if (el == NULL) {
+            *tags  = NULL;
+            *n_tag = 0;
+            break;
+        }
+
+        if (el->n_tag < *n_tag) {
+            *tags  = el->tags;
+            *n_tag = el->n_tag;
+        }
+    }
+
+    return 0;
+}
+
+static inline bool same_str(const char *a, const char *b)
+{
+    return a == b || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+static char *dup_str(const char *str)
+{
+    return str != NULL ? strdup(str) : NULL;
+}
+
+// sets search.matches to the snapshot indexes of the tags matching the query
+static int search_matches(neu_group_tags_t *snapshot, const char *name,
+                          const char *desc)
+{
+    tags_search_t * search  = &snapshot->search;
+    struct query    q       = { .name = (char *) name, .desc = (char *) desc };
+    const uint32_t *cand    = NULL;
+    uint32_t        n_cand  = utarray_len(snapshot->tags);
+    const uint32_t *tags    = NULL;
+    uint32_t        n_tag   = 0;
+    uint32_t *      matches = NULL;
+    uint32_t        n_match = 0;
+
+    if (search->matches != NULL && same_str(search->name, name) &&
+        same_str(search->desc, desc)) {
+        return 0;
+    }
 
+    if (!search->built && build_search(snapshot) != 0) {
+        return -1;
+    }
+
+    if (rarest_gram(search, name, &tags, &n_tag) == 0 && n_tag < n_cand) {
+        cand   = tags;
+        n_cand = n_tag;
+    }
+    if (rarest_gram(search, desc, &tags, &n_tag) == 0 && n_tag < n_cand) {
+        cand   = tags;
+        n_cand = n_tag;
+    }
+
+    matches = calloc(n_cand + 1, sizeof(uint32_t));
+    if (matches == NULL) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < n_cand; i++) {
+        uint32_t index = cand != NULL ? cand[i] : i;
+
+        if (match_query(utarray_eltptr(snapshot->tags, index), &q)) {
+            matches[n_match++] = index;
+        }
+    }
+
+    free(search->name);
+    free(search->desc);
+    free(search->matches);
+    search->name    = dup_str(name);
+    search->desc    = dup_str(desc);
+    search->matches = matches;
+    search->n_match = n_match;
+
+    if ((name != NULL && search->name == NULL) ||
+        (desc != NULL && search->desc == NULL)) {
+        free(search->matches);
+        search->matches = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// position of the first match added after the tag at cursor, which may have
+// been deleted since
+static uint32_t after_cursor(const neu_group_tags_t *snapshot,
+                             const uint32_t *matches, uint32_t n_match,
+                             uint64_t cursor)
+{
+    uint32_t lo = 0, hi = n_match;
+
+    while (lo < hi) {
+        uint32_t mid   = lo + (hi - lo) / 2;
+        uint32_t index = matches != NULL ? matches[mid] : mid;
+
+        if (snapshot->seqs[index] <= cursor) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*
+ * Queries run on the read snapshot, the group is only locked to take it, so
+ * they never hold up the driver. Unfiltered pages cost O(page), filtered ones
+ * check the tags sharing the rarest trigram of the filter once, then their
+ * next pages cost O(page) as well.
+ */
+static UT_array *query_read_tags(neu_group_t *group, const char *name,
+                                 const char *desc, bool by_cursor,
+                                 uint64_t from, uint32_t limit,
+                                 int *total_count, uint64_t *next)
+{
+    neu_group_tags_t *snapshot = neu_group_get_read_tags(group);
+    UT_array *        array    = NULL;
+    const uint32_t *  matches  = NULL;
+    uint32_t          n_match  = 0;
+    uint32_t          first = 0, end = 0;
+
+    utarray_new(array, neu_tag_get_icd());
+    if (snapshot == NULL) {
+        goto done;
+    }
+
+    pthread_mutex_lock(&snapshot->search_mtx);
+    n_match = utarray_len(snapshot->tags);
+    if (name != NULL || desc != NULL) {
+        if (search_matches(snapshot, name, desc) == 0) {
+            matches = snapshot->search.matches;
+            n_match = snapshot->search.n_match;
+        } else {
+            n_match = 0;
+        }
+    }
+
+    if (by_cursor) {
+        first = after_cursor(snapshot, matches, n_match, from);
+    } else {
+        first = from < n_match ? from : n_match;
+    }
+    end = limit > 0 && n_match - first > limit ? first + limit : n_match;
+
+    for (uint32_t i = first; i < end; i++) {
+        neu_datatag_t *tag = (neu_datatag_t *) utarray_front(snapshot->tags);
+        utarray_push_back(array, &tag[matches != NULL ? matches[i] : i]);
+    }
+
+    if (next != NULL) {
+        *next = end < n_match && end > first
+            ? snapshot->seqs[matches != NULL ? matches[end - 1] : end - 1]
+            : 0;
+    }
+    pthread_mutex_unlock(&snapshot->search_mtx);
+    neu_group_tags_unref(snapshot);
+
+done:
+    if (total_count != NULL) {
+        *total_count = n_match;
+    }
+    if (snapshot == NULL && next != NULL) {
+        *next = 0;
+    }
     return array;
 }
 
+UT_array *neu_group_query_read_tag(neu_group_t *group, const char *name,
+                                   const char *desc)
+{
+    return query_read_tags(group, name, desc, false, 0, 0, NULL, NULL);
+}
+
 UT_array *neu_group_query_read_tag_paginate(neu_group_t *group,
                                             const char *name, const char *desc,
                                             int current_page, int page_size,
                                             int *total_count)
 {
-    UT_array *   array = NULL;
-    struct query q     = {
-        .name = (char *) name,
-        .desc = (char *) desc,
-    };
+    uint64_t from = UINT64_MAX;
 
-    pthread_mutex_lock(&group->mtx);
-    array = filter_tags_by_page(group->tags, is_readable_and_match_query, &q,
-                                current_page, page_size, total_count);
-    pthread_mutex_unlock(&group->mtx);
+    if (current_page > 0 && page_size > 0) {
+        from = (uint64_t)(current_page - 1) * page_size;
+    }
 
-    return array;
+    return query_read_tags(group, name, desc, false, from,
+                           page_size > 0 ? page_size : 1, total_count, NULL);
 }
 
-UT_array *neu_group_get_read_tag(neu_group_t *group)
+UT_array *neu_group_query_read_tag_cursor(neu_group_t *group, const char *name,
+                                          const char *desc, uint64_t cursor,
+                                          int page_size, uint64_t *next,
+                                          int *total_count)
 {
-    UT_array *array = NULL;
+    return query_read_tags(group, name, desc, true, cursor,
+                           page_size > 0 ? page_size : 0, total_count, next);
+}
+
+static neu_group_tags_t *new_read_tags(neu_group_t *group)
+{
+    neu_group_tags_t *snapshot = calloc(1, sizeof(neu_group_tags_t));
+    tag_elem_t *      el = NULL, *tmp = NULL;
+    uint32_t          n_tag = 0;
+
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    snapshot->ref     = 1;
+    snapshot->version = group->version;
+    snapshot->seqs    = calloc(HASH_COUNT(group->tags) + 1, sizeof(uint64_t));
+    utarray_new(snapshot->tags, neu_tag_get_icd());
+    if (snapshot->seqs != NULL) {
+        HASH_ITER(hh, group->tags, el, tmp)
+        {
+            if (is_readable(el->tag, NULL)) {
+                snapshot->seqs[n_tag++] = el->seq;
+                utarray_push_back(snapshot->tags, el->tag);
+            }
+        }
+    }
+
+    snapshot->names = neu_tag_names_new(snapshot->tags);
+    if (n_tag > 0) {
+        snapshot->index_block = calloc(n_tag, sizeof(snapshot_index_t));
+    }
+
+    if (snapshot->seqs == NULL || snapshot->names == NULL ||
+        (n_tag > 0 && snapshot->index_block == NULL)) {
+        neu_tag_names_unref(snapshot->names);
+        utarray_free(snapshot->tags);
+        free(snapshot->seqs);
+        free(snapshot);
+        return NULL;
+    }
+
+    pthread_mutex_init(&snapshot->search_mtx, NULL);
+
+    for (uint32_t i = 0; i < n_tag; i++) {
+        snapshot_index_t *el = &snapshot->index_block[i];
+        neu_datatag_t *   tag =
+            (neu_datatag_t *) utarray_eltptr(snapshot->tags, i);
+
+        el->name  = tag->name;
+        el->index = i;
+        HASH_ADD_KEYPTR(hh, snapshot->index, el->name, strlen(el->name), el);
+    }
+
+    return snapshot;
+}
+
+neu_group_tags_t *neu_group_get_read_tags(neu_group_t *group)
+{
+    neu_group_tags_t *snapshot = NULL;
 
     pthread_mutex_lock(&group->mtx);
-    array = filter_tags(group->tags, is_readable, NULL);
+    if (group->read_tags == NULL ||
+        group->read_tags->version != group->version) {
+        snapshot = new_read_tags(group);
+        if (snapshot != NULL) {
+            neu_group_tags_unref(group->read_tags);
+            group->read_tags = snapshot;
+        }
+    }
+
+    snapshot = group->read_tags;
+    if (snapshot != NULL) {
+        neu_group_tags_ref(snapshot);
+    }
     pthread_mutex_unlock(&group->mtx);
 
-    return array;
+    return snapshot;
+}
+
+neu_group_tags_t *neu_group_tags_ref(neu_group_tags_t *tags)
+{
+    __atomic_add_fetch(&tags->ref, 1, __ATOMIC_RELAXED);
+    return tags;
+}
+
+void neu_group_tags_unref(neu_group_tags_t *tags)
+{
+    if (tags == NULL) {
+        return;
+    }
+
+    if (__atomic_sub_fetch(&tags->ref, 1, __ATOMIC_ACQ_REL) == 0) {
+        free_search(&tags->search);
+        pthread_mutex_destroy(&tags->search_mtx);
+        HASH_CLEAR(hh, tags->index);
+        free(tags->index_block);
+        neu_tag_names_unref(tags->names);
+        utarray_free(tags->tags);
+        free(tags->seqs);
+        free(tags);
+    }
+}
+
+uint64_t neu_group_tags_version(const neu_group_tags_t *tags)
+{
+    return tags->version;
 }
 
-uint16_t neu_group_tag_size(const neu_group_t *group)
+UT_array *neu_group_tags_array(const neu_group_tags_t *tags)
 {
-    uint16_t size = 0;
+    return tags->tags;
+}
+
+neu_tag_names_t *neu_group_tags_names(const neu_group_tags_t *tags)
+{
+    return tags->names;
+}
+
+const neu_datatag_t *neu_group_tags_find(const neu_group_tags_t *tags,
+                                         const char *name, uint32_t *index)
+{
+    snapshot_index_t *find = NULL;
+
+    HASH_FIND_STR(tags->index, name, find);
+    if (find == NULL) {
+        return NULL;
+    }
+
+    if (index != NULL) {
+        *index = find->index;
+    }
+    return (const neu_datatag_t *) utarray_eltptr(tags->tags, find->index);
+}
+
+uint32_t neu_group_tag_size(const neu_group_t *group)
+{
+    uint32_t size = 0;
 
     size = HASH_COUNT(group->tags);
 
@@ -382,6 +835,17 @@ bool neu_group_is_change(neu_group_t *group, int64_t timestamp)
     return change;
 }
 
+int64_t neu_group_get_timestamp(neu_group_t *group)
+{
+    int64_t timestamp = 0;
+
+    pthread_mutex_lock(&group->mtx);
+    timestamp = group->timestamp;
+    pthread_mutex_unlock(&group->mtx);
+
+    return timestamp;
+}
+
 static void update_timestamp(neu_group_t *group)
 {
     struct timeval tv = { 0 };
@@ -389,6 +853,7 @@ static void update_timestamp(neu_group_t *group)
     gettimeofday(&tv, NULL);
 
     group->timestamp = (int64_t) tv.tv_sec * 1000 * 1000 + (int64_t) tv.tv_usec;
+    group->version += 1;
 }
 
 static UT_array *to_array(tag_elem_t *tags)
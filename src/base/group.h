@@ -25,9 +25,18 @@
 #include "utils/utextend.h"
 
 #include "tag.h"
+#include "tag_values.h"
 
 typedef struct neu_group neu_group_t;
 
+/**
+ * Immutable snapshot of the readable tags of a group with their name table,
+ * rebuilt on the first read after the group changes and shared by all the
+ * readers until then. Each holder owns a reference, the tags and the names
+ * stay valid until its neu_group_tags_unref.
+ */
+typedef struct neu_group_tags neu_group_tags_t;
+
 neu_group_t *neu_group_new(const char *name, uint32_t interval);
 const char * neu_group_get_name(const neu_group_t *group);
 int          neu_group_set_name(neu_group_t *group, const char *name);
@@ -36,19 +45,40 @@ void         neu_group_set_interval(neu_group_t *group, uint32_t interval);
 void         neu_group_destroy(neu_group_t *group);
 int          neu_group_update(neu_group_t *group, uint32_t interval);
 int          neu_group_add_tag(neu_group_t *group, const neu_datatag_t *tag);
+// all or nothing, on conflict *index is the first conflicting tag
+int neu_group_add_tags(neu_group_t *group, const neu_datatag_t *tags,
+                       uint32_t n_tag, uint32_t *index);
 int          neu_group_update_tag(neu_group_t *group, const neu_datatag_t *tag);
 int          neu_group_del_tag(neu_group_t *group, const char *tag_name);
 UT_array *   neu_group_get_tag(neu_group_t *group);
 UT_array *   neu_group_query_tag(neu_group_t *group, const char *name);
-UT_array *   neu_group_get_read_tag(neu_group_t *group);
 UT_array *   neu_group_query_read_tag(neu_group_t *group, const char *name,
                                       const char *desc);
 UT_array *   neu_group_query_read_tag_paginate(neu_group_t *group,
                                                const char *name, const char *desc,
                                                int current_page, int page_size,
                                                int *total_count);
-uint16_t     neu_group_tag_size(const neu_group_t *group);
+// tags in the order they were added, after the tag at cursor, 0 for the
+// first page. *next is the cursor of the following page, 0 after the last.
+UT_array *neu_group_query_read_tag_cursor(neu_group_t *group, const char *name,
+                                          const char *desc, uint64_t cursor,
+                                          int page_size, uint64_t *next,
+                                          int *total_count);
+uint32_t     neu_group_tag_size(const neu_group_t *group);
 neu_datatag_t *neu_group_find_tag(neu_group_t *group, const char *tag);
+
+// the current snapshot of the readable tags, with a reference taken
+neu_group_tags_t *neu_group_get_read_tags(neu_group_t *group);
+neu_group_tags_t *neu_group_tags_ref(neu_group_tags_t *tags);
+void              neu_group_tags_unref(neu_group_tags_t *tags);
+uint64_t          neu_group_tags_version(const neu_group_tags_t *tags);
+// neu_datatag_t array, must not be modified
+UT_array *       neu_group_tags_array(const neu_group_tags_t *tags);
+neu_tag_names_t *neu_group_tags_names(const neu_group_tags_t *tags);
+// *index is the index of the tag in the array and in the name table
+const neu_datatag_t *neu_group_tags_find(const neu_group_tags_t *tags,
+                                         const char *name, uint32_t *index);
+
 void neu_group_split_static_tags(neu_group_t *group, UT_array **static_tags,
                                  UT_array **other_tags);
 
@@ -57,5 +87,6 @@ typedef void (*neu_group_change_fn)(void *arg, int64_t timestamp,
                                     uint32_t interval);
 void neu_group_change_test(neu_group_t *group, int64_t timestamp, void *arg,
                            neu_group_change_fn fn);
-bool neu_group_is_change(neu_group_t *group, int64_t timestamp);
+bool    neu_group_is_change(neu_group_t *group, int64_t timestamp);
+int64_t neu_group_get_timestamp(neu_group_t *group);
 #endif
\ No newline at end of file
@@ -37,6 +37,11 @@ pthread_rwlock_t g_metrics_mtx_ = PTHREAD_RWLOCK_INITIALIZER;
 neu_metrics_t    g_metrics_;
 static uint64_t  g_start_ts_;
 
+// fit for latencies in milliseconds
+const uint64_t neu_metric_histogram_bounds[NEU_METRIC_HISTOGRAM_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000,
+};
+
 static void find_os_info()
 {
     const char *cmd =
@@ -309,6 +314,12 @@ int neu_metric_entries_add(neu_metric_entry_t **entries, const char *name,
             free(entry);
             return -1;
         }
+    } else if (NEU_METRIC_TYPE_HISTOGRAM == type) {
+        entry->hist = calloc(1, sizeof(*entry->hist));
+        if (NULL == entry->hist) {
+            free(entry);
+            return -1;
+        }
     } else {
         entry->value = init;
     }
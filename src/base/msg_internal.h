@@ -80,6 +80,8 @@ extern "C" {
     XX(NEU_RESP_ADD_TAG, neu_resp_add_tag_t)                         \
     XX(NEU_REQ_ADD_GTAG, neu_req_add_gtag_t)                         \
     XX(NEU_RESP_ADD_GTAG, neu_resp_add_tag_t)                        \
+    XX(NEU_REQ_IMPORT_TAG, neu_req_import_tag_t)                     \
+    XX(NEU_RESP_IMPORT_TAG, neu_resp_import_tag_t)                   \
     XX(NEU_REQ_DEL_TAG, neu_req_del_tag_t)                           \
     XX(NEU_REQ_UPDATE_TAG, neu_req_update_tag_t)                     \
     XX(NEU_RESP_UPDATE_TAG, neu_resp_update_tag_t)                   \
@@ -165,7 +167,7 @@ static inline neu_msg_t *neu_msg_new(neu_reqresp_type_e t, void *ctx,
     }
 
     size_t     total = sizeof(neu_msg_t) + body_size;
-    neu_msg_t *msg   = calloc(1, total);
+    neu_msg_t *msg   = (neu_msg_t *) calloc(1, total);
     if (msg) {
         msg->head.type = t;
         msg->head.len  = total;
@@ -179,7 +181,7 @@ static inline neu_msg_t *neu_msg_new(neu_reqresp_type_e t, void *ctx,
 
 static inline neu_msg_t *neu_msg_copy(const neu_msg_t *other)
 {
-    neu_msg_t *msg = calloc(1, other->head.len);
+    neu_msg_t *msg = (neu_msg_t *) calloc(1, other->head.len);
     if (msg) {
         memcpy(msg, other, other->head.len);
     }
@@ -44,7 +44,7 @@ neu_tag_sort_result_t *neu_tag_sort(UT_array *tags, neu_tag_sort_fn sort,
 
 void neu_tag_sort_free(neu_tag_sort_result_t *result)
 {
-    for (uint16_t i = 0; i < result->n_sort; i++) {
+    for (uint32_t i = 0; i < result->n_sort; i++) {
         utarray_free(result->sorts[i].tags);
     }
 
@@ -71,7 +71,7 @@ static void tag_sort(neu_tag_sort_result_t *result, void *tag,
 {
     bool sorted = false;
 
-    for (uint16_t i = 0; i < result->n_sort; i++) {
+    for (uint32_t i = 0; i < result->n_sort; i++) {
         if (fn(&result->sorts[i],
                *(void **) utarray_back(result->sorts[i].tags), tag)) {
             utarray_push_back(result->sorts[i].tags, &tag);
@@ -0,0 +1,503 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+#include <stdlib.h>
+#include <string.h>
+
+#include "errcodes.h"
+#include "msg.h"
+
+#include "tag_values.h"
+
+struct neu_tag_names {
+    uint32_t ref;
+    uint32_t n_name;
+    char **  names;
+    double * bias;
+    char *   buf;
+};
+
+typedef struct {
+    uint32_t       value;
+    uint32_t       n_meta;
+    neu_tag_meta_t metas[NEU_TAG_META_SIZE];
+} values_meta_t;
+
+struct neu_tag_values {
+    uint32_t         ref;
+    char *           driver;
+    char *           group;
+    neu_tag_names_t *names;
+
+    uint32_t  n_value;
+    uint32_t  cap;
+    uint32_t *index;
+    uint8_t * type;
+    uint8_t * precision;
+    uint64_t *scalar; // value bits, or the location in buf
+
+    char * buf;
+    size_t buf_len;
+    size_t buf_cap;
+
+    values_meta_t *metas; // sorted by value
+    uint32_t       n_meta;
+    uint32_t       meta_cap;
+};
+
+// location of a variable length value in buf: offset, length and ptr type
+#define VAR_PACK(off, len, ptype) \
+    ((uint64_t)(off) | ((uint64_t)(len) << 32) | ((uint64_t)(ptype) << 48))
+#define VAR_OFF(v) ((uint32_t)((v) &0xffffffff))
+#define VAR_LEN(v) ((uint16_t)(((v) >> 32) & 0xffff))
+#define VAR_PTYPE(v) ((neu_type_e)(((v) >> 48) & 0xff))
+
+neu_tag_names_t *neu_tag_names_new(UT_array *tags)
+{
+    neu_tag_names_t *names = calloc(1, sizeof(neu_tag_names_t));
+    size_t           size  = 0;
+    uint32_t         i     = 0;
+
+    if (names == NULL) {
+        return NULL;
+    }
+
+    names->ref    = 1;
+    names->n_name = utarray_len(tags);
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        size += strlen(tag->name) + 1;
+    }
+
+    names->names = calloc(names->n_name + 1, sizeof(char *));
+    names->bias  = calloc(names->n_name + 1, sizeof(double));
+    names->buf   = calloc(size + 1, 1);
+    if (names->names == NULL || names->bias == NULL || names->buf == NULL) {
+        free(names->names);
+        free(names->bias);
+        free(names->buf);
+        free(names);
+        return NULL;
+    }
+
+    size = 0;
+    utarray_foreach(tags, neu_datatag_t *, tag)
+    {
+        size_t len = strlen(tag->name) + 1;
+
+        memcpy(names->buf + size, tag->name, len);
+        names->names[i] = names->buf + size;
+        names->bias[i]  = tag->bias;
+        size += len;
+        i += 1;
+    }
+
+    return names;
+}
+
+neu_tag_names_t *neu_tag_names_ref(neu_tag_names_t *names)
+{
+    __atomic_add_fetch(&names->ref, 1, __ATOMIC_RELAXED);
+    return names;
+}
+
+void neu_tag_names_unref(neu_tag_names_t *names)
+{
+    if (names == NULL) {
+        return;
+    }
+
+    if (__atomic_sub_fetch(&names->ref, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(names->names);
+        free(names->bias);
+        free(names->buf);
+        free(names);
+    }
+}
+
+uint32_t neu_tag_names_size(const neu_tag_names_t *names)
+{
+    return names->n_name;
+}
+
+const char *neu_tag_names_get(const neu_tag_names_t *names, uint32_t i)
+{
+    if (i >= names->n_name) {
+        return NULL;
+    }
+
+    return names->names[i];
+}
+
+neu_tag_values_t *neu_tag_values_new(const char *driver, const char *group,
+                                     neu_tag_names_t *names)
+{
+    size_t            driver_len = strlen(driver) + 1;
+    size_t            group_len  = strlen(group) + 1;
+    neu_tag_values_t *values =
+        calloc(1, sizeof(neu_tag_values_t) + driver_len + group_len);
+
+    if (values == NULL) {
+        return NULL;
+    }
+
+    values->ref    = 1;
+    values->driver = (char *) &values[1];
+    values->group  = values->driver + driver_len;
+    memcpy(values->driver, driver, driver_len);
+    memcpy(values->group, group, group_len);
+    values->names = neu_tag_names_ref(names);
+
+    return values;
+}
+
+neu_tag_values_t *neu_tag_values_ref(neu_tag_values_t *values)
+{
+    __atomic_add_fetch(&values->ref, 1, __ATOMIC_RELAXED);
+    return values;
+}
+
+void neu_tag_values_unref(neu_tag_values_t *values)
+{
+    if (values == NULL) {
+        return;
+    }
+
+    if (__atomic_sub_fetch(&values->ref, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    neu_tag_names_unref(values->names);
+    free(values->index);
+    free(values->type);
+    free(values->precision);
+    free(values->scalar);
+    free(values->buf);
+    free(values->metas);
+    free(values);
+}
+
+const char *neu_tag_values_driver(const neu_tag_values_t *values)
+{
+    return values->driver;
+}
+
+const char *neu_tag_values_group(const neu_tag_values_t *values)
+{
+    return values->group;
+}
+
+static int grow(void **ptr, size_t size)
+{
+    void *p = realloc(*ptr, size);
+
+    if (p == NULL) {
+        return -1;
+    }
+
+    *ptr = p;
+    return 0;
+}
+
+static int grow_values(neu_tag_values_t *values, uint32_t cap)
+{
+    if (grow((void **) &values->index, cap * sizeof(uint32_t)) != 0 ||
+        grow((void **) &values->type, cap * sizeof(uint8_t)) != 0 ||
+        grow((void **) &values->precision, cap * sizeof(uint8_t)) != 0 ||
+        grow((void **) &values->scalar, cap * sizeof(uint64_t)) != 0) {
+        return -1;
+    }
+
+    values->cap = cap;
+    return 0;
+}
+
+static int reserve_values(neu_tag_values_t *values)
+{
+    uint32_t cap = 0;
+
+    if (values->n_value < values->cap) {
+        return 0;
+    }
+
+    cap = values->cap == 0 ? neu_tag_names_size(values->names)
+                           : values->cap * 2;
+    if (cap <= values->n_value) {
+        cap = values->n_value + 16;
+    }
+
+    return grow_values(values, cap);
+}
+
+int neu_tag_values_reserve(neu_tag_values_t *values, uint32_t n)
+{
+    if (n <= values->cap) {
+        return 0;
+    }
+
+    return grow_values(values, n) == 0 ? 0 : NEU_ERR_EINTERNAL;
+}
+
+static int push_var(neu_tag_values_t *values, const void *data, uint16_t len,
+                    neu_type_e ptype, uint64_t *scalar)
+{
+    size_t need = values->buf_len + len + 1;
+
+    if (need > UINT32_MAX) {
+        return -1;
+    }
+
+    if (need > values->buf_cap) {
+        size_t cap = values->buf_cap == 0 ? 256 : values->buf_cap;
+
+        while (cap < need) {
+            cap *= 2;
+        }
+        if (grow((void **) &values->buf, cap) != 0) {
+            return -1;
+        }
+        values->buf_cap = cap;
+    }
+
+    memcpy(values->buf + values->buf_len, data, len);
+    values->buf[values->buf_len + len] = '\0';
+    *scalar = VAR_PACK(values->buf_len, len, ptype);
+    values->buf_len += len + 1;
+
+    return 0;
+}
+
+static int push_metas(neu_tag_values_t *values, const neu_tag_meta_t *metas,
+                      int n_meta)
+{
+    int n = 0;
+
+    while (n < n_meta && n < NEU_TAG_META_SIZE && metas[n].name[0] != '\0') {
+        n += 1;
+    }
+
+    if (n == 0) {
+        return 0;
+    }
+
+    if (values->n_meta == values->meta_cap) {
+        uint32_t cap = values->meta_cap == 0 ? 8 : values->meta_cap * 2;
+
+        if (grow((void **) &values->metas, cap * sizeof(values_meta_t)) != 0) {
+            return -1;
+        }
+        values->meta_cap = cap;
+    }
+
+    values_meta_t *vm = &values->metas[values->n_meta++];
+    vm->value         = values->n_value;
+    vm->n_meta        = n;
+    memcpy(vm->metas, metas, n * sizeof(neu_tag_meta_t));
+
+    return 0;
+}
+
+int neu_tag_values_push(neu_tag_values_t *values, uint32_t index,
+                        const neu_dvalue_t *value, const neu_tag_meta_t *metas,
+                        int n_meta)
+{
+    uint64_t scalar = 0;
+    int      ret    = 0;
+
+    if (reserve_values(values) != 0) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    switch (value->type) {
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+        ret = push_var(values, value->value.str,
+                       strnlen(value->value.str, NEU_VALUE_SIZE - 1),
+                       value->type, &scalar);
+        break;
+    case NEU_TYPE_BYTES:
+        ret = push_var(values, value->value.bytes.bytes,
+                       value->value.bytes.length, value->type, &scalar);
+        break;
+    case NEU_TYPE_PTR:
+        ret = push_var(values, value->value.ptr.ptr, value->value.ptr.length,
+                       value->value.ptr.type, &scalar);
+        break;
+    default:
+        memcpy(&scalar, &value->value, sizeof(scalar));
+        break;
+    }
+
+    if (ret != 0 || push_metas(values, metas, n_meta) != 0) {
+        return NEU_ERR_EINTERNAL;
+    }
+
+    values->index[values->n_value]     = index;
+    values->type[values->n_value]      = value->type;
+    values->precision[values->n_value] = value->precision;
+    values->scalar[values->n_value]    = scalar;
+    values->n_value += 1;
+
+    return NEU_ERR_SUCCESS;
+}
+
+uint32_t neu_tag_values_size(const neu_tag_values_t *values)
+{
+    return values->n_value;
+}
+
+const char *neu_tag_values_name(const neu_tag_values_t *values, uint32_t i)
+{
+    return neu_tag_names_get(values->names, values->index[i]);
+}
+
+uint32_t neu_tag_values_index(const neu_tag_values_t *values, uint32_t i)
+{
+    return values->index[i];
+}
+
+neu_tag_names_t *neu_tag_values_names(const neu_tag_values_t *values)
+{
+    return values->names;
+}
+
+void neu_tag_values_get(const neu_tag_values_t *values, uint32_t i,
+                        neu_dvalue_t *value)
+{
+    uint64_t scalar = values->scalar[i];
+
+    memset(value, 0, sizeof(*value));
+    value->type      = values->type[i];
+    value->precision = values->precision[i];
+
+    switch (value->type) {
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+        memcpy(value->value.str, values->buf + VAR_OFF(scalar),
+               VAR_LEN(scalar));
+        break;
+    case NEU_TYPE_BYTES:
+        memcpy(value->value.bytes.bytes, values->buf + VAR_OFF(scalar),
+               VAR_LEN(scalar));
+        value->value.bytes.length = VAR_LEN(scalar);
+        break;
+    case NEU_TYPE_PTR:
+        value->value.ptr.type   = VAR_PTYPE(scalar);
+        value->value.ptr.length = VAR_LEN(scalar);
+        value->value.ptr.ptr    = (uint8_t *) values->buf + VAR_OFF(scalar);
+        break;
+    default:
+        memcpy(&value->value, &scalar, sizeof(scalar));
+        break;
+    }
+}
+
+int neu_tag_values_metas(const neu_tag_values_t *values, uint32_t i,
+                         const neu_tag_meta_t **metas)
+{
+    uint32_t lo = 0, hi = values->n_meta;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (values->metas[mid].value < i) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo < values->n_meta && values->metas[lo].value == i) {
+        *metas = values->metas[lo].metas;
+        return values->metas[lo].n_meta;
+    }
+
+    *metas = NULL;
+    return 0;
+}
+
+static void values_to_json(const neu_tag_values_t *values, uint32_t i,
+                           neu_json_read_resp_tag_t *tag_json)
+{
+    uint64_t     scalar = values->scalar[i];
+    neu_dvalue_t value  = { 0 };
+
+    tag_json->name         = (char *) neu_tag_values_name(values, i);
+    tag_json->error        = 0;
+    tag_json->datatag.bias = values->names->bias[values->index[i]];
+
+    switch (values->type[i]) {
+    case NEU_TYPE_STRING:
+    case NEU_TYPE_TIME:
+    case NEU_TYPE_DATA_AND_TIME:
+    case NEU_TYPE_PTR:
+        tag_json->t             = NEU_JSON_STR;
+        tag_json->value.val_str = values->buf + VAR_OFF(scalar);
+        break;
+    case NEU_TYPE_BYTES:
+        tag_json->t = NEU_JSON_BYTES;
+        tag_json->value.val_bytes.length = VAR_LEN(scalar);
+        tag_json->value.val_bytes.bytes =
+            (uint8_t *) values->buf + VAR_OFF(scalar);
+        break;
+    default:
+        neu_tag_values_get(values, i, &value);
+        neu_dvalue_to_json(&value, tag_json);
+        break;
+    }
+}
+
+void neu_tag_values_to_json(const neu_tag_values_t *values, uint32_t i,
+                            neu_json_read_resp_tag_t *tag_json)
+{
+    const neu_tag_meta_t *metas  = NULL;
+    int                   n_meta = neu_tag_values_metas(values, i, &metas);
+
+    if (n_meta > 0) {
+        tag_json->metas =
+            (neu_json_tag_meta_t *) calloc(n_meta, sizeof(neu_json_tag_meta_t));
+        if (tag_json->metas != NULL) {
+            tag_json->n_meta = n_meta;
+            neu_json_metas_to_json((neu_tag_meta_t *) metas, n_meta, tag_json);
+        }
+    }
+
+    values_to_json(values, i, tag_json);
+}
+
+void neu_tag_values_fill_json(const neu_tag_values_t *values, uint32_t i,
+                              neu_json_read_resp_tag_t *tag_json,
+                              neu_json_tag_meta_t *     metas)
+{
+    const neu_tag_meta_t *src    = NULL;
+    int                   n_meta = neu_tag_values_metas(values, i, &src);
+
+    if (n_meta > NEU_TAG_META_SIZE) {
+        n_meta = NEU_TAG_META_SIZE;
+    }
+
+    if (n_meta > 0) {
+        tag_json->metas  = metas;
+        tag_json->n_meta = n_meta;
+        neu_json_metas_to_json((neu_tag_meta_t *) src, n_meta, tag_json);
+    }
+
+    values_to_json(values, i, tag_json);
+}
@@ -18,6 +18,7 @@
  **/
 
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -26,13 +27,13 @@
 #include <arpa/inet.h>
 
 #define NNG_SUPP_TLS 1
-#define NNG_SUPP_SQLITE 1
 #include <nng/mqtt/mqtt_client.h>
 #include <nng/nng.h>
 #include <nng/supplemental/tls/tls.h>
 #include <nng/supplemental/util/platform.h>
 
 #include "connection/mqtt_client.h"
+#include "connection/mqtt_store.h"
 #include "errcodes.h"
 #include "event/event.h"
 #include "utils/asprintf.h"
@@ -74,6 +75,7 @@ typedef enum {
     TASK_SUB,
     TASK_UNSUB,
     TASK_RECV,
+    TASK_REPLAY,
 } task_kind_e;
 
 #define TASK_UNION_FIELDS                     \
@@ -122,8 +124,16 @@ struct neu_mqtt_client_s {
     void *                          connect_cb_data;
     neu_mqtt_client_connection_cb_t disconnect_cb;
     void *                          disconnect_cb_data;
-    nng_mqtt_sqlite_option *        sqlite_cfg;
-    char *                          db;
+    char *                          id;
+    size_t                          cache_mem_size;
+    size_t                          cache_disk_size;
+    uint32_t                        replay_rate;
+    neu_mqtt_store_t *              store;
+    neu_event_timer_t *             replay_timer;
+    uint64_t                        replay_gen;
+    size_t                          replay_count;
+    size_t                          replay_pending;
+    bool                            replay_failed;
     bool                            receiving;
     nng_aio *                       recv_aio;
     subscription_t *                subscriptions;
@@ -142,6 +152,7 @@ static void           task_handle_pub(task_t *task, neu_mqtt_client_t *client);
 static void           task_handle_sub(task_t *task, neu_mqtt_client_t *client);
 static void task_handle_unsub(task_t *task, neu_mqtt_client_t *client);
 static void task_handle_recv(task_t *task, neu_mqtt_client_t *client);
+static void task_handle_replay(task_t *task, neu_mqtt_client_t *client);
 
 static subscription_t *       subscription_new(neu_mqtt_client_t *client,
                                                neu_mqtt_qos_e qos, const char *topic,
@@ -153,6 +164,7 @@ static inline void            subscriptions_free(subscription_t *subscriptions);
 
 static void recv_cb(void *arg);
 static int  resub_cb(void *data);
+static int  replay_cb(void *data);
 static void disconnect_cb(nng_pipe p, nng_pipe_ev ev, void *arg);
 static void connect_cb(nng_pipe p, nng_pipe_ev ev, void *arg);
 
@@ -166,6 +178,7 @@ static int            client_send_sub_msg(neu_mqtt_client_t *client,
 static inline void    client_start_recv(neu_mqtt_client_t *client);
 static inline int     client_start_timer(neu_mqtt_client_t *client);
 static inline int     client_make_url(neu_mqtt_client_t *client);
+static void           client_replay(neu_mqtt_client_t *client);
 
 static inline uint8_t neu_mqtt_version_to_nng_mqtt_version(neu_mqtt_version_e v)
 {
@@ -320,6 +333,8 @@ static void task_cb(void *arg)
         task_handle_unsub(task, client);
     } else if (TASK_RECV == task->kind) {
         task_handle_recv(task, client);
+    } else if (TASK_REPLAY == task->kind) {
+        task_handle_replay(task, client);
     } else {
         log(error, "unexpected task kind:%d", task->kind);
         assert(!"logic error, task kind not exhausted");
@@ -340,6 +355,17 @@ static void task_handle_pub(task_t *task, neu_mqtt_client_t *client)
         nng_msg_free(msg);
         log(error, "send PUBLISH error: %s", nng_strerror(rv));
         log(error, "pub [%s, QoS%d] fail", task->pub.topic, task->pub.qos);
+
+        // keep the message for replay
+        nng_mtx_lock(client->mtx);
+        if (client->store &&
+            0 ==
+                neu_mqtt_store_push(client->store, task->pub.qos,
+                                    task->pub.topic, task->pub.payload,
+                                    task->pub.len)) {
+            rv = 0;
+        }
+        nng_mtx_unlock(client->mtx);
     } else {
         log(debug, "pub [%s, QoS%d] %" PRIu32 " bytes", task->pub.topic,
             task->pub.qos, task->pub.len);
@@ -352,6 +378,33 @@ static void task_handle_pub(task_t *task, neu_mqtt_client_t *client)
     return;
 }
 
+static void task_handle_replay(task_t *task, neu_mqtt_client_t *client)
+{
+    nng_aio *aio = task->aio;
+
+    int rv = 0;
+    if (0 != (rv = nng_aio_result(aio))) {
+        nng_msg *msg = nng_aio_get_msg(aio);
+        nng_msg_free(msg);
+        log(error, "resend cached PUBLISH error: %s", nng_strerror(rv));
+    }
+
+    nng_mtx_lock(client->mtx);
+    if (0 != rv) {
+        client->replay_failed = true;
+    }
+    if (0 == --client->replay_pending) {
+        // the whole batch is resent unless all messages went out, and none
+        // may be popped if the messages read were dropped meanwhile
+        if (!client->replay_failed && client->store &&
+            client->replay_gen == neu_mqtt_store_generation(client->store)) {
+            neu_mqtt_store_pop(client->store, client->replay_count);
+        }
+        client->replay_count = 0;
+    }
+    nng_mtx_unlock(client->mtx);
+}
+
 static void task_handle_sub(task_t *task, neu_mqtt_client_t *client)
 {
     int      rv  = 0;
@@ -535,6 +588,20 @@ static int resub_cb(void *data)
     return 0;
 }
 
+static int replay_cb(void *data)
+{
+    neu_mqtt_client_t *client = data;
+
+    nng_mtx_lock(client->mtx);
+    if (client->connected && client->store && 0 == client->replay_pending &&
+        neu_mqtt_store_count(client->store) > 0) {
+        client_replay(client);
+    }
+    nng_mtx_unlock(client->mtx);
+
+    return 0;
+}
+
 static void connect_cb(nng_pipe p, nng_pipe_ev ev, void *arg)
 {
     (void) p;
@@ -835,11 +902,52 @@ static inline int client_start_timer(neu_mqtt_client_t *client)
         return -1;
     }
 
+    if (client->store) {
+        neu_event_timer_param_t replay_param = {
+            .second      = client->retry / 1000,
+            .millisecond = client->retry % 1000,
+            .cb          = replay_cb,
+            .usr_data    = client,
+        };
+
+        client->replay_timer = neu_event_add_timer(events, replay_param);
+        if (NULL == client->replay_timer) {
+            neu_event_del_timer(events, timer);
+            neu_event_close(events);
+            return -1;
+        }
+    }
+
     client->events = events;
     client->timer  = timer;
     return 0;
 }
 
+static inline void client_stop_timer(neu_mqtt_client_t *client)
+{
+    neu_events_t *     events       = NULL;
+    neu_event_timer_t *timer        = NULL;
+    neu_event_timer_t *replay_timer = NULL;
+
+    nng_mtx_lock(client->mtx);
+    events               = client->events;
+    timer                = client->timer;
+    replay_timer         = client->replay_timer;
+    client->events       = NULL;
+    client->timer        = NULL;
+    client->replay_timer = NULL;
+    nng_mtx_unlock(client->mtx);
+
+    // the timer callbacks take the lock
+    if (events) {
+        if (replay_timer) {
+            neu_event_del_timer(events, replay_timer);
+        }
+        neu_event_del_timer(events, timer);
+        neu_event_close(events);
+    }
+}
+
 static inline int client_make_url(neu_mqtt_client_t *client)
 {
     char *      url = NULL;
@@ -898,23 +1006,120 @@ static inline nng_tls_config *alloc_tls_config(neu_mqtt_client_t *client)
     return cfg;
 }
 
-static inline nng_mqtt_sqlite_option *
-alloc_sqlite_config(neu_mqtt_client_t *client)
+static nng_msg *alloc_pub_msg(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
+                              const char *topic, const uint8_t *payload,
+                              uint32_t len)
 {
-    int                     rv;
-    nng_mqtt_sqlite_option *cfg = NULL;
+    int      rv      = 0;
+    nng_msg *pub_msg = NULL;
 
-    if ((rv = nng_mqtt_alloc_sqlite_opt(&cfg)) != 0) {
-        log(error, "nng_mqtt_alloc_sqlite_opt fail: %s", nng_strerror(rv));
+    if (0 != (rv = nng_mqtt_msg_alloc(&pub_msg, 0))) {
+        log(error, "nng_mqtt_msg_alloc fail: %s", nng_strerror(rv));
         return NULL;
     }
 
-    nng_mqtt_set_sqlite_enable(cfg, true);
-    nng_mqtt_set_sqlite_flush_threshold(cfg, 256);
-    nng_mqtt_set_sqlite_max_rows(cfg, 256);
-    nng_mqtt_set_sqlite_db_dir(cfg, "persistence/");
+    if (0 != (rv = nng_mqtt_msg_set_publish_topic(pub_msg, topic))) {
+        nng_msg_free(pub_msg);
+        log(error, "nng_mqtt_msg_set_publish_topic fail: %s", nng_strerror(rv));
+        return NULL;
+    }
 
-    return cfg;
+    // topic and payload are copied into the message
+    nng_mqtt_msg_set_packet_type(pub_msg, NNG_MQTT_PUBLISH);
+    nng_mqtt_msg_set_publish_payload(pub_msg, (uint8_t *) payload, len);
+    nng_mqtt_msg_set_publish_qos(pub_msg, qos);
+
+    return pub_msg;
+}
+
+// send the next batch of cached messages, the batch size paces the replay at
+// replay_rate messages per second of the replay timer
+static void client_replay(neu_mqtt_client_t *client)
+{
+    uint32_t             cursor = 0;
+    neu_mqtt_store_msg_t msg    = { 0 };
+    size_t batch = (size_t) client->replay_rate * client->retry / 1000;
+
+    if (0 == batch) {
+        batch = 1;
+    } else if (batch > client->task_limit / 2) {
+        // leave tasks for live messages
+        batch = client->task_limit / 2;
+    }
+
+    client->replay_gen    = neu_mqtt_store_generation(client->store);
+    client->replay_failed = false;
+    client->replay_count  = 0;
+
+    while (client->replay_count < batch &&
+           0 == neu_mqtt_store_read(client->store, &cursor, &msg)) {
+        nng_msg *pub_msg =
+            alloc_pub_msg(client, msg.qos, msg.topic, msg.payload, msg.len);
+        task_t *task = NULL;
+
+        if (NULL == pub_msg) {
+            break;
+        }
+
+        task = client_alloc_task(client);
+        if (NULL == task) {
+            nng_msg_free(pub_msg);
+            break;
+        }
+
+        task->kind = TASK_REPLAY;
+        client->replay_count += 1;
+        client->replay_pending += 1;
+        nng_aio_set_msg(task->aio, pub_msg);
+        nng_send_aio(client->sock, task->aio);
+    }
+
+    log(debug, "resend %zu of %zu cached messages", client->replay_count,
+        neu_mqtt_store_count(client->store));
+}
+
+static char *client_store_dir(neu_mqtt_client_t *client)
+{
+    char *dir = NULL;
+
+    // one directory per client id, so the cache survives restarts
+    neu_asprintf(&dir, "persistence/mqtt-store-%s",
+                 client->id ? client->id : "default");
+    if (NULL == dir) {
+        return NULL;
+    }
+
+    for (char *p = dir + sizeof("persistence/mqtt-store-") - 1; *p; ++p) {
+        if (!isalnum((unsigned char) *p) && '-' != *p && '_' != *p) {
+            *p = '_';
+        }
+    }
+
+    return dir;
+}
+
+static void client_remove_store(neu_mqtt_client_t *client)
+{
+    char *dir = NULL;
+
+    if (NULL == client->store) {
+        // remove the files left by an earlier run
+        dir = client_store_dir(client);
+        if (NULL == dir) {
+            return;
+        }
+        client->store = neu_mqtt_store_open(dir, client->cache_mem_size,
+                                            client->cache_disk_size,
+                                            client->log);
+        free(dir);
+    }
+
+    if (client->store) {
+        log(notice, "rm cache store, %zu messages discarded",
+            neu_mqtt_store_count(client->store));
+        neu_mqtt_store_destroy(client->store);
+        client->store = NULL;
+    }
 }
 
 neu_mqtt_client_t *neu_mqtt_client_new(neu_mqtt_version_e version)
@@ -937,8 +1142,9 @@ neu_mqtt_client_t *neu_mqtt_client_new(neu_mqtt_version_e version)
     }
 
     client->version    = version;
-    client->retry      = NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT;
-    client->task_limit = 1024;
+    client->retry       = NEU_MQTT_CACHE_SYNC_INTERVAL_DEFAULT;
+    client->replay_rate = NEU_MQTT_CACHE_REPLAY_RATE_DEFAULT;
+    client->task_limit  = 1024;
 
     return client;
 }
@@ -965,14 +1171,12 @@ void neu_mqtt_client_free(neu_mqtt_client_t *client)
         if (client->tls_cfg) {
             nng_tls_config_free(client->tls_cfg);
         }
-        if (client->sqlite_cfg) {
-            nng_mqtt_free_sqlite_opt(client->sqlite_cfg);
-        }
+        neu_mqtt_store_close(client->store);
         nng_aio_free(client->recv_aio);
         subscriptions_free(client->subscriptions);
         tasks_free(client->task_free_list);
         nng_msg_free(client->conn_msg);
-        free(client->db);
+        free(client->id);
         free(client->url);
         free(client->host);
         nng_mtx_free(client->mtx);
@@ -1007,8 +1211,8 @@ size_t neu_mqtt_client_get_cached_msgs_num(neu_mqtt_client_t *client)
     size_t num = 0;
 
     nng_mtx_lock(client->mtx);
-    if (NULL != client->sqlite_cfg) {
-        num = nng_mqtt_sqlite_db_get_cached_size(client->sqlite_cfg);
+    if (NULL != client->store) {
+        num = neu_mqtt_store_count(client->store);
     }
     nng_mtx_unlock(client->mtx);
 
@@ -1053,6 +1257,15 @@ int neu_mqtt_client_set_id(neu_mqtt_client_t *client, const char *id)
     nng_mtx_lock(client->mtx);
     return_failure_if_open();
 
+    char *i = strdup(id);
+    if (NULL == i) {
+        nng_mtx_unlock(client->mtx);
+        log(error, "strdup id fail");
+        return -1;
+    }
+
+    free(client->id);
+    client->id = i;
     nng_mqtt_msg_set_connect_client_id(client->conn_msg, id);
     nng_mtx_unlock(client->mtx);
 
@@ -1197,74 +1410,13 @@ end:
     return rv;
 }
 
-static void rand_str(char *dst, size_t len)
-{
-    char alphabet[] = "0123456789"
-                      "abcdefghijklmnopqrstuvwxyz"
-                      "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-    while (len-- > 1) {
-        size_t i = (double) rand() / RAND_MAX * ((sizeof alphabet) - 1);
-        *dst++   = alphabet[i];
-    }
-    *dst = '\0';
-}
-
-static int neu_mqtt_client_set_cache_db(neu_mqtt_client_t *client)
-{
-    char str[8] = { 0 };
-    rand_str(str, sizeof(str));
-
-    char *db = NULL;
-    neu_asprintf(&db, "neuron-mqtt-client-%s.db", str);
-    if (NULL == db) {
-        log(error, "neu_asprintf nano-mqtt cilent db fail");
-        return NEU_ERR_EINTERNAL;
-    }
-
-    if (client->db && 0 == strcmp(client->db, db)) {
-        free(db);
-        return 0;
-    }
-
-    neu_mqtt_client_remove_cache_db(client);
-
-    free(client->db);
-    client->db = db;
-
-    if (client->sqlite_cfg) {
-        nng_mqtt_sqlite_db_init(client->sqlite_cfg, db, client->version);
-    }
-
-    log(notice, "set cache db %s", db);
-
-    return 0;
-}
-
 void neu_mqtt_client_remove_cache_db(neu_mqtt_client_t *client)
 {
-    if (NULL == client->db) {
-        return;
-    }
-
-    const char *dir       = "persistence";
-    int         path_size = strlen(dir) + strlen(client->db) + 6;
-    char *      path      = calloc(path_size, 1);
-    if (NULL == path) {
-        return;
+    nng_mtx_lock(client->mtx);
+    if (client->cache_mem_size > 0) {
+        client_remove_store(client);
     }
-
-    snprintf(path, path_size, "%s/%s", dir, client->db);
-    log(notice, "rm cache db %s", path);
-    remove(path);
-    snprintf(path, path_size, "%s/%s-shm", dir, client->db);
-    log(notice, "rm cache db %s", path);
-    remove(path);
-    snprintf(path, path_size, "%s/%s-wal", dir, client->db);
-    log(notice, "rm cache db %s", path);
-    remove(path);
-
-    free(path);
+    nng_mtx_unlock(client->mtx);
 }
 
 int neu_mqtt_client_set_cache_size(neu_mqtt_client_t *client,
@@ -1278,40 +1430,24 @@ int neu_mqtt_client_set_cache_size(neu_mqtt_client_t *client,
     if (0 == mem_size_bytes && 0 == db_size_bytes) {
         // disable cache
         log(debug, "cache disabled");
-        if (client->sqlite_cfg) {
-            nng_mqtt_free_sqlite_opt(client->sqlite_cfg);
-            client->sqlite_cfg = NULL;
-            neu_mqtt_client_remove_cache_db(client);
+        if (client->cache_mem_size > 0) {
+            client_remove_store(client);
         }
+        client->cache_mem_size  = 0;
+        client->cache_disk_size = 0;
         goto end;
     }
 
-    if (NULL == client->sqlite_cfg) {
-        client->sqlite_cfg = alloc_sqlite_config(client);
-        if (NULL == client->sqlite_cfg) {
-            log(error, "alloc_sqlite_config fail");
-            rv = -1;
-            goto end;
-        }
-    }
-
-    if (0 != (rv = neu_mqtt_client_set_cache_db(client))) {
-        return rv;
+    if (mem_size_bytes > db_size_bytes) {
+        log(error, "cache memory size %zu larger than disk size %zu",
+            mem_size_bytes, db_size_bytes);
+        rv = -1;
+        goto end;
     }
 
-    // FIXME: until NanoSDK cache size limit feature out
-    // Assume that,
-    // 1. every upload message follows the below template
-    //    '{"node":"","group":"","timestamp":1669708991767,"values":{"":0},"errors":{}}'
-    // 2. every upload message has 50 tags in average
-    // 3. every tag has 4 bytes data
-    // then, estimated average message size is
-    //    len(tmpl) + 128/2 + 128/2 + 50*(64/2+4) ~= 2000
-    size_t avg_msg_size = 2000;
-    nng_mqtt_set_sqlite_flush_threshold(client->sqlite_cfg,
-                                        mem_size_bytes / avg_msg_size);
-    nng_mqtt_set_sqlite_max_rows(client->sqlite_cfg,
-                                 db_size_bytes / avg_msg_size);
+    // the store is opened with the client
+    client->cache_mem_size  = mem_size_bytes;
+    client->cache_disk_size = db_size_bytes;
 
 end:
     nng_mtx_unlock(client->mtx);
@@ -1340,6 +1476,25 @@ int neu_mqtt_client_set_cache_sync_interval(neu_mqtt_client_t *client,
     return rv;
 }
 
+int neu_mqtt_client_set_cache_replay_rate(neu_mqtt_client_t *client,
+                                          uint32_t           rate)
+{
+    int rv = 0;
+
+    nng_mtx_lock(client->mtx);
+    return_failure_if_open();
+
+    if (NEU_MQTT_CACHE_REPLAY_RATE_MIN <= rate &&
+        rate <= NEU_MQTT_CACHE_REPLAY_RATE_MAX) {
+        client->replay_rate = rate;
+    } else {
+        rv = -1;
+    }
+
+    nng_mtx_unlock(client->mtx);
+    return rv;
+}
+
 int neu_mqtt_client_set_zlog_category(neu_mqtt_client_t *client,
                                       zlog_category_t *  cat)
 {
@@ -1378,6 +1533,20 @@ int neu_mqtt_client_open(neu_mqtt_client_t *client)
         goto error;
     }
 
+    if (client->cache_mem_size > 0 && NULL == client->store) {
+        char *dir = client_store_dir(client);
+        if (NULL != dir) {
+            client->store =
+                neu_mqtt_store_open(dir, client->cache_mem_size,
+                                    client->cache_disk_size, client->log);
+            free(dir);
+        }
+        if (NULL == client->store) {
+            log(error, "open cache store fail");
+            goto error;
+        }
+    }
+
     if (0 != client_start_timer(client)) {
         log(error, "client_start_timer fail");
         goto error;
@@ -1390,14 +1559,6 @@ int neu_mqtt_client_open(neu_mqtt_client_t *client)
         goto error;
     }
 
-    if (client->sqlite_cfg &&
-        (rv = nng_socket_set_ptr(client->sock, NNG_OPT_MQTT_SQLITE,
-                                 client->sqlite_cfg))) {
-        log(error, "nng_socket_set_ptr(NNG_OPT_MQTT_SQLITE) fail: %s",
-            nng_strerror(rv));
-        goto error;
-    }
-
     nng_dialer dialer;
     if ((rv = nng_dialer_create(&dialer, client->sock, client->url)) != 0) {
         log(error, "nng_dialer_create fail: %s", nng_strerror(rv));
@@ -1434,37 +1595,25 @@ int neu_mqtt_client_open(neu_mqtt_client_t *client)
 
 error:
     nng_mtx_unlock(client->mtx);
-    if (client->events) {
-        neu_event_del_timer(client->events, client->timer);
-        neu_event_close(client->events);
-        client->events = NULL;
-        client->timer  = NULL;
-    }
+    client_stop_timer(client);
     nng_close(client->sock);
+    neu_mqtt_store_close(client->store);
+    client->store = NULL;
     return -1;
 }
 
 int neu_mqtt_client_close(neu_mqtt_client_t *client)
 {
-    int                rv     = 0;
-    neu_events_t *     events = NULL;
-    neu_event_timer_t *timer  = NULL;
+    int rv = 0;
 
     nng_mtx_lock(client->mtx);
     if (!client->open) {
         nng_mtx_unlock(client->mtx);
         return 0;
     }
-    events         = client->events;
-    timer          = client->timer;
-    client->events = NULL;
-    client->timer  = NULL;
     nng_mtx_unlock(client->mtx);
 
-    if (events) {
-        neu_event_del_timer(events, timer);
-        neu_event_close(events);
-    }
+    client_stop_timer(client);
 
     // NanoSDK quirks: calling nng_aio_stop will block if the aio is in use
     // nng_aio_stop(client->recv_aio);
@@ -1482,7 +1631,10 @@ int neu_mqtt_client_close(neu_mqtt_client_t *client)
         neu_msleep(100);
         nng_mtx_lock(client->mtx);
     }
-    client->open = false;
+    // failed messages were stored by their tasks, keep them for the next open
+    neu_mqtt_store_close(client->store);
+    client->store = NULL;
+    client->open  = false;
     nng_mtx_unlock(client->mtx);
 
     return 0;
@@ -1496,21 +1648,27 @@ int neu_mqtt_client_publish(neu_mqtt_client_t *client, neu_mqtt_qos_e qos,
     nng_msg *pub_msg = NULL;
     task_t * task    = NULL;
 
-    if (0 != (rv = nng_mqtt_msg_alloc(&pub_msg, 0))) {
-        log(error, "nng_mqtt_msg_alloc fail: %s", nng_strerror(rv));
-        return -1;
+    nng_mtx_lock(client->mtx);
+    if (client->store && !client->connected) {
+        // store and forward once connected
+        rv = neu_mqtt_store_push(client->store, qos, topic, payload, len);
+        nng_mtx_unlock(client->mtx);
+        if (0 != rv) {
+            log(error, "cache pub [%s, QoS%d] fail", topic, qos);
+            return -1;
+        }
+        if (cb) {
+            cb(0, qos, topic, payload, len, data);
+        }
+        return 0;
     }
+    nng_mtx_unlock(client->mtx);
 
-    if (0 != (rv = nng_mqtt_msg_set_publish_topic(pub_msg, topic))) {
-        nng_msg_free(pub_msg);
-        log(error, "nng_mqtt_msg_set_publish_topic fail: %s", nng_strerror(rv));
+    pub_msg = alloc_pub_msg(client, qos, topic, payload, len);
+    if (NULL == pub_msg) {
         return -1;
     }
 
-    nng_mqtt_msg_set_packet_type(pub_msg, NNG_MQTT_PUBLISH);
-    nng_mqtt_msg_set_publish_payload(pub_msg, (uint8_t *) payload, len);
-    nng_mqtt_msg_set_publish_qos(pub_msg, qos);
-
     nng_mtx_lock(client->mtx);
     task = client_alloc_task(client);
     nng_mtx_unlock(client->mtx);
@@ -0,0 +1,635 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "connection/mqtt_store.h"
+#include "utils/utlist.h"
+
+#define log(level, ...)                              \
+    do {                                             \
+        if (store->log) {                            \
+            zlog_##level(store->log, ##__VA_ARGS__); \
+        }                                            \
+    } while (0)
+
+#define SEG_MAGIC 0x5347454e // "NEGS"
+#define SEG_HDR_SIZE 64
+#define SEG_SIZE_MIN 4096
+#define SEG_NAME_FMT "seg-%08x.log"
+#define SEG_NAME_LEN sizeof("seg-00000000.log")
+
+// header at the beginning of every segment file
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t size;
+    uint32_t read_off;  // first record not consumed
+    uint32_t write_off; // end of the last complete record
+} seg_hdr_t;
+
+// followed by the NUL terminated topic and the payload, padded to 8 bytes
+typedef struct {
+    uint32_t len; // of the whole record
+    uint32_t sum;
+    uint32_t payload_len;
+    uint16_t topic_len;
+    uint8_t  qos;
+    uint8_t  pad;
+} rec_hdr_t;
+
+typedef struct seg_s {
+    uint32_t      seq;
+    uint32_t      size;
+    uint32_t      read_off;
+    uint32_t      write_off;
+    size_t        count; // records between read_off and write_off
+    uint8_t *     map;   // NULL if not mapped
+    struct seg_s *prev;
+    struct seg_s *next;
+} seg_t;
+
+struct neu_mqtt_store_s {
+    char *           dir;
+    size_t           seg_size;
+    size_t           disk_bytes;
+    size_t           disk_used;
+    size_t           count;
+    uint64_t         dropped;
+    uint64_t         gen;
+    uint32_t         next_seq;
+    seg_t *          segs; // oldest first
+    zlog_category_t *log;
+};
+
+static inline size_t rec_size(size_t topic_len, uint32_t len)
+{
+    return (sizeof(rec_hdr_t) + topic_len + 1 + len + 7) & ~(size_t) 7;
+}
+
+// FNV-1a of the record after the checksum field
+static uint32_t rec_sum(const rec_hdr_t *rec)
+{
+    const uint8_t *p   = (const uint8_t *) &rec->payload_len;
+    const uint8_t *end = (const uint8_t *) rec + sizeof(rec_hdr_t) +
+        rec->topic_len + 1 + rec->payload_len;
+    uint32_t h = 2166136261u;
+
+    while (p < end) {
+        h = (h ^ *p++) * 16777619u;
+    }
+
+    return h;
+}
+
+static inline seg_hdr_t *seg_hdr(seg_t *seg)
+{
+    return (seg_hdr_t *) seg->map;
+}
+
+static char *seg_path(neu_mqtt_store_t *store, uint32_t seq)
+{
+    size_t n    = strlen(store->dir) + 1 + SEG_NAME_LEN;
+    char * path = malloc(n);
+
+    if (path != NULL) {
+        snprintf(path, n, "%s/" SEG_NAME_FMT, store->dir, seq);
+    }
+
+    return path;
+}
+
+static int seg_map(neu_mqtt_store_t *store, seg_t *seg)
+{
+    char *path = NULL;
+    int   fd   = -1;
+
+    if (seg->map != NULL) {
+        return 0;
+    }
+
+    path = seg_path(store, seg->seq);
+    if (path == NULL) {
+        return -1;
+    }
+
+    fd = open(path, O_RDWR);
+    if (fd < 0) {
+        log(error, "open %s fail: %s", path, strerror(errno));
+        free(path);
+        return -1;
+    }
+
+    seg->map = mmap(NULL, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg->map == MAP_FAILED) {
+        log(error, "mmap %s fail: %s", path, strerror(errno));
+        seg->map = NULL;
+        free(path);
+        return -1;
+    }
+
+    free(path);
+    return 0;
+}
+
+static void seg_unmap(seg_t *seg)
+{
+    if (seg->map != NULL) {
+        munmap(seg->map, seg->size);
+        seg->map = NULL;
+    }
+}
+
+// only the oldest and the newest segments stay mapped
+static inline void seg_maybe_unmap(neu_mqtt_store_t *store, seg_t *seg)
+{
+    if (seg != store->segs && seg != store->segs->prev) {
+        seg_unmap(seg);
+    }
+}
+
+static void seg_remove(neu_mqtt_store_t *store, seg_t *seg)
+{
+    char *path = seg_path(store, seg->seq);
+
+    if (path != NULL) {
+        unlink(path);
+        free(path);
+    }
+
+    seg_unmap(seg);
+    DL_DELETE(store->segs, seg);
+    store->disk_used -= seg->size;
+    free(seg);
+}
+
+static seg_t *seg_create(neu_mqtt_store_t *store, uint32_t size)
+{
+    char *     path = NULL;
+    seg_t *    seg  = NULL;
+    seg_hdr_t *hdr  = NULL;
+    int        fd   = -1;
+    int        rv   = 0;
+
+    seg  = calloc(1, sizeof(*seg));
+    path = seg_path(store, store->next_seq);
+    if (seg == NULL || path == NULL) {
+        goto error;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        log(error, "open %s fail: %s", path, strerror(errno));
+        goto error;
+    }
+
+    // reserve the blocks now, running out of disk space on a store to a
+    // mapping would raise SIGBUS
+    if ((rv = posix_fallocate(fd, 0, size)) != 0) {
+        log(error, "fallocate %s %" PRIu32 " fail: %s", path, size,
+            strerror(rv));
+        close(fd);
+        unlink(path);
+        goto error;
+    }
+
+    seg->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg->map == MAP_FAILED) {
+        log(error, "mmap %s fail: %s", path, strerror(errno));
+        unlink(path);
+        goto error;
+    }
+
+    seg->seq       = store->next_seq++;
+    seg->size      = size;
+    seg->read_off  = SEG_HDR_SIZE;
+    seg->write_off = SEG_HDR_SIZE;
+
+    hdr            = seg_hdr(seg);
+    hdr->seq       = seg->seq;
+    hdr->size      = size;
+    hdr->read_off  = seg->read_off;
+    hdr->write_off = seg->write_off;
+    hdr->magic     = SEG_MAGIC;
+
+    store->disk_used += size;
+    free(path);
+    return seg;
+
+error:
+    free(path);
+    free(seg);
+    return NULL;
+}
+
+static void drop_oldest(neu_mqtt_store_t *store)
+{
+    seg_t *seg = store->segs;
+
+    log(warn, "store full, drop segment %08" PRIx32 " of %zu messages",
+        seg->seq, seg->count);
+    store->dropped += seg->count;
+    store->count -= seg->count;
+    store->gen += 1;
+    seg_remove(store, seg);
+
+    if (store->segs != NULL && seg_map(store, store->segs) != 0) {
+        log(error, "map oldest segment fail");
+    }
+}
+
+// validate the records of a segment found on open, a torn last record is
+// cut off
+static int seg_recover(neu_mqtt_store_t *store, seg_t *seg, off_t file_size)
+{
+    seg_hdr_t *hdr = NULL;
+    uint32_t   off = 0;
+
+    if ((size_t) file_size < SEG_SIZE_MIN) {
+        return -1;
+    }
+
+    seg->size = file_size;
+    if (seg_map(store, seg) != 0) {
+        return -1;
+    }
+
+    hdr = seg_hdr(seg);
+    if (hdr->magic != SEG_MAGIC || hdr->seq != seg->seq ||
+        hdr->size != seg->size || hdr->read_off < SEG_HDR_SIZE ||
+        hdr->read_off > hdr->write_off || hdr->write_off > seg->size) {
+        return -1;
+    }
+
+    off = hdr->read_off;
+    while (off + sizeof(rec_hdr_t) <= hdr->write_off) {
+        rec_hdr_t *rec = (rec_hdr_t *) (seg->map + off);
+
+        if (rec->len < sizeof(rec_hdr_t) || rec->len > hdr->write_off - off ||
+            rec->len != rec_size(rec->topic_len, rec->payload_len) ||
+            rec->sum != rec_sum(rec)) {
+            log(warn, "segment %08" PRIx32 " corrupted at %" PRIu32, seg->seq,
+                off);
+            break;
+        }
+        off += rec->len;
+        seg->count += 1;
+    }
+
+    seg->read_off  = hdr->read_off;
+    seg->write_off = off;
+    hdr->write_off = off;
+    return 0;
+}
+
+static int seq_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static int store_recover(neu_mqtt_store_t *store)
+{
+    DIR *          dir  = NULL;
+    struct dirent *ent  = NULL;
+    uint32_t *     seqs = NULL;
+    size_t         n    = 0;
+    size_t         cap  = 0;
+
+    dir = opendir(store->dir);
+    if (dir == NULL) {
+        log(error, "opendir %s fail: %s", store->dir, strerror(errno));
+        return -1;
+    }
+
+    while ((ent = readdir(dir)) != NULL) {
+        uint32_t seq = 0;
+        char     name[SEG_NAME_LEN];
+
+        if (strlen(ent->d_name) != SEG_NAME_LEN - 1 ||
+            sscanf(ent->d_name, "seg-%8" SCNx32 ".log", &seq) != 1) {
+            continue;
+        }
+        snprintf(name, sizeof(name), SEG_NAME_FMT, seq);
+        if (strcmp(name, ent->d_name) != 0) {
+            continue;
+        }
+
+        if (n == cap) {
+            uint32_t *tmp = realloc(seqs, (cap ? cap * 2 : 16) * sizeof(*tmp));
+            if (tmp == NULL) {
+                free(seqs);
+                closedir(dir);
+                return -1;
+            }
+            seqs = tmp;
+            cap  = cap ? cap * 2 : 16;
+        }
+        seqs[n++] = seq;
+    }
+    closedir(dir);
+
+    if (n > 0) {
+        qsort(seqs, n, sizeof(*seqs), seq_cmp);
+    }
+    for (size_t i = 0; i < n; i++) {
+        struct stat st   = { 0 };
+        char *      path = seg_path(store, seqs[i]);
+        seg_t *     seg  = calloc(1, sizeof(*seg));
+
+        if (path == NULL || seg == NULL) {
+            free(path);
+            free(seg);
+            free(seqs);
+            return -1;
+        }
+
+        seg->seq = seqs[i];
+        if (stat(path, &st) != 0 || seg_recover(store, seg, st.st_size) != 0 ||
+            seg->count == 0) {
+            if (seg->count == 0 && seg->map != NULL) {
+                log(debug, "remove consumed segment %s", path);
+            } else {
+                log(warn, "remove invalid segment %s", path);
+            }
+            seg_unmap(seg);
+            unlink(path);
+            free(path);
+            free(seg);
+            continue;
+        }
+        free(path);
+
+        DL_APPEND(store->segs, seg);
+        store->disk_used += seg->size;
+        store->count += seg->count;
+        store->next_seq = seg->seq + 1;
+        seg_unmap(seg);
+    }
+    free(seqs);
+
+    // the budget may have been lowered since the segments were written
+    while (store->segs != NULL && store->disk_used > store->disk_bytes) {
+        drop_oldest(store);
+    }
+
+    if (store->segs != NULL &&
+        (seg_map(store, store->segs) != 0 ||
+         seg_map(store, store->segs->prev) != 0)) {
+        return -1;
+    }
+
+    if (store->count > 0) {
+        log(notice, "store %s recovered %zu messages in %zu bytes", store->dir,
+            store->count, store->disk_used);
+    }
+
+    return 0;
+}
+
+neu_mqtt_store_t *neu_mqtt_store_open(const char *dir, size_t mem_bytes,
+                                      size_t disk_bytes, zlog_category_t *log)
+{
+    neu_mqtt_store_t *store = NULL;
+    long              page  = sysconf(_SC_PAGESIZE);
+
+    if (mem_bytes / 2 < SEG_SIZE_MIN || disk_bytes < mem_bytes ||
+        mem_bytes / 2 > UINT32_MAX) {
+        return NULL;
+    }
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        if (log) {
+            zlog_error(log, "mkdir %s fail: %s", dir, strerror(errno));
+        }
+        return NULL;
+    }
+
+    store = calloc(1, sizeof(*store));
+    if (store == NULL) {
+        return NULL;
+    }
+
+    store->dir        = strdup(dir);
+    store->seg_size   = mem_bytes / 2 / page * page;
+    store->disk_bytes = disk_bytes;
+    store->log        = log;
+
+    if (store->dir == NULL || store_recover(store) != 0) {
+        neu_mqtt_store_close(store);
+        return NULL;
+    }
+
+    return store;
+}
+
+void neu_mqtt_store_close(neu_mqtt_store_t *store)
+{
+    seg_t *seg = NULL, *tmp = NULL;
+
+    if (store == NULL) {
+        return;
+    }
+
+    DL_FOREACH_SAFE(store->segs, seg, tmp)
+    {
+        DL_DELETE(store->segs, seg);
+        seg_unmap(seg);
+        free(seg);
+    }
+
+    free(store->dir);
+    free(store);
+}
+
+void neu_mqtt_store_destroy(neu_mqtt_store_t *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    while (store->segs != NULL) {
+        seg_remove(store, store->segs);
+    }
+
+    if (rmdir(store->dir) != 0) {
+        log(warn, "rmdir %s fail: %s", store->dir, strerror(errno));
+    }
+
+    neu_mqtt_store_close(store);
+}
+
+int neu_mqtt_store_push(neu_mqtt_store_t *store, uint8_t qos,
+                        const char *topic, const uint8_t *payload,
+                        uint32_t len)
+{
+    size_t     topic_len = strlen(topic);
+    size_t     size      = 0;
+    seg_t *    tail      = store->segs ? store->segs->prev : NULL;
+    rec_hdr_t *rec       = NULL;
+
+    size = rec_size(topic_len, len);
+    if (topic_len > UINT16_MAX || SEG_HDR_SIZE + size > UINT32_MAX ||
+        SEG_HDR_SIZE + size > store->disk_bytes) {
+        log(error, "message on %s of %" PRIu32 " bytes exceeds the store",
+            topic, len);
+        return -1;
+    }
+
+    if (tail == NULL || tail->write_off + size > tail->size) {
+        // a message larger than a segment gets a segment of its own
+        size_t seg_size = store->seg_size;
+
+        if (SEG_HDR_SIZE + size > seg_size) {
+            seg_size = SEG_HDR_SIZE + size;
+        }
+
+        if (tail != NULL && tail->count == 0) {
+            // the only segment, emptied by pop
+            seg_remove(store, tail);
+        }
+
+        while (store->segs != NULL &&
+               store->disk_used + seg_size > store->disk_bytes) {
+            drop_oldest(store);
+        }
+
+        seg_t *seg = seg_create(store, seg_size);
+        if (seg == NULL) {
+            return -1;
+        }
+
+        tail = store->segs ? store->segs->prev : NULL;
+        DL_APPEND(store->segs, seg);
+        if (tail != NULL) {
+            seg_maybe_unmap(store, tail);
+        }
+        tail = seg;
+    }
+
+    rec              = (rec_hdr_t *) (tail->map + tail->write_off);
+    rec->len         = size;
+    rec->payload_len = len;
+    rec->topic_len   = topic_len;
+    rec->qos         = qos;
+    rec->pad         = 0;
+    memcpy(rec + 1, topic, topic_len + 1);
+    memcpy((uint8_t *) (rec + 1) + topic_len + 1, payload, len);
+    rec->sum = rec_sum(rec);
+
+    tail->write_off += size;
+    tail->count += 1;
+    seg_hdr(tail)->write_off = tail->write_off;
+    store->count += 1;
+
+    return 0;
+}
+
+int neu_mqtt_store_read(neu_mqtt_store_t *store, uint32_t *cursor,
+                        neu_mqtt_store_msg_t *msg)
+{
+    seg_t *    head = store->segs;
+    uint32_t   off  = 0;
+    rec_hdr_t *rec  = NULL;
+
+    if (head == NULL || head->map == NULL) {
+        return -1;
+    }
+
+    off = *cursor == 0 ? head->read_off : *cursor;
+    if (off < head->read_off || off >= head->write_off) {
+        return -1;
+    }
+
+    rec          = (rec_hdr_t *) (head->map + off);
+    msg->qos     = rec->qos;
+    msg->topic   = (const char *) (rec + 1);
+    msg->payload = (const uint8_t *) (rec + 1) + rec->topic_len + 1;
+    msg->len     = rec->payload_len;
+    *cursor      = off + rec->len;
+
+    return 0;
+}
+
+void neu_mqtt_store_pop(neu_mqtt_store_t *store, size_t n)
+{
+    while (n > 0 && store->segs != NULL) {
+        seg_t *    head = store->segs;
+        rec_hdr_t *rec  = NULL;
+
+        if (head->count == 0 || head->map == NULL) {
+            // only the newest segment may be empty
+            break;
+        }
+
+        rec = (rec_hdr_t *) (head->map + head->read_off);
+        head->read_off += rec->len;
+        head->count -= 1;
+        store->count -= 1;
+        n -= 1;
+
+        if (head->count > 0) {
+            seg_hdr(head)->read_off = head->read_off;
+        } else if (head != head->prev) {
+            seg_remove(store, head);
+            if (seg_map(store, store->segs) != 0) {
+                log(error, "map oldest segment fail");
+            }
+        } else {
+            // the last segment is reused from the beginning
+            head->read_off           = SEG_HDR_SIZE;
+            head->write_off          = SEG_HDR_SIZE;
+            seg_hdr(head)->write_off = SEG_HDR_SIZE;
+            seg_hdr(head)->read_off  = SEG_HDR_SIZE;
+        }
+    }
+}
+
+size_t neu_mqtt_store_count(const neu_mqtt_store_t *store)
+{
+    return store->count;
+}
+
+size_t neu_mqtt_store_disk_used(const neu_mqtt_store_t *store)
+{
+    return store->disk_used;
+}
+
+uint64_t neu_mqtt_store_dropped(const neu_mqtt_store_t *store)
+{
+    return store->dropped;
+}
+
+uint64_t neu_mqtt_store_generation(const neu_mqtt_store_t *store)
+{
+    return store->gen;
+}
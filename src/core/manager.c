@@ -55,11 +55,14 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data);
 
 inline static void reply(neu_manager_t *manager, neu_reqresp_head_t *header,
                          void *data);
-inline static void forward_msg(neu_manager_t *     manager,
+inline static int  forward_msg(neu_manager_t *     manager,
                                neu_reqresp_head_t *header, const char *node);
 inline static void forward_msg_copy(neu_manager_t *     manager,
                                     neu_reqresp_head_t *header,
                                     const char *        node);
+inline static void forward_subscribe_msg_copy(neu_manager_t *     manager,
+                                              neu_reqresp_head_t *header,
+                                              const char *        node);
 
 static void start_static_adapter(neu_manager_t *manager, const char *name);
 static int  update_timestamp(void *usr_data);
@@ -876,8 +879,8 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (error.error == NEU_ERR_SUCCESS) {
             cmd->port = app_port;
+            forward_subscribe_msg_copy(manager, header, cmd->driver);
             forward_msg_copy(manager, header, cmd->app);
-            forward_msg_copy(manager, header, cmd->driver);
             manager_storage_subscribe(manager, cmd->app, cmd->driver,
                                       cmd->group, cmd->params);
         } else {
@@ -933,6 +936,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
             manager, cmd->app, cmd->driver, cmd->group, cmd->params);
 
         if (error.error == NEU_ERR_SUCCESS) {
+            forward_subscribe_msg_copy(manager, header, cmd->driver);
             forward_msg_copy(manager, header, cmd->app);
             manager_storage_update_subscribe(manager, cmd->app, cmd->driver,
                                              cmd->group, cmd->params);
@@ -1205,7 +1209,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (neu_node_manager_find(manager->node_manager, header->receiver) ==
             NULL) {
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 free(cmd->tags[i]);
             }
             free(cmd->tags);
@@ -1225,7 +1229,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (neu_node_manager_find(manager->node_manager, header->receiver) ==
             NULL) {
-            for (int i = 0; i < cmd->n_tag; i++) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
                 neu_tag_fini(&cmd->tags[i]);
             }
             free(cmd->tags);
@@ -1244,7 +1248,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         if (neu_node_manager_find(manager->node_manager, header->receiver) ==
             NULL) {
-            for (int i = 0; i < cmd->n_group; i++) {
+            for (uint32_t i = 0; i < cmd->n_group; i++) {
                 for (int j = 0; j < cmd->groups[i].n_tag; j++) {
                     neu_tag_fini(&cmd->groups[i].tags[j]);
                 }
@@ -1261,6 +1265,25 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
         break;
     }
+    case NEU_REQ_IMPORT_TAG: {
+        neu_req_import_tag_t *cmd = (neu_req_import_tag_t *) &header[1];
+
+        if (neu_node_manager_find(manager->node_manager, header->receiver) ==
+            NULL) {
+            for (uint32_t i = 0; i < cmd->n_tag; i++) {
+                neu_tag_fini(&cmd->tags[i]);
+            }
+            free(cmd->tags);
+            neu_resp_error_t e = { .error = NEU_ERR_NODE_NOT_EXIST };
+            header->type       = NEU_RESP_ERROR;
+            neu_msg_exchange(header);
+            reply(manager, header, &e);
+        } else {
+            forward_msg(manager, header, header->receiver);
+        }
+
+        break;
+    }
     case NEU_REQ_NODE_SETTING: {
         neu_req_node_setting_t *cmd = (neu_req_node_setting_t *) &header[1];
 
@@ -1279,6 +1302,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
 
     case NEU_RESP_ADD_TAG:
     case NEU_RESP_ADD_GTAG:
+    case NEU_RESP_IMPORT_TAG:
     case NEU_RESP_UPDATE_TAG:
     case NEU_RESP_GET_TAG:
     case NEU_RESP_GET_GROUP:
@@ -1318,7 +1342,7 @@ static int manager_loop(enum neu_event_io_type type, int fd, void *usr_data)
                 neu_req_driver_t *driver = &cmd->drivers[i];
                 manager_storage_add_node(manager, driver->node);
                 adapter_storage_setting(driver->node, driver->setting);
-                for (uint16_t j = 0; j < driver->n_group; j++) {
+                for (uint32_t j = 0; j < driver->n_group; j++) {
                     adapter_storage_add_group(driver->node,
                                               driver->groups[j].group,
                                               driver->groups[j].interval);
@@ -1387,6 +1411,26 @@ inline static void forward_msg_copy(neu_manager_t *     manager,
     forward_msg(manager, neu_msg_get_header(msg), node);
 }
 
+inline static void forward_subscribe_msg_copy(neu_manager_t *     manager,
+                                              neu_reqresp_head_t *header,
+                                              const char *        node)
+{
+    neu_msg_t *          msg    = neu_msg_copy((neu_msg_t *) header);
+    neu_reqresp_head_t * hd     = neu_msg_get_header(msg);
+    neu_req_subscribe_t *cmd    = (neu_req_subscribe_t *) &hd[1];
+    char *               params = NULL;
+
+    // the app frees the params of the original message, the driver gets
+    // its own copy
+    if (cmd->params != NULL) {
+        params = cmd->params = strdup(cmd->params);
+    }
+    if (0 != forward_msg(manager, hd, node)) {
+        // the message is gone, the copy is still ours
+        free(params);
+    }
+}
+
 static void start_static_adapter(neu_manager_t *manager, const char *name)
 {
     neu_adapter_t *       adapter      = NULL;
@@ -305,8 +305,14 @@ int neu_manager_send_subscribe(neu_manager_t *manager, const char *app,
     }
     cmd.params = NULL;
 
+    // the driver parses the report mode of the subscription from the params
+    if (params && NULL == (cmd.params = strdup(params))) {
+        return NEU_ERR_EINTERNAL;
+    }
+
     msg = neu_msg_new(NEU_REQ_SUBSCRIBE_GROUP, NULL, &cmd);
     if (NULL == msg) {
+        free(cmd.params);
         return NEU_ERR_EINTERNAL;
     }
     header = neu_msg_get_header(msg);
@@ -318,6 +324,7 @@ int neu_manager_send_subscribe(neu_manager_t *manager, const char *app,
     if (0 != ret) {
         nlog_warn("send %s to %s driver failed",
                   neu_reqresp_type_string(NEU_REQ_SUBSCRIBE_GROUP), driver);
+        free(cmd.params);
         neu_msg_free(msg);
     } else {
         nlog_notice("send %s to %s driver",
@@ -87,8 +87,9 @@ int neu_manager_get_node_info(neu_manager_t *manager, const char *name,
 int neu_manager_add_drivers(neu_manager_t *         manager,
                             neu_req_driver_array_t *req);
 
-inline static void forward_msg(neu_manager_t *     manager,
-                               neu_reqresp_head_t *header, const char *node)
+// the message is freed if it cannot be sent, 0 on success
+inline static int forward_msg(neu_manager_t *     manager,
+                              neu_reqresp_head_t *header, const char *node)
 {
     struct sockaddr_un addr =
         neu_node_manager_get_addr(manager->node_manager, node);
@@ -106,6 +107,8 @@ inline static void forward_msg(neu_manager_t *     manager,
                   neu_reqresp_type_string(t), receiver, &addr.sun_path[1]);
         neu_msg_free(msg);
     }
+
+    return ret;
 }
 
 #endif
@@ -24,95 +24,324 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "event/event.h"
 #include "utils/log.h"
+#include "utils/utlist.h"
 
 #ifdef NEU_PLATFORM_LINUX
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
 
+// epoll events handled per wakeup
+#define EVENT_BATCH 64
+
+// 4 levels of 64 slots with 1ms ticks cover about 4.6 hours, longer
+// timers are parked on the top level and re-placed when it wraps
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_SPAN_OF(level) ((int64_t) 1 << (WHEEL_BITS * ((level) + 1)))
+#define WHEEL_SPAN WHEEL_SPAN_OF(WHEEL_LEVELS - 1)
+
+#define TIMER_IDLE -1
+#define TIMER_DUE -2
+
 struct neu_event_timer {
-    int                    fd;
-    struct event_data *    event_data;
-    struct itimerspec      value;
-    neu_event_timer_type_e type;
-    pthread_mutex_t        mtx;
-    bool                   stop;
+    int64_t                  expire;
+    int64_t                  period;
+    neu_event_timer_type_e   type;
+    neu_event_timer_callback cb;
+    void *                   usr_data;
+
+    // wheel level and slot, or TIMER_IDLE/TIMER_DUE
+    int level;
+    int slot;
+    // stop: deleted, release: deleted by its own callback
+    bool stop;
+    bool release;
+
+    struct neu_event_timer *prev, *next;
 };
 
 struct neu_event_io {
-    int                fd;
-    struct event_data *event_data;
-};
-struct event_data {
-    enum {
-        TIMER = 0,
-        IO    = 1,
-    } type;
-    union {
-        neu_event_io_callback    io;
-        neu_event_timer_callback timer;
-    } callback;
-    union {
-        neu_event_io_t    io;
-        neu_event_timer_t timer;
-    } ctx;
-
-    void *usr_data;
-    int   fd;
-    int   index;
-    bool  use;
-};
+    int                   fd;
+    neu_event_io_callback cb;
+    void *                usr_data;
+    bool                  deleted;
 
-#define EVENT_SIZE 1400
+    struct neu_event_io *prev, *next;
+};
 
 struct neu_events {
     int       epoll_fd;
+    int       timer_fd;
     pthread_t thread;
     bool      stop;
 
-    pthread_mutex_t   mtx;
-    int               n_event;
-    struct event_data event_datas[EVENT_SIZE];
+    pthread_mutex_t mtx;
+    pthread_cond_t  cond;
+
+    // hierarchical timing wheel in milliseconds, all timers of the events
+    // share timer_fd which is armed for the next slot to visit
+    int64_t            now;
+    int64_t            armed;
+    uint64_t           pending[WHEEL_LEVELS];
+    neu_event_timer_t *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    neu_event_timer_t *due;
+    neu_event_timer_t *running;
+
+    neu_event_io_t *ios;
+    // deleted ios, freed once no epoll batch can refer to them
+    neu_event_io_t *garbage;
 };
 
-static int get_free_event(neu_events_t *events)
+static inline int64_t monotonic_ms()
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline int wheel_digit(int64_t t, int level)
+{
+    return (int) ((t >> (level * WHEEL_BITS)) & WHEEL_MASK);
+}
+
+static void wheel_insert(neu_events_t *events, neu_event_timer_t *timer)
+{
+    uint64_t diff  = (uint64_t)(timer->expire ^ events->now);
+    int      level = 0;
+    int      slot  = 0;
+
+    // the highest digit that differs from now decides the level
+    if (diff != 0) {
+        level = (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+    }
+
+    if (level < WHEEL_LEVELS) {
+        slot = wheel_digit(timer->expire, level);
+    } else {
+        level = WHEEL_LEVELS - 1;
+        if (timer->expire - events->now < WHEEL_SPAN) {
+            // visited once the top level wraps
+            slot = wheel_digit(timer->expire, level);
+        } else {
+            slot = (wheel_digit(events->now, level) + WHEEL_MASK) & WHEEL_MASK;
+        }
+    }
+
+    timer->level = level;
+    timer->slot  = slot;
+    DL_APPEND(events->slots[level][slot], timer);
+    events->pending[level] |= (uint64_t) 1 << slot;
+}
+
+static void timer_unlink(neu_events_t *events, neu_event_timer_t *timer)
+{
+    if (timer->level == TIMER_DUE) {
+        DL_DELETE(events->due, timer);
+    } else if (timer->level >= 0) {
+        DL_DELETE(events->slots[timer->level][timer->slot], timer);
+        if (events->slots[timer->level][timer->slot] == NULL) {
+            events->pending[timer->level] &= ~((uint64_t) 1 << timer->slot);
+        }
+    }
+
+    timer->level = TIMER_IDLE;
+}
+
+// the next time the wheel has to be visited, either to fire a level 0 slot
+// or to cascade a slot of a higher level
+static int64_t wheel_next(neu_events_t *events)
+{
+    int64_t next = INT64_MAX;
+
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        uint64_t pending = events->pending[level];
+        int      shift   = level * WHEEL_BITS;
+        int      digit   = wheel_digit(events->now, level);
+        int64_t  base    = events->now & ~(WHEEL_SPAN_OF(level) - 1);
+        uint64_t ahead   = 0;
+        int64_t  t       = INT64_MAX;
+
+        // slots behind the current digit only exist on the top level
+        if (digit < WHEEL_MASK) {
+            ahead = pending & (~(uint64_t) 0 << (digit + 1));
+        }
+
+        if (ahead != 0) {
+            t = base + ((int64_t) __builtin_ctzll(ahead) << shift);
+        } else if (pending != 0 && level == WHEEL_LEVELS - 1) {
+            t = base + WHEEL_SPAN;
+            t += (int64_t) __builtin_ctzll(pending) << shift;
+        }
+
+        if (t < next) {
+            next = t;
+        }
+    }
+
+    return next;
+}
+
+static void wheel_advance(neu_events_t *events, int64_t target)
+{
+    int64_t next = 0;
+
+    while ((next = wheel_next(events)) <= target) {
+        events->now = next;
+
+        for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+            int64_t span = (int64_t) 1 << (level * WHEEL_BITS);
+            int     slot = wheel_digit(next, level);
+
+            if ((next & (span - 1)) != 0 ||
+                (events->pending[level] & ((uint64_t) 1 << slot)) == 0) {
+                continue;
+            }
+
+            neu_event_timer_t *list = events->slots[level][slot];
+            neu_event_timer_t *el = NULL, *tmp = NULL;
+
+            events->slots[level][slot] = NULL;
+            events->pending[level] &= ~((uint64_t) 1 << slot);
+            DL_FOREACH_SAFE(list, el, tmp)
+            {
+                DL_DELETE(list, el);
+                wheel_insert(events, el);
+            }
+        }
+
+        int slot = wheel_digit(next, 0);
+        if ((events->pending[0] & ((uint64_t) 1 << slot)) != 0) {
+            neu_event_timer_t *el = NULL;
+
+            DL_FOREACH(events->slots[0][slot], el) { el->level = TIMER_DUE; }
+            DL_CONCAT(events->due, events->slots[0][slot]);
+            events->slots[0][slot] = NULL;
+            events->pending[0] &= ~((uint64_t) 1 << slot);
+        }
+    }
+
+    if (target > events->now) {
+        events->now = target;
+    }
+}
+
+static void timer_arm(neu_events_t *events)
 {
-    int ret = -1;
+    int64_t           next  = wheel_next(events);
+    struct itimerspec value = { 0 };
+
+    if (next == events->armed) {
+        return;
+    }
+
+    events->armed = next;
+    if (next != INT64_MAX) {
+        value.it_value.tv_sec  = next / 1000;
+        value.it_value.tv_nsec = (next % 1000) * 1000 * 1000;
+    }
+
+    timerfd_settime(events->timer_fd, TFD_TIMER_ABSTIME, &value, NULL);
+}
+
+static void timer_rearm(neu_events_t *events, neu_event_timer_t *timer)
+{
+    if (timer->type == NEU_EVENT_TIMER_BLOCK) {
+        // the period starts over once the callback returns
+        timer->expire = monotonic_ms() + timer->period;
+    } else {
+        timer->expire += timer->period;
+        if (timer->expire <= events->now) {
+            // skip the missed periods and keep the phase
+            int64_t missed = (events->now - timer->expire) / timer->period;
+            timer->expire += (missed + 1) * timer->period;
+        }
+    }
+
+    wheel_insert(events, timer);
+}
+
+static void dispatch_timers(neu_events_t *events)
+{
+    neu_event_timer_t *timer = NULL;
+
     pthread_mutex_lock(&events->mtx);
-    for (int i = 0; i < EVENT_SIZE; i++) {
-        if (events->event_datas[i].use == false) {
-            events->event_datas[i].use   = true;
-            events->event_datas[i].index = i;
-            ret                          = i;
-            break;
+    events->armed = 0;
+    wheel_advance(events, monotonic_ms());
+
+    while ((timer = events->due) != NULL) {
+        DL_DELETE(events->due, timer);
+        timer->level    = TIMER_IDLE;
+        events->running = timer;
+        pthread_mutex_unlock(&events->mtx);
+
+        timer->cb(timer->usr_data);
+
+        pthread_mutex_lock(&events->mtx);
+        events->running = NULL;
+        if (timer->release) {
+            free(timer);
+        } else if (!timer->stop) {
+            timer_rearm(events, timer);
         }
+        pthread_cond_broadcast(&events->cond);
     }
 
+    timer_arm(events);
     pthread_mutex_unlock(&events->mtx);
-    return ret;
 }
 
-static void free_event(neu_events_t *events, int index)
+static void free_garbage(neu_events_t *events)
 {
+    neu_event_io_t *el = NULL, *tmp = NULL;
+
     pthread_mutex_lock(&events->mtx);
-    events->event_datas[index].use   = false;
-    events->event_datas[index].index = 0;
+    DL_FOREACH_SAFE(events->garbage, el, tmp)
+    {
+        DL_DELETE(events->garbage, el);
+        free(el);
+    }
     pthread_mutex_unlock(&events->mtx);
 }
 
+static void dispatch_io(neu_event_io_t *io, uint32_t flags)
+{
+    if (__atomic_load_n(&io->deleted, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    if ((flags & EPOLLHUP) == EPOLLHUP) {
+        io->cb(NEU_EVENT_IO_HUP, io->fd, io->usr_data);
+        return;
+    }
+
+    if ((flags & EPOLLRDHUP) == EPOLLRDHUP) {
+        io->cb(NEU_EVENT_IO_CLOSED, io->fd, io->usr_data);
+        return;
+    }
+
+    if ((flags & EPOLLIN) == EPOLLIN) {
+        io->cb(NEU_EVENT_IO_READ, io->fd, io->usr_data);
+    }
+}
+
 static void *event_loop(void *arg)
 {
-    neu_events_t *events   = (neu_events_t *) arg;
-    int           epoll_fd = events->epoll_fd;
+    neu_events_t *     events   = (neu_events_t *) arg;
+    int                epoll_fd = events->epoll_fd;
+    struct epoll_event ready[EVENT_BATCH];
 
     while (!events->stop) {
-        struct epoll_event event = { 0 };
-        struct event_data *data  = NULL;
+        free_garbage(events);
 
-        int ret = epoll_wait(epoll_fd, &event, 1, 1000);
+        int ret = epoll_wait(epoll_fd, ready, EVENT_BATCH, 1000);
         if (ret == 0) {
             continue;
         }
@@ -127,50 +356,18 @@ static void *event_loop(void *arg)
             break;
         }
 
-        data = (struct event_data *) event.data.ptr;
-
-        switch (data->type) {
-        case TIMER:
-            pthread_mutex_lock(&data->ctx.timer.mtx);
-            if ((event.events & EPOLLIN) == EPOLLIN) {
+        for (int i = 0; i < ret; i++) {
+            if (ready[i].data.ptr == NULL) {
                 uint64_t t;
 
-                ssize_t size = read(data->fd, &t, sizeof(t));
+                ssize_t size = read(events->timer_fd, &t, sizeof(t));
                 (void) size;
 
-                if (!data->ctx.timer.stop) {
-                    if (data->ctx.timer.type == NEU_EVENT_TIMER_BLOCK) {
-                        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, data->fd, NULL);
-                        ret = data->callback.timer(data->usr_data);
-                        timerfd_settime(data->fd, 0, &data->ctx.timer.value,
-                                        NULL);
-                        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, data->fd, &event);
-                    } else {
-                        ret = data->callback.timer(data->usr_data);
-                    }
-                }
-            }
-
-            pthread_mutex_unlock(&data->ctx.timer.mtx);
-            break;
-        case IO:
-            if ((event.events & EPOLLHUP) == EPOLLHUP) {
-                data->callback.io(NEU_EVENT_IO_HUP, data->fd, data->usr_data);
-                break;
+                dispatch_timers(events);
+            } else {
+                dispatch_io((neu_event_io_t *) ready[i].data.ptr,
+                            ready[i].events);
             }
-
-            if ((event.events & EPOLLRDHUP) == EPOLLRDHUP) {
-                data->callback.io(NEU_EVENT_IO_CLOSED, data->fd,
-                                  data->usr_data);
-                break;
-            }
-
-            if ((event.events & EPOLLIN) == EPOLLIN) {
-                data->callback.io(NEU_EVENT_IO_READ, data->fd, data->usr_data);
-                break;
-            }
-
-            break;
         }
     }
 
@@ -186,9 +383,20 @@ neu_events_t *neu_event_new(void)
     nlog_notice("create epoll: %d(%d)", events->epoll_fd, errno);
     assert(events->epoll_fd > 0);
 
-    events->stop    = false;
-    events->n_event = 0;
+    events->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    assert(events->timer_fd > 0);
+
+    struct epoll_event event = {
+        .events   = EPOLLIN,
+        .data.ptr = NULL,
+    };
+    epoll_ctl(events->epoll_fd, EPOLL_CTL_ADD, events->timer_fd, &event);
+
+    events->stop  = false;
+    events->now   = monotonic_ms();
+    events->armed = INT64_MAX;
     pthread_mutex_init(&events->mtx, NULL);
+    pthread_cond_init(&events->cond, NULL);
 
     pthread_create(&events->thread, NULL, event_loop, events);
 
@@ -201,7 +409,37 @@ int neu_event_close(neu_events_t *events)
     close(events->epoll_fd);
 
     pthread_join(events->thread, NULL);
+
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            neu_event_timer_t *el = NULL, *tmp = NULL;
+
+            DL_FOREACH_SAFE(events->slots[level][slot], el, tmp)
+            {
+                DL_DELETE(events->slots[level][slot], el);
+                free(el);
+            }
+        }
+    }
+
+    neu_event_timer_t *timer = NULL, *timer_tmp = NULL;
+    DL_FOREACH_SAFE(events->due, timer, timer_tmp)
+    {
+        DL_DELETE(events->due, timer);
+        free(timer);
+    }
+
+    neu_event_io_t *io = NULL, *io_tmp = NULL;
+    DL_FOREACH_SAFE(events->ios, io, io_tmp)
+    {
+        DL_DELETE(events->ios, io);
+        free(io);
+    }
+    free_garbage(events);
+
+    close(events->timer_fd);
     pthread_mutex_destroy(&events->mtx);
+    pthread_cond_destroy(&events->cond);
 
     free(events);
     return 0;
@@ -210,101 +448,84 @@ int neu_event_close(neu_events_t *events)
 neu_event_timer_t *neu_event_add_timer(neu_events_t *          events,
                                        neu_event_timer_param_t timer)
 {
-    int               ret      = 0;
-    int               timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
-    struct itimerspec value    = {
-        .it_value.tv_sec     = timer.second,
-        .it_value.tv_nsec    = timer.millisecond * 1000 * 1000,
-        .it_interval.tv_sec  = timer.second,
-        .it_interval.tv_nsec = timer.millisecond * 1000 * 1000,
-    };
-    int index = get_free_event(events);
-    if (index < 0) {
-        zlog_fatal(neuron, "no free event: %d", events->epoll_fd);
-    }
-    assert(index >= 0);
+    neu_event_timer_t *timer_ctx = calloc(1, sizeof(neu_event_timer_t));
 
-    neu_event_timer_t *timer_ctx = &events->event_datas[index].ctx.timer;
-    timer_ctx->event_data        = &events->event_datas[index];
+    timer_ctx->period   = timer.second * 1000 + timer.millisecond;
+    timer_ctx->type     = timer.type;
+    timer_ctx->cb       = timer.cb;
+    timer_ctx->usr_data = timer.usr_data;
+    timer_ctx->level    = TIMER_IDLE;
 
-    struct epoll_event event = {
-        .events   = EPOLLIN,
-        .data.ptr = timer_ctx->event_data,
-    };
-
-    timerfd_settime(timer_fd, 0, &value, NULL);
-
-    timer_ctx->event_data->type           = TIMER;
-    timer_ctx->event_data->fd             = timer_fd;
-    timer_ctx->event_data->usr_data       = timer.usr_data;
-    timer_ctx->event_data->callback.timer = timer.cb;
-    timer_ctx->event_data->ctx.timer = events->event_datas[index].ctx.timer;
-    timer_ctx->event_data->index     = index;
-
-    timer_ctx->value = value;
-    timer_ctx->fd    = timer_fd;
-    timer_ctx->type  = timer.type;
-    timer_ctx->stop  = false;
-    pthread_mutex_init(&timer_ctx->mtx, NULL);
-
-    ret = epoll_ctl(events->epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+    pthread_mutex_lock(&events->mtx);
+    // a zero period never fires, same as a disarmed timerfd
+    if (timer_ctx->period > 0) {
+        timer_ctx->expire = monotonic_ms() + timer_ctx->period;
+        if (timer_ctx->expire <= events->now) {
+            timer_ctx->expire = events->now + 1;
+        }
+        wheel_insert(events, timer_ctx);
+        timer_arm(events);
+    }
+    pthread_mutex_unlock(&events->mtx);
 
     zlog_notice(neuron,
                 "add timer, second: %" PRId64 ", millisecond: %" PRId64
-                ", timer: %d in epoll %d, "
-                "ret: %d, index: %d",
-                timer.second, timer.millisecond, timer_fd, events->epoll_fd,
-                ret, index);
+                ", timer: %p in epoll %d",
+                timer.second, timer.millisecond, (void *) timer_ctx,
+                events->epoll_fd);
 
     return timer_ctx;
 }
 
 int neu_event_del_timer(neu_events_t *events, neu_event_timer_t *timer)
 {
-    zlog_notice(neuron, "del timer: %d from epoll: %d, index: %d", timer->fd,
-                events->epoll_fd, timer->event_data->index);
+    zlog_notice(neuron, "del timer: %p from epoll: %d", (void *) timer,
+                events->epoll_fd);
 
+    pthread_mutex_lock(&events->mtx);
+    timer_unlink(events, timer);
     timer->stop = true;
-    epoll_ctl(events->epoll_fd, EPOLL_CTL_DEL, timer->fd, NULL);
 
-    pthread_mutex_lock(&timer->mtx);
-    close(timer->fd);
-    pthread_mutex_unlock(&timer->mtx);
+    if (events->running == timer) {
+        if (pthread_equal(pthread_self(), events->thread)) {
+            // deleted by its own callback, freed once it returns
+            timer->release = true;
+            pthread_mutex_unlock(&events->mtx);
+            return 0;
+        }
+
+        while (events->running == timer) {
+            pthread_cond_wait(&events->cond, &events->mtx);
+        }
+    }
+    pthread_mutex_unlock(&events->mtx);
 
-    pthread_mutex_destroy(&timer->mtx);
-    free_event(events, timer->event_data->index);
+    free(timer);
     return 0;
 }
 
 neu_event_io_t *neu_event_add_io(neu_events_t *events, neu_event_io_param_t io)
 {
-    int ret   = 0;
-    int index = get_free_event(events);
+    int             ret    = 0;
+    neu_event_io_t *io_ctx = calloc(1, sizeof(neu_event_io_t));
 
-    nlog_notice("add io, fd: %d, epoll: %d, index: %d", io.fd, events->epoll_fd,
-                index);
-    assert(index >= 0);
+    io_ctx->fd       = io.fd;
+    io_ctx->cb       = io.cb;
+    io_ctx->usr_data = io.usr_data;
+
+    pthread_mutex_lock(&events->mtx);
+    DL_APPEND(events->ios, io_ctx);
+    pthread_mutex_unlock(&events->mtx);
 
-    neu_event_io_t *io_ctx   = &events->event_datas[index].ctx.io;
-    io_ctx->event_data       = &events->event_datas[index];
     struct epoll_event event = {
         .events   = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP,
-        .data.ptr = io_ctx->event_data,
+        .data.ptr = io_ctx,
     };
 
-    io_ctx->event_data->type        = IO;
-    io_ctx->event_data->fd          = io.fd;
-    io_ctx->event_data->usr_data    = io.usr_data;
-    io_ctx->event_data->callback.io = io.cb;
-    io_ctx->event_data->ctx.io      = events->event_datas[index].ctx.io;
-    io_ctx->event_data->index       = index;
-
-    io_ctx->fd = io.fd;
-
     ret = epoll_ctl(events->epoll_fd, EPOLL_CTL_ADD, io.fd, &event);
 
-    nlog_notice("add io, fd: %d, epoll: %d, ret: %d(%d), index: %d", io.fd,
-                events->epoll_fd, ret, errno, index);
+    nlog_notice("add io, fd: %d, epoll: %d, ret: %d(%d)", io.fd,
+                events->epoll_fd, ret, errno);
     assert(ret == 0);
 
     return io_ctx;
@@ -316,13 +537,19 @@ int neu_event_del_io(neu_events_t *events, neu_event_io_t *io)
         return 0;
     }
 
-    zlog_notice(neuron, "del io: %d from epoll: %d, index: %d", io->fd,
-                events->epoll_fd, io->event_data->index);
+    zlog_notice(neuron, "del io: %d from epoll: %d", io->fd,
+                events->epoll_fd);
 
     epoll_ctl(events->epoll_fd, EPOLL_CTL_DEL, io->fd, NULL);
-    free_event(events, io->event_data->index);
+
+    // the current epoll batch may still refer to it
+    pthread_mutex_lock(&events->mtx);
+    __atomic_store_n(&io->deleted, true, __ATOMIC_RELEASE);
+    DL_DELETE(events->ios, io);
+    DL_APPEND(events->garbage, io);
+    pthread_mutex_unlock(&events->mtx);
 
     return 0;
 }
 
-#endif
\ No newline at end of file
+#endif
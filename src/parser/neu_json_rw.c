@@ -181,9 +181,13 @@ int neu_json_encode_read_paginate_resp(void *json_object, void *param)
         { .name      = "pageSize",
           .t         = NEU_JSON_INT,
           .v.val_int = resp->meta.page_size },
-        { .name = "total", .t = NEU_JSON_INT, .v.val_int = resp->meta.total }
+        { .name = "total", .t = NEU_JSON_INT, .v.val_int = resp->meta.total },
+        { .name      = "nextCursor",
+          .t         = NEU_JSON_INT,
+          .v.val_int = resp->meta.next_cursor },
     };
-    neu_json_encode_field(meta_object, meta_elems, 3);
+    neu_json_encode_field(meta_object, meta_elems,
+                          resp->meta.by_cursor ? 4 : 3);
 
     neu_json_elem_t resp_elems[] = {
         { .name = "meta", .t = NEU_JSON_OBJECT, .v.val_object = meta_object },
@@ -715,6 +719,12 @@ int neu_json_decode_read_paginate_req(char *                         buf,
             .t         = NEU_JSON_BOOL,
             .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
         },
+        {
+            .name      = "cursor",
+            .t         = NEU_JSON_INT,
+            .attribute = NEU_JSON_ATTRIBUTE_OPTIONAL,
+            .v.val_int = -1,
+        },
     };
 
     ret = neu_json_decode_by_json(json_obj, NEU_JSON_ELEM_SIZE(req_elems),
@@ -724,9 +734,10 @@ int neu_json_decode_read_paginate_req(char *                         buf,
         goto error;
     }
 
-    req->node  = req_elems[0].v.val_str;
-    req->group = req_elems[1].v.val_str;
-    req->sync  = req_elems[2].v.val_bool;
+    req->node   = req_elems[0].v.val_str;
+    req->group  = req_elems[1].v.val_str;
+    req->sync   = req_elems[2].v.val_bool;
+    req->cursor = -1;
 
     if (req_elems[3].v.val_object) {
         ret = neu_json_decode_by_json(req_elems[3].v.val_object,
@@ -741,6 +752,7 @@ int neu_json_decode_read_paginate_req(char *                         buf,
         req->current_page = query_elems[2].v.val_int;
         req->page_size    = query_elems[3].v.val_int;
         req->is_error     = query_elems[4].v.val_bool;
+        req->cursor       = query_elems[5].v.val_int;
     }
 
     *result = req;
@@ -1039,6 +1051,156 @@ void neu_json_metas_to_json_paginate(
     }
 }
 
+static void write_value(neu_json_writer_t *w, enum neu_json_type t,
+                        const union neu_json_value *v, int precision,
+                        double bias)
+{
+    switch (t) {
+    case NEU_JSON_BIT:
+        neu_json_writer_int(w, v->val_bit);
+        break;
+    case NEU_JSON_INT:
+        neu_json_writer_int(w, v->val_int);
+        break;
+    case NEU_JSON_STR:
+        neu_json_writer_string(w, v->val_str);
+        break;
+    case NEU_JSON_FLOAT: {
+        double t = v->val_float;
+        if (precision == 0 && bias == 0) {
+            t = neu_json_format_float(v->val_float);
+        }
+        neu_json_writer_real(w, t, precision);
+        break;
+    }
+    case NEU_JSON_DOUBLE:
+        neu_json_writer_real(w, v->val_double, precision);
+        break;
+    case NEU_JSON_BOOL:
+        neu_json_writer_bool(w, v->val_bool);
+        break;
+    case NEU_JSON_BYTES:
+        neu_json_writer_array_begin(w);
+        for (int i = 0; i < v->val_bytes.length; i++) {
+            neu_json_writer_int(w, v->val_bytes.bytes[i]);
+        }
+        neu_json_writer_array_end(w);
+        break;
+    default:
+        neu_json_writer_null(w);
+        break;
+    }
+}
+
+static void write_metas(neu_json_writer_t *             w,
+                        const neu_json_read_resp_tag_t *tag)
+{
+    for (int k = 0; k < tag->n_meta; k++) {
+        neu_json_writer_key(w, tag->metas[k].name);
+        write_value(w, tag->metas[k].t, &tag->metas[k].value, 0, 0);
+    }
+}
+
+void neu_json_write_read_periodic(neu_json_writer_t *             w,
+                                  const neu_json_read_periodic_t *periodic)
+{
+    neu_json_writer_key(w, "node");
+    neu_json_writer_string(w, periodic->node);
+    neu_json_writer_key(w, "group");
+    neu_json_writer_string(w, periodic->group);
+    neu_json_writer_key(w, "timestamp");
+    neu_json_writer_int(w, (int64_t) periodic->timestamp);
+}
+
+void neu_json_write_read_resp(neu_json_writer_t *w, int n_tag,
+                              neu_json_tag_fill_fn fill, void *ctx)
+{
+    neu_json_writer_key(w, "tags");
+    neu_json_writer_array_begin(w);
+    for (int i = 0; i < n_tag; i++) {
+        neu_json_read_resp_tag_t tag                      = { 0 };
+        neu_json_tag_meta_t      metas[NEU_TAG_META_SIZE] = { 0 };
+
+        fill(ctx, i, &tag, metas);
+
+        neu_json_writer_object_begin(w);
+        neu_json_writer_key(w, "name");
+        neu_json_writer_string(w, tag.name);
+        if (tag.error != 0) {
+            neu_json_writer_key(w, "error");
+            neu_json_writer_int(w, tag.error);
+        } else {
+            neu_json_writer_key(w, "value");
+            write_value(w, tag.t, &tag.value, tag.precision,
+                        tag.datatag.bias);
+
+            if (tag.t == NEU_JSON_FLOAT || tag.t == NEU_JSON_DOUBLE) {
+                neu_json_writer_key(w, "transferPrecision");
+                neu_json_writer_int(w, tag.precision > 0 ? tag.precision : 1);
+            }
+        }
+        write_metas(w, &tag);
+        neu_json_writer_object_end(w);
+    }
+    neu_json_writer_array_end(w);
+}
+
+void neu_json_write_read_resp1(neu_json_writer_t *w, int n_tag,
+                               neu_json_tag_fill_fn fill, void *ctx)
+{
+    int n_error = 0;
+    int n_metas = 0;
+
+    neu_json_writer_key(w, "values");
+    neu_json_writer_object_begin(w);
+    for (int i = 0; i < n_tag; i++) {
+        neu_json_read_resp_tag_t tag                      = { 0 };
+        neu_json_tag_meta_t      metas[NEU_TAG_META_SIZE] = { 0 };
+
+        fill(ctx, i, &tag, metas);
+        if (tag.error != 0) {
+            n_error += 1;
+        } else {
+            neu_json_writer_key(w, tag.name);
+            write_value(w, tag.t, &tag.value, tag.precision,
+                        tag.datatag.bias);
+        }
+        n_metas += tag.n_meta > 0;
+    }
+    neu_json_writer_object_end(w);
+
+    // errors and metas are rare, tags are only pulled again when present
+    neu_json_writer_key(w, "errors");
+    neu_json_writer_object_begin(w);
+    for (int i = 0; n_error > 0 && i < n_tag; i++) {
+        neu_json_read_resp_tag_t tag                      = { 0 };
+        neu_json_tag_meta_t      metas[NEU_TAG_META_SIZE] = { 0 };
+
+        fill(ctx, i, &tag, metas);
+        if (tag.error != 0) {
+            neu_json_writer_key(w, tag.name);
+            neu_json_writer_int(w, tag.error);
+        }
+    }
+    neu_json_writer_object_end(w);
+
+    neu_json_writer_key(w, "metas");
+    neu_json_writer_object_begin(w);
+    for (int i = 0; n_metas > 0 && i < n_tag; i++) {
+        neu_json_read_resp_tag_t tag                      = { 0 };
+        neu_json_tag_meta_t      metas[NEU_TAG_META_SIZE] = { 0 };
+
+        fill(ctx, i, &tag, metas);
+        if (tag.n_meta > 0) {
+            neu_json_writer_key(w, tag.name);
+            neu_json_writer_object_begin(w);
+            write_metas(w, &tag);
+            neu_json_writer_object_end(w);
+        }
+    }
+    neu_json_writer_object_end(w);
+}
+
 int neu_json_decode_write_gtags_req(char *                       buf,
                                     neu_json_write_gtags_req_t **result)
 {
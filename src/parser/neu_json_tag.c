@@ -399,6 +399,29 @@ int neu_json_encode_au_tags_resp(void *json_object, void *param)
     return ret;
 }
 
+int neu_json_encode_import_tags_resp(void *json_object, void *param)
+{
+    int                         ret  = 0;
+    neu_json_import_tags_res_t *resp = (neu_json_import_tags_res_t *) param;
+    neu_json_elem_t             resp_elems[] = {
+        {
+            .name      = "index",
+            .t         = NEU_JSON_INT,
+            .v.val_int = resp->index,
+        },
+        {
+            .name      = "error",
+            .t         = NEU_JSON_INT,
+            .v.val_int = resp->error,
+        },
+    };
+
+    ret = neu_json_encode_field(json_object, resp_elems,
+                                NEU_JSON_ELEM_SIZE(resp_elems));
+
+    return ret;
+}
+
 int neu_json_encode_gtag(void *json_obj, void *param)
 {
     neu_json_gtag_t *gtag      = param;
@@ -75,6 +75,13 @@ typedef struct {
 
 int neu_json_encode_au_tags_resp(void *json_object, void *param);
 
+typedef struct {
+    uint32_t index;
+    int      error;
+} neu_json_import_tags_res_t;
+
+int neu_json_encode_import_tags_resp(void *json_object, void *param);
+
 typedef struct {
     char *          group;
     int             n_tag;
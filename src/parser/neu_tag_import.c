@@ -0,0 +1,555 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errcodes.h"
+#include "json/json.h"
+
+#include "neu_json_tag.h"
+#include "neu_tag_import.h"
+
+typedef enum {
+    JSON_ARRAY_BEGIN,
+    JSON_ELEM_BEGIN,
+    JSON_OBJECT,
+    JSON_ELEM_END,
+    JSON_DONE,
+} json_state_e;
+
+typedef enum {
+    CSV_FIELD_BEGIN,
+    CSV_UNQUOTED,
+    CSV_QUOTED,
+    CSV_QUOTE, // a quote in a quoted field, either escaped or closing
+} csv_state_e;
+
+typedef enum {
+    COL_NAME,
+    COL_ADDRESS,
+    COL_ATTRIBUTE,
+    COL_TYPE,
+    COL_PRECISION,
+    COL_DECIMAL,
+    COL_BIAS,
+    COL_DESCRIPTION,
+    COL_VALUE,
+    COL_MAX,
+} column_e;
+
+static const char *column_names[COL_MAX] = {
+    [COL_NAME]        = "name",
+    [COL_ADDRESS]     = "address",
+    [COL_ATTRIBUTE]   = "attribute",
+    [COL_TYPE]        = "type",
+    [COL_PRECISION]   = "precision",
+    [COL_DECIMAL]     = "decimal",
+    [COL_BIAS]        = "bias",
+    [COL_DESCRIPTION] = "description",
+    [COL_VALUE]       = "value",
+};
+
+struct neu_tag_import {
+    neu_tag_import_format_e format;
+    int                     state;
+    bool                    error;
+
+    // json object spanning chunks, or the fields of the csv record
+    char * buf;
+    size_t len;
+    size_t cap;
+
+    int  depth;
+    bool in_str;
+    bool escape;
+    bool comma;
+
+    bool     header;
+    int      n_column;
+    column_e columns[COL_MAX];
+    int      n_field;
+    size_t   fields[COL_MAX];
+    size_t   field_start;
+
+    neu_datatag_t *tags;
+    uint32_t       n_tag;
+    uint32_t       cap_tag;
+};
+
+neu_tag_import_t *neu_tag_import_new(neu_tag_import_format_e format)
+{
+    neu_tag_import_t *imp = calloc(1, sizeof(neu_tag_import_t));
+
+    if (NULL != imp) {
+        imp->format = format;
+        imp->state =
+            NEU_TAG_IMPORT_JSON == format ? JSON_ARRAY_BEGIN : CSV_FIELD_BEGIN;
+    }
+
+    return imp;
+}
+
+void neu_tag_import_free(neu_tag_import_t *imp)
+{
+    if (NULL == imp) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < imp->n_tag; i++) {
+        neu_tag_fini(&imp->tags[i]);
+    }
+    free(imp->tags);
+    free(imp->buf);
+    free(imp);
+}
+
+uint32_t neu_tag_import_count(const neu_tag_import_t *imp)
+{
+    return imp->n_tag;
+}
+
+neu_datatag_t *neu_tag_import_take(neu_tag_import_t *imp, uint32_t *n_tag)
+{
+    neu_datatag_t *tags = imp->tags;
+
+    *n_tag       = imp->n_tag;
+    imp->tags    = NULL;
+    imp->n_tag   = 0;
+    imp->cap_tag = 0;
+
+    return tags;
+}
+
+static int buf_append(neu_tag_import_t *imp, const char *s, size_t n)
+{
+    if (imp->len + n + 1 > imp->cap) {
+        size_t cap = imp->cap > 0 ? imp->cap : 256;
+        char * buf = NULL;
+
+        while (cap < imp->len + n + 1) {
+            cap *= 2;
+        }
+        if (NULL == (buf = realloc(imp->buf, cap))) {
+            return -1;
+        }
+        imp->buf = buf;
+        imp->cap = cap;
+    }
+
+    memcpy(imp->buf + imp->len, s, n);
+    imp->len += n;
+    imp->buf[imp->len] = '\0';
+    return 0;
+}
+
+static inline int buf_putc(neu_tag_import_t *imp, char c)
+{
+    if (imp->len + 2 <= imp->cap) {
+        imp->buf[imp->len++] = c;
+        return 0;
+    }
+
+    return buf_append(imp, &c, 1);
+}
+
+// the returned tag is counted once complete
+static neu_datatag_t *next_tag(neu_tag_import_t *imp)
+{
+    if (imp->n_tag == imp->cap_tag) {
+        uint32_t       cap  = imp->cap_tag > 0 ? imp->cap_tag * 2 : 64;
+        neu_datatag_t *tags = realloc(imp->tags, cap * sizeof(neu_datatag_t));
+        if (NULL == tags) {
+            return NULL;
+        }
+        imp->tags    = tags;
+        imp->cap_tag = cap;
+    }
+
+    memset(&imp->tags[imp->n_tag], 0, sizeof(neu_datatag_t));
+    return &imp->tags[imp->n_tag];
+}
+
+static int json_tag(neu_tag_import_t *imp, const char *s, size_t len)
+{
+    neu_json_tag_t jtag = { 0 };
+    neu_datatag_t *tag  = next_tag(imp);
+    void *         root = NULL;
+    int            rv   = 0;
+
+    if (NULL == tag || NULL == (root = neu_json_decode_newb((char *) s, len))) {
+        return -1;
+    }
+
+    rv = neu_json_decode_tag_json(root, &jtag);
+    neu_json_decode_free(root);
+    if (0 != rv) {
+        return -1;
+    }
+
+    // take over the decoded strings
+    tag->name        = jtag.name;
+    tag->address     = jtag.address;
+    tag->description = jtag.description ? jtag.description : strdup("");
+    tag->attribute   = jtag.attribute;
+    tag->type        = jtag.type;
+    tag->precision   = jtag.precision;
+    tag->decimal     = jtag.decimal;
+    tag->bias        = jtag.bias;
+
+    if (NEU_ATTRIBUTE_STATIC & tag->attribute) {
+        rv = neu_tag_set_static_value_json(tag, jtag.t, &jtag.value);
+    }
+    if (NEU_JSON_STR == jtag.t) {
+        free(jtag.value.val_str);
+    }
+    if (0 != rv) {
+        neu_tag_fini(tag);
+        return -1;
+    }
+
+    imp->n_tag += 1;
+    return 0;
+}
+
+static int json_feed(neu_tag_import_t *imp, const char *buf, size_t len)
+{
+    // start of the object in buf, unless it began in a previous chunk
+    size_t start = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = buf[i];
+
+        switch (imp->state) {
+        case JSON_ARRAY_BEGIN:
+            if ('[' == c) {
+                imp->state = JSON_ELEM_BEGIN;
+            } else if (!isspace((unsigned char) c)) {
+                return -1;
+            }
+            break;
+        case JSON_ELEM_BEGIN:
+            if ('{' == c) {
+                imp->state = JSON_OBJECT;
+                imp->depth = 1;
+                imp->len   = 0;
+                start      = i;
+            } else if (']' == c && !imp->comma) {
+                imp->state = JSON_DONE;
+            } else if (!isspace((unsigned char) c)) {
+                return -1;
+            }
+            break;
+        case JSON_OBJECT:
+            if (imp->in_str) {
+                if (imp->escape) {
+                    imp->escape = false;
+                } else if ('\\' == c) {
+                    imp->escape = true;
+                } else if ('"' == c) {
+                    imp->in_str = false;
+                }
+            } else if ('"' == c) {
+                imp->in_str = true;
+            } else if ('{' == c || '[' == c) {
+                imp->depth += 1;
+            } else if (('}' == c || ']' == c) && 0 == --imp->depth) {
+                int rv = 0;
+
+                if (imp->len > 0) {
+                    rv = buf_append(imp, buf, i + 1) ||
+                        json_tag(imp, imp->buf, imp->len);
+                    imp->len = 0;
+                } else {
+                    rv = json_tag(imp, buf + start, i + 1 - start);
+                }
+                if (0 != rv) {
+                    return -1;
+                }
+
+                imp->state = JSON_ELEM_END;
+                imp->comma = false;
+            }
+            break;
+        case JSON_ELEM_END:
+            if (',' == c) {
+                imp->state = JSON_ELEM_BEGIN;
+                imp->comma = true;
+            } else if (']' == c) {
+                imp->state = JSON_DONE;
+            } else if (!isspace((unsigned char) c)) {
+                return -1;
+            }
+            break;
+        case JSON_DONE:
+            if (!isspace((unsigned char) c)) {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    if (JSON_OBJECT == imp->state) {
+        size_t from = imp->len > 0 ? 0 : start;
+        return buf_append(imp, buf + from, len - from);
+    }
+
+    return 0;
+}
+
+// empty is zero, trailing garbage is an error
+static int parse_int(const char *s, int64_t *v)
+{
+    char *end = NULL;
+
+    if (NULL == s || '\0' == *s) {
+        *v = 0;
+        return 0;
+    }
+
+    errno = 0;
+    *v    = strtoll(s, &end, 10);
+    return 0 != errno || '\0' != *end ? -1 : 0;
+}
+
+static int parse_double(const char *s, double *v)
+{
+    char *end = NULL;
+
+    if (NULL == s || '\0' == *s) {
+        *v = 0;
+        return 0;
+    }
+
+    errno = 0;
+    *v    = strtod(s, &end);
+    return 0 != errno || '\0' != *end ? -1 : 0;
+}
+
+static int csv_header(neu_tag_import_t *imp)
+{
+    bool seen[COL_MAX] = { 0 };
+
+    for (int i = 0; i < imp->n_field; i++) {
+        const char *name = imp->buf + imp->fields[i];
+        int         col  = 0;
+
+        // byte order mark written by spreadsheets
+        if (0 == i && 0 == strncmp(name, "\xEF\xBB\xBF", 3)) {
+            name += 3;
+        }
+
+        for (col = 0; col < COL_MAX; col++) {
+            if (0 == strcmp(name, column_names[col])) {
+                break;
+            }
+        }
+        if (COL_MAX == col || seen[col]) {
+            return -1;
+        }
+
+        seen[col]       = true;
+        imp->columns[i] = col;
+        imp->n_column   = i + 1;
+    }
+
+    if (!seen[COL_NAME] || !seen[COL_ADDRESS] || !seen[COL_ATTRIBUTE] ||
+        !seen[COL_TYPE]) {
+        return -1;
+    }
+
+    imp->header = true;
+    return 0;
+}
+
+static int csv_tag(neu_tag_import_t *imp)
+{
+    const char *   v[COL_MAX] = { NULL };
+    neu_datatag_t *tag        = NULL;
+    int64_t        attribute = 0, type = 0, precision = 0;
+
+    if (imp->n_field != imp->n_column) {
+        return -1;
+    }
+
+    for (int i = 0; i < imp->n_field; i++) {
+        v[imp->columns[i]] = imp->buf + imp->fields[i];
+    }
+
+    if ('\0' == *v[COL_NAME] || '\0' == *v[COL_ATTRIBUTE] ||
+        '\0' == *v[COL_TYPE] || 0 != parse_int(v[COL_ATTRIBUTE], &attribute) ||
+        0 != parse_int(v[COL_TYPE], &type) ||
+        0 != parse_int(v[COL_PRECISION], &precision) || precision < 0 ||
+        precision > UINT8_MAX) {
+        return -1;
+    }
+
+    if (NULL == (tag = next_tag(imp))) {
+        return -1;
+    }
+
+    tag->attribute   = attribute;
+    tag->type        = type;
+    tag->precision   = precision;
+    tag->name        = strdup(v[COL_NAME]);
+    tag->address     = strdup(v[COL_ADDRESS]);
+    tag->description = strdup(v[COL_DESCRIPTION] ? v[COL_DESCRIPTION] : "");
+
+    if (NULL == tag->name || NULL == tag->address ||
+        NULL == tag->description ||
+        0 != parse_double(v[COL_DECIMAL], &tag->decimal) ||
+        0 != parse_double(v[COL_BIAS], &tag->bias)) {
+        goto error;
+    }
+
+    if (NEU_ATTRIBUTE_STATIC & tag->attribute) {
+        if (0 != neu_tag_load_static_value(tag, v[COL_VALUE])) {
+            goto error;
+        }
+    } else if (NULL != v[COL_VALUE] && '\0' != *v[COL_VALUE]) {
+        // non static tag should have no initial value
+        goto error;
+    }
+
+    imp->n_tag += 1;
+    return 0;
+
+error:
+    neu_tag_fini(tag);
+    return -1;
+}
+
+static int csv_field_end(neu_tag_import_t *imp)
+{
+    if (COL_MAX == imp->n_field || 0 != buf_putc(imp, '\0')) {
+        return -1;
+    }
+
+    imp->fields[imp->n_field++] = imp->field_start;
+    imp->field_start            = imp->len;
+    return 0;
+}
+
+static int csv_record_end(neu_tag_import_t *imp)
+{
+    int rv = csv_field_end(imp);
+
+    // skip blank lines
+    if (0 == rv && !(1 == imp->n_field && '\0' == imp->buf[imp->fields[0]])) {
+        rv = imp->header ? csv_tag(imp) : csv_header(imp);
+    }
+
+    imp->n_field     = 0;
+    imp->len         = 0;
+    imp->field_start = 0;
+    return rv;
+}
+
+static int csv_feed(neu_tag_import_t *imp, const char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char c  = buf[i];
+        int  rv = 0;
+
+        switch (imp->state) {
+        case CSV_FIELD_BEGIN:
+            if ('"' == c) {
+                imp->state = CSV_QUOTED;
+                break;
+            }
+            imp->state = CSV_UNQUOTED;
+            // fall through
+        case CSV_UNQUOTED:
+            if (',' == c) {
+                rv         = csv_field_end(imp);
+                imp->state = CSV_FIELD_BEGIN;
+            } else if ('\n' == c) {
+                rv         = csv_record_end(imp);
+                imp->state = CSV_FIELD_BEGIN;
+            } else if ('\r' != c) {
+                rv = buf_putc(imp, c);
+            }
+            break;
+        case CSV_QUOTED:
+            if ('"' == c) {
+                imp->state = CSV_QUOTE;
+            } else {
+                rv = buf_putc(imp, c);
+            }
+            break;
+        case CSV_QUOTE:
+            if ('"' == c) {
+                rv         = buf_putc(imp, c);
+                imp->state = CSV_QUOTED;
+            } else if (',' == c) {
+                rv         = csv_field_end(imp);
+                imp->state = CSV_FIELD_BEGIN;
+            } else if ('\n' == c) {
+                rv         = csv_record_end(imp);
+                imp->state = CSV_FIELD_BEGIN;
+            } else if ('\r' != c) {
+                rv = -1;
+            }
+            break;
+        }
+
+        if (0 != rv) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int neu_tag_import_feed(neu_tag_import_t *imp, const char *buf, size_t len)
+{
+    int rv = 0;
+
+    if (!imp->error) {
+        rv = NEU_TAG_IMPORT_JSON == imp->format ? json_feed(imp, buf, len)
+                                                : csv_feed(imp, buf, len);
+        imp->error = 0 != rv;
+    }
+
+    return imp->error ? NEU_ERR_BODY_IS_WRONG : 0;
+}
+
+int neu_tag_import_finish(neu_tag_import_t *imp)
+{
+    if (imp->error) {
+        return NEU_ERR_BODY_IS_WRONG;
+    }
+
+    if (NEU_TAG_IMPORT_JSON == imp->format) {
+        imp->error = JSON_DONE != imp->state;
+    } else if (CSV_QUOTED == imp->state) {
+        imp->error = true;
+    } else {
+        if (CSV_FIELD_BEGIN != imp->state || imp->n_field > 0) {
+            imp->error = 0 != csv_record_end(imp);
+        }
+        imp->error = imp->error || !imp->header;
+        imp->state = CSV_FIELD_BEGIN;
+    }
+
+    return imp->error ? NEU_ERR_BODY_IS_WRONG : 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#ifndef _NEU_TAG_IMPORT_H_
+#define _NEU_TAG_IMPORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tag.h"
+
+/** Streaming parser of tags to import.
+ *
+ * JSON input is an array of tag objects as in the add tags request, each
+ * object is decoded on its own so no document of the whole array is built.
+ * CSV input starts with a header naming the columns among name, address,
+ * attribute, type, precision, decimal, bias, description and value, the
+ * first four being mandatory. The value of static tags is written in JSON,
+ * e.g. 1.5 or "text".
+ *
+ * Input may be fed in chunks of any size, a record can span chunks.
+ */
+typedef enum {
+    NEU_TAG_IMPORT_JSON,
+    NEU_TAG_IMPORT_CSV,
+} neu_tag_import_format_e;
+
+typedef struct neu_tag_import neu_tag_import_t;
+
+neu_tag_import_t *neu_tag_import_new(neu_tag_import_format_e format);
+void              neu_tag_import_free(neu_tag_import_t *imp);
+
+/**
+ * @brief Parse the next chunk of input.
+ *
+ * @return 0 on success, NEU_ERR_BODY_IS_WRONG if the input is malformed, the
+ *         record in error is the one following the tags parsed so far.
+ */
+int neu_tag_import_feed(neu_tag_import_t *imp, const char *buf, size_t len);
+
+/**
+ * @brief Signal the end of input, fails on a truncated record.
+ */
+int neu_tag_import_finish(neu_tag_import_t *imp);
+
+uint32_t neu_tag_import_count(const neu_tag_import_t *imp);
+
+/**
+ * @brief Move out the tags parsed, the caller owns them.
+ */
+neu_datatag_t *neu_tag_import_take(neu_tag_import_t *imp, uint32_t *n_tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
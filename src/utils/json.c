@@ -26,7 +26,7 @@
 #include "utils/log.h"
 #include "json/json.h"
 
-static double format_tag_value(float ele_value)
+double neu_json_format_float(float ele_value)
 {
     double scale    = pow(10, 5);
     double value    = ele_value;
@@ -84,7 +84,7 @@ static json_t *encode_object_value(neu_json_elem_t *ele)
     case NEU_JSON_FLOAT: {
         double t = ele->v.val_float;
         if (ele->precision == 0 && ele->bias == 0) {
-            t = format_tag_value(ele->v.val_float);
+            t = neu_json_format_float(ele->v.val_float);
         }
         ob = json_realp(t, ele->precision);
         break;
@@ -116,7 +116,7 @@ static json_t *encode_object(json_t *object, neu_json_elem_t ele)
     case NEU_JSON_FLOAT: {
         double t = ele.v.val_float;
         if (ele.precision == 0 && ele.bias == 0) {
-            t = format_tag_value(ele.v.val_float);
+            t = neu_json_format_float(ele.v.val_float);
         }
         json_object_set_new(ob, ele.name, json_realp(t, ele.precision));
         break;
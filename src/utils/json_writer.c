@@ -0,0 +1,413 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/json_writer.h"
+
+// doubles below 2^53 hold every integer exactly
+#define EXACT_INT_MAX 9007199254740992.0
+#define REAL_PRECISION_MAX 15
+#define SHORTEST_DIGITS_MAX 9
+
+static const double pow10_tbl[] = {
+    1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+};
+
+static const char digit_pairs[] = "00010203040506070809"
+                                  "10111213141516171819"
+                                  "20212223242526272829"
+                                  "30313233343536373839"
+                                  "40414243444546474849"
+                                  "50515253545556575859"
+                                  "60616263646566676869"
+                                  "70717273747576777879"
+                                  "80818283848586878889"
+                                  "90919293949596979899";
+
+static bool reserve(neu_json_writer_t *w, size_t n)
+{
+    if (w->error) {
+        return false;
+    }
+
+    // one byte more for the terminating NUL, a detached writer keeps its
+    // capacity as the size of the next buffer
+    if (w->buf == NULL || w->len + n + 1 > w->cap) {
+        size_t cap = w->cap > 0 ? w->cap : 256;
+        char * buf = NULL;
+
+        while (w->len + n + 1 > cap) {
+            cap *= 2;
+        }
+
+        buf = realloc(w->buf, cap);
+        if (buf == NULL) {
+            w->error = true;
+            return false;
+        }
+        w->buf = buf;
+        w->cap = cap;
+    }
+
+    return true;
+}
+
+static inline void put(neu_json_writer_t *w, const char *s, size_t n)
+{
+    if (reserve(w, n)) {
+        memcpy(w->buf + w->len, s, n);
+        w->len += n;
+    }
+}
+
+static inline void put_char(neu_json_writer_t *w, char c)
+{
+    if (reserve(w, 1)) {
+        w->buf[w->len++] = c;
+    }
+}
+
+// separator before a value or a key of the current container
+static void separate(neu_json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+
+    if (w->depth > 0) {
+        if (!w->first[w->depth - 1]) {
+            put_char(w, ',');
+        }
+        w->first[w->depth - 1] = false;
+    }
+}
+
+// digits of v backwards from end, returns the first digit
+static char *u64_to_str(uint64_t v, char *end)
+{
+    char *p = end;
+
+    while (v >= 100) {
+        unsigned i = (unsigned) (v % 100) * 2;
+
+        v /= 100;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+
+    if (v >= 10) {
+        unsigned i = (unsigned) v * 2;
+
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    } else {
+        *--p = (char) ('0' + v);
+    }
+
+    return p;
+}
+
+// scaled / 10^digits as decimal text, trailing zeros of the fraction dropped
+static void put_fixed(neu_json_writer_t *w, int64_t scaled, int digits)
+{
+    char     tmp[48];
+    char *   end  = tmp + sizeof(tmp);
+    uint64_t abs  = scaled < 0 ? -(uint64_t) scaled : (uint64_t) scaled;
+    uint64_t unit = (uint64_t) pow10_tbl[digits];
+    uint64_t frac = abs % unit;
+    char *   p    = NULL;
+
+    if (frac == 0 || digits == 0) {
+        *--end = '0';
+    } else {
+        int n = digits;
+
+        while (frac % 10 == 0) {
+            frac /= 10;
+            n -= 1;
+        }
+
+        p = u64_to_str(frac, end);
+        while (end - p < n) {
+            *--p = '0';
+        }
+        end = p;
+    }
+
+    *--end = '.';
+    p      = u64_to_str(abs / unit, end);
+    if (scaled < 0) {
+        *--p = '-';
+    }
+
+    put(w, p, tmp + sizeof(tmp) - p);
+}
+
+void neu_json_writer_init(neu_json_writer_t *w, size_t cap)
+{
+    memset(w, 0, sizeof(*w));
+    w->cap = cap;
+}
+
+void neu_json_writer_reset(neu_json_writer_t *w)
+{
+    w->len       = 0;
+    w->error     = false;
+    w->after_key = false;
+    w->depth     = 0;
+}
+
+void neu_json_writer_fini(neu_json_writer_t *w)
+{
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+}
+
+const char *neu_json_writer_str(neu_json_writer_t *w)
+{
+    if (w->error || w->depth != 0 || !reserve(w, 0)) {
+        return NULL;
+    }
+
+    w->buf[w->len] = '\0';
+    return w->buf;
+}
+
+size_t neu_json_writer_len(const neu_json_writer_t *w)
+{
+    return w->len;
+}
+
+char *neu_json_writer_detach(neu_json_writer_t *w)
+{
+    char *str = (char *) neu_json_writer_str(w);
+
+    if (str != NULL) {
+        w->buf = NULL;
+    }
+
+    neu_json_writer_reset(w);
+    return str;
+}
+
+static void container_begin(neu_json_writer_t *w, char c)
+{
+    separate(w);
+    if (w->depth == NEU_JSON_WRITER_DEPTH) {
+        w->error = true;
+        return;
+    }
+
+    put_char(w, c);
+    w->first[w->depth] = true;
+    w->depth += 1;
+}
+
+static void container_end(neu_json_writer_t *w, char c)
+{
+    if (w->depth == 0 || w->after_key) {
+        w->error = true;
+        return;
+    }
+
+    w->depth -= 1;
+    put_char(w, c);
+}
+
+void neu_json_writer_object_begin(neu_json_writer_t *w)
+{
+    container_begin(w, '{');
+}
+
+void neu_json_writer_object_end(neu_json_writer_t *w)
+{
+    container_end(w, '}');
+}
+
+void neu_json_writer_array_begin(neu_json_writer_t *w)
+{
+    container_begin(w, '[');
+}
+
+void neu_json_writer_array_end(neu_json_writer_t *w)
+{
+    container_end(w, ']');
+}
+
+static void put_string(neu_json_writer_t *w, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *      run   = str;
+
+    put_char(w, '"');
+    for (const char *p = str; *p != '\0'; p++) {
+        unsigned char c = (unsigned char) *p;
+
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        put(w, run, p - run);
+        run = p + 1;
+
+        switch (c) {
+        case '"':
+            put(w, "\\\"", 2);
+            break;
+        case '\\':
+            put(w, "\\\\", 2);
+            break;
+        case '\n':
+            put(w, "\\n", 2);
+            break;
+        case '\r':
+            put(w, "\\r", 2);
+            break;
+        case '\t':
+            put(w, "\\t", 2);
+            break;
+        case '\b':
+            put(w, "\\b", 2);
+            break;
+        case '\f':
+            put(w, "\\f", 2);
+            break;
+        default: {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+            put(w, esc, sizeof(esc));
+            break;
+        }
+        }
+    }
+    put(w, run, strlen(run));
+    put_char(w, '"');
+}
+
+void neu_json_writer_key(neu_json_writer_t *w, const char *key)
+{
+    if (w->depth == 0 || w->after_key) {
+        w->error = true;
+        return;
+    }
+
+    separate(w);
+    put_string(w, key);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void neu_json_writer_string(neu_json_writer_t *w, const char *str)
+{
+    separate(w);
+    if (str == NULL) {
+        put(w, "null", 4);
+    } else {
+        put_string(w, str);
+    }
+}
+
+void neu_json_writer_int(neu_json_writer_t *w, int64_t value)
+{
+    char     tmp[24];
+    char *   end = tmp + sizeof(tmp);
+    uint64_t abs = value < 0 ? -(uint64_t) value : (uint64_t) value;
+    char *   p   = u64_to_str(abs, end);
+
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    separate(w);
+    put(w, p, end - p);
+}
+
+void neu_json_writer_bool(neu_json_writer_t *w, bool value)
+{
+    separate(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void neu_json_writer_null(neu_json_writer_t *w)
+{
+    separate(w);
+    put(w, "null", 4);
+}
+
+void neu_json_writer_real(neu_json_writer_t *w, double value, int precision)
+{
+    char tmp[32];
+    int  n = 0;
+
+    separate(w);
+    if (!isfinite(value)) {
+        put(w, "null", 4);
+        return;
+    }
+
+    if (precision > 0) {
+        if (precision > REAL_PRECISION_MAX) {
+            precision = REAL_PRECISION_MAX;
+        }
+
+        double scaled = value * pow10_tbl[precision];
+        if (fabs(scaled) < EXACT_INT_MAX) {
+            put_fixed(w, llround(scaled), precision);
+            return;
+        }
+    } else {
+        // the fewest fraction digits whose decimal reads back as value, the
+        // quotient of two exact doubles is rounded the same way as strtod
+        for (int d = 0; d <= SHORTEST_DIGITS_MAX; d++) {
+            double scaled = value * pow10_tbl[d];
+            double r      = 0;
+
+            if (fabs(scaled) >= EXACT_INT_MAX) {
+                break;
+            }
+
+            r = nearbyint(scaled);
+            if (r / pow10_tbl[d] == value) {
+                put_fixed(w, (int64_t) r, d);
+                return;
+            }
+        }
+    }
+
+    // shortest of 15 to 17 significant digits that reads back as value
+    for (int digits = 15; digits <= 17; digits++) {
+        n = snprintf(tmp, sizeof(tmp), "%.*g", digits, value);
+        if (strtod(tmp, NULL) == value) {
+            break;
+        }
+    }
+    put(w, tmp, n);
+    if (strpbrk(tmp, ".eE") == NULL) {
+        put(w, ".0", 2);
+    }
+}
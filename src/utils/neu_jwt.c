@@ -20,12 +20,14 @@
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 
 #include <jwt.h>
+#include <openssl/sha.h>
 
 #include "errcodes.h"
 #include "utils/log.h"
@@ -43,6 +45,103 @@ static struct public_key_store key_store;
 static char                    neuron_private_key[2048] = { 0 };
 static char                    neuron_public_key[2048]  = { 0 };
 
+// verified tokens, keyed by the sha256 of the token
+struct jwt_cache_entry {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    int64_t       exp;
+    uint64_t      used;
+    bool          valid;
+};
+
+static struct {
+    pthread_mutex_t        mtx;
+    struct jwt_cache_entry entries[NEU_JWT_CACHE_SIZE];
+    uint64_t               tick;
+    uint64_t               hits;
+    uint64_t               misses;
+} jwt_cache = { .mtx = PTHREAD_MUTEX_INITIALIZER };
+
+typedef enum {
+    JWT_CACHE_MISS,
+    JWT_CACHE_HIT,
+    JWT_CACHE_EXPIRED,
+} jwt_cache_result_e;
+
+static jwt_cache_result_e jwt_cache_find(const unsigned char *digest,
+                                         int64_t              now)
+{
+    jwt_cache_result_e result = JWT_CACHE_MISS;
+
+    pthread_mutex_lock(&jwt_cache.mtx);
+    for (int i = 0; i < NEU_JWT_CACHE_SIZE; i++) {
+        struct jwt_cache_entry *e = &jwt_cache.entries[i];
+
+        if (!e->valid || memcmp(e->digest, digest, sizeof(e->digest)) != 0) {
+            continue;
+        }
+
+        if (now >= e->exp) {
+            e->valid = false;
+            result   = JWT_CACHE_EXPIRED;
+        } else {
+            e->used = ++jwt_cache.tick;
+            result  = JWT_CACHE_HIT;
+        }
+        break;
+    }
+
+    if (result == JWT_CACHE_HIT) {
+        jwt_cache.hits += 1;
+    } else {
+        jwt_cache.misses += 1;
+    }
+    pthread_mutex_unlock(&jwt_cache.mtx);
+
+    return result;
+}
+
+static void jwt_cache_add(const unsigned char *digest, int64_t exp)
+{
+    struct jwt_cache_entry *victim = &jwt_cache.entries[0];
+
+    pthread_mutex_lock(&jwt_cache.mtx);
+    // a free slot, otherwise the least recently used one
+    for (int i = 0; i < NEU_JWT_CACHE_SIZE; i++) {
+        struct jwt_cache_entry *e = &jwt_cache.entries[i];
+
+        if (!e->valid) {
+            victim = e;
+            break;
+        }
+        if (e->used < victim->used) {
+            victim = e;
+        }
+    }
+
+    memcpy(victim->digest, digest, sizeof(victim->digest));
+    victim->exp   = exp;
+    victim->used  = ++jwt_cache.tick;
+    victim->valid = true;
+    pthread_mutex_unlock(&jwt_cache.mtx);
+}
+
+void neu_jwt_cache_invalidate()
+{
+    pthread_mutex_lock(&jwt_cache.mtx);
+    for (int i = 0; i < NEU_JWT_CACHE_SIZE; i++) {
+        jwt_cache.entries[i].valid = false;
+    }
+    pthread_mutex_unlock(&jwt_cache.mtx);
+}
+
+void neu_jwt_cache_stats(uint64_t *hits, uint64_t *misses)
+{
+    pthread_mutex_lock(&jwt_cache.mtx);
+    *hits   = jwt_cache.hits;
+    *misses = jwt_cache.misses;
+    pthread_mutex_unlock(&jwt_cache.mtx);
+}
+
 static int find_key(const char *name)
 {
     for (int i = 0; i < key_store.size; i++) {
@@ -104,6 +203,7 @@ static void load_neuron_key(const char *dir_path)
     assert(content != NULL);
 
     strncpy(neuron_public_key, content, sizeof(neuron_public_key) - 1);
+    neu_jwt_cache_invalidate();
 }
 
 static void scanf_key(const char *dir_path)
@@ -112,6 +212,7 @@ static void scanf_key(const char *dir_path)
     struct dirent *ptr = NULL;
 
     memset(&key_store, 0, sizeof(key_store));
+    neu_jwt_cache_invalidate();
 
     dir = opendir(dir_path);
     if (dir == NULL) {
@@ -275,9 +376,12 @@ static void *neu_jwt_decode(char *token)
 
 int neu_jwt_validate(char *b_token)
 {
-    jwt_valid_t *jwt_valid = NULL;
-    jwt_alg_t    opt_alg   = JWT_ALG_RS256;
-    char *       token     = NULL;
+    jwt_valid_t * jwt_valid = NULL;
+    jwt_alg_t     opt_alg   = JWT_ALG_RS256;
+    char *        token     = NULL;
+    time_t        now       = time(NULL);
+    long          exp       = 0;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
 
     if (b_token == NULL || strlen(b_token) <= strlen("Bearar ")) {
         return NEU_ERR_NEED_TOKEN;
@@ -285,6 +389,19 @@ int neu_jwt_validate(char *b_token)
 
     token = &b_token[strlen("Bearar ")];
 
+    // a token verified before skips the signature check until it expires
+    SHA256((const unsigned char *) token, strlen(token), digest);
+    switch (jwt_cache_find(digest, now)) {
+    case JWT_CACHE_HIT:
+        return NEU_ERR_SUCCESS;
+    case JWT_CACHE_EXPIRED:
+        zlog_error(neuron, "Jwt failed to validate : %d",
+                   JWT_VALIDATION_EXPIRED);
+        return NEU_ERR_EXPIRED_TOKEN;
+    case JWT_CACHE_MISS:
+        break;
+    }
+
     jwt_t *jwt = (jwt_t *) neu_jwt_decode(token);
 
     if (jwt == NULL) {
@@ -307,7 +424,7 @@ int neu_jwt_validate(char *b_token)
         return NEU_ERR_EINTERNAL;
     }
 
-    ret = jwt_valid_set_now(jwt_valid, time(NULL));
+    ret = jwt_valid_set_now(jwt_valid, now);
     if (ret != 0 || jwt_valid == NULL) {
         zlog_error(neuron, "Failed to set time: %d", ret);
         jwt_valid_free(jwt_valid);
@@ -327,6 +444,13 @@ int neu_jwt_validate(char *b_token)
         }
     }
 
+    // tokens without an expiry are verified every time
+    errno = 0;
+    exp   = jwt_get_grant_int(jwt, "exp");
+    if (errno == 0 && exp > now) {
+        jwt_cache_add(digest, exp);
+    }
+
     jwt_valid_free(jwt_valid);
     jwt_free(jwt);
 
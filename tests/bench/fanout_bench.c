@@ -0,0 +1,191 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Fan-out cost of one group report shared by N subscribers.
+ *
+ * The producer builds a snapshot of NEU_BENCH_TAGS tags per report and hands
+ * a reference to every subscriber thread, which walks all values and drops
+ * its reference, as an app adapter does after encoding a report.
+ *
+ * usage: fanout_bench [reports]
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/log.h"
+
+#include "tag.h"
+#include "tag_values.h"
+
+#define NEU_BENCH_TAGS 1000
+#define NEU_BENCH_QUEUE 64
+
+zlog_category_t *neuron = NULL;
+
+typedef struct {
+    pthread_mutex_t   mtx;
+    pthread_cond_t    cond;
+    neu_tag_values_t *queue[NEU_BENCH_QUEUE];
+    uint32_t          head;
+    uint32_t          tail;
+    bool              stop;
+    pthread_t         tid;
+    uint64_t          sum;
+} subscriber_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *subscriber_run(void *arg)
+{
+    subscriber_t *sub = (subscriber_t *) arg;
+
+    while (true) {
+        neu_tag_values_t *values = NULL;
+
+        pthread_mutex_lock(&sub->mtx);
+        while (sub->head == sub->tail && !sub->stop) {
+            pthread_cond_wait(&sub->cond, &sub->mtx);
+        }
+        if (sub->head == sub->tail) {
+            pthread_mutex_unlock(&sub->mtx);
+            break;
+        }
+        values = sub->queue[sub->head % NEU_BENCH_QUEUE];
+        sub->head += 1;
+        pthread_cond_broadcast(&sub->cond);
+        pthread_mutex_unlock(&sub->mtx);
+
+        for (uint32_t i = 0; i < neu_tag_values_size(values); i++) {
+            neu_dvalue_t value = { 0 };
+
+            neu_tag_values_get(values, i, &value);
+            sub->sum += value.value.u64;
+        }
+        neu_tag_values_unref(values);
+    }
+
+    return NULL;
+}
+
+static void subscriber_push(subscriber_t *sub, neu_tag_values_t *values)
+{
+    pthread_mutex_lock(&sub->mtx);
+    while (sub->tail - sub->head == NEU_BENCH_QUEUE) {
+        pthread_cond_wait(&sub->cond, &sub->mtx);
+    }
+    sub->queue[sub->tail % NEU_BENCH_QUEUE] = neu_tag_values_ref(values);
+    sub->tail += 1;
+    pthread_cond_broadcast(&sub->cond);
+    pthread_mutex_unlock(&sub->mtx);
+}
+
+static neu_tag_names_t *make_names(void)
+{
+    UT_array *       tags  = NULL;
+    neu_tag_names_t *names = NULL;
+    char             name[NEU_TAG_NAME_LEN] = { 0 };
+
+    utarray_new(tags, neu_tag_get_icd());
+    for (int i = 0; i < NEU_BENCH_TAGS; i++) {
+        neu_datatag_t tag = { 0 };
+
+        snprintf(name, sizeof(name), "tag%d", i);
+        tag.name        = name;
+        tag.address     = "1!400001";
+        tag.description = "";
+        utarray_push_back(tags, &tag);
+    }
+
+    names = neu_tag_names_new(tags);
+    utarray_free(tags);
+    return names;
+}
+
+static uint64_t run(neu_tag_names_t *names, int n_sub, int reports)
+{
+    subscriber_t *subs  = calloc(n_sub, sizeof(subscriber_t));
+    uint64_t      start = 0;
+
+    for (int i = 0; i < n_sub; i++) {
+        pthread_mutex_init(&subs[i].mtx, NULL);
+        pthread_cond_init(&subs[i].cond, NULL);
+        pthread_create(&subs[i].tid, NULL, subscriber_run, &subs[i]);
+    }
+
+    start = now_ns();
+    for (int r = 0; r < reports; r++) {
+        neu_tag_values_t *values = neu_tag_values_new("bench", "grp", names);
+
+        for (uint32_t i = 0; i < NEU_BENCH_TAGS; i++) {
+            neu_dvalue_t value = { 0 };
+
+            value.type      = NEU_TYPE_UINT32;
+            value.value.u32 = r + i;
+            neu_tag_values_push(values, i, &value, NULL, 0);
+        }
+
+        for (int i = 0; i < n_sub; i++) {
+            subscriber_push(&subs[i], values);
+        }
+        neu_tag_values_unref(values);
+    }
+
+    for (int i = 0; i < n_sub; i++) {
+        pthread_mutex_lock(&subs[i].mtx);
+        subs[i].stop = true;
+        pthread_cond_broadcast(&subs[i].cond);
+        pthread_mutex_unlock(&subs[i].mtx);
+        pthread_join(subs[i].tid, NULL);
+        pthread_cond_destroy(&subs[i].cond);
+        pthread_mutex_destroy(&subs[i].mtx);
+    }
+    free(subs);
+
+    return now_ns() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    int              reports = argc > 1 ? atoi(argv[1]) : 10000;
+    neu_tag_names_t *names   = make_names();
+    const int        subs[]  = { 1, 2, 4, 8, 16, 32 };
+
+    printf("subscribers,tags,reports,ns_per_report\n");
+    for (size_t i = 0; i < sizeof(subs) / sizeof(subs[0]); i++) {
+        uint64_t ns = run(names, subs[i], reports);
+
+        printf("%d,%d,%d,%" PRIu64 "\n", subs[i], NEU_BENCH_TAGS, reports,
+               ns / reports);
+    }
+
+    neu_tag_names_unref(names);
+    return 0;
+}
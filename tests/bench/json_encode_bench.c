@@ -0,0 +1,210 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Cost of encoding one group report as an MQTT upload payload.
+ *
+ * Compares the jansson tree built by neu_json_encode_with_mqtt with the
+ * streaming writer used by the MQTT plugin, for both upload formats and
+ * reports of 1k, 10k and 100k tags of mixed types. Every encoder runs about
+ * the same number of tags in total, the payload is freed after each report
+ * as publish does.
+ *
+ * usage: json_encode_bench [total tags per run]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/json_writer.h"
+#include "utils/log.h"
+#include "json/neu_json_fn.h"
+#include "json/neu_json_rw.h"
+
+#include "tag.h"
+#include "tag_values.h"
+
+zlog_category_t *neuron = NULL;
+
+typedef enum {
+    FORMAT_VALUES,
+    FORMAT_TAGS,
+} bench_format_e;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static neu_tag_values_t *make_values(int n_tag, neu_tag_names_t **names)
+{
+    UT_array *        tags   = NULL;
+    neu_tag_values_t *values = NULL;
+    char              name[NEU_TAG_NAME_LEN] = { 0 };
+
+    utarray_new(tags, neu_tag_get_icd());
+    for (int i = 0; i < n_tag; i++) {
+        neu_datatag_t tag = { 0 };
+
+        snprintf(name, sizeof(name), "tag%d", i);
+        tag.name        = name;
+        tag.address     = "1!400001";
+        tag.description = "";
+        utarray_push_back(tags, &tag);
+    }
+    *names = neu_tag_names_new(tags);
+    utarray_free(tags);
+
+    values = neu_tag_values_new("bench", "grp", *names);
+    for (int i = 0; i < n_tag; i++) {
+        neu_dvalue_t value = { 0 };
+
+        switch (i % 5) {
+        case 0:
+            value.type      = NEU_TYPE_INT32;
+            value.value.i32 = i * 7 - 1000;
+            break;
+        case 1:
+            value.type      = NEU_TYPE_FLOAT;
+            value.value.f32 = i * 0.25f + 0.1f;
+            break;
+        case 2:
+            value.type      = NEU_TYPE_DOUBLE;
+            value.precision = 3;
+            value.value.d64 = i * 1.0 / 3;
+            break;
+        case 3:
+            value.type          = NEU_TYPE_BOOL;
+            value.value.boolean = i & 8;
+            break;
+        default:
+            value.type = NEU_TYPE_STRING;
+            snprintf(value.value.str, sizeof(value.value.str), "state-%d", i);
+            break;
+        }
+        neu_tag_values_push(values, i, &value, NULL, 0);
+    }
+
+    return values;
+}
+
+static char *encode_jansson(neu_tag_values_t *values, bench_format_e format)
+{
+    char *                   str    = NULL;
+    neu_json_read_periodic_t header = { .group     = "grp",
+                                        .node      = "bench",
+                                        .timestamp = 1700000000000 };
+    neu_json_read_resp_t     json   = { 0 };
+
+    json.n_tag = neu_tag_values_size(values);
+    json.tags  = calloc(json.n_tag, sizeof(neu_json_read_resp_tag_t));
+    for (int i = 0; i < json.n_tag; i++) {
+        neu_tag_values_to_json(values, i, &json.tags[i]);
+    }
+
+    neu_json_encode_with_mqtt(&json,
+                              FORMAT_VALUES == format
+                                  ? neu_json_encode_read_resp1
+                                  : neu_json_encode_read_resp,
+                              &header, neu_json_encode_read_periodic_resp,
+                              &str);
+
+    for (int i = 0; i < json.n_tag; i++) {
+        free(json.tags[i].metas);
+    }
+    free(json.tags);
+    return str;
+}
+
+static void fill_tag(void *ctx, int index, neu_json_read_resp_tag_t *tag,
+                     neu_json_tag_meta_t *metas)
+{
+    neu_tag_values_fill_json((neu_tag_values_t *) ctx, index, tag, metas);
+}
+
+static char *encode_writer(neu_json_writer_t *w, neu_tag_values_t *values,
+                           bench_format_e format)
+{
+    int                      n_tag  = neu_tag_values_size(values);
+    neu_json_read_periodic_t header = { .group     = "grp",
+                                        .node      = "bench",
+                                        .timestamp = 1700000000000 };
+
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_write_read_periodic(w, &header);
+    if (FORMAT_VALUES == format) {
+        neu_json_write_read_resp1(w, n_tag, fill_tag, values);
+    } else {
+        neu_json_write_read_resp(w, n_tag, fill_tag, values);
+    }
+    neu_json_writer_object_end(w);
+
+    return neu_json_writer_detach(w);
+}
+
+int main(int argc, char *argv[])
+{
+    long              total     = argc > 1 ? atol(argv[1]) : 2000000;
+    const int         sizes[]   = { 1000, 10000, 100000 };
+    const char *      formats[] = { "values", "tags" };
+    neu_json_writer_t w         = { 0 };
+
+    neu_json_writer_init(&w, 0);
+
+    printf("tags,format,encoder,reports,ns_per_report,ns_per_tag,bytes\n");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        neu_tag_names_t * names   = NULL;
+        neu_tag_values_t *values  = make_values(sizes[s], &names);
+        int               reports = total / sizes[s] > 0 ? total / sizes[s] : 1;
+
+        for (int f = FORMAT_VALUES; f <= FORMAT_TAGS; f++) {
+            for (int writer = 0; writer <= 1; writer++) {
+                size_t   bytes = 0;
+                uint64_t start = now_ns();
+                uint64_t ns    = 0;
+
+                for (int r = 0; r < reports; r++) {
+                    char *str = writer ? encode_writer(&w, values, f)
+                                       : encode_jansson(values, f);
+
+                    bytes = str != NULL ? strlen(str) : 0;
+                    free(str);
+                }
+                ns = now_ns() - start;
+
+                printf("%d,%s,%s,%d,%" PRIu64 ",%" PRIu64 ",%zu\n", sizes[s],
+                       formats[f], writer ? "writer" : "jansson", reports,
+                       ns / reports, ns / reports / sizes[s], bytes);
+            }
+        }
+
+        neu_tag_values_unref(values);
+        neu_tag_names_unref(names);
+    }
+
+    neu_json_writer_fini(&w);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Trans data transport between two adapter threads: the abstract datagram
+ * socket used before, and the in-process ring with an eventfd wakeup.
+ *
+ * A producer thread sends messages carrying their send time, a consumer
+ * thread polls like an adapter event loop does and records the latency.
+ * Each transport runs saturated for the throughput, then paced at one
+ * message every 20us for the latency without queueing.
+ *
+ * usage: msg_transport_bench [messages]
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "adapter/msg_ring.h"
+#include "errcodes.h"
+#include "utils/log.h"
+
+#define BENCH_PORT 65001
+
+zlog_category_t *neuron = NULL;
+
+typedef struct {
+    const char *name;
+    int         n_msg;
+    int         sock;
+    bool        ring;
+    uint64_t    pace_ns;
+
+    struct sockaddr_un    addr;
+    adapter_msg_inbox_t * inbox;
+    adapter_msg_outbox_t *outbox;
+
+    uint64_t *latency;
+    uint32_t  wakeups;
+} bench_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void *producer_run(void *arg)
+{
+    bench_t *bench = (bench_t *) arg;
+    uint64_t start = now_ns();
+
+    for (int i = 0; i < bench->n_msg; i++) {
+        neu_reqresp_trans_data_t data = { 0 };
+        neu_msg_t *              msg  = NULL;
+        int                      ret  = 0;
+
+        if (bench->pace_ns > 0) {
+            uint64_t        at = start + i * bench->pace_ns;
+            struct timespec ts = {
+                .tv_sec  = at / 1000000000,
+                .tv_nsec = at % 1000000000,
+            };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+
+        msg = neu_msg_new(NEU_REQRESP_TRANS_DATA, (void *) (uintptr_t) now_ns(),
+                          &data);
+        do {
+            if (bench->ring) {
+                ret = adapter_msg_outbox_send(bench->outbox, BENCH_PORT, msg);
+            } else {
+                ret = neu_send_msg_to(bench->sock, &bench->addr, msg);
+            }
+            if (ret != 0) {
+                sched_yield();
+            }
+        } while (ret != 0);
+    }
+
+    return NULL;
+}
+
+static int consume(bench_t *bench, int fd, int received)
+{
+    neu_msg_t *msg = NULL;
+
+    bench->wakeups += 1;
+    if (bench->ring) {
+        adapter_msg_inbox_ack(bench->inbox);
+    }
+
+    while (received < bench->n_msg) {
+        if (bench->ring) {
+            msg = adapter_msg_inbox_pop(bench->inbox);
+        } else if (neu_recv_msg(fd, &msg) != 0) {
+            msg = NULL;
+        }
+        if (msg == NULL) {
+            break;
+        }
+
+        neu_reqresp_head_t *header = neu_msg_get_header(msg);
+        bench->latency[received++] = now_ns() - (uintptr_t) header->ctx;
+        neu_msg_free(msg);
+    }
+
+    return received;
+}
+
+static void run(bench_t *bench)
+{
+    int                epfd     = epoll_create1(0);
+    int                fd       = -1;
+    int                received = 0;
+    pthread_t          tid;
+    struct epoll_event event = { .events = EPOLLIN };
+    uint64_t           start = 0, elapsed = 0;
+
+    bench->latency = calloc(bench->n_msg, sizeof(uint64_t));
+    bench->wakeups = 0;
+
+    if (bench->ring) {
+        bench->inbox  = adapter_msg_inbox_new("bench", BENCH_PORT, 1024);
+        bench->outbox = adapter_msg_outbox_new("bench");
+        fd            = adapter_msg_inbox_fd(bench->inbox);
+    } else {
+        fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        bind(fd, (struct sockaddr *) &bench->addr, sizeof(bench->addr));
+    }
+    event.data.fd = fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event);
+
+    start = now_ns();
+    pthread_create(&tid, NULL, producer_run, bench);
+    while (received < bench->n_msg) {
+        if (epoll_wait(epfd, &event, 1, 1000) == 1) {
+            received = consume(bench, fd, received);
+        }
+    }
+    elapsed = now_ns() - start;
+    pthread_join(tid, NULL);
+
+    qsort(bench->latency, bench->n_msg, sizeof(uint64_t), cmp_u64);
+    printf("%s,%s,%d,%.0f,%" PRIu64 ",%" PRIu64 ",%" PRIu32 "\n",
+           bench->name, bench->pace_ns > 0 ? "paced" : "saturated",
+           bench->n_msg, bench->n_msg * 1e9 / elapsed,
+           bench->latency[bench->n_msg / 2],
+           bench->latency[bench->n_msg * 99 / 100], bench->wakeups);
+
+    if (bench->ring) {
+        adapter_msg_outbox_free(bench->outbox);
+        adapter_msg_inbox_free(bench->inbox);
+    } else {
+        close(fd);
+    }
+    close(epfd);
+    free(bench->latency);
+}
+
+int main(int argc, char *argv[])
+{
+    int     n_msg = argc > 1 ? atoi(argv[1]) : 1000000;
+    bench_t bench = { 0 };
+
+    bench.sock            = socket(AF_UNIX, SOCK_DGRAM, 0);
+    bench.addr.sun_family = AF_UNIX;
+    snprintf(bench.addr.sun_path, sizeof(bench.addr.sun_path),
+             "%cneuron-bench-%d", '\0', getpid());
+
+    printf("transport,load,messages,msgs_per_sec,p50_ns,p99_ns,wakeups\n");
+
+    for (int i = 0; i < 2; i++) {
+        bench.name = i == 0 ? "socket" : "ring";
+        bench.ring = i == 1;
+
+        bench.n_msg   = n_msg;
+        bench.pace_ns = 0;
+        run(&bench);
+
+        bench.n_msg   = n_msg / 10;
+        bench.pace_ns = 20000;
+        run(&bench);
+    }
+
+    close(bench.sock);
+    return 0;
+}
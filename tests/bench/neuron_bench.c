@@ -0,0 +1,1340 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * End to end throughput and latency of a whole neuron instance.
+ *
+ * For each point of the sweep over nodes, groups per node, tags per group and
+ * subscribers, a child process runs the manager in-process, configures Modbus
+ * TCP nodes reading the modbus simulator and MQTT apps publishing to a local
+ * MQTT sink through the REST API, then measures after a warm up:
+ *
+ *   - tag values read by the drivers per second (tag_reads_total)
+ *   - messages, tag values and bytes published per second
+ *   - latency percentiles from the report timestamp to the sink
+ *   - CPU of the instance, and per 1k configured tags
+ *   - RSS growth of the instance, and per 1k configured tags
+ *
+ * The simulator and the sink are separate processes, so only the instance is
+ * charged for CPU and memory. It uses the abstract manager socket, so no other
+ * neuron may run on the host. Run it from the build directory, it needs the
+ * config, plugins and simulator directories there.
+ *
+ * usage: ./tests/bench/neuron-bench [-n 1,4] [-g 1,10] [-t 100,1000] [-s 1,2]
+ *                                    [--json]
+ */
+
+#if defined(__GNUC__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <jansson.h>
+
+#include "argparse.h"
+#include "core/manager.h"
+#include "persist/persist.h"
+#include "utils/json_writer.h"
+#include "utils/log.h"
+#include "utils/time.h"
+
+#define BENCH_SWEEP_MAX 16
+#define BENCH_TAGS_PER_REQ 2000
+#define BENCH_MQTT_PACKET_MAX (64 * 1024 * 1024)
+#define BENCH_HTTP_TIMEOUT 60
+
+// globals the instance expects from main.c
+zlog_category_t *neuron            = NULL;
+bool             disable_jwt       = true;
+int              default_log_level = ZLOG_LEVEL_WARN;
+char             host_port[32]     = { 0 };
+char             g_status[32]      = { 0 };
+int64_t          global_timestamp  = 0;
+
+typedef struct {
+    int values[BENCH_SWEEP_MAX];
+    int n;
+} sweep_t;
+
+typedef struct {
+    sweep_t  nodes;
+    sweep_t  groups;
+    sweep_t  tags;
+    sweep_t  subscribers;
+    int      interval_ms;
+    int      warmup_s;
+    int      duration_s;
+    uint16_t http_port;
+    uint16_t modbus_port;
+    uint16_t mqtt_port;
+    bool     json;
+
+    const char *simulator;
+    char        workdir[64];
+
+    pid_t sim_pid;
+    pid_t sink_pid;
+    int   sink_req;  // write end of the sink control pipe
+    int   sink_resp; // read end of the sink reply pipe
+} bench_t;
+
+typedef struct {
+    int nodes;
+    int groups;
+    int tags;
+    int subscribers;
+} point_t;
+
+typedef struct {
+    uint64_t msgs;
+    uint64_t tags;
+    uint64_t bytes;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+    uint32_t max;
+} sink_stats_t;
+
+typedef struct {
+    int          rv;
+    double       seconds;
+    uint64_t     reads;
+    double       cpu_seconds;
+    uint64_t     rss;
+    uint64_t     rss_growth;
+    sink_stats_t sink;
+} point_result_t;
+
+static double now_s(void)
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parse_sweep(const char *s, sweep_t *sweep)
+{
+    char *end = NULL;
+
+    sweep->n = 0;
+    while (*s != '\0') {
+        long v = strtol(s, &end, 10);
+
+        if (end == s || v <= 0 || sweep->n == BENCH_SWEEP_MAX) {
+            return -1;
+        }
+        sweep->values[sweep->n++] = v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+    }
+
+    return sweep->n > 0 ? 0 : -1;
+}
+
+static int listen_local(uint16_t port)
+{
+    int                one  = 1;
+    int                fd   = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family      = AF_INET,
+        .sin_port        = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int connect_local(uint16_t port)
+{
+    int                fd   = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family      = AF_INET,
+        .sin_port        = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int write_all(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+static int read_all(int fd, void *data, size_t len)
+{
+    uint8_t *p = data;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/*
+ * MQTT sink
+ *
+ * A minimal MQTT 3.1.1 broker accepting every client and subscription and
+ * counting the values of the published reports. It runs in its own process
+ * and answers snapshot requests on a pipe.
+ */
+
+typedef struct {
+    int      fd;
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+} sink_conn_t;
+
+typedef struct {
+    uint64_t  msgs;
+    uint64_t  tags;
+    uint64_t  bytes;
+    uint32_t *latency;
+    size_t    n_latency;
+    size_t    cap_latency;
+} sink_t;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void sink_snapshot(sink_t *sink, sink_stats_t *stats)
+{
+    size_t n = sink->n_latency;
+
+    stats->msgs  = sink->msgs;
+    stats->tags  = sink->tags;
+    stats->bytes = sink->bytes;
+    if (n > 0) {
+        qsort(sink->latency, n, sizeof(uint32_t), cmp_u32);
+        stats->p50 = sink->latency[(n - 1) * 50 / 100];
+        stats->p90 = sink->latency[(n - 1) * 90 / 100];
+        stats->p99 = sink->latency[(n - 1) * 99 / 100];
+        stats->max = sink->latency[n - 1];
+    }
+}
+
+static void sink_reset(sink_t *sink)
+{
+    sink->msgs      = 0;
+    sink->tags      = 0;
+    sink->bytes     = 0;
+    sink->n_latency = 0;
+}
+
+static void sink_report(sink_t *sink, const uint8_t *payload, size_t len)
+{
+    json_t *root = json_loadb((const char *) payload, len, 0, NULL);
+    json_t *ts   = NULL;
+
+    sink->msgs += 1;
+    sink->bytes += len;
+    if (root == NULL) {
+        return;
+    }
+
+    // values format carries objects, tags format an array
+    sink->tags += json_object_size(json_object_get(root, "values")) +
+        json_object_size(json_object_get(root, "errors")) +
+        json_array_size(json_object_get(root, "tags"));
+
+    ts = json_object_get(root, "timestamp");
+    if (json_is_integer(ts)) {
+        int64_t latency = neu_time_ms() - json_integer_value(ts);
+
+        if (sink->n_latency == sink->cap_latency) {
+            size_t    cap = sink->cap_latency > 0 ? sink->cap_latency * 2
+                                                : 4096;
+            uint32_t *p   = realloc(sink->latency, cap * sizeof(uint32_t));
+
+            if (p != NULL) {
+                sink->latency     = p;
+                sink->cap_latency = cap;
+            }
+        }
+        if (sink->n_latency < sink->cap_latency) {
+            sink->latency[sink->n_latency++] = latency > 0 ? latency : 0;
+        }
+    }
+
+    json_decref(root);
+}
+
+// returns the packet length, 0 if incomplete, -1 if malformed
+static int64_t mqtt_packet_len(const uint8_t *p, size_t len, size_t *hdr_len)
+{
+    uint32_t remaining = 0;
+
+    for (size_t i = 1; i < 5; i++) {
+        if (i >= len) {
+            return 0;
+        }
+        remaining |= (uint32_t)(p[i] & 0x7f) << (7 * (i - 1));
+        if ((p[i] & 0x80) == 0) {
+            *hdr_len = i + 1;
+            if (remaining > BENCH_MQTT_PACKET_MAX) {
+                return -1;
+            }
+            return len >= i + 1 + remaining ? (int64_t)(i + 1 + remaining)
+                                            : 0;
+        }
+    }
+
+    return -1;
+}
+
+static int sink_packet(sink_t *sink, sink_conn_t *conn, const uint8_t *p,
+                       size_t hdr_len, size_t len)
+{
+    const uint8_t *body = p + hdr_len;
+    size_t         n    = len - hdr_len;
+    uint8_t        ack[8 + 256];
+
+    switch (p[0] >> 4) {
+    case 1: // CONNECT
+        ack[0] = 0x20;
+        ack[1] = 2;
+        ack[2] = 0;
+        ack[3] = 0;
+        return send(conn->fd, ack, 4, MSG_NOSIGNAL) == 4 ? 0 : -1;
+    case 3: { // PUBLISH
+        uint8_t qos   = (p[0] >> 1) & 0x3;
+        size_t  topic = 0;
+        size_t  off   = 0;
+
+        if (n < 2) {
+            return -1;
+        }
+        topic = (size_t) body[0] << 8 | body[1];
+        off   = 2 + topic + (qos > 0 ? 2 : 0);
+        if (off > n) {
+            return -1;
+        }
+        sink_report(sink, body + off, n - off);
+        if (qos > 0) {
+            ack[0] = qos == 1 ? 0x40 : 0x50;
+            ack[1] = 2;
+            ack[2] = body[2 + topic];
+            ack[3] = body[3 + topic];
+            return send(conn->fd, ack, 4, MSG_NOSIGNAL) == 4 ? 0 : -1;
+        }
+        return 0;
+    }
+    case 6: // PUBREL
+        ack[0] = 0x70;
+        ack[1] = 2;
+        ack[2] = n >= 2 ? body[0] : 0;
+        ack[3] = n >= 2 ? body[1] : 0;
+        return send(conn->fd, ack, 4, MSG_NOSIGNAL) == 4 ? 0 : -1;
+    case 8: { // SUBSCRIBE, every filter is granted QoS 0
+        size_t n_filter = 0;
+
+        for (size_t off = 2; off + 2 <= n;) {
+            off += 2 + ((size_t) body[off] << 8 | body[off + 1]) + 1;
+            n_filter += 1;
+        }
+        if (n < 2 || n_filter > 256 - 2) {
+            return -1;
+        }
+        ack[0] = 0x90;
+        ack[1] = 2 + n_filter;
+        ack[2] = body[0];
+        ack[3] = body[1];
+        memset(ack + 4, 0, n_filter);
+        return send(conn->fd, ack, 4 + n_filter, MSG_NOSIGNAL) ==
+                (ssize_t)(4 + n_filter)
+            ? 0
+            : -1;
+    }
+    case 10: // UNSUBSCRIBE
+        ack[0] = 0xb0;
+        ack[1] = 2;
+        ack[2] = n >= 2 ? body[0] : 0;
+        ack[3] = n >= 2 ? body[1] : 0;
+        return send(conn->fd, ack, 4, MSG_NOSIGNAL) == 4 ? 0 : -1;
+    case 12: // PINGREQ
+        ack[0] = 0xd0;
+        ack[1] = 0;
+        return send(conn->fd, ack, 2, MSG_NOSIGNAL) == 2 ? 0 : -1;
+    case 14: // DISCONNECT
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+static int sink_readable(sink_t *sink, sink_conn_t *conn)
+{
+    while (true) {
+        size_t  hdr_len = 0;
+        int64_t len     = 0;
+        ssize_t n       = 0;
+
+        if (conn->cap - conn->len < 4096) {
+            size_t   cap = conn->cap > 0 ? conn->cap * 2 : 65536;
+            uint8_t *buf = realloc(conn->buf, cap);
+
+            if (buf == NULL) {
+                return -1;
+            }
+            conn->buf = buf;
+            conn->cap = cap;
+        }
+
+        n = recv(conn->fd, conn->buf + conn->len, conn->cap - conn->len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        conn->len += n;
+
+        size_t off = 0;
+        while ((len = mqtt_packet_len(conn->buf + off, conn->len - off,
+                                      &hdr_len)) > 0) {
+            if (sink_packet(sink, conn, conn->buf + off, hdr_len, len) != 0) {
+                return -1;
+            }
+            off += len;
+        }
+        if (len < 0) {
+            return -1;
+        }
+        memmove(conn->buf, conn->buf + off, conn->len - off);
+        conn->len -= off;
+    }
+}
+
+static void sink_run(int listen_fd, int req_fd, int resp_fd)
+{
+    sink_t             sink = { 0 };
+    struct epoll_event events[64];
+    struct epoll_event ev   = { .events = EPOLLIN };
+    int                epfd = epoll_create1(0);
+
+    ev.data.ptr = &listen_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+    ev.data.ptr = &req_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, req_fd, &ev);
+
+    while (true) {
+        int n = epoll_wait(epfd, events, 64, -1);
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &listen_fd) {
+                int          fd   = accept(listen_fd, NULL, NULL);
+                int          one  = 1;
+                sink_conn_t *conn = NULL;
+
+                if (fd < 0 || NULL == (conn = calloc(1, sizeof(*conn)))) {
+                    if (fd >= 0) {
+                        close(fd);
+                    }
+                    continue;
+                }
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                conn->fd    = fd;
+                ev.data.ptr = conn;
+                epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+            } else if (events[i].data.ptr == &req_fd) {
+                sink_stats_t stats = { 0 };
+                char         cmd   = 0;
+
+                if (read_all(req_fd, &cmd, 1) != 0) {
+                    // the bench is gone
+                    _exit(0);
+                }
+                if (cmd == 's') {
+                    sink_snapshot(&sink, &stats);
+                }
+                sink_reset(&sink);
+                write_all(resp_fd, &stats, sizeof(stats));
+            } else {
+                sink_conn_t *conn = events[i].data.ptr;
+
+                if (sink_readable(&sink, conn) != 0) {
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+                    close(conn->fd);
+                    free(conn->buf);
+                    free(conn);
+                }
+            }
+        }
+    }
+}
+
+static int sink_request(bench_t *b, char cmd, sink_stats_t *stats)
+{
+    sink_stats_t s = { 0 };
+
+    if (write_all(b->sink_req, &cmd, 1) != 0 ||
+        read_all(b->sink_resp, &s, sizeof(s)) != 0) {
+        return -1;
+    }
+    if (stats != NULL) {
+        *stats = s;
+    }
+
+    return 0;
+}
+
+static int start_sink(bench_t *b)
+{
+    int req[2]    = { -1, -1 };
+    int resp[2]   = { -1, -1 };
+    int listen_fd = listen_local(b->mqtt_port);
+
+    if (listen_fd < 0 || pipe(req) != 0 || pipe(resp) != 0) {
+        fprintf(stderr, "mqtt sink on port %u fail: %s\n", b->mqtt_port,
+                strerror(errno));
+        return -1;
+    }
+
+    b->sink_pid = fork();
+    if (b->sink_pid < 0) {
+        return -1;
+    }
+    if (b->sink_pid == 0) {
+        close(req[1]);
+        close(resp[0]);
+        sink_run(listen_fd, req[0], resp[1]);
+        _exit(0);
+    }
+
+    close(listen_fd);
+    close(req[0]);
+    close(resp[1]);
+    b->sink_req  = req[1];
+    b->sink_resp = resp[0];
+    return 0;
+}
+
+static int start_simulator(bench_t *b)
+{
+    char port[8] = { 0 };
+
+    snprintf(port, sizeof(port), "%u", b->modbus_port);
+    b->sim_pid = fork();
+    if (b->sim_pid < 0) {
+        return -1;
+    }
+    if (b->sim_pid == 0) {
+        execl(b->simulator, b->simulator, "-n", "-l", "0", "tcp", port,
+              "ip_v4", (char *) NULL);
+        fprintf(stderr, "exec %s fail: %s\n", b->simulator, strerror(errno));
+        _exit(1);
+    }
+
+    // wait until the simulator listens
+    for (int i = 0; i < 100; i++) {
+        int fd = connect_local(b->modbus_port);
+
+        if (fd >= 0) {
+            close(fd);
+            return 0;
+        }
+        usleep(50 * 1000);
+    }
+
+    fprintf(stderr, "modbus simulator %s not listening on port %u\n",
+            b->simulator, b->modbus_port);
+    return -1;
+}
+
+/*
+ * instance side
+ */
+
+// blocking HTTP/1.1 request to the REST API, returns the status code
+static int http_call(bench_t *b, const char *method, const char *path,
+                     const char *body, char **resp_body)
+{
+    struct timeval tv      = { .tv_sec = BENCH_HTTP_TIMEOUT };
+    size_t         len     = body != NULL ? strlen(body) : 0;
+    char           hdr[512] = { 0 };
+    char *         buf     = NULL;
+    size_t         n       = 0;
+    size_t         cap     = 0;
+    char *         end     = NULL;
+    long           content = -1;
+    int            status  = -1;
+    int            fd      = connect_local(b->http_port);
+
+    if (fd < 0) {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    snprintf(hdr, sizeof(hdr),
+             "%s %s HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+             "Content-Type: application/json\r\nContent-Length: %zu\r\n"
+             "Connection: close\r\n\r\n",
+             method, path, len);
+    if (write_all(fd, hdr, strlen(hdr)) != 0 ||
+        (len > 0 && write_all(fd, body, len) != 0)) {
+        close(fd);
+        return -1;
+    }
+
+    while (end == NULL || content < 0 ||
+           n < (size_t)(end - buf) + 4 + content) {
+        ssize_t r = 0;
+
+        if (cap - n < 4096) {
+            char *p = realloc(buf, cap > 0 ? cap * 2 : 8192);
+
+            if (p == NULL) {
+                break;
+            }
+            if (end != NULL) {
+                end = p + (end - buf);
+            }
+            buf = p;
+            cap = cap > 0 ? cap * 2 : 8192;
+        }
+
+        r = recv(fd, buf + n, cap - n - 1, 0);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            break;
+        }
+        n += r;
+        buf[n] = '\0';
+
+        if (end == NULL && (end = strstr(buf, "\r\n\r\n")) != NULL) {
+            char *cl = strcasestr(buf, "\r\nContent-Length:");
+
+            sscanf(buf, "HTTP/1.%*d %d", &status);
+            content = cl != NULL && cl < end ? atol(cl + 17) : 0;
+        }
+    }
+    close(fd);
+
+    if (resp_body != NULL && end != NULL) {
+        *resp_body = strdup(end + 4);
+    }
+    free(buf);
+
+    return status;
+}
+
+static int http_post(bench_t *b, const char *path, neu_json_writer_t *w)
+{
+    const char *body   = neu_json_writer_str(w);
+    int         status = body != NULL ? http_call(b, "POST", path, body, NULL)
+                                      : -1;
+
+    if (status != 200) {
+        fprintf(stderr, "POST %s: %d\n", path, status);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int add_node(bench_t *b, neu_json_writer_t *w, const char *name,
+                    const char *plugin)
+{
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "name");
+    neu_json_writer_string(w, name);
+    neu_json_writer_key(w, "plugin");
+    neu_json_writer_string(w, plugin);
+    neu_json_writer_object_end(w);
+
+    return http_post(b, "/api/v2/node", w);
+}
+
+static int setup_driver(bench_t *b, const point_t *p, neu_json_writer_t *w,
+                        int node)
+{
+    char name[NEU_NODE_NAME_LEN] = { 0 };
+
+    snprintf(name, sizeof(name), "bench-modbus-%d", node);
+    if (add_node(b, w, name, "Modbus TCP") != 0) {
+        return -1;
+    }
+
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node");
+    neu_json_writer_string(w, name);
+    neu_json_writer_key(w, "params");
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "connection_mode");
+    neu_json_writer_int(w, 0);
+    neu_json_writer_key(w, "interval");
+    neu_json_writer_int(w, 0);
+    neu_json_writer_key(w, "host");
+    neu_json_writer_string(w, "127.0.0.1");
+    neu_json_writer_key(w, "port");
+    neu_json_writer_int(w, b->modbus_port);
+    neu_json_writer_key(w, "timeout");
+    neu_json_writer_int(w, 3000);
+    neu_json_writer_key(w, "max_retries");
+    neu_json_writer_int(w, 0);
+    neu_json_writer_key(w, "retry_interval");
+    neu_json_writer_int(w, 1);
+    neu_json_writer_object_end(w);
+    neu_json_writer_object_end(w);
+    if (http_post(b, "/api/v2/node/setting", w) != 0) {
+        return -1;
+    }
+
+    for (int g = 0; g < p->groups; g++) {
+        for (int t = 0; t < p->tags; t += BENCH_TAGS_PER_REQ) {
+            char buf[32] = { 0 };
+
+            neu_json_writer_reset(w);
+            neu_json_writer_object_begin(w);
+            neu_json_writer_key(w, "node");
+            neu_json_writer_string(w, name);
+            neu_json_writer_key(w, "groups");
+            neu_json_writer_array_begin(w);
+            neu_json_writer_object_begin(w);
+            snprintf(buf, sizeof(buf), "group-%d", g);
+            neu_json_writer_key(w, "group");
+            neu_json_writer_string(w, buf);
+            neu_json_writer_key(w, "interval");
+            neu_json_writer_int(w, b->interval_ms);
+            neu_json_writer_key(w, "tags");
+            neu_json_writer_array_begin(w);
+            for (int i = t; i < p->tags && i < t + BENCH_TAGS_PER_REQ; i++) {
+                neu_json_writer_object_begin(w);
+                snprintf(buf, sizeof(buf), "tag-%d", i);
+                neu_json_writer_key(w, "name");
+                neu_json_writer_string(w, buf);
+                snprintf(buf, sizeof(buf), "1!4%05d", i % 65536 + 1);
+                neu_json_writer_key(w, "address");
+                neu_json_writer_string(w, buf);
+                neu_json_writer_key(w, "attribute");
+                neu_json_writer_int(w, NEU_ATTRIBUTE_READ);
+                neu_json_writer_key(w, "type");
+                neu_json_writer_int(w, NEU_TYPE_INT16);
+                neu_json_writer_object_end(w);
+            }
+            neu_json_writer_array_end(w);
+            neu_json_writer_object_end(w);
+            neu_json_writer_array_end(w);
+            neu_json_writer_object_end(w);
+            if (http_post(b, "/api/v2/gtags", w) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int setup_app(bench_t *b, const point_t *p, neu_json_writer_t *w,
+                     int sub)
+{
+    char name[NEU_NODE_NAME_LEN] = { 0 };
+    char topic[128]              = { 0 };
+
+    snprintf(name, sizeof(name), "bench-mqtt-%d", sub);
+    if (add_node(b, w, name, "MQTT") != 0) {
+        return -1;
+    }
+
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "node");
+    neu_json_writer_string(w, name);
+    neu_json_writer_key(w, "params");
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "client-id");
+    neu_json_writer_string(w, name);
+    neu_json_writer_key(w, "qos");
+    neu_json_writer_int(w, 0);
+    neu_json_writer_key(w, "format");
+    neu_json_writer_int(w, 0);
+    snprintf(topic, sizeof(topic), "/neuron/%s/write/req", name);
+    neu_json_writer_key(w, "write-req-topic");
+    neu_json_writer_string(w, topic);
+    snprintf(topic, sizeof(topic), "/neuron/%s/write/resp", name);
+    neu_json_writer_key(w, "write-resp-topic");
+    neu_json_writer_string(w, topic);
+    neu_json_writer_key(w, "offline-cache");
+    neu_json_writer_bool(w, false);
+    neu_json_writer_key(w, "cache-sync-interval");
+    neu_json_writer_int(w, 100);
+    neu_json_writer_key(w, "host");
+    neu_json_writer_string(w, "127.0.0.1");
+    neu_json_writer_key(w, "port");
+    neu_json_writer_int(w, b->mqtt_port);
+    neu_json_writer_key(w, "username");
+    neu_json_writer_string(w, "");
+    neu_json_writer_key(w, "password");
+    neu_json_writer_string(w, "");
+    neu_json_writer_key(w, "ssl");
+    neu_json_writer_bool(w, false);
+    neu_json_writer_object_end(w);
+    neu_json_writer_object_end(w);
+    if (http_post(b, "/api/v2/node/setting", w) != 0) {
+        return -1;
+    }
+
+    snprintf(topic, sizeof(topic), "/neuron/%s/upload", name);
+    for (int n = 0; n < p->nodes; n++) {
+        for (int g = 0; g < p->groups; g++) {
+            char buf[NEU_NODE_NAME_LEN] = { 0 };
+
+            neu_json_writer_reset(w);
+            neu_json_writer_object_begin(w);
+            neu_json_writer_key(w, "app");
+            neu_json_writer_string(w, name);
+            snprintf(buf, sizeof(buf), "bench-modbus-%d", n);
+            neu_json_writer_key(w, "driver");
+            neu_json_writer_string(w, buf);
+            snprintf(buf, sizeof(buf), "group-%d", g);
+            neu_json_writer_key(w, "group");
+            neu_json_writer_string(w, buf);
+            neu_json_writer_key(w, "params");
+            neu_json_writer_object_begin(w);
+            neu_json_writer_key(w, "topic");
+            neu_json_writer_string(w, topic);
+            neu_json_writer_object_end(w);
+            neu_json_writer_object_end(w);
+            if (http_post(b, "/api/v2/subscribe", w) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// sum of tag_reads_total of every driver
+static int scrape_reads(bench_t *b, uint64_t *reads)
+{
+    char *body   = NULL;
+    int   status = http_call(b, "GET", "/api/v2/metrics?category=driver",
+                           NULL, &body);
+
+    *reads = 0;
+    if (status != 200 || body == NULL) {
+        free(body);
+        return -1;
+    }
+
+    for (char *line = body; line != NULL && *line != '\0';) {
+        char *next = strchr(line, '\n');
+
+        if (strncmp(line, NEU_METRIC_TAG_READS_TOTAL "{",
+                    strlen(NEU_METRIC_TAG_READS_TOTAL "{")) == 0) {
+            char *v = strchr(line, ' ');
+
+            if (v != NULL) {
+                *reads += strtoull(v + 1, NULL, 10);
+            }
+        }
+        line = next != NULL ? next + 1 : NULL;
+    }
+    free(body);
+
+    return 0;
+}
+
+static uint64_t rss_bytes(void)
+{
+    unsigned long size = 0, resident = 0;
+    FILE *        fp   = fopen("/proc/self/statm", "r");
+
+    if (fp == NULL) {
+        return 0;
+    }
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+
+    return (uint64_t) resident * sysconf(_SC_PAGESIZE);
+}
+
+static double cpu_seconds(void)
+{
+    struct rusage ru = { 0 };
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+        ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static int run_point(bench_t *b, const point_t *p, point_result_t *r)
+{
+    neu_json_writer_t w     = { 0 };
+    uint64_t          rss0  = 0;
+    uint64_t          reads = 0;
+    double            cpu   = 0;
+    double            start = 0;
+
+    if (chdir(b->workdir) != 0) {
+        return -1;
+    }
+    unlink("persistence/sqlite.db");
+    unlink("persistence/plugins.json");
+
+    zlog_init("./config/zlog.conf");
+    neuron = zlog_get_category("neuron");
+    zlog_level_switch(neuron, default_log_level);
+    snprintf(host_port, sizeof(host_port), "http://127.0.0.1:%u",
+             b->http_port);
+    g_config_dir     = "config";
+    g_plugin_dir     = "plugins";
+    global_timestamp = neu_time_ms();
+
+    if (neu_persister_create(g_config_dir) != 0 ||
+        neu_manager_create() == NULL) {
+        return -1;
+    }
+
+    rss0 = rss_bytes();
+    neu_json_writer_init(&w, 0);
+    for (int n = 0; n < p->nodes; n++) {
+        if (setup_driver(b, p, &w, n) != 0) {
+            return -1;
+        }
+    }
+    for (int s = 0; s < p->subscribers; s++) {
+        if (setup_app(b, p, &w, s) != 0) {
+            return -1;
+        }
+    }
+    neu_json_writer_fini(&w);
+
+    sleep(b->warmup_s);
+
+    if (sink_request(b, 'r', NULL) != 0 || scrape_reads(b, &reads) != 0) {
+        return -1;
+    }
+    cpu   = cpu_seconds();
+    start = now_s();
+
+    sleep(b->duration_s);
+
+    if (sink_request(b, 's', &r->sink) != 0 ||
+        scrape_reads(b, &r->reads) != 0) {
+        return -1;
+    }
+    r->cpu_seconds = cpu_seconds() - cpu;
+    r->seconds     = now_s() - start;
+    r->reads -= reads;
+    r->rss        = rss_bytes();
+    r->rss_growth = r->rss > rss0 ? r->rss - rss0 : 0;
+
+    return 0;
+}
+
+// runs a point in a fresh process, the instance is not torn down
+static int measure(bench_t *b, const point_t *p, point_result_t *r)
+{
+    int   fds[2] = { -1, -1 };
+    pid_t pid    = 0;
+    int   status = 0;
+
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+
+    pid = fork();
+    if (pid == 0) {
+        point_result_t result = { 0 };
+
+        close(fds[0]);
+        result.rv = run_point(b, p, &result);
+        write_all(fds[1], &result, sizeof(result));
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (pid < 0 || read_all(fds[0], r, sizeof(*r)) != 0) {
+        r->rv = -1;
+    }
+    close(fds[0]);
+
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+    }
+
+    return r->rv;
+}
+
+static void print_result(bench_t *b, const point_t *p,
+                         const point_result_t *r, neu_json_writer_t *w)
+{
+    double total = (double) p->nodes * p->groups * p->tags;
+    double secs  = r->seconds > 0 ? r->seconds : 1;
+    double cpu   = r->cpu_seconds / secs * 100;
+
+    if (!b->json) {
+        printf("%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%u,%u,%u,%u,%.2f,%.3f,"
+               "%" PRIu64 ",%.0f\n",
+               p->nodes, p->groups, p->tags, p->subscribers, total,
+               r->reads / secs, r->sink.msgs / secs, r->sink.tags / secs,
+               r->sink.bytes / secs, r->sink.p50, r->sink.p90, r->sink.p99,
+               r->sink.max, cpu, cpu / (total / 1000), r->rss,
+               r->rss_growth / (total / 1000));
+        fflush(stdout);
+        return;
+    }
+
+    neu_json_writer_reset(w);
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "nodes");
+    neu_json_writer_int(w, p->nodes);
+    neu_json_writer_key(w, "groups");
+    neu_json_writer_int(w, p->groups);
+    neu_json_writer_key(w, "tags");
+    neu_json_writer_int(w, p->tags);
+    neu_json_writer_key(w, "subscribers");
+    neu_json_writer_int(w, p->subscribers);
+    neu_json_writer_key(w, "total_tags");
+    neu_json_writer_int(w, (int64_t) total);
+    neu_json_writer_key(w, "interval_ms");
+    neu_json_writer_int(w, b->interval_ms);
+    neu_json_writer_key(w, "seconds");
+    neu_json_writer_real(w, secs, 3);
+    neu_json_writer_key(w, "read_tags_per_sec");
+    neu_json_writer_real(w, r->reads / secs, 1);
+    neu_json_writer_key(w, "publish_msgs_per_sec");
+    neu_json_writer_real(w, r->sink.msgs / secs, 1);
+    neu_json_writer_key(w, "publish_tags_per_sec");
+    neu_json_writer_real(w, r->sink.tags / secs, 1);
+    neu_json_writer_key(w, "publish_bytes_per_sec");
+    neu_json_writer_real(w, r->sink.bytes / secs, 1);
+    neu_json_writer_key(w, "latency_ms");
+    neu_json_writer_object_begin(w);
+    neu_json_writer_key(w, "p50");
+    neu_json_writer_int(w, r->sink.p50);
+    neu_json_writer_key(w, "p90");
+    neu_json_writer_int(w, r->sink.p90);
+    neu_json_writer_key(w, "p99");
+    neu_json_writer_int(w, r->sink.p99);
+    neu_json_writer_key(w, "max");
+    neu_json_writer_int(w, r->sink.max);
+    neu_json_writer_object_end(w);
+    neu_json_writer_key(w, "cpu_percent");
+    neu_json_writer_real(w, cpu, 2);
+    neu_json_writer_key(w, "cpu_percent_per_1k_tags");
+    neu_json_writer_real(w, cpu / (total / 1000), 3);
+    neu_json_writer_key(w, "rss_bytes");
+    neu_json_writer_int(w, r->rss);
+    neu_json_writer_key(w, "rss_bytes_per_1k_tags");
+    neu_json_writer_real(w, r->rss_growth / (total / 1000), 0);
+    neu_json_writer_object_end(w);
+
+    printf("%s\n", neu_json_writer_str(w));
+    fflush(stdout);
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag,
+                        struct FTW *ftw)
+{
+    (void) sb;
+    (void) flag;
+    (void) ftw;
+
+    return remove(path);
+}
+
+static int make_workdir(bench_t *b)
+{
+    char cwd[256]  = { 0 };
+    char path[512] = { 0 };
+
+    snprintf(b->workdir, sizeof(b->workdir), "neuron-bench-XXXXXX");
+    if (getcwd(cwd, sizeof(cwd)) == NULL || mkdtemp(b->workdir) == NULL) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/config", cwd);
+    if (chdir(b->workdir) != 0) {
+        return -1;
+    }
+    if (symlink(path, "config") != 0) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/plugins", cwd);
+    if (symlink(path, "plugins") != 0 || mkdir("persistence", 0755) != 0 ||
+        mkdir("logs", 0755) != 0) {
+        return -1;
+    }
+
+    return chdir(cwd);
+}
+
+static inline void usage(const char *prog)
+{
+    // clang-format off
+    const char *text =
+    "USAGE:\n"
+    "    %s [OPTIONS]\n\n"
+    "OPTIONS:\n"
+    "    -n, --nodes LIST        Modbus TCP nodes (default 1)\n"
+    "    -g, --groups LIST       groups per node (default 1)\n"
+    "    -t, --tags LIST         tags per group (default 1000)\n"
+    "    -s, --subscribers LIST  MQTT apps subscribing all groups (default 1)\n"
+    "    -i, --interval MS       group interval (default 1000)\n"
+    "    -w, --warmup S          seconds before measuring (default 3)\n"
+    "    -d, --duration S        seconds measured (default 10)\n"
+    "    -S, --simulator PATH    modbus simulator\n"
+    "                            (default ./simulator/modbus_simulator)\n"
+    "    -p, --http-port PORT    REST API port (default 7000)\n"
+    "    -M, --modbus-port PORT  simulator port (default 60502)\n"
+    "    -Q, --mqtt-port PORT    MQTT sink port (default 61883)\n"
+    "    -j, --json              one JSON object per point instead of CSV\n"
+    "    -h, --help              show this help message\n"
+    "\n"
+    "LIST is a comma separated list of values, every combination is run.\n";
+    // clang-format on
+
+    fprintf(stderr, text, prog);
+}
+
+int main(int argc, char *argv[])
+{
+    bench_t b = {
+        .nodes       = { { 1 }, 1 },
+        .groups      = { { 1 }, 1 },
+        .tags        = { { 1000 }, 1 },
+        .subscribers = { { 1 }, 1 },
+        .interval_ms = 1000,
+        .warmup_s    = 3,
+        .duration_s  = 10,
+        .http_port   = 7000,
+        .modbus_port = 60502,
+        .mqtt_port   = 61883,
+        .simulator   = "./simulator/modbus_simulator",
+    };
+    neu_json_writer_t w  = { 0 };
+    int               rv = 0;
+
+    struct option long_options[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "nodes", required_argument, NULL, 'n' },
+        { "groups", required_argument, NULL, 'g' },
+        { "tags", required_argument, NULL, 't' },
+        { "subscribers", required_argument, NULL, 's' },
+        { "interval", required_argument, NULL, 'i' },
+        { "warmup", required_argument, NULL, 'w' },
+        { "duration", required_argument, NULL, 'd' },
+        { "simulator", required_argument, NULL, 'S' },
+        { "http-port", required_argument, NULL, 'p' },
+        { "modbus-port", required_argument, NULL, 'M' },
+        { "mqtt-port", required_argument, NULL, 'Q' },
+        { "json", no_argument, NULL, 'j' },
+        { NULL, 0, NULL, 0 },
+    };
+
+    int c            = 0;
+    int option_index = 0;
+
+    while ((c = getopt_long(argc, argv, "hn:g:t:s:i:w:d:S:p:M:Q:j",
+                            long_options, &option_index)) != -1) {
+        switch (c) {
+        case 'n':
+            rv = parse_sweep(optarg, &b.nodes);
+            break;
+        case 'g':
+            rv = parse_sweep(optarg, &b.groups);
+            break;
+        case 't':
+            rv = parse_sweep(optarg, &b.tags);
+            break;
+        case 's':
+            rv = parse_sweep(optarg, &b.subscribers);
+            break;
+        case 'i':
+            b.interval_ms = atoi(optarg);
+            break;
+        case 'w':
+            b.warmup_s = atoi(optarg);
+            break;
+        case 'd':
+            b.duration_s = atoi(optarg);
+            break;
+        case 'S':
+            b.simulator = optarg;
+            break;
+        case 'p':
+            b.http_port = atoi(optarg);
+            break;
+        case 'M':
+            b.modbus_port = atoi(optarg);
+            break;
+        case 'Q':
+            b.mqtt_port = atoi(optarg);
+            break;
+        case 'j':
+            b.json = true;
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+        if (rv != 0) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (b.interval_ms <= 0 || b.duration_s <= 0 || b.warmup_s < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    if (make_workdir(&b) != 0 || start_sink(&b) != 0 ||
+        start_simulator(&b) != 0) {
+        fprintf(stderr, "bench setup fail: %s\n", strerror(errno));
+        rv = 1;
+        goto end;
+    }
+
+    if (!b.json) {
+        printf("nodes,groups,tags,subscribers,total_tags,read_tags_per_sec,"
+               "publish_msgs_per_sec,publish_tags_per_sec,"
+               "publish_bytes_per_sec,latency_p50_ms,latency_p90_ms,"
+               "latency_p99_ms,latency_max_ms,cpu_percent,"
+               "cpu_percent_per_1k_tags,rss_bytes,rss_bytes_per_1k_tags\n");
+    }
+
+    neu_json_writer_init(&w, 0);
+    for (int n = 0; n < b.nodes.n; n++) {
+        for (int g = 0; g < b.groups.n; g++) {
+            for (int t = 0; t < b.tags.n; t++) {
+                for (int s = 0; s < b.subscribers.n; s++) {
+                    point_t        p = { b.nodes.values[n], b.groups.values[g],
+                                  b.tags.values[t], b.subscribers.values[s] };
+                    point_result_t r = { 0 };
+
+                    if (measure(&b, &p, &r) != 0) {
+                        fprintf(stderr,
+                                "point nodes %d groups %d tags %d "
+                                "subscribers %d fail\n",
+                                p.nodes, p.groups, p.tags, p.subscribers);
+                        rv = 1;
+                        continue;
+                    }
+                    print_result(&b, &p, &r, &w);
+                }
+            }
+        }
+    }
+    neu_json_writer_fini(&w);
+
+end:
+    if (b.sim_pid > 0) {
+        kill(b.sim_pid, SIGTERM);
+        waitpid(b.sim_pid, NULL, 0);
+    }
+    if (b.sink_pid > 0) {
+        kill(b.sink_pid, SIGTERM);
+        waitpid(b.sink_pid, NULL, 0);
+    }
+    if (b.workdir[0] != '\0') {
+        nftw(b.workdir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    return rv;
+}
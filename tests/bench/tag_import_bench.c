@@ -0,0 +1,277 @@
+/**
+ * NEURON IIoT System for Industry 4.0
+ * Copyright (C) 2020-2022 EMQ Technologies Co., Ltd All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+/*
+ * Cost of importing a large tag list into one group.
+ *
+ * For 10k, 100k and 500k tags: parsing a CSV and a JSON body with the
+ * streaming import parser, adding the tags to a group at once against one
+ * by one, and persisting them in one SQLite transaction against one
+ * statement per tag. The one by one persistence is only run up to
+ * --baseline tags as it takes minutes beyond.
+ *
+ * The database is created in a temporary directory from the schemas in
+ * --schema, the build directory copies them to config/.
+ *
+ * usage: tag_import_bench [--schema dir] [--baseline n] [sizes...]
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "base/group.h"
+#include "parser/neu_tag_import.h"
+#include "persist/persist.h"
+#include "utils/log.h"
+
+#include "define.h"
+#include "errcodes.h"
+#include "tag.h"
+
+zlog_category_t *neuron = NULL;
+
+#define CHUNK_SIZE (64 * 1024)
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts = { 0 };
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(uint32_t n_tag, const char *stage, const char *path,
+                   uint64_t ns)
+{
+    printf("%" PRIu32 ",%s,%s,%.3f,%.0f\n", n_tag, stage, path, ns / 1e6,
+           ns > 0 ? n_tag * 1e9 / ns : 0);
+    fflush(stdout);
+}
+
+static char *make_body(neu_tag_import_format_e format, uint32_t n_tag,
+                       size_t *len)
+{
+    size_t cap = 128 + (size_t) n_tag * 160;
+    char * buf = malloc(cap);
+    size_t off = 0;
+
+    if (NEU_TAG_IMPORT_CSV == format) {
+        off += snprintf(buf + off, cap - off,
+                        "name,address,attribute,type,precision,description\n");
+    } else {
+        buf[off++] = '[';
+    }
+
+    for (uint32_t i = 0; i < n_tag; i++) {
+        if (NEU_TAG_IMPORT_CSV == format) {
+            off += snprintf(buf + off, cap - off,
+                            "tag%" PRIu32 ",1!4%05" PRIu32 ",3,%d,0,"
+                            "\"imported, %" PRIu32 "\"\n",
+                            i, i % 65536, 3 + i % 10, i);
+        } else {
+            off += snprintf(buf + off, cap - off,
+                            "%s{\"name\":\"tag%" PRIu32
+                            "\",\"address\":\"1!4%05" PRIu32
+                            "\",\"attribute\":3,\"type\":%d,\"precision\":0,"
+                            "\"description\":\"imported, %" PRIu32 "\"}",
+                            i > 0 ? "," : "", i, i % 65536, 3 + i % 10, i);
+        }
+    }
+
+    if (NEU_TAG_IMPORT_JSON == format) {
+        buf[off++] = ']';
+    }
+    buf[off] = '\0';
+
+    *len = off;
+    return buf;
+}
+
+static neu_datatag_t *parse(neu_tag_import_format_e format, uint32_t n_tag,
+                            uint32_t *n_parsed)
+{
+    size_t            len  = 0;
+    char *            body = make_body(format, n_tag, &len);
+    neu_tag_import_t *imp  = neu_tag_import_new(format);
+    neu_datatag_t *   tags = NULL;
+    uint64_t          ns   = now_ns();
+    int               rv   = 0;
+
+    // in chunks as read from a socket
+    for (size_t off = 0; 0 == rv && off < len; off += CHUNK_SIZE) {
+        size_t n = len - off < CHUNK_SIZE ? len - off : CHUNK_SIZE;
+        rv       = neu_tag_import_feed(imp, body + off, n);
+    }
+    if (0 == rv) {
+        rv = neu_tag_import_finish(imp);
+    }
+    tags = neu_tag_import_take(imp, n_parsed);
+    ns   = now_ns() - ns;
+
+    if (0 != rv || *n_parsed != n_tag) {
+        fprintf(stderr, "parse fail at tag %" PRIu32 "\n",
+                neu_tag_import_count(imp));
+        exit(1);
+    }
+
+    report(n_tag, "parse", NEU_TAG_IMPORT_CSV == format ? "csv" : "json", ns);
+
+    neu_tag_import_free(imp);
+    free(body);
+    return tags;
+}
+
+static void free_tags(neu_datatag_t *tags, uint32_t n_tag)
+{
+    for (uint32_t i = 0; i < n_tag; i++) {
+        neu_tag_fini(&tags[i]);
+    }
+    free(tags);
+}
+
+static void add_to_group(neu_datatag_t *tags, uint32_t n_tag)
+{
+    neu_group_t *group = neu_group_new("bench", 1000);
+    uint32_t     index = 0;
+    uint64_t     ns    = 0;
+
+    // untimed, so that neither path pays for growing the heap
+    neu_group_add_tags(group, tags, n_tag, &index);
+    neu_group_destroy(group);
+
+    group = neu_group_new("bench", 1000);
+    ns    = now_ns();
+    if (0 != neu_group_add_tags(group, tags, n_tag, &index)) {
+        fprintf(stderr, "group add fail at tag %" PRIu32 "\n", index);
+        exit(1);
+    }
+    report(n_tag, "group", "bulk", now_ns() - ns);
+    neu_group_destroy(group);
+
+    group = neu_group_new("bench", 1000);
+    ns    = now_ns();
+    for (uint32_t i = 0; i < n_tag; i++) {
+        neu_group_add_tag(group, &tags[i]);
+    }
+    report(n_tag, "group", "one_by_one", now_ns() - ns);
+    neu_group_destroy(group);
+}
+
+static void persist(neu_datatag_t *tags, uint32_t n_tag, uint32_t baseline)
+{
+    char                     name[64] = { 0 };
+    neu_persist_group_info_t info     = { .interval = 1000, .name = name };
+    uint64_t                 ns       = 0;
+
+    snprintf(name, sizeof(name), "bulk-%" PRIu32, n_tag);
+    neu_persister_store_group("bench", &info);
+    ns = now_ns();
+    if (0 != neu_persister_store_tags("bench", name, tags, n_tag)) {
+        fprintf(stderr, "store tags fail\n");
+        exit(1);
+    }
+    report(n_tag, "persist", "transaction", now_ns() - ns);
+
+    if (n_tag > baseline) {
+        return;
+    }
+
+    snprintf(name, sizeof(name), "one-%" PRIu32, n_tag);
+    neu_persister_store_group("bench", &info);
+    ns = now_ns();
+    for (uint32_t i = 0; i < n_tag; i++) {
+        neu_persister_store_tag("bench", name, &tags[i]);
+    }
+    report(n_tag, "persist", "one_by_one", now_ns() - ns);
+}
+
+int main(int argc, char *argv[])
+{
+    char                    schema[PATH_MAX] = { 0 };
+    char                    dir[]            = "/tmp/tag-import-bench-XXXXXX";
+    const char *            schema_arg       = "config";
+    uint32_t                baseline         = 10000;
+    uint32_t                sizes[16]        = { 0 };
+    int                     n_size           = 0;
+    neu_persist_node_info_t node             = {
+        .name        = "bench",
+        .type        = NEU_NA_TYPE_DRIVER,
+        .plugin_name = "Modbus TCP",
+        .state       = NEU_NODE_RUNNING_STATE_INIT,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "--schema") && i + 1 < argc) {
+            schema_arg = argv[++i];
+        } else if (0 == strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baseline = strtoul(argv[++i], NULL, 10);
+        } else if (n_size < 16) {
+            sizes[n_size++] = strtoul(argv[i], NULL, 10);
+        }
+    }
+
+    if (0 == n_size) {
+        sizes[n_size++] = 10000;
+        sizes[n_size++] = 100000;
+        sizes[n_size++] = 500000;
+    }
+
+    // the persister takes a schema directory relative to the working one
+    if (NULL == realpath(schema_arg, schema) || NULL == mkdtemp(dir) ||
+        0 != chdir(dir) || 0 != mkdir("persistence", 0755) ||
+        0 != symlink(schema, "config")) {
+        fprintf(stderr, "usage: %s [--schema dir] [--baseline n] [sizes...]\n",
+                argv[0]);
+        return 1;
+    }
+
+    if (0 != neu_persister_create("config") ||
+        0 != neu_persister_store_node(&node)) {
+        fprintf(stderr, "create database from `%s` fail\n", schema);
+        return 1;
+    }
+
+    printf("tags,stage,path,ms,tags_per_s\n");
+    for (int s = 0; s < n_size; s++) {
+        uint32_t       n    = 0;
+        neu_datatag_t *tags = parse(NEU_TAG_IMPORT_JSON, sizes[s], &n);
+
+        free_tags(tags, n);
+        tags = parse(NEU_TAG_IMPORT_CSV, sizes[s], &n);
+        add_to_group(tags, n);
+        persist(tags, n, baseline);
+        free_tags(tags, n);
+    }
+
+    neu_persister_destroy();
+    unlink("persistence/sqlite.db");
+    unlink("persistence/sqlite.db-wal");
+    unlink("persistence/sqlite.db-shm");
+    rmdir("persistence");
+    unlink("config");
+    chdir("/");
+    rmdir(dir);
+    return 0;
+}
@@ -513,6 +513,36 @@ class TestMQTT:
             params["topic"] = UPLOAD_TOPIC
             api.subscribe_group_update(NODE, DRIVER, GROUP, params)
 
+    @description(
+        given="MQTT node with upload batching",
+        when="reconfigure the node while uploading",
+        then="broker should receive batched data on upload topic",
+    )
+    def test_mqtt_upload_batch_reconfig(self, mocker, conf_fmt_tags):
+        conf = {**conf_fmt_tags, "batch-interval": 200}
+        api.node_setting_check(NODE, conf)
+        api.node_ctl(NODE, config.NEU_CTL_START)
+
+        # switch batching off and on while the group reports every INTERVAL
+        for i in range(10):
+            conf["batch-interval"] = 0 if i % 2 == 0 else 100 + i * 10
+            api.node_setting_check(NODE, conf)
+            time.sleep(INTERVAL * 1.5 / 1000)
+
+        conf["batch-interval"] = 500
+        api.node_setting_check(NODE, conf)
+        response = api.get_nodes_state(NODE)
+        assert 200 == response.status_code
+        assert config.NEU_NODE_STATE_RUNNING == response.json()["running"]
+
+        msg = mocker.get(UPLOAD_TOPIC, timeout=3)
+        assert isinstance(msg, list)
+        assert len(msg) >= 1
+        for report in msg:
+            assert DRIVER == report["node"]
+            assert GROUP == report["group"]
+            assert TAG0["name"] in [tag["name"] for tag in report["tags"]]
+
     @description(
         given="MQTT node and conf_cache",
         when="broken network connection restored",
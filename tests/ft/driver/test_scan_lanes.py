@@ -0,0 +1,115 @@
+import base64
+import time
+
+import pytest
+from prometheus_client.parser import text_string_to_metric_families
+
+import neuron.api as api
+import neuron.error as error
+import neuron.config as config
+from neuron.common import description
+
+# tests/plugins/l1: every group on its own lane, each read takes 80ms
+LIBRARY = "libplugin-l1.so"
+PLUGIN = "l1"
+NODE = "l1-lanes"
+GROUPS = ["g1", "g2"]
+INTERVAL = 100
+TAG = {
+    "name": "tag0",
+    "address": "1",
+    "attribute": config.NEU_TAG_ATTRIBUTE_READ,
+    "type": config.NEU_TYPE_INT16,
+}
+
+
+def read_file(path):
+    with open(path, "rb") as f:
+        return str(base64.b64encode(f.read()), encoding="utf-8")
+
+
+@pytest.fixture(autouse=True, scope="class")
+def lanes_node():
+    response = api.add_plugin(
+        library_name=LIBRARY,
+        so_file=read_file("build/tests/plugins/" + LIBRARY),
+        schema_file=read_file("build/tests/plugins/schema/l1.json"),
+    )
+    assert 200 == response.status_code
+    try:
+        api.add_node_check(NODE, PLUGIN)
+        for group in GROUPS:
+            api.add_group_check(NODE, group, INTERVAL)
+            api.add_tags_check(NODE, group, tags=[TAG])
+        yield
+    finally:
+        api.del_node(NODE)
+        api.del_plugin(PLUGIN)
+
+
+def overruns():
+    response = api.get_metrics(category="driver", node=NODE)
+    assert 200 == response.status_code
+
+    total = 0
+    for family in text_string_to_metric_families(response.text):
+        for sample in family.samples:
+            if sample.name == "group_scan_overruns_total":
+                total += sample.value
+    return total
+
+
+def overruns_in(seconds):
+    start = overruns()
+    time.sleep(seconds)
+    return overruns() - start
+
+
+class TestScanLanes:
+    @description(
+        given="driver node with two slow groups on two lanes",
+        when="read with one scan worker, then with two",
+        then="the groups are read concurrently with two workers",
+    )
+    def test_lanes_concurrent(self):
+        # keep the phase, a late read overruns instead of moving the period
+        api.node_setting_check(NODE, {"scan_workers": 1, "scan_policy": "skip"})
+        api.node_ctl(NODE, config.NEU_CTL_START)
+        response = api.get_nodes_state(NODE)
+        assert 200 == response.status_code
+        assert config.NEU_NODE_STATE_RUNNING == response.json()["running"]
+
+        # read in turn, 2 x 80ms do not fit in one interval
+        time.sleep(0.5)
+        assert overruns_in(1) >= 5
+
+        api.node_setting_check(NODE, {"scan_workers": 2, "scan_policy": "skip"})
+        time.sleep(0.5)
+        assert overruns_in(1) <= 1
+
+    @description(
+        given="modbus tcp node, its groups share one connection",
+        when="set scan_workers",
+        then="more than one scan worker is rejected",
+    )
+    def test_no_lanes(self):
+        node = "modbus-no-lanes"
+        setting = {
+            "connection_mode": 0,
+            "transport_mode": 0,
+            "interval": 20,
+            "host": "127.0.0.1",
+            "port": 502,
+            "timeout": 3000,
+            "max_retries": 0,
+            "retry_interval": 1,
+        }
+        api.add_node_check(node, config.PLUGIN_MODBUS_TCP)
+        try:
+            response = api.node_setting(node, {**setting, "scan_workers": 2})
+            assert 400 == response.status_code
+            assert error.NEU_ERR_NODE_SETTING_INVALID == response.json()["error"]
+
+            api.node_setting_check(node, {**setting, "scan_workers": 1})
+        finally:
+            api.del_node(node)
@@ -352,7 +352,7 @@ class TestHttp:
             "name": driver_1["name"],
             "plugin": driver_1["plugin"],
             "params": driver_1["params"],
-            "groups": [{"group": "grp", "interval": 1000, "tags": []} for _ in range(1000)]
+            "groups": [{"group": "grp", "interval": 1000, "tags": []} for _ in range(8193)]
         }
         response = api.put_drivers([driver])
         assert 400 == response.status_code
@@ -290,4 +290,27 @@ class TestReadPaginate:
         assert error.NEU_ERR_PLUGIN_NOT_RUNNING == response.json()["items"][2]["error"]
 
         api.node_ctl_check(node='modbus-tcp', ctl=config.NEU_CTL_START)
-        time.sleep(0.3)
\ No newline at end of file
+        time.sleep(0.3)
+
+    @description(given="created modbus node and tags", when="read tags with cursor", then="read success")
+    def test_read_tags_cursor(self, param):
+        response = api.read_tags_paginate(node=param[0], group='group', query= {"cursor": 0, "pageSize": 5})
+        assert 8 == response.json()["meta"]["total"]
+        assert 5 == len(response.json()["items"])
+        assert "hold_bit"    == response.json()["items"][0]["name"]
+        assert "hold_uint32" == response.json()["items"][4]["name"]
+        cursor = response.json()["meta"]["nextCursor"]
+        assert 0 != cursor
+
+        response = api.read_tags_paginate(node=param[0], group='group', query= {"cursor": cursor, "pageSize": 5})
+        assert 8 == response.json()["meta"]["total"]
+        assert 3 == len(response.json()["items"])
+        assert "hold_float"  == response.json()["items"][0]["name"]
+        assert "hold_bytes"  == response.json()["items"][2]["name"]
+        assert 0 == response.json()["meta"]["nextCursor"]
+
+        response = api.read_tags_paginate(node=param[0], group='group', query= {"cursor": 0, "pageSize": 1, "name": "int"})
+        assert 4 == response.json()["meta"]["total"]
+        assert 1 == len(response.json()["items"])
+        assert "hold_int16"  == response.json()["items"][0]["name"]
+        assert 0 != response.json()["meta"]["nextCursor"]
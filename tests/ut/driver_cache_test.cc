@@ -0,0 +1,192 @@
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "tag.h"
+
+#include "adapter/driver/cache.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static neu_dvalue_t int_value(int32_t v)
+{
+    neu_dvalue_t value = {};
+    value.type         = NEU_TYPE_INT32;
+    value.value.i32    = v;
+    return value;
+}
+
+TEST(DriverCacheTest, add_update_get)
+{
+    neu_driver_cache_t *     cache               = neu_driver_cache_new();
+    neu_driver_cache_value_t value               = {};
+    neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+    neu_driver_cache_add(cache, "grp", "tag1", int_value(0));
+    neu_driver_cache_update(cache, "grp", "tag1", 100, int_value(42), NULL, 0);
+
+    EXPECT_EQ(0,
+              neu_driver_cache_meta_get(cache, "grp", "tag1", &value, metas,
+                                        NEU_TAG_META_SIZE));
+    EXPECT_EQ(100, value.timestamp);
+    EXPECT_EQ(NEU_TYPE_INT32, value.value.type);
+    EXPECT_EQ(42, value.value.value.i32);
+
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get(cache, "grp", "tag2", &value, metas,
+                                        NEU_TAG_META_SIZE));
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get(cache, "grp1", "tag1", &value, metas,
+                                        NEU_TAG_META_SIZE));
+
+    neu_driver_cache_destroy(cache);
+}
+
+TEST(DriverCacheTest, handle)
+{
+    neu_driver_cache_t *     cache               = neu_driver_cache_new();
+    neu_driver_cache_value_t value               = {};
+    neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+    EXPECT_FALSE(
+        neu_tag_handle_valid(neu_driver_cache_find(cache, "grp", "tag1")));
+
+    neu_driver_cache_add(cache, "grp", "tag1", int_value(0));
+    neu_driver_cache_add(cache, "grp", "tag2", int_value(0));
+
+    neu_driver_cache_handle_t h1 = neu_driver_cache_find(cache, "grp", "tag1");
+    neu_driver_cache_handle_t h2 = neu_driver_cache_find(cache, "grp", "tag2");
+    EXPECT_TRUE(neu_tag_handle_valid(h1));
+    EXPECT_NE(h1.index, h2.index);
+
+    EXPECT_EQ(0,
+              neu_driver_cache_update_by_handle(cache, h2, 1, int_value(7),
+                                                NULL, 0, false));
+    EXPECT_EQ(0,
+              neu_driver_cache_meta_get(cache, "grp", "tag2", &value, metas,
+                                        NEU_TAG_META_SIZE));
+    EXPECT_EQ(7, value.value.value.i32);
+
+    // a deleted entry ignores updates
+    neu_driver_cache_del(cache, "grp", "tag2");
+    EXPECT_NE(0,
+              neu_driver_cache_update_by_handle(cache, h2, 2, int_value(8),
+                                                NULL, 0, false));
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get_by_handle(cache, h2, &value, metas,
+                                                  NEU_TAG_META_SIZE));
+
+    // the slot is reused by the next tag, the stale handle does not reach it
+    neu_driver_cache_add(cache, "grp", "tag3", int_value(3));
+    neu_driver_cache_handle_t h3 = neu_driver_cache_find(cache, "grp", "tag3");
+    EXPECT_EQ(h2.index, h3.index);
+    EXPECT_NE(h2.generation, h3.generation);
+
+    EXPECT_NE(0,
+              neu_driver_cache_update_by_handle(cache, h2, 3, int_value(9),
+                                                NULL, 0, false));
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get_by_handle(cache, h2, &value, metas,
+                                                  NEU_TAG_META_SIZE));
+    EXPECT_EQ(0,
+              neu_driver_cache_meta_get_by_handle(cache, h3, &value, metas,
+                                                  NEU_TAG_META_SIZE));
+    EXPECT_EQ(3, value.value.value.i32);
+
+    neu_driver_cache_destroy(cache);
+}
+
+TEST(DriverCacheTest, changed)
+{
+    neu_driver_cache_t *     cache               = neu_driver_cache_new();
+    neu_driver_cache_value_t value               = {};
+    neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+    neu_driver_cache_add(cache, "grp", "tag1", int_value(0));
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get_changed(cache, "grp", "tag1", &value,
+                                                metas, NEU_TAG_META_SIZE));
+
+    neu_driver_cache_update(cache, "grp", "tag1", 1, int_value(1), NULL, 0);
+    EXPECT_EQ(0,
+              neu_driver_cache_meta_get_changed(cache, "grp", "tag1", &value,
+                                                metas, NEU_TAG_META_SIZE));
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get_changed(cache, "grp", "tag1", &value,
+                                                metas, NEU_TAG_META_SIZE));
+
+    neu_driver_cache_update(cache, "grp", "tag1", 2, int_value(1), NULL, 0);
+    EXPECT_NE(0,
+              neu_driver_cache_meta_get_changed(cache, "grp", "tag1", &value,
+                                                metas, NEU_TAG_META_SIZE));
+
+    neu_driver_cache_destroy(cache);
+}
+
+struct writer_arg {
+    neu_driver_cache_t *       cache;
+    neu_driver_cache_handle_t *handles;
+};
+
+static void *writer(void *arg)
+{
+    struct writer_arg *w = (struct writer_arg *) arg;
+
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 100; i++) {
+            neu_driver_cache_update_by_handle(w->cache, w->handles[i], round,
+                                              int_value(round), NULL, 0,
+                                              false);
+        }
+    }
+
+    return NULL;
+}
+
+TEST(DriverCacheTest, concurrent_update)
+{
+    neu_driver_cache_t *      cache    = neu_driver_cache_new();
+    char                      name[32] = { 0 };
+    pthread_t                 tids[4];
+    struct writer_arg         args[4];
+    neu_driver_cache_handle_t handles[400];
+
+    for (int i = 0; i < 400; i++) {
+        snprintf(name, sizeof(name), "tag%d", i);
+        neu_driver_cache_add(cache, "grp", name, int_value(0));
+        handles[i] = neu_driver_cache_find(cache, "grp", name);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        args[i].cache   = cache;
+        args[i].handles = handles + i * 100;
+        pthread_create(&tids[i], NULL, writer, &args[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    for (int i = 0; i < 400; i++) {
+        neu_driver_cache_value_t value               = {};
+        neu_tag_meta_t           metas[NEU_TAG_META_SIZE] = {};
+
+        snprintf(name, sizeof(name), "tag%d", i);
+        EXPECT_EQ(0,
+                  neu_driver_cache_meta_get(cache, "grp", name, &value, metas,
+                                            NEU_TAG_META_SIZE));
+        EXPECT_EQ(99, value.value.value.i32);
+    }
+
+    neu_driver_cache_destroy(cache);
+}
+
+int main(int argc, char **argv)
+{
+    zlog_init("./config/dev.conf");
+    neuron = zlog_get_category("neuron");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,166 @@
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "msgpack_rw.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+typedef std::vector<uint8_t> bytes_t;
+
+static neu_tag_names_t *make_names(const std::vector<std::string> &tag_names)
+{
+    UT_array *       tags  = NULL;
+    neu_tag_names_t *names = NULL;
+
+    utarray_new(tags, neu_tag_get_icd());
+    for (const std::string &name : tag_names) {
+        neu_datatag_t tag = {};
+
+        tag.name        = (char *) name.c_str();
+        tag.address     = (char *) "1!400001";
+        tag.description = (char *) "";
+        utarray_push_back(tags, &tag);
+    }
+
+    names = neu_tag_names_new(tags);
+    utarray_free(tags);
+    return names;
+}
+
+static bytes_t encode(neu_tag_values_t *values, uint64_t timestamp)
+{
+    neu_reqresp_trans_data_t trans_data = {};
+
+    trans_data.driver = (char *) neu_tag_values_driver(values);
+    trans_data.group  = (char *) neu_tag_values_group(values);
+    trans_data.values = values;
+
+    size_t  size = msgpack_encode_read_resp(&trans_data, timestamp, NULL);
+    bytes_t buf(size + 1, 0xff);
+
+    EXPECT_EQ(size, msgpack_encode_read_resp(&trans_data, timestamp, &buf[0]));
+    EXPECT_EQ(0xff, buf[size]);
+    buf.resize(size);
+    return buf;
+}
+
+static void str(bytes_t &out, const std::string &s)
+{
+    if (s.size() < 32) {
+        out.push_back(0xa0 | s.size());
+    } else {
+        out.push_back(0xd9);
+        out.push_back(s.size());
+    }
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+static void map32(bytes_t &out, uint32_t n)
+{
+    out.insert(out.end(), { 0xdf, 0, 0, (uint8_t)(n >> 8), (uint8_t) n });
+}
+
+TEST(EkuiperMsgpackTest, ReadResp)
+{
+    neu_tag_names_t * names  = make_names({ "i16", "f64", "err", "str" });
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+    neu_dvalue_t      value  = {};
+    neu_tag_meta_t    meta   = {};
+
+    value.type      = NEU_TYPE_INT16;
+    value.value.i16 = -300;
+    neu_tag_values_push(values, 0, &value, NULL, 0);
+    value.type      = NEU_TYPE_DOUBLE;
+    value.value.d64 = 1.5;
+    neu_tag_values_push(values, 1, &value, NULL, 0);
+    value.type      = NEU_TYPE_ERROR;
+    value.value.i32 = 3002;
+    neu_tag_values_push(values, 2, &value, NULL, 0);
+
+    strcpy(meta.name, "unit");
+    meta.value.type     = NEU_TYPE_UINT8;
+    meta.value.value.u8 = 7;
+    value.type          = NEU_TYPE_STRING;
+    strcpy(value.value.str, "hi");
+    neu_tag_values_push(values, 3, &value, &meta, 1);
+
+    bytes_t expected = { 0x86 };
+    str(expected, "node_name");
+    str(expected, "modbus");
+    str(expected, "group_name");
+    str(expected, "grp");
+    str(expected, "timestamp");
+    expected.insert(expected.end(), { 0xcd, 0x03, 0xe8 });
+
+    str(expected, "values");
+    map32(expected, 3);
+    str(expected, "i16");
+    expected.insert(expected.end(), { 0xd1, 0xfe, 0xd4 });
+    str(expected, "f64");
+    expected.insert(expected.end(), { 0xcb, 0x3f, 0xf8, 0, 0, 0, 0, 0, 0 });
+    str(expected, "str");
+    str(expected, "hi");
+
+    str(expected, "errors");
+    map32(expected, 1);
+    str(expected, "err");
+    expected.insert(expected.end(), { 0xcd, 0x0b, 0xba });
+
+    str(expected, "metas");
+    map32(expected, 1);
+    str(expected, "str");
+    expected.push_back(0x81);
+    str(expected, "unit");
+    expected.push_back(0x07);
+
+    EXPECT_EQ(expected, encode(values, 1000));
+
+    neu_tag_values_unref(values);
+    neu_tag_names_unref(names);
+}
+
+TEST(EkuiperMsgpackTest, LargeReadResp)
+{
+    std::vector<std::string> tag_names;
+    for (int i = 0; i < 300; i++) {
+        tag_names.push_back("a_rather_long_tag_name_number_" +
+                            std::to_string(i));
+    }
+
+    neu_tag_names_t * names  = make_names(tag_names);
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+
+    for (uint32_t i = 0; i < tag_names.size(); i++) {
+        neu_dvalue_t value = {};
+
+        value.type      = NEU_TYPE_INT64;
+        value.value.i64 = (int64_t) i * i * i * i * i * i * i - 1;
+        neu_tag_values_push(values, i, &value, NULL, 0);
+    }
+
+    bytes_t buf = encode(values, UINT64_C(1700000000000));
+
+    const uint8_t values_key[] = { 0xa6, 'v', 'a', 'l', 'u', 'e', 's',
+                                   0xdf, 0,   0,   0x01, 0x2c };
+    EXPECT_NE(buf.end(),
+              std::search(buf.begin(), buf.end(), values_key,
+                          values_key + sizeof(values_key)));
+
+    bytes_t last;
+    str(last, tag_names.back());
+    last.insert(last.end(),
+                { 0xcf, 0x02, 0xf7, 0x07, 0x7e, 0x8d, 0x68, 0xb8, 0xa2 });
+    EXPECT_NE(buf.end(),
+              std::search(buf.begin(), buf.end(), last.begin(), last.end()));
+
+    neu_tag_values_unref(values);
+    neu_tag_names_unref(names);
+}
@@ -0,0 +1,161 @@
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "event/event.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static int count_cb(void *usr_data)
+{
+    ((std::atomic<int> *) usr_data)->fetch_add(1);
+    return 0;
+}
+
+static neu_event_timer_t *add_timer(neu_events_t *events, int64_t ms,
+                                    std::atomic<int> *counter,
+                                    neu_event_timer_type_e type =
+                                        NEU_EVENT_TIMER_NOBLOCK)
+{
+    neu_event_timer_param_t param = {};
+
+    param.second      = ms / 1000;
+    param.millisecond = ms % 1000;
+    param.usr_data    = counter;
+    param.cb          = count_cb;
+    param.type        = type;
+    return neu_event_add_timer(events, param);
+}
+
+TEST(EventTest, timer_period)
+{
+    neu_events_t *   events = neu_event_new();
+    std::atomic<int> fast(0), slow(0), idle(0);
+
+    neu_event_timer_t *t1 = add_timer(events, 10, &fast);
+    neu_event_timer_t *t2 = add_timer(events, 100, &slow,
+                                      NEU_EVENT_TIMER_BLOCK);
+    neu_event_timer_t *t3 = add_timer(events, 3600 * 1000, &idle);
+
+    usleep(550 * 1000);
+    neu_event_del_timer(events, t1);
+    neu_event_del_timer(events, t2);
+    neu_event_del_timer(events, t3);
+
+    EXPECT_GE(fast.load(), 30);
+    EXPECT_LE(fast.load(), 56);
+    EXPECT_GE(slow.load(), 3);
+    EXPECT_LE(slow.load(), 5);
+    EXPECT_EQ(0, idle.load());
+
+    // nothing fires once deleted
+    int n = fast.load();
+    usleep(50 * 1000);
+    EXPECT_EQ(n, fast.load());
+
+    neu_event_close(events);
+}
+
+TEST(EventTest, many_timers)
+{
+    neu_events_t *                  events = neu_event_new();
+    std::atomic<int>                counter(0);
+    std::vector<neu_event_timer_t *> timers;
+
+    // more than the former fixed event table could hold
+    for (int i = 0; i < 3000; i++) {
+        timers.push_back(add_timer(events, 50 + i % 50, &counter));
+    }
+
+    usleep(250 * 1000);
+    for (auto timer : timers) {
+        neu_event_del_timer(events, timer);
+    }
+
+    EXPECT_GE(counter.load(), 3000 * 2);
+    neu_event_close(events);
+}
+
+struct self_del {
+    neu_events_t *                   events;
+    std::atomic<neu_event_timer_t *> timer;
+    std::atomic<int>                 fired;
+};
+
+static int self_del_cb(void *usr_data)
+{
+    self_del *ctx = (self_del *) usr_data;
+
+    ctx->fired.fetch_add(1);
+    neu_event_del_timer(ctx->events, ctx->timer.load());
+    return 0;
+}
+
+TEST(EventTest, delete_in_callback)
+{
+    neu_events_t *          events = neu_event_new();
+    self_del                ctx    = { events, { NULL }, { 0 } };
+    neu_event_timer_param_t param  = {};
+
+    param.millisecond = 5;
+    param.usr_data    = &ctx;
+    param.cb          = self_del_cb;
+
+    ctx.timer = neu_event_add_timer(events, param);
+    usleep(100 * 1000);
+    EXPECT_EQ(1, ctx.fired.load());
+
+    neu_event_close(events);
+}
+
+static int io_cb(enum neu_event_io_type type, int fd, void *usr_data)
+{
+    uint64_t v = 0;
+
+    if (type == NEU_EVENT_IO_READ && read(fd, &v, sizeof(v)) == sizeof(v)) {
+        ((std::atomic<int> *) usr_data)->fetch_add((int) v);
+    }
+    return 0;
+}
+
+TEST(EventTest, io)
+{
+    neu_events_t *   events = neu_event_new();
+    std::atomic<int> counter(0);
+    std::vector<int> fds;
+    std::vector<neu_event_io_t *> ios;
+
+    for (int i = 0; i < 200; i++) {
+        neu_event_io_param_t param = {};
+
+        param.fd       = eventfd(0, EFD_NONBLOCK);
+        param.usr_data = &counter;
+        param.cb       = io_cb;
+        fds.push_back(param.fd);
+        ios.push_back(neu_event_add_io(events, param));
+    }
+
+    for (int fd : fds) {
+        uint64_t v = 1;
+        EXPECT_EQ((ssize_t) sizeof(v), write(fd, &v, sizeof(v)));
+    }
+
+    for (int i = 0; i < 100 && counter.load() < 200; i++) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(200, counter.load());
+
+    for (size_t i = 0; i < ios.size(); i++) {
+        neu_event_del_io(events, ios[i]);
+        close(fds[i]);
+    }
+    neu_event_close(events);
+}
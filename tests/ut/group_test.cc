@@ -0,0 +1,309 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "base/group.h"
+#include "errcodes.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static void add_tag(neu_group_t *group, const char *name, int attribute,
+                    const char *description = "")
+{
+    neu_datatag_t tag = {};
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) "1!40001";
+    tag.description = (char *) description;
+    tag.attribute   = (neu_attribute_e) attribute;
+    tag.type        = NEU_TYPE_INT16;
+    ASSERT_EQ(0, neu_group_add_tag(group, &tag));
+}
+
+TEST(GroupTest, ReadTagsShared)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+
+    add_tag(group, "a", NEU_ATTRIBUTE_READ);
+    add_tag(group, "b", NEU_ATTRIBUTE_WRITE);
+    add_tag(group, "c", NEU_ATTRIBUTE_SUBSCRIBE);
+
+    neu_group_tags_t *s1 = neu_group_get_read_tags(group);
+    neu_group_tags_t *s2 = neu_group_get_read_tags(group);
+    ASSERT_NE(nullptr, s1);
+    EXPECT_EQ(s1, s2);
+    EXPECT_EQ(2, utarray_len(neu_group_tags_array(s1)));
+    EXPECT_EQ(2, neu_tag_names_size(neu_group_tags_names(s1)));
+
+    uint32_t             index = 0;
+    const neu_datatag_t *tag   = neu_group_tags_find(s1, "c", &index);
+    ASSERT_NE(nullptr, tag);
+    EXPECT_STREQ("c", tag->name);
+    EXPECT_STREQ("c", neu_tag_names_get(neu_group_tags_names(s1), index));
+    EXPECT_EQ(nullptr, neu_group_tags_find(s1, "b", &index));
+    EXPECT_EQ(nullptr, neu_group_tags_find(s1, "x", &index));
+
+    neu_group_tags_unref(s2);
+    neu_group_tags_unref(s1);
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, ReadTagsCopyOnWrite)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+
+    add_tag(group, "a", NEU_ATTRIBUTE_READ);
+    neu_group_tags_t *s1 = neu_group_get_read_tags(group);
+
+    // every change publishes a new snapshot, the old one is left untouched
+    add_tag(group, "b", NEU_ATTRIBUTE_READ);
+    neu_group_tags_t *s2 = neu_group_get_read_tags(group);
+    EXPECT_NE(s1, s2);
+    EXPECT_LT(neu_group_tags_version(s1), neu_group_tags_version(s2));
+    EXPECT_EQ(1, utarray_len(neu_group_tags_array(s1)));
+    EXPECT_EQ(2, utarray_len(neu_group_tags_array(s2)));
+
+    ASSERT_EQ(0, neu_group_del_tag(group, "a"));
+    neu_group_tags_t *s3 = neu_group_get_read_tags(group);
+    EXPECT_NE(s2, s3);
+    EXPECT_EQ(nullptr, neu_group_tags_find(s3, "a", NULL));
+    EXPECT_NE(nullptr, neu_group_tags_find(s1, "a", NULL));
+
+    // snapshots outlive the group
+    neu_group_destroy(group);
+    EXPECT_STREQ("a", neu_tag_names_get(neu_group_tags_names(s1), 0));
+    neu_group_tags_unref(s1);
+    neu_group_tags_unref(s2);
+    neu_group_tags_unref(s3);
+}
+
+TEST(GroupTest, ReadTagsConcurrent)
+{
+    neu_group_t *            group = neu_group_new("group", 1000);
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([group] {
+            for (int k = 0; k < 2000; k++) {
+                neu_group_tags_t *s     = neu_group_get_read_tags(group);
+                neu_tag_names_t * names = neu_group_tags_names(s);
+                EXPECT_EQ(utarray_len(neu_group_tags_array(s)),
+                          neu_tag_names_size(names));
+                neu_group_tags_unref(s);
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; i++) {
+        add_tag(group, ("t" + std::to_string(i)).c_str(), NEU_ATTRIBUTE_READ);
+    }
+
+    for (auto &t : readers) {
+        t.join();
+    }
+
+    neu_group_tags_t *s = neu_group_get_read_tags(group);
+    EXPECT_EQ(200, utarray_len(neu_group_tags_array(s)));
+    neu_group_tags_unref(s);
+    neu_group_destroy(group);
+}
+
+// fills the group with n read tags named prefix0 ... prefix(n-1) in one batch
+static void add_tags(neu_group_t *group, const std::string &prefix, uint32_t n)
+{
+    std::vector<std::string>   names(n);
+    std::vector<neu_datatag_t> tags(n);
+    uint32_t                   index = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        names[i]            = prefix + std::to_string(i);
+        tags[i].name        = (char *) names[i].c_str();
+        tags[i].address     = (char *) "1!40001";
+        tags[i].description = (char *) "";
+        tags[i].attribute   = NEU_ATTRIBUTE_READ;
+        tags[i].type        = NEU_TYPE_INT16;
+    }
+
+    ASSERT_EQ(0, neu_group_add_tags(group, tags.data(), n, &index));
+    ASSERT_EQ(n, index);
+}
+
+TEST(GroupTest, LargeGroup)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+
+    add_tags(group, "t", 100000);
+    add_tag(group, "last", NEU_ATTRIBUTE_READ);
+    EXPECT_EQ(100001u, neu_group_tag_size(group));
+
+    neu_group_tags_t *s     = neu_group_get_read_tags(group);
+    uint32_t          index = 0;
+    EXPECT_EQ(100001u, utarray_len(neu_group_tags_array(s)));
+    ASSERT_NE(nullptr, neu_group_tags_find(s, "last", &index));
+    EXPECT_STREQ("last", neu_tag_names_get(neu_group_tags_names(s), index));
+    ASSERT_NE(nullptr, neu_group_tags_find(s, "t99999", &index));
+    EXPECT_STREQ("t99999", neu_tag_names_get(neu_group_tags_names(s), index));
+    neu_group_tags_unref(s);
+
+    ASSERT_EQ(0, neu_group_del_tag(group, "t70000"));
+    EXPECT_EQ(100000u, neu_group_tag_size(group));
+    EXPECT_EQ(nullptr, neu_group_find_tag(group, "t70000"));
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, LargeInstance)
+{
+    std::vector<neu_group_t *> groups;
+    uint64_t                   total = 0;
+
+    // 1M tags in one node
+    for (int i = 0; i < 8; i++) {
+        std::string name = "g" + std::to_string(i);
+        groups.push_back(neu_group_new(name.c_str(), 1000));
+        add_tags(groups.back(), "t", 131072);
+    }
+
+    for (neu_group_t *group : groups) {
+        neu_group_tags_t *s = neu_group_get_read_tags(group);
+        EXPECT_EQ(131072u, neu_tag_names_size(neu_group_tags_names(s)));
+        total += neu_group_tag_size(group);
+        neu_group_tags_unref(s);
+        neu_group_destroy(group);
+    }
+
+    EXPECT_EQ(1048576u, total);
+}
+
+static std::vector<std::string> tag_names(UT_array *tags)
+{
+    std::vector<std::string> names;
+
+    utarray_foreach(tags, neu_datatag_t *, tag) { names.push_back(tag->name); }
+    utarray_free(tags);
+    return names;
+}
+
+TEST(GroupTest, QueryReadTag)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+
+    add_tag(group, "temp_b", NEU_ATTRIBUTE_READ, "boiler");
+    add_tag(group, "temp_a", NEU_ATTRIBUTE_READ, "tank");
+    add_tag(group, "valve", NEU_ATTRIBUTE_WRITE, "temp");
+    add_tag(group, "level", NEU_ATTRIBUTE_SUBSCRIBE, "tank temp");
+    add_tag(group, "tem", NEU_ATTRIBUTE_READ);
+
+    using names = std::vector<std::string>;
+    // in the order of addition, the name filter also matches descriptions
+    EXPECT_EQ((names { "temp_b", "temp_a", "level", "tem" }),
+              tag_names(neu_group_query_read_tag(group, NULL, NULL)));
+    EXPECT_EQ((names { "temp_b", "temp_a", "level" }),
+              tag_names(neu_group_query_read_tag(group, "temp", NULL)));
+    EXPECT_EQ((names { "temp_b", "temp_a", "level", "tem" }),
+              tag_names(neu_group_query_read_tag(group, "te", NULL)));
+    EXPECT_EQ((names { "temp_a", "level" }),
+              tag_names(neu_group_query_read_tag(group, "temp", "tank")));
+    EXPECT_EQ((names {}),
+              tag_names(neu_group_query_read_tag(group, "xyz", NULL)));
+
+    int total = 0;
+    EXPECT_EQ((names { "level" }),
+              tag_names(neu_group_query_read_tag_paginate(group, "temp", NULL,
+                                                          2, 2, &total)));
+    EXPECT_EQ(3, total);
+    EXPECT_EQ((names {}),
+              tag_names(neu_group_query_read_tag_paginate(group, "temp", NULL,
+                                                          3, 2, &total)));
+    EXPECT_EQ(3, total);
+
+    // the snapshot follows the changes
+    ASSERT_EQ(0, neu_group_del_tag(group, "temp_a"));
+    EXPECT_EQ((names { "temp_b", "level" }),
+              tag_names(neu_group_query_read_tag(group, "temp", NULL)));
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, QueryReadTagCursor)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+
+    for (int i = 0; i < 10; i++) {
+        add_tag(group, ("t" + std::to_string(i)).c_str(), NEU_ATTRIBUTE_READ);
+    }
+
+    using names = std::vector<std::string>;
+
+    uint64_t next  = 0;
+    int      total = 0;
+
+    EXPECT_EQ((names { "t0", "t1", "t2", "t3" }),
+              tag_names(neu_group_query_read_tag_cursor(group, NULL, NULL, 0,
+                                                        4, &next, &total)));
+    EXPECT_EQ(10, total);
+    ASSERT_NE(0u, next);
+
+    // the cursor stays valid when its tag is gone and tags are added
+    uint64_t cursor = next;
+    ASSERT_EQ(0, neu_group_del_tag(group, "t3"));
+    ASSERT_EQ(0, neu_group_del_tag(group, "t4"));
+    add_tag(group, "t10", NEU_ATTRIBUTE_READ);
+    EXPECT_EQ((names { "t5", "t6", "t7", "t8" }),
+              tag_names(neu_group_query_read_tag_cursor(
+                  group, NULL, NULL, cursor, 4, &next, &total)));
+    EXPECT_EQ(9, total);
+
+    EXPECT_EQ((names { "t9", "t10" }),
+              tag_names(neu_group_query_read_tag_cursor(
+                  group, NULL, NULL, next, 4, &next, &total)));
+    EXPECT_EQ(0u, next);
+
+    // filtered
+    EXPECT_EQ((names { "t1" }),
+              tag_names(neu_group_query_read_tag_cursor(group, "t1", NULL, 0,
+                                                        1, &next, &total)));
+    EXPECT_EQ(2, total);
+    EXPECT_EQ((names { "t10" }),
+              tag_names(neu_group_query_read_tag_cursor(
+                  group, "t1", NULL, next, 1, &next, &total)));
+    EXPECT_EQ(0u, next);
+
+    neu_group_destroy(group);
+}
+
+TEST(GroupTest, QueryLargeGroup)
+{
+    neu_group_t *group = neu_group_new("group", 1000);
+    uint64_t     next  = 0;
+    int          total = 0;
+
+    add_tags(group, "t", 100000);
+
+    UT_array *tags = neu_group_query_read_tag_cursor(group, "t9999", NULL, 0,
+                                                     5, &next, &total);
+    EXPECT_EQ(11, total); // t9999 and t99990 ... t99999
+    EXPECT_EQ((std::vector<std::string> { "t9999", "t99990", "t99991",
+                                          "t99992", "t99993" }),
+              tag_names(tags));
+
+    // next pages reuse the matches
+    tags = neu_group_query_read_tag_cursor(group, "t9999", NULL, next, 10,
+                                           &next, &total);
+    EXPECT_EQ(6, utarray_len(tags));
+    EXPECT_EQ(0u, next);
+    utarray_free(tags);
+
+    tags = neu_group_query_read_tag_paginate(group, NULL, NULL, 1000, 100,
+                                             &total);
+    EXPECT_EQ(100000, total);
+    EXPECT_STREQ("t99900", ((neu_datatag_t *) utarray_front(tags))->name);
+    utarray_free(tags);
+
+    neu_group_destroy(group);
+}
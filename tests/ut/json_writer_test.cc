@@ -0,0 +1,159 @@
+#include <math.h>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "utils/json_writer.h"
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+static std::string real(double value, int precision)
+{
+    neu_json_writer_t w;
+    std::string       str;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_array_begin(&w);
+    neu_json_writer_real(&w, value, precision);
+    neu_json_writer_array_end(&w);
+    str = neu_json_writer_str(&w);
+    neu_json_writer_fini(&w);
+
+    // strip the brackets
+    return str.substr(1, str.size() - 2);
+}
+
+TEST(JsonWriterTest, Nesting)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_key(&w, "a");
+    neu_json_writer_int(&w, 1);
+    neu_json_writer_key(&w, "b");
+    neu_json_writer_array_begin(&w);
+    neu_json_writer_bool(&w, true);
+    neu_json_writer_null(&w);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_object_end(&w);
+    neu_json_writer_array_begin(&w);
+    neu_json_writer_array_end(&w);
+    neu_json_writer_array_end(&w);
+    neu_json_writer_key(&w, "c");
+    neu_json_writer_string(&w, "x");
+    neu_json_writer_object_end(&w);
+
+    EXPECT_STREQ("{\"a\":1,\"b\":[true,null,{},[]],\"c\":\"x\"}",
+                 neu_json_writer_str(&w));
+
+    // the buffer is reused after a reset
+    neu_json_writer_reset(&w);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_object_end(&w);
+    EXPECT_STREQ("{}", neu_json_writer_str(&w));
+    EXPECT_EQ(2, neu_json_writer_len(&w));
+
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Unbalanced)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_object_begin(&w);
+    neu_json_writer_key(&w, "a");
+    EXPECT_EQ(nullptr, neu_json_writer_str(&w));
+    neu_json_writer_object_end(&w);
+    EXPECT_EQ(nullptr, neu_json_writer_str(&w));
+
+    neu_json_writer_reset(&w);
+    neu_json_writer_array_end(&w);
+    EXPECT_EQ(nullptr, neu_json_writer_str(&w));
+
+    neu_json_writer_reset(&w);
+    for (int i = 0; i <= NEU_JSON_WRITER_DEPTH; i++) {
+        neu_json_writer_array_begin(&w);
+    }
+    EXPECT_EQ(nullptr, neu_json_writer_str(&w));
+
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Escape)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_array_begin(&w);
+    neu_json_writer_string(&w, "a\"b\\c\nd\te\x01");
+    neu_json_writer_string(&w, "\xe4\xb8\xad");
+    neu_json_writer_string(&w, NULL);
+    neu_json_writer_array_end(&w);
+
+    EXPECT_STREQ("[\"a\\\"b\\\\c\\nd\\te\\u0001\",\"\xe4\xb8\xad\",null]",
+                 neu_json_writer_str(&w));
+
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Int)
+{
+    neu_json_writer_t w;
+
+    neu_json_writer_init(&w, 0);
+    neu_json_writer_array_begin(&w);
+    neu_json_writer_int(&w, 0);
+    neu_json_writer_int(&w, 7);
+    neu_json_writer_int(&w, -42);
+    neu_json_writer_int(&w, INT64_MAX);
+    neu_json_writer_int(&w, INT64_MIN);
+    neu_json_writer_array_end(&w);
+
+    EXPECT_STREQ("[0,7,-42,9223372036854775807,-9223372036854775808]",
+                 neu_json_writer_str(&w));
+
+    neu_json_writer_fini(&w);
+}
+
+TEST(JsonWriterTest, Real)
+{
+    EXPECT_EQ("1.0", real(1, 0));
+    EXPECT_EQ("-0.5", real(-0.5, 0));
+    EXPECT_EQ("0.1", real(0.1, 0));
+    EXPECT_EQ("123.456", real(123.456, 0));
+    EXPECT_EQ("0.3333333333333333", real(1.0 / 3, 0));
+    EXPECT_EQ("1e+300", real(1e300, 0));
+    // shortest round trip, not the 16 digits jansson prints
+    EXPECT_EQ("0.30000000000000004", real(0.1 + 0.2, 0));
+    EXPECT_EQ("null", real(NAN, 0));
+    EXPECT_EQ("null", real(INFINITY, 2));
+
+    EXPECT_EQ("0.333", real(1.0 / 3, 3));
+    EXPECT_EQ("2.5", real(2.5, 3));
+    EXPECT_EQ("-1.06", real(-1.055001, 2));
+    EXPECT_EQ("0.0", real(0.0004, 3));
+    EXPECT_EQ("-12.0", real(-12, 1));
+}
+
+TEST(JsonWriterTest, Detach)
+{
+    neu_json_writer_t w;
+    char *            str = NULL;
+
+    neu_json_writer_init(&w, 0);
+    for (int i = 0; i < 2; i++) {
+        neu_json_writer_reset(&w);
+        neu_json_writer_array_begin(&w);
+        neu_json_writer_int(&w, i);
+        neu_json_writer_array_end(&w);
+
+        str = neu_json_writer_detach(&w);
+        EXPECT_EQ(i == 0 ? std::string("[0]") : std::string("[1]"), str);
+        free(str);
+    }
+
+    neu_json_writer_fini(&w);
+}
@@ -1,7 +1,9 @@
 #include <sys/time.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
+#include "errcodes.h"
 #include "jwt.h"
 #include "utils/neu_jwt.h"
 
@@ -34,6 +36,73 @@ TEST(JwtTest, JwtValidate)
 
     jwt_free_str(token);
 }
+
+TEST(JwtTest, JwtValidateCache)
+{
+    char *   token         = NULL;
+    char     b_token[1024] = { 0 };
+    uint64_t hits = 0, misses = 0, hits0 = 0, misses0 = 0;
+
+    EXPECT_EQ(0, neu_jwt_init((char *) "./config"));
+    EXPECT_EQ(0, neu_jwt_new(&token));
+    snprintf(b_token, sizeof(b_token), "Bearer %s", token);
+    neu_jwt_cache_stats(&hits0, &misses0);
+
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    neu_jwt_cache_stats(&hits, &misses);
+    EXPECT_EQ(hits0 + 1, hits);
+    EXPECT_EQ(misses0 + 1, misses);
+
+    // a tampered token never matches the cached one
+    b_token[strlen(b_token) - 2] ^= 1;
+    EXPECT_NE(0, neu_jwt_validate(b_token));
+    b_token[strlen(b_token) - 2] ^= 1;
+
+    neu_jwt_cache_invalidate();
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    neu_jwt_cache_stats(&hits, &misses);
+    EXPECT_EQ(hits0 + 1, hits);
+    EXPECT_EQ(misses0 + 3, misses);
+
+    jwt_free_str(token);
+}
+
+TEST(JwtTest, JwtValidateCacheExpired)
+{
+    FILE *         f             = fopen("./config/neuron.key", "r");
+    char           key[2048]     = { 0 };
+    char           b_token[1024] = { 0 };
+    char *         token         = NULL;
+    jwt_t *        jwt           = NULL;
+    struct timeval tv            = { 0 };
+
+    ASSERT_NE(nullptr, f);
+    ASSERT_LT(0, fread(key, 1, sizeof(key) - 1, f));
+    fclose(f);
+
+    EXPECT_EQ(0, neu_jwt_init((char *) "./config"));
+
+    gettimeofday(&tv, NULL);
+    EXPECT_EQ(0, jwt_new(&jwt));
+    EXPECT_EQ(0, jwt_add_grant(jwt, "iss", "neuron"));
+    EXPECT_EQ(0, jwt_add_grant_int(jwt, "exp", tv.tv_sec + 2));
+    EXPECT_EQ(0,
+              jwt_set_alg(jwt, JWT_ALG_RS256, (const unsigned char *) key,
+                          strlen(key)));
+    token = jwt_encode_str(jwt);
+    jwt_free(jwt);
+    snprintf(b_token, sizeof(b_token), "Bearer %s", token);
+
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    EXPECT_EQ(0, neu_jwt_validate(b_token));
+    sleep(3);
+    EXPECT_EQ(NEU_ERR_EXPIRED_TOKEN, neu_jwt_validate(b_token));
+    EXPECT_EQ(NEU_ERR_EXPIRED_TOKEN, neu_jwt_validate(b_token));
+
+    jwt_free_str(token);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
@@ -0,0 +1,136 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "metrics.h"
+#include "utils/log.h"
+
+zlog_category_t *neuron           = NULL;
+int64_t          global_timestamp = 0;
+
+class MetricsTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        metrics = neu_node_metrics_new(NULL, NEU_NA_TYPE_DRIVER,
+                                       (char *) "metrics-test");
+        ASSERT_NE(nullptr, metrics);
+    }
+
+    void TearDown() override { neu_node_metrics_free(metrics); }
+
+    neu_node_metrics_t *metrics = NULL;
+};
+
+TEST_F(MetricsTest, HistogramBuckets)
+{
+    ASSERT_EQ(0,
+              neu_node_metrics_add(metrics, NULL, NEU_METRIC_RTT_MS,
+                                   NEU_METRIC_RTT_MS_HELP,
+                                   NEU_METRIC_RTT_MS_TYPE, 0));
+    neu_metric_entry_t *e =
+        neu_node_metrics_find(metrics, NULL, NEU_METRIC_RTT_MS);
+    ASSERT_NE(nullptr, e);
+    EXPECT_STREQ("histogram", neu_metric_type_str(e->type));
+
+    // bounds are inclusive
+    neu_node_metrics_update_entry(metrics, e, 0);
+    neu_node_metrics_update_entry(metrics, e, 1);
+    neu_node_metrics_update_entry(metrics, e, 2);
+    neu_node_metrics_update_entry(metrics, e, 3);
+    neu_node_metrics_update_entry(metrics, e, 10001);
+    EXPECT_EQ(0, neu_node_metrics_update(metrics, NULL, NEU_METRIC_RTT_MS, 7));
+
+    EXPECT_EQ(2, e->hist->buckets[0]);
+    EXPECT_EQ(1, e->hist->buckets[1]);
+    EXPECT_EQ(1, e->hist->buckets[2]);
+    EXPECT_EQ(1, e->hist->buckets[3]);
+    EXPECT_EQ(1, e->hist->buckets[NEU_METRIC_HISTOGRAM_BUCKETS - 1]);
+    EXPECT_EQ(6, e->hist->count);
+    EXPECT_EQ(10014, e->hist->sum);
+
+    neu_node_metrics_reset(metrics);
+    EXPECT_EQ(0, e->hist->count);
+    EXPECT_EQ(0, e->hist->sum);
+    for (int i = 0; i < NEU_METRIC_HISTOGRAM_BUCKETS; ++i) {
+        EXPECT_EQ(0, e->hist->buckets[i]);
+    }
+}
+
+TEST_F(MetricsTest, UpdateByHandle)
+{
+    ASSERT_EQ(0,
+              neu_node_metrics_add(metrics, NULL, NEU_METRIC_TAG_READS_TOTAL,
+                                   NEU_METRIC_TAG_READS_TOTAL_HELP,
+                                   NEU_METRIC_TAG_READS_TOTAL_TYPE, 0));
+    ASSERT_EQ(0,
+              neu_node_metrics_add(metrics, "grp",
+                                   NEU_METRIC_GROUP_LAST_TIMER_MS,
+                                   NEU_METRIC_GROUP_LAST_TIMER_MS_HELP,
+                                   NEU_METRIC_GROUP_LAST_TIMER_MS_TYPE, 0));
+
+    EXPECT_EQ(nullptr,
+              neu_node_metrics_find(metrics, NULL, NEU_METRIC_RTT_MS));
+    EXPECT_EQ(nullptr,
+              neu_node_metrics_find(metrics, "none",
+                                    NEU_METRIC_GROUP_LAST_TIMER_MS));
+
+    neu_metric_entry_t *reads =
+        neu_node_metrics_find(metrics, NULL, NEU_METRIC_TAG_READS_TOTAL);
+    neu_metric_entry_t *timer =
+        neu_node_metrics_find(metrics, "grp", NEU_METRIC_GROUP_LAST_TIMER_MS);
+    ASSERT_NE(nullptr, reads);
+    ASSERT_NE(nullptr, timer);
+
+    neu_node_metrics_update_entry(metrics, reads, 3);
+    neu_node_metrics_update_entry(metrics, reads, 4);
+    EXPECT_EQ(7, neu_metric_entry_value(reads));
+
+    neu_node_metrics_update_entry(metrics, timer, 30);
+    neu_node_metrics_update_entry(metrics, timer, 20);
+    EXPECT_EQ(20, neu_metric_entry_value(timer));
+
+    // handles survive group renaming
+    ASSERT_EQ(0, neu_node_metrics_update_group(metrics, "grp", "grp2"));
+    EXPECT_EQ(timer,
+              neu_node_metrics_find(metrics, "grp2",
+                                    NEU_METRIC_GROUP_LAST_TIMER_MS));
+
+    neu_node_metrics_reset(metrics);
+    EXPECT_EQ(0, neu_metric_entry_value(reads));
+}
+
+TEST_F(MetricsTest, ConcurrentUpdates)
+{
+    ASSERT_EQ(0,
+              neu_node_metrics_add(metrics, NULL, NEU_METRIC_TAG_READS_TOTAL,
+                                   NEU_METRIC_TAG_READS_TOTAL_HELP,
+                                   NEU_METRIC_TAG_READS_TOTAL_TYPE, 0));
+    ASSERT_EQ(0,
+              neu_node_metrics_add(metrics, NULL, NEU_METRIC_RTT_MS,
+                                   NEU_METRIC_RTT_MS_HELP,
+                                   NEU_METRIC_RTT_MS_TYPE, 0));
+    neu_metric_entry_t *reads =
+        neu_node_metrics_find(metrics, NULL, NEU_METRIC_TAG_READS_TOTAL);
+    neu_metric_entry_t *rtt =
+        neu_node_metrics_find(metrics, NULL, NEU_METRIC_RTT_MS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 100000; ++i) {
+                neu_node_metrics_update_entry(metrics, reads, 1);
+                neu_node_metrics_update_entry(metrics, rtt, 5);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(400000, neu_metric_entry_value(reads));
+    EXPECT_EQ(400000, rtt->hist->count);
+    EXPECT_EQ(400000, rtt->hist->buckets[2]);
+    EXPECT_EQ(2000000, rtt->hist->sum);
+}
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <neuron.h>
+extern "C" {
+#include "modbus_req.h"
+}
+
+zlog_category_t *neuron           = NULL;
+int64_t          global_timestamp = 0;
+
+/*
+ * a fake modbus tcp device behind neu_conn_send/neu_conn_recv, every holding
+ * register holds its address + 1000 except the illegal ones
+ */
+struct request {
+    uint16_t seq;
+    uint8_t  slave_id;
+    uint8_t  function;
+    uint16_t start;
+    uint16_t n_reg;
+};
+
+struct device {
+    std::deque<request>  pending;
+    std::vector<uint8_t> stream;
+    // start address -> requests, requests to drop, response delay ms
+    std::map<uint16_t, int> sent;
+    std::map<uint16_t, int> drop;
+    std::map<uint16_t, int> delay;
+    // [start, end) answered with an illegal address exception
+    std::vector<std::pair<uint16_t, uint16_t>> illegal;
+
+    int    n_send       = 0;
+    int    fail_send    = 0;  // nth send fails
+    int    n_idle       = 0;  // recvs that timed out
+    size_t max_pending  = 0;
+    int    stale        = -1; // start address answered after an unknown seq
+    bool   reverse      = false; // answer the newest first
+    bool   disconnected = false;
+};
+
+static device dev;
+
+static void put16(std::vector<uint8_t> &out, uint16_t v)
+{
+    out.push_back(v >> 8);
+    out.push_back(v & 0xff);
+}
+
+static bool rejected(const request &req)
+{
+    for (auto &range : dev.illegal) {
+        if (req.start < range.second && range.first < req.start + req.n_reg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void respond(uint16_t seq, const request &req)
+{
+    if (rejected(req)) {
+        put16(dev.stream, seq);
+        put16(dev.stream, 0);
+        put16(dev.stream, 3);
+        dev.stream.push_back(req.slave_id);
+        dev.stream.push_back(req.function | 0x80);
+        dev.stream.push_back(0x02);
+        return;
+    }
+
+    put16(dev.stream, seq);
+    put16(dev.stream, 0);
+    put16(dev.stream, 3 + 2 * req.n_reg);
+    dev.stream.push_back(req.slave_id);
+    dev.stream.push_back(req.function);
+    dev.stream.push_back(2 * req.n_reg);
+    for (uint16_t i = 0; i < req.n_reg; i++) {
+        put16(dev.stream, req.start + i + 1000);
+    }
+}
+
+static void answer()
+{
+    while (!dev.pending.empty()) {
+        request req = dev.reverse ? dev.pending.back() : dev.pending.front();
+        if (dev.reverse) {
+            dev.pending.pop_back();
+        } else {
+            dev.pending.pop_front();
+        }
+
+        if (dev.drop[req.start] > 0) {
+            dev.drop[req.start] -= 1;
+            continue;
+        }
+
+        if (dev.stale == req.start) {
+            dev.stale = -1;
+            respond(req.seq + 0x100, req);
+        }
+
+        if (dev.delay[req.start] > 0) {
+            usleep(dev.delay[req.start] * 1000);
+        }
+
+        respond(req.seq, req);
+        return;
+    }
+}
+
+extern "C" {
+ssize_t neu_conn_send(neu_conn_t *conn, uint8_t *buf, ssize_t len)
+{
+    (void) conn;
+
+    dev.n_send += 1;
+    if (dev.n_send == dev.fail_send) {
+        return -1;
+    }
+
+    EXPECT_EQ(12, len);
+    request req  = {};
+    req.seq      = buf[0] << 8 | buf[1];
+    req.slave_id = buf[6];
+    req.function = buf[7];
+    req.start    = buf[8] << 8 | buf[9];
+    req.n_reg    = buf[10] << 8 | buf[11];
+
+    dev.pending.push_back(req);
+    dev.sent[req.start] += 1;
+    dev.max_pending = std::max(dev.max_pending, dev.pending.size());
+    return len;
+}
+
+ssize_t neu_conn_recv(neu_conn_t *conn, uint8_t *buf, ssize_t len)
+{
+    (void) conn;
+
+    if (dev.stream.empty()) {
+        answer();
+    }
+    if (dev.stream.empty()) {
+        dev.n_idle += 1;
+        return 0;
+    }
+
+    ssize_t n = std::min(len, (ssize_t) dev.stream.size());
+    memcpy(buf, dev.stream.data(), n);
+    dev.stream.erase(dev.stream.begin(), dev.stream.begin() + n);
+    return n;
+}
+
+void neu_conn_disconnect(neu_conn_t *conn)
+{
+    (void) conn;
+    dev.disconnected = true;
+}
+
+neu_conn_state_t neu_conn_state(neu_conn_t *conn)
+{
+    (void) conn;
+    neu_conn_state_t state = {};
+    return state;
+}
+}
+
+static std::map<std::string, neu_dvalue_t> values;
+static std::map<std::string, int>          n_updates;
+
+static void update(neu_adapter_t *adapter, const char *group, const char *tag,
+                   neu_dvalue_t value)
+{
+    (void) adapter;
+    (void) group;
+
+    std::string name = tag == NULL ? "" : tag;
+    values[name]     = value;
+    n_updates[name] += 1;
+}
+
+static neu_tag_handle_t resolve_tag(neu_adapter_t *adapter, const char *group,
+                                    const char *tag)
+{
+    (void) adapter;
+    (void) group;
+    (void) tag;
+
+    neu_tag_handle_t handle = { NEU_TAG_HANDLE_INVALID_INDEX, 0 };
+    return handle;
+}
+
+static int update_metric(neu_adapter_t *adapter, const char *metric_name,
+                         uint64_t n, const char *group)
+{
+    (void) adapter;
+    (void) metric_name;
+    (void) n;
+    (void) group;
+    return 0;
+}
+
+class ModbusPipelineTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        dev = device();
+        values.clear();
+        n_updates.clear();
+
+        callbacks.update_metric      = update_metric;
+        callbacks.driver.update      = update;
+        callbacks.driver.resolve_tag = resolve_tag;
+
+        plugin = (neu_plugin_t *) calloc(1, sizeof(neu_plugin_t));
+        plugin->common.adapter_callbacks = &callbacks;
+
+        plugin->conn     = (neu_conn_t *) &dev;
+        plugin->protocol = MODBUS_PROTOCOL_TCP;
+        plugin->timeout  = 3000;
+        plugin->stack =
+            modbus_stack_create((void *) plugin, MODBUS_PROTOCOL_TCP,
+                                modbus_send_msg, modbus_value_handle,
+                                modbus_write_resp);
+        modbus_stack_set_match(plugin->stack, modbus_match_seq);
+
+        group.group_name = strdup("grp");
+        utarray_new(group.tags, neu_tag_get_icd());
+    }
+
+    void TearDown() override
+    {
+        if (group.group_free != NULL) {
+            group.group_free(&group);
+        }
+        utarray_free(group.tags);
+        free(group.group_name);
+        if (plugin->excludes != NULL) {
+            utarray_free(plugin->excludes);
+        }
+        modbus_stack_destroy(plugin->stack);
+        free(plugin);
+    }
+
+    // holding register tag<i> at register start
+    void add_tag(int i, uint16_t start)
+    {
+        char name[16]    = { 0 };
+        char address[16] = { 0 };
+        snprintf(name, sizeof(name), "tag%d", i);
+        snprintf(address, sizeof(address), "1!4%05d", start + 1);
+
+        neu_datatag_t tag = {};
+        tag.name          = name;
+        tag.address       = address;
+        tag.attribute     = NEU_ATTRIBUTE_READ;
+        tag.type          = NEU_TYPE_INT16;
+        tag.description   = (char *) "";
+        utarray_push_back(group.tags, &tag);
+        starts.push_back(start);
+    }
+
+    // holding registers 100 apart, one read command each
+    void add_tags(int n)
+    {
+        for (int i = 0; i < n; i++) {
+            add_tag(i, 100 * i);
+        }
+    }
+
+    void scan()
+    {
+        values.clear();
+        n_updates.clear();
+        modbus_group_timer(plugin, &group, 0xfa);
+    }
+
+    size_t n_excludes()
+    {
+        return plugin->excludes == NULL ? 0 : utarray_len(plugin->excludes);
+    }
+
+    void expect_value(int i)
+    {
+        std::string name = "tag" + std::to_string(i);
+        ASSERT_EQ(1, n_updates[name]) << name;
+        EXPECT_EQ(NEU_TYPE_INT16, values[name].type) << name;
+        EXPECT_EQ(starts[i] + 1000, values[name].value.i16) << name;
+    }
+
+    void expect_error(int i, int error)
+    {
+        std::string name = "tag" + std::to_string(i);
+        ASSERT_EQ(1, n_updates[name]) << name;
+        EXPECT_EQ(NEU_TYPE_ERROR, values[name].type) << name;
+        EXPECT_EQ(error, values[name].value.i32) << name;
+    }
+
+    adapter_callbacks_t   callbacks = {};
+    neu_plugin_group_t    group     = {};
+    neu_plugin_t *        plugin    = NULL;
+    std::vector<uint16_t> starts;
+};
+
+TEST_F(ModbusPipelineTest, out_of_order_responses)
+{
+    plugin->max_inflight = 4;
+    dev.reverse          = true;
+    dev.stale            = 500;
+    add_tags(6);
+
+    scan();
+
+    EXPECT_EQ(6, dev.n_send);
+    EXPECT_EQ(4u, dev.max_pending);
+    EXPECT_EQ(0, dev.n_idle);
+    EXPECT_FALSE(dev.disconnected);
+    EXPECT_EQ(0u, n_updates.count(""));
+    for (int i = 0; i < 6; i++) {
+        expect_value(i);
+    }
+}
+
+TEST_F(ModbusPipelineTest, retry_after_timeout)
+{
+    plugin->max_inflight = 4;
+    plugin->max_retries  = 1;
+    dev.drop[100]        = 1;
+    add_tags(3);
+
+    scan();
+
+    EXPECT_EQ(2, dev.sent[100]);
+    EXPECT_FALSE(dev.disconnected);
+    for (int i = 0; i < 3; i++) {
+        expect_value(i);
+    }
+}
+
+TEST_F(ModbusPipelineTest, retries_exhausted)
+{
+    plugin->max_inflight = 4;
+    plugin->max_retries  = 0;
+    dev.drop[100]        = 1;
+    add_tags(3);
+
+    scan();
+
+    EXPECT_EQ(1, dev.sent[100]);
+    EXPECT_FALSE(dev.disconnected);
+    expect_value(0);
+    expect_error(1, NEU_ERR_PLUGIN_DEVICE_NOT_RESPONSE);
+    expect_value(2);
+}
+
+TEST_F(ModbusPipelineTest, per_request_timeout)
+{
+    // tag0 gets lost, it is resent once the slow tag1 arrived, without
+    // waiting for a receive to time out
+    plugin->max_inflight = 2;
+    plugin->max_retries  = 1;
+    plugin->timeout      = 2;
+    dev.drop[0]          = 1;
+    dev.delay[100]       = 10;
+    add_tags(2);
+
+    scan();
+
+    EXPECT_EQ(2, dev.sent[0]);
+    EXPECT_EQ(1, dev.sent[100]);
+    EXPECT_EQ(0, dev.n_idle);
+    expect_value(0);
+    expect_value(1);
+}
+
+TEST_F(ModbusPipelineTest, send_failed)
+{
+    // tag0 and tag1 are received, tag2 is in flight, sending tag3 fails
+    plugin->max_inflight = 2;
+    dev.fail_send        = 4;
+    add_tags(6);
+
+    scan();
+
+    EXPECT_TRUE(dev.disconnected);
+    EXPECT_EQ(0u, n_updates.count(""));
+    expect_value(0);
+    expect_value(1);
+    for (int i = 2; i < 6; i++) {
+        expect_error(i, NEU_ERR_PLUGIN_DISCONNECTED);
+    }
+}
+
+TEST_F(ModbusPipelineTest, rejected_gap)
+{
+    // tag0 and tag1 are read together through 1..9, 5 does not exist
+    plugin->max_inflight = 1;
+    modbus_set_max_gap(plugin, 16);
+    dev.illegal.push_back({ 5, 6 });
+    add_tag(0, 0);
+    add_tag(1, 10);
+
+    scan();
+    expect_error(0, NEU_ERR_PLUGIN_READ_FAILURE);
+    expect_error(1, NEU_ERR_PLUGIN_READ_FAILURE);
+    EXPECT_EQ(1, dev.sent[1]);
+    ASSERT_EQ(1u, n_excludes());
+
+    modbus_range_t *range = (modbus_range_t *) utarray_front(plugin->excludes);
+    EXPECT_EQ(1, range->start);
+    EXPECT_EQ(10, range->end);
+
+    // read apart from now on
+    scan();
+    expect_value(0);
+    expect_value(1);
+    EXPECT_EQ(1, dev.sent[10]);
+}
+
+TEST_F(ModbusPipelineTest, rejected_tag)
+{
+    // tag1 does not exist, the gap is fine and still read through, a late
+    // response arrives before the one of the gap
+    plugin->max_inflight = 4;
+    modbus_set_max_gap(plugin, 16);
+    dev.illegal.push_back({ 10, 11 });
+    dev.stale = 1;
+    add_tag(0, 0);
+    add_tag(1, 10);
+    add_tag(2, 100);
+
+    scan();
+    expect_error(0, NEU_ERR_PLUGIN_READ_FAILURE);
+    expect_error(1, NEU_ERR_PLUGIN_READ_FAILURE);
+    expect_value(2);
+    EXPECT_EQ(1, dev.sent[1]);
+    EXPECT_EQ(0u, n_excludes());
+    EXPECT_FALSE(dev.disconnected);
+
+    // probed once
+    scan();
+    expect_error(0, NEU_ERR_PLUGIN_READ_FAILURE);
+    expect_value(2);
+    EXPECT_EQ(1, dev.sent[1]);
+    EXPECT_EQ(2, dev.sent[0]);
+}
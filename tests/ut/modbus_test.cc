@@ -154,6 +154,147 @@ TEST(test_modbus_data_unwrap, should_return_right_data_value)
     EXPECT_EQ(0x44, *(bytes + 3));
 }
 
+static UT_array *hold_points(const uint16_t *addresses, int n,
+                             modbus_point_t *points)
+{
+    UT_array *tags = NULL;
+    utarray_new(tags, &ut_ptr_icd);
+
+    for (int i = 0; i < n; i++) {
+        modbus_point_t *p = &points[i];
+
+        p->slave_id      = 1;
+        p->area          = MODBUS_AREA_HOLD_REGISTER;
+        p->start_address = addresses[i];
+        p->n_register    = 1;
+        p->type          = NEU_TYPE_UINT16;
+        utarray_push_back(tags, &p);
+    }
+
+    return tags;
+}
+
+TEST(test_modbus_tag_sort, should_read_contiguous_tags_without_gap)
+{
+    uint16_t       addresses[] = { 100, 101, 103, 110 };
+    modbus_point_t points[4]   = {};
+    UT_array *     tags        = hold_points(addresses, 4, points);
+
+    modbus_read_cmd_sort_t *sort = modbus_tag_sort(tags, 250, 0, NULL);
+
+    EXPECT_EQ(3, sort->n_cmd);
+    EXPECT_EQ(100, sort->cmd[0].start_address);
+    EXPECT_EQ(2, sort->cmd[0].n_register);
+    EXPECT_EQ(103, sort->cmd[1].start_address);
+    EXPECT_EQ(110, sort->cmd[2].start_address);
+
+    modbus_tag_sort_free(sort);
+    utarray_free(tags);
+}
+
+TEST(test_modbus_tag_sort, should_read_through_small_gaps)
+{
+    uint16_t       addresses[] = { 100, 103, 110, 200 };
+    modbus_point_t points[4]   = {};
+    UT_array *     tags        = hold_points(addresses, 4, points);
+
+    modbus_read_cmd_sort_t *sort = modbus_tag_sort(tags, 250, 8, NULL);
+
+    EXPECT_EQ(2, sort->n_cmd);
+    EXPECT_EQ(100, sort->cmd[0].start_address);
+    EXPECT_EQ(11, sort->cmd[0].n_register);
+    EXPECT_EQ(3, utarray_len(sort->cmd[0].tags));
+    EXPECT_EQ(200, sort->cmd[1].start_address);
+    EXPECT_EQ(1, sort->cmd[1].n_register);
+
+    modbus_tag_sort_free(sort);
+    utarray_free(tags);
+}
+
+TEST(test_modbus_tag_sort, should_keep_commands_within_pdu)
+{
+    uint16_t       addresses[100] = {};
+    modbus_point_t points[100]    = {};
+
+    for (int i = 0; i < 100; i++) {
+        addresses[i] = i * 10;
+    }
+
+    UT_array *              tags = hold_points(addresses, 100, points);
+    modbus_read_cmd_sort_t *sort = modbus_tag_sort(tags, 250, 10, NULL);
+    uint32_t                n    = 0;
+
+    EXPECT_LT(sort->n_cmd, 100);
+    for (uint16_t i = 0; i < sort->n_cmd; i++) {
+        EXPECT_LT(sort->cmd[i].n_register * 2, 250);
+        n += utarray_len(sort->cmd[i].tags);
+    }
+    EXPECT_EQ(100, n);
+
+    modbus_tag_sort_free(sort);
+    utarray_free(tags);
+}
+
+TEST(test_modbus_tag_sort, should_not_read_through_excluded_range)
+{
+    uint16_t       addresses[] = { 100, 103, 110 };
+    modbus_point_t points[3]   = {};
+    UT_array *     tags        = hold_points(addresses, 3, points);
+    UT_array *     excludes    = NULL;
+    modbus_range_t range       = {
+        .slave_id = 1,
+        .area     = MODBUS_AREA_HOLD_REGISTER,
+        .start    = 104,
+        .end      = 108,
+    };
+
+    utarray_new(excludes, modbus_range_icd());
+    utarray_push_back(excludes, &range);
+
+    modbus_read_cmd_sort_t *sort = modbus_tag_sort(tags, 250, 8, excludes);
+
+    EXPECT_EQ(2, sort->n_cmd);
+    EXPECT_EQ(100, sort->cmd[0].start_address);
+    EXPECT_EQ(4, sort->cmd[0].n_register);
+    EXPECT_EQ(110, sort->cmd[1].start_address);
+
+    modbus_tag_sort_free(sort);
+    utarray_free(excludes);
+    utarray_free(tags);
+}
+
+TEST(test_modbus_read_cmd_exclude_gaps, should_return_unused_registers)
+{
+    uint16_t       addresses[] = { 100, 103, 110 };
+    modbus_point_t points[3]   = {};
+    UT_array *     tags        = hold_points(addresses, 3, points);
+    UT_array *     excludes    = NULL;
+
+    points[1].n_register = 2;
+    utarray_new(excludes, modbus_range_icd());
+
+    modbus_read_cmd_sort_t *sort = modbus_tag_sort(tags, 250, 8, NULL);
+    ASSERT_EQ(1, sort->n_cmd);
+
+    EXPECT_EQ(2, modbus_read_cmd_exclude_gaps(&sort->cmd[0], excludes));
+    ASSERT_EQ(2, utarray_len(excludes));
+
+    modbus_range_t *gap = (modbus_range_t *) utarray_eltptr(excludes, 0);
+    EXPECT_EQ(101, gap->start);
+    EXPECT_EQ(103, gap->end);
+    gap = (modbus_range_t *) utarray_eltptr(excludes, 1);
+    EXPECT_EQ(105, gap->start);
+    EXPECT_EQ(110, gap->end);
+
+    modbus_read_cmd_sort_t *replan = modbus_tag_sort(tags, 250, 8, excludes);
+    EXPECT_EQ(3, replan->n_cmd);
+
+    modbus_tag_sort_free(replan);
+    modbus_tag_sort_free(sort);
+    utarray_free(excludes);
+    utarray_free(tags);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
@@ -0,0 +1,100 @@
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "mqtt_batch.h"
+}
+
+struct published {
+    std::string topic;
+    std::string payload;
+    uint32_t    n_msg;
+};
+
+static void flush_cb(void *ctx, const char *topic, char *payload, size_t len,
+                     uint32_t n_msg)
+{
+    std::vector<published> *out = (std::vector<published> *) ctx;
+
+    EXPECT_EQ(len, strlen(payload));
+    out->push_back({ topic, std::string(payload, len), n_msg });
+    free(payload);
+}
+
+static int add(mqtt_batch_t *batch, const char *topic, const char *msg)
+{
+    return mqtt_batch_add(batch, topic, msg, strlen(msg));
+}
+
+TEST(MqttBatchTest, FlushPerTopic)
+{
+    std::vector<published> out;
+    mqtt_batch_t *         batch = mqtt_batch_new(1024, flush_cb, &out);
+
+    mqtt_batch_flush(batch);
+    EXPECT_EQ(0, out.size());
+
+    EXPECT_EQ(0, add(batch, "/a", "{\"group\":\"g1\"}"));
+    EXPECT_EQ(0, add(batch, "/b", "{\"group\":\"g2\"}"));
+    EXPECT_EQ(0, add(batch, "/a", "{\"group\":\"g3\"}"));
+    EXPECT_EQ(0, out.size());
+
+    mqtt_batch_flush(batch);
+    ASSERT_EQ(2, out.size());
+    for (const published &p : out) {
+        if (p.topic == "/a") {
+            EXPECT_EQ("[{\"group\":\"g1\"},{\"group\":\"g3\"}]", p.payload);
+            EXPECT_EQ(2, p.n_msg);
+        } else {
+            EXPECT_EQ("/b", p.topic);
+            EXPECT_EQ("[{\"group\":\"g2\"}]", p.payload);
+            EXPECT_EQ(1, p.n_msg);
+        }
+    }
+
+    // nothing left
+    mqtt_batch_flush(batch);
+    EXPECT_EQ(2, out.size());
+
+    EXPECT_EQ(0, add(batch, "/a", "{}"));
+    mqtt_batch_flush(batch);
+    ASSERT_EQ(3, out.size());
+    EXPECT_EQ("[{}]", out[2].payload);
+
+    mqtt_batch_free(batch);
+}
+
+TEST(MqttBatchTest, SizeLimit)
+{
+    std::vector<published> out;
+    mqtt_batch_t *         batch = mqtt_batch_new(64, flush_cb, &out);
+    std::string            msg   = "{\"v\":\"" + std::string(20, 'x') + "\"}";
+
+    // [msg,msg] is 59 bytes, a third message would not fit
+    EXPECT_EQ(0, add(batch, "/a", msg.c_str()));
+    EXPECT_EQ(0, add(batch, "/a", msg.c_str()));
+    EXPECT_EQ(0, out.size());
+    EXPECT_EQ(0, add(batch, "/a", msg.c_str()));
+    ASSERT_EQ(1, out.size());
+    EXPECT_EQ("[" + msg + "," + msg + "]", out[0].payload);
+    EXPECT_EQ(2, out[0].n_msg);
+
+    // a message over the limit goes out alone, after the pending one
+    std::string big = "{\"v\":\"" + std::string(100, 'y') + "\"}";
+    EXPECT_EQ(0, add(batch, "/a", big.c_str()));
+    ASSERT_EQ(3, out.size());
+    EXPECT_EQ("[" + msg + "]", out[1].payload);
+    EXPECT_EQ("[" + big + "]", out[2].payload);
+
+    mqtt_batch_flush(batch);
+    EXPECT_EQ(3, out.size());
+
+    // pending messages are dropped
+    EXPECT_EQ(0, add(batch, "/a", msg.c_str()));
+    mqtt_batch_free(batch);
+    EXPECT_EQ(3, out.size());
+}
@@ -0,0 +1,258 @@
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "connection/mqtt_store.h"
+#include "utils/log.h"
+
+zlog_category_t *neuron = NULL;
+
+#define STORE_DIR "./mqtt-store-test"
+#define MEM_BYTES (2 * 4096)
+
+static std::string payload_of(int i, size_t len)
+{
+    std::string s = std::to_string(i);
+
+    s.resize(len, 'x');
+    return s;
+}
+
+static void push(neu_mqtt_store_t *store, int i, size_t len)
+{
+    std::string p = payload_of(i, len);
+
+    ASSERT_EQ(0,
+              neu_mqtt_store_push(store, 1, "/neuron/test",
+                                  (const uint8_t *) p.data(), p.size()));
+}
+
+// read and consume every message, returns their payloads
+static std::vector<std::string> drain(neu_mqtt_store_t *store)
+{
+    std::vector<std::string> msgs;
+
+    while (neu_mqtt_store_count(store) > 0) {
+        uint32_t             cursor = 0;
+        size_t               n      = 0;
+        neu_mqtt_store_msg_t msg    = {};
+
+        while (0 == neu_mqtt_store_read(store, &cursor, &msg)) {
+            EXPECT_STREQ("/neuron/test", msg.topic);
+            EXPECT_EQ(1, msg.qos);
+            msgs.emplace_back((const char *) msg.payload, msg.len);
+            n += 1;
+        }
+        if (n == 0) {
+            break;
+        }
+        neu_mqtt_store_pop(store, n);
+    }
+
+    return msgs;
+}
+
+static size_t seg_files()
+{
+    size_t         n   = 0;
+    DIR *          dir = opendir(STORE_DIR);
+    struct dirent *ent = NULL;
+
+    while (dir != NULL && (ent = readdir(dir)) != NULL) {
+        n += 0 == strncmp(ent->d_name, "seg-", 4);
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    return n;
+}
+
+class MqttStoreTest : public ::testing::Test {
+  protected:
+    void SetUp() override
+    {
+        neu_mqtt_store_destroy(
+            neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL));
+    }
+
+    void TearDown() override
+    {
+        neu_mqtt_store_destroy(
+            neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL));
+    }
+};
+
+TEST_F(MqttStoreTest, Order)
+{
+    neu_mqtt_store_t *store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+
+    for (int i = 0; i < 200; i++) {
+        push(store, i, 100);
+    }
+    EXPECT_EQ(200, neu_mqtt_store_count(store));
+    EXPECT_LE(2, seg_files());
+
+    std::vector<std::string> msgs = drain(store);
+    ASSERT_EQ(200, msgs.size());
+    for (int i = 0; i < 200; i++) {
+        EXPECT_EQ(payload_of(i, 100), msgs[i]);
+    }
+
+    // consumed segments are removed but the last one
+    EXPECT_EQ(1, seg_files());
+    EXPECT_EQ(0, neu_mqtt_store_dropped(store));
+
+    push(store, 7, 10);
+    msgs = drain(store);
+    ASSERT_EQ(1, msgs.size());
+    EXPECT_EQ(payload_of(7, 10), msgs[0]);
+
+    neu_mqtt_store_close(store);
+}
+
+TEST_F(MqttStoreTest, ReadWithoutPop)
+{
+    uint32_t             cursor = 0;
+    neu_mqtt_store_msg_t msg    = {};
+    neu_mqtt_store_t *   store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+
+    EXPECT_EQ(-1, neu_mqtt_store_read(store, &cursor, &msg));
+
+    push(store, 0, 10);
+    push(store, 1, 10);
+    ASSERT_EQ(0, neu_mqtt_store_read(store, &cursor, &msg));
+    ASSERT_EQ(0, neu_mqtt_store_read(store, &cursor, &msg));
+    EXPECT_EQ(-1, neu_mqtt_store_read(store, &cursor, &msg));
+
+    // a failed batch is read again from the start
+    neu_mqtt_store_pop(store, 1);
+    cursor = 0;
+    ASSERT_EQ(0, neu_mqtt_store_read(store, &cursor, &msg));
+    EXPECT_EQ(payload_of(1, 10), std::string((const char *) msg.payload,
+                                             msg.len));
+
+    neu_mqtt_store_close(store);
+}
+
+TEST_F(MqttStoreTest, DiskBudget)
+{
+    uint64_t          gen = 0;
+    neu_mqtt_store_t *store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 4 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+    gen = neu_mqtt_store_generation(store);
+
+    for (int i = 0; i < 1000; i++) {
+        push(store, i, 100);
+        EXPECT_LE(neu_mqtt_store_disk_used(store), 4 * 4096);
+    }
+    EXPECT_LE(seg_files(), 4);
+    EXPECT_NE(gen, neu_mqtt_store_generation(store));
+    EXPECT_EQ(1000,
+              neu_mqtt_store_count(store) + neu_mqtt_store_dropped(store));
+
+    // the newest messages are kept in order
+    std::vector<std::string> msgs = drain(store);
+    ASSERT_FALSE(msgs.empty());
+    int first = 1000 - (int) msgs.size();
+    for (size_t i = 0; i < msgs.size(); i++) {
+        EXPECT_EQ(payload_of(first + i, 100), msgs[i]);
+    }
+
+    neu_mqtt_store_close(store);
+}
+
+TEST_F(MqttStoreTest, Oversized)
+{
+    neu_mqtt_store_t *store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 8 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+
+    push(store, 0, 10);
+    push(store, 1, 3 * 4096);
+    push(store, 2, 10);
+
+    std::vector<std::string> msgs = drain(store);
+    ASSERT_EQ(3, msgs.size());
+    EXPECT_EQ(payload_of(1, 3 * 4096), msgs[1]);
+
+    std::string p(8 * 4096, 'x');
+    EXPECT_EQ(-1,
+              neu_mqtt_store_push(store, 0, "/neuron/test",
+                                  (const uint8_t *) p.data(), p.size()));
+
+    neu_mqtt_store_close(store);
+}
+
+TEST_F(MqttStoreTest, Reopen)
+{
+    neu_mqtt_store_t *store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+
+    for (int i = 0; i < 100; i++) {
+        push(store, i, 100);
+    }
+    neu_mqtt_store_pop(store, 30);
+    neu_mqtt_store_close(store);
+
+    store = neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+    EXPECT_EQ(70, neu_mqtt_store_count(store));
+
+    push(store, 100, 100);
+    std::vector<std::string> msgs = drain(store);
+    ASSERT_EQ(71, msgs.size());
+    for (int i = 0; i < 71; i++) {
+        EXPECT_EQ(payload_of(30 + i, 100), msgs[i]);
+    }
+
+    neu_mqtt_store_close(store);
+}
+
+TEST_F(MqttStoreTest, ReopenTorn)
+{
+    std::string       path;
+    neu_mqtt_store_t *store =
+        neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+
+    for (int i = 0; i < 10; i++) {
+        push(store, i, 100);
+    }
+    neu_mqtt_store_close(store);
+
+    // corrupt the payload of the last message
+    DIR *          dir = opendir(STORE_DIR);
+    struct dirent *ent = NULL;
+    while ((ent = readdir(dir)) != NULL) {
+        if (0 == strncmp(ent->d_name, "seg-", 4)) {
+            path = std::string(STORE_DIR "/") + ent->d_name;
+        }
+    }
+    closedir(dir);
+
+    FILE *fp = fopen(path.c_str(), "r+");
+    ASSERT_NE(nullptr, fp);
+    uint32_t write_off = 0;
+    fseek(fp, 16, SEEK_SET);
+    ASSERT_EQ(1, fread(&write_off, sizeof(write_off), 1, fp));
+    fseek(fp, write_off - 10, SEEK_SET);
+    fputc('y', fp);
+    fclose(fp);
+
+    store = neu_mqtt_store_open(STORE_DIR, MEM_BYTES, 16 * 4096, NULL);
+    ASSERT_NE(nullptr, store);
+    EXPECT_EQ(9, neu_mqtt_store_count(store));
+    EXPECT_EQ(9, drain(store).size());
+
+    neu_mqtt_store_close(store);
+}
@@ -0,0 +1,180 @@
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/msg_q.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static neu_msg_t *new_msg(uintptr_t seq, const char *group = NULL)
+{
+    neu_reqresp_trans_data_t data = {};
+
+    data.driver = (char *) "driver";
+    data.group  = (char *) group;
+    return neu_msg_new(NEU_REQRESP_TRANS_DATA, (void *) seq, &data);
+}
+
+static uintptr_t pop_seq(adapter_msg_q_t *q)
+{
+    neu_msg_t *msg = NULL;
+
+    adapter_msg_q_pop(q, &msg, NULL);
+
+    neu_reqresp_head_t *header = (neu_reqresp_head_t *) neu_msg_get_header(msg);
+    uintptr_t           seq    = (uintptr_t) header->ctx;
+
+    neu_msg_free(msg);
+    return seq;
+}
+
+static uint32_t depth(adapter_msg_q_t *q)
+{
+    adapter_msg_q_stats_t stats = {};
+
+    adapter_msg_q_stats(q, &stats);
+    return stats.depth;
+}
+
+static uint64_t drops(adapter_msg_q_t *q)
+{
+    adapter_msg_q_stats_t stats = {};
+
+    adapter_msg_q_stats(q, &stats);
+    return stats.drops;
+}
+
+TEST(MsgQTest, policy_parse)
+{
+    adapter_msg_q_policy_e policy = ADAPTER_MSG_Q_DROP_NEWEST;
+
+    EXPECT_EQ(0, adapter_msg_q_policy_parse("drop_oldest", &policy));
+    EXPECT_EQ(ADAPTER_MSG_Q_DROP_OLDEST, policy);
+    EXPECT_EQ(0, adapter_msg_q_policy_parse("coalesce", &policy));
+    EXPECT_EQ(ADAPTER_MSG_Q_COALESCE, policy);
+    EXPECT_EQ(0, adapter_msg_q_policy_parse("drop_newest", &policy));
+    EXPECT_EQ(ADAPTER_MSG_Q_DROP_NEWEST, policy);
+    EXPECT_EQ(-1, adapter_msg_q_policy_parse("lifo", &policy));
+}
+
+TEST(MsgQTest, drop_newest)
+{
+    adapter_msg_q_t *q = adapter_msg_q_new("app", 4);
+
+    for (uintptr_t i = 0; i < 4; i++) {
+        EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(i)));
+    }
+    neu_msg_t *full = new_msg(4);
+    EXPECT_EQ(-1, adapter_msg_q_push(q, full));
+    neu_msg_free(full);
+    EXPECT_EQ(4, depth(q));
+    EXPECT_EQ(1, drops(q));
+
+    for (uintptr_t i = 0; i < 4; i++) {
+        EXPECT_EQ(i, pop_seq(q));
+    }
+    EXPECT_EQ(0, depth(q));
+
+    // left in the queue, freed with it
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(5)));
+    adapter_msg_q_free(q);
+}
+
+TEST(MsgQTest, drop_oldest)
+{
+    adapter_msg_q_t *q = adapter_msg_q_new("app", 4);
+
+    adapter_msg_q_set_policy(q, ADAPTER_MSG_Q_DROP_OLDEST);
+    for (uintptr_t i = 0; i < 10; i++) {
+        EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(i)));
+    }
+    EXPECT_EQ(4, depth(q));
+    EXPECT_EQ(6, drops(q));
+
+    for (uintptr_t i = 6; i < 10; i++) {
+        EXPECT_EQ(i, pop_seq(q));
+    }
+
+    adapter_msg_q_free(q);
+}
+
+TEST(MsgQTest, coalesce)
+{
+    adapter_msg_q_t *q = adapter_msg_q_new("app", 2);
+
+    adapter_msg_q_set_policy(q, ADAPTER_MSG_Q_COALESCE);
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(0, "g1")));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(1, "g2")));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(2, "g1")));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(3, "g1")));
+    // no room for a third group
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(4, "g3")));
+    EXPECT_EQ(2, depth(q));
+    EXPECT_EQ(3, drops(q));
+
+    // g1 keeps its place in the queue with the latest snapshot
+    EXPECT_EQ(3, pop_seq(q));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(5, "g1")));
+    EXPECT_EQ(1, pop_seq(q));
+    EXPECT_EQ(5, pop_seq(q));
+
+    // messages without a group are queued as is
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(6)));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(7, "g2")));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(8, "g2")));
+    EXPECT_EQ(6, pop_seq(q));
+    EXPECT_EQ(0, adapter_msg_q_push(q, new_msg(9, "g1")));
+
+    adapter_msg_q_free(q);
+}
+
+struct producer_arg {
+    adapter_msg_q_t *q;
+    uintptr_t        base;
+    uintptr_t        n;
+};
+
+static void *produce(void *arg)
+{
+    producer_arg *p = (producer_arg *) arg;
+
+    for (uintptr_t i = 0; i < p->n; i++) {
+        neu_msg_t *msg = new_msg(p->base + i);
+        while (adapter_msg_q_push(p->q, msg) != 0) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+TEST(MsgQTest, producers)
+{
+    adapter_msg_q_t *q = adapter_msg_q_new("app", 64);
+    producer_arg     args[4];
+    pthread_t        tids[4];
+    uintptr_t        next[4] = { 0 };
+
+    for (int i = 0; i < 4; i++) {
+        args[i] = { q, (uintptr_t) i << 32, 10000 };
+        pthread_create(&tids[i], NULL, produce, &args[i]);
+    }
+
+    for (int i = 0; i < 4 * 10000; i++) {
+        uintptr_t seq = pop_seq(q);
+        int       p   = seq >> 32;
+
+        // each producer is received in order
+        ASSERT_EQ(next[p], seq & 0xffffffff);
+        next[p] += 1;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    EXPECT_EQ(0, depth(q));
+    adapter_msg_q_free(q);
+}
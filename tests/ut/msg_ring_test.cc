@@ -0,0 +1,201 @@
+#include <poll.h>
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/msg_ring.h"
+#include "errcodes.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static neu_msg_t *new_msg(uintptr_t seq)
+{
+    neu_reqresp_trans_data_t data = {};
+
+    return neu_msg_new(NEU_REQRESP_TRANS_DATA, (void *) seq, &data);
+}
+
+static uintptr_t msg_seq(neu_msg_t *msg)
+{
+    neu_reqresp_head_t *header = (neu_reqresp_head_t *) neu_msg_get_header(msg);
+    uintptr_t           seq    = (uintptr_t) header->ctx;
+
+    neu_msg_free(msg);
+    return seq;
+}
+
+static bool readable(int fd)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    return poll(&pfd, 1, 0) == 1;
+}
+
+TEST(MsgRingTest, no_inbox)
+{
+    adapter_msg_outbox_t *outbox = adapter_msg_outbox_new("driver");
+    neu_msg_t *           msg    = new_msg(0);
+
+    EXPECT_EQ(NEU_ERR_NODE_NOT_EXIST,
+              adapter_msg_outbox_send(outbox, 60001, msg));
+    neu_msg_free(msg);
+    adapter_msg_outbox_free(outbox);
+}
+
+TEST(MsgRingTest, fifo_and_wakeup)
+{
+    adapter_msg_inbox_t * inbox  = adapter_msg_inbox_new("app", 60002, 4);
+    adapter_msg_outbox_t *outbox = adapter_msg_outbox_new("driver");
+
+    ASSERT_NE(nullptr, inbox);
+    EXPECT_EQ(nullptr, adapter_msg_inbox_new("app2", 60002, 4));
+    EXPECT_FALSE(readable(adapter_msg_inbox_fd(inbox)));
+
+    for (uintptr_t i = 0; i < 4; i++) {
+        EXPECT_EQ(0, adapter_msg_outbox_send(outbox, 60002, new_msg(i)));
+    }
+    neu_msg_t *full = new_msg(4);
+    EXPECT_EQ(NEU_ERR_EINTERNAL, adapter_msg_outbox_send(outbox, 60002, full));
+    neu_msg_free(full);
+
+    EXPECT_TRUE(readable(adapter_msg_inbox_fd(inbox)));
+    adapter_msg_inbox_ack(inbox);
+    EXPECT_FALSE(readable(adapter_msg_inbox_fd(inbox)));
+
+    for (uintptr_t i = 0; i < 4; i++) {
+        neu_msg_t *msg = adapter_msg_inbox_pop(inbox);
+        ASSERT_NE(nullptr, msg);
+        EXPECT_EQ(i, msg_seq(msg));
+    }
+    EXPECT_EQ(nullptr, adapter_msg_inbox_pop(inbox));
+
+    // left in the ring, freed with the ring
+    EXPECT_EQ(0, adapter_msg_outbox_send(outbox, 60002, new_msg(5)));
+    EXPECT_TRUE(readable(adapter_msg_inbox_fd(inbox)));
+    adapter_msg_inbox_free(inbox);
+
+    neu_msg_t *msg = new_msg(6);
+    EXPECT_EQ(NEU_ERR_NODE_NOT_EXIST,
+              adapter_msg_outbox_send(outbox, 60002, msg));
+    neu_msg_free(msg);
+    adapter_msg_outbox_free(outbox);
+}
+
+TEST(MsgRingTest, inbox_recreated)
+{
+    adapter_msg_inbox_t * inbox  = adapter_msg_inbox_new("app", 60004, 4);
+    adapter_msg_outbox_t *outbox = adapter_msg_outbox_new("driver");
+
+    ASSERT_NE(nullptr, inbox);
+    EXPECT_EQ(0, adapter_msg_outbox_send(outbox, 60004, new_msg(0)));
+    adapter_msg_inbox_free(inbox);
+
+    // the cached ring is closed, the send attaches to the new inbox
+    inbox = adapter_msg_inbox_new("app", 60004, 4);
+    ASSERT_NE(nullptr, inbox);
+    EXPECT_EQ(0, adapter_msg_outbox_send(outbox, 60004, new_msg(1)));
+
+    neu_msg_t *msg = adapter_msg_inbox_pop(inbox);
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(1u, msg_seq(msg));
+    EXPECT_EQ(nullptr, adapter_msg_inbox_pop(inbox));
+
+    adapter_msg_outbox_free(outbox);
+    adapter_msg_inbox_free(inbox);
+}
+
+TEST(MsgRingTest, outbox_freed)
+{
+    adapter_msg_inbox_t *inbox = adapter_msg_inbox_new("app", 60005, 4);
+
+    ASSERT_NE(nullptr, inbox);
+
+    // the ring of a freed producer is drained, then its slot is reused
+    for (uintptr_t i = 0; i < 2 * ADAPTER_MSG_RING_MAX_PRODUCER; i++) {
+        adapter_msg_outbox_t *outbox = adapter_msg_outbox_new("driver");
+
+        ASSERT_EQ(0, adapter_msg_outbox_send(outbox, 60005, new_msg(i)));
+        adapter_msg_outbox_free(outbox);
+
+        EXPECT_TRUE(readable(adapter_msg_inbox_fd(inbox)));
+        adapter_msg_inbox_ack(inbox);
+        neu_msg_t *msg = adapter_msg_inbox_pop(inbox);
+        ASSERT_NE(nullptr, msg);
+        EXPECT_EQ(i, msg_seq(msg));
+        EXPECT_EQ(nullptr, adapter_msg_inbox_pop(inbox));
+    }
+
+    // a message left by a freed producer is freed with the inbox
+    adapter_msg_outbox_t *outbox = adapter_msg_outbox_new("driver");
+    EXPECT_EQ(0, adapter_msg_outbox_send(outbox, 60005, new_msg(0)));
+    adapter_msg_outbox_free(outbox);
+    adapter_msg_inbox_free(inbox);
+}
+
+struct producer_arg {
+    adapter_msg_outbox_t *outbox;
+    uint16_t              port;
+    uintptr_t             base;
+    uintptr_t             n;
+};
+
+static void *produce(void *arg)
+{
+    producer_arg *p = (producer_arg *) arg;
+
+    for (uintptr_t i = 0; i < p->n; i++) {
+        neu_msg_t *msg = new_msg(p->base + i);
+        while (adapter_msg_outbox_send(p->outbox, p->port, msg) != 0) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+TEST(MsgRingTest, producers)
+{
+    adapter_msg_inbox_t * inbox = adapter_msg_inbox_new("app", 60003, 64);
+    adapter_msg_outbox_t *outboxes[2];
+    producer_arg          args[4];
+    pthread_t             tids[4];
+    uintptr_t             next[4]  = { 0 };
+    uintptr_t             received = 0;
+
+    ASSERT_NE(nullptr, inbox);
+    // two producers with two threads each
+    for (int i = 0; i < 2; i++) {
+        outboxes[i] = adapter_msg_outbox_new("driver");
+    }
+    for (int i = 0; i < 4; i++) {
+        args[i] = { outboxes[i / 2], 60003, (uintptr_t) i << 32, 10000 };
+        pthread_create(&tids[i], NULL, produce, &args[i]);
+    }
+
+    while (received < 4 * 10000) {
+        struct pollfd pfd = { adapter_msg_inbox_fd(inbox), POLLIN, 0 };
+        neu_msg_t *   msg = NULL;
+
+        poll(&pfd, 1, 100);
+        adapter_msg_inbox_ack(inbox);
+        while ((msg = adapter_msg_inbox_pop(inbox)) != NULL) {
+            uintptr_t seq = msg_seq(msg);
+            int       p   = seq >> 32;
+
+            // each thread is received in order
+            ASSERT_EQ(next[p], seq & 0xffffffff);
+            next[p] += 1;
+            received += 1;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    for (int i = 0; i < 2; i++) {
+        adapter_msg_outbox_free(outboxes[i]);
+    }
+    adapter_msg_inbox_free(inbox);
+}
@@ -0,0 +1,198 @@
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "tag.h"
+
+#include "adapter/driver/delta.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static neu_tag_names_t *make_names(int n)
+{
+    UT_array *       tags  = NULL;
+    neu_tag_names_t *names = NULL;
+    char             name[NEU_TAG_NAME_LEN] = { 0 };
+
+    utarray_new(tags, neu_tag_get_icd());
+    for (int i = 0; i < n; i++) {
+        neu_datatag_t tag = {};
+
+        snprintf(name, sizeof(name), "tag%d", i);
+        tag.name        = name;
+        tag.address     = (char *) "1!400001";
+        tag.description = (char *) "";
+        utarray_push_back(tags, &tag);
+    }
+
+    names = neu_tag_names_new(tags);
+    utarray_free(tags);
+    return names;
+}
+
+static neu_tag_values_t *make_values(neu_tag_names_t *names,
+                                     const double *   v)
+{
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+
+    for (uint32_t i = 0; i < neu_tag_names_size(names); i++) {
+        neu_dvalue_t value = {};
+
+        value.type      = NEU_TYPE_DOUBLE;
+        value.value.d64 = v[i];
+        neu_tag_values_push(values, i, &value, NULL, 0);
+    }
+
+    return values;
+}
+
+static uint32_t report_size(neu_report_delta_t *delta,
+                            neu_tag_names_t *names, const double *v,
+                            int64_t now)
+{
+    neu_tag_values_t *values = make_values(names, v);
+    neu_tag_values_t *report = neu_report_delta_filter(delta, values, now);
+    uint32_t          size   = report ? neu_tag_values_size(report) : 0;
+
+    neu_tag_values_unref(report);
+    neu_tag_values_unref(values);
+    return size;
+}
+
+TEST(ReportDeltaTest, params)
+{
+    EXPECT_EQ(NULL, neu_report_delta_new(NULL));
+    EXPECT_EQ(NULL, neu_report_delta_new("{\"topic\": \"/neuron\"}"));
+    EXPECT_EQ(NULL, neu_report_delta_new("{\"delta\": {\"keyframe\": -1}}"));
+
+    neu_report_delta_t *delta = neu_report_delta_new("{\"delta\": {}}");
+    EXPECT_NE(nullptr, delta);
+    neu_report_delta_free(delta);
+}
+
+TEST(ReportDeltaTest, changed_only)
+{
+    neu_tag_names_t *   names = make_names(3);
+    neu_report_delta_t *delta =
+        neu_report_delta_new("{\"topic\": \"t\", \"delta\": {}}");
+    double v[3] = { 1, 2, 3 };
+
+    ASSERT_NE(nullptr, delta);
+    EXPECT_EQ(3, report_size(delta, names, v, 0));
+    EXPECT_EQ(0, report_size(delta, names, v, 1000));
+
+    v[1] = 2.5;
+    EXPECT_EQ(1, report_size(delta, names, v, 2000));
+    EXPECT_EQ(0, report_size(delta, names, v, 3000));
+
+    v[2] = -1;
+
+    neu_tag_values_t *values = make_values(names, v);
+    neu_tag_values_t *report = neu_report_delta_filter(delta, values, 4000);
+    neu_dvalue_t      value  = {};
+
+    ASSERT_NE(nullptr, report);
+    ASSERT_EQ(1, neu_tag_values_size(report));
+    EXPECT_STREQ("tag2", neu_tag_values_name(report, 0));
+    neu_tag_values_get(report, 0, &value);
+    EXPECT_EQ(-1, value.value.d64);
+
+    neu_tag_values_unref(report);
+    neu_tag_values_unref(values);
+    neu_report_delta_free(delta);
+    neu_tag_names_unref(names);
+}
+
+TEST(ReportDeltaTest, deadband)
+{
+    neu_tag_names_t *   names = make_names(2);
+    neu_report_delta_t *delta = neu_report_delta_new(
+        "{\"delta\": {\"deadband\": 1.0, \"deadbands\": [{\"name\": \"tag1\", "
+        "\"deadband\": 10}]}}");
+    double v[2] = { 0, 0 };
+
+    ASSERT_NE(nullptr, delta);
+    EXPECT_EQ(2, report_size(delta, names, v, 0));
+
+    v[0] = 0.5;
+    v[1] = 5;
+    EXPECT_EQ(0, report_size(delta, names, v, 1));
+
+    // compared with the last reported value, not the last read one
+    v[0] = 1.2;
+    EXPECT_EQ(1, report_size(delta, names, v, 2));
+
+    v[1] = 10.5;
+    EXPECT_EQ(1, report_size(delta, names, v, 3));
+
+    neu_report_delta_free(delta);
+    neu_tag_names_unref(names);
+}
+
+TEST(ReportDeltaTest, quality)
+{
+    neu_tag_names_t *   names  = make_names(1);
+    neu_report_delta_t *delta  = neu_report_delta_new("{\"delta\": {}}");
+    neu_tag_values_t *  values = NULL;
+    neu_tag_values_t *  report = NULL;
+    neu_dvalue_t        value  = {};
+    double              v[1]   = { 7 };
+
+    ASSERT_NE(nullptr, delta);
+    EXPECT_EQ(1, report_size(delta, names, v, 0));
+
+    values          = neu_tag_values_new("modbus", "grp", names);
+    value.type      = NEU_TYPE_ERROR;
+    value.value.i32 = 3000;
+    neu_tag_values_push(values, 0, &value, NULL, 0);
+    report = neu_report_delta_filter(delta, values, 1);
+    EXPECT_EQ(values, report);
+    neu_tag_values_unref(report);
+    neu_tag_values_unref(values);
+
+    EXPECT_EQ(1, report_size(delta, names, v, 2));
+
+    neu_tag_meta_t metas[NEU_TAG_META_SIZE] = {};
+    strcpy(metas[0].name, "quality");
+    metas[0].value.type      = NEU_TYPE_INT32;
+    metas[0].value.value.i32 = 1;
+
+    values          = neu_tag_values_new("modbus", "grp", names);
+    value           = {};
+    value.type      = NEU_TYPE_DOUBLE;
+    value.value.d64 = 7;
+    neu_tag_values_push(values, 0, &value, metas, NEU_TAG_META_SIZE);
+    report = neu_report_delta_filter(delta, values, 3);
+    EXPECT_NE(nullptr, report);
+    neu_tag_values_unref(report);
+    neu_tag_values_unref(values);
+
+    neu_report_delta_free(delta);
+    neu_tag_names_unref(names);
+}
+
+TEST(ReportDeltaTest, keyframe)
+{
+    neu_tag_names_t *   names = make_names(2);
+    neu_report_delta_t *delta =
+        neu_report_delta_new("{\"delta\": {\"keyframe\": 10}}");
+    double v[2] = { 1, 2 };
+
+    ASSERT_NE(nullptr, delta);
+    EXPECT_EQ(2, report_size(delta, names, v, 0));
+    EXPECT_EQ(0, report_size(delta, names, v, 5000));
+    EXPECT_EQ(2, report_size(delta, names, v, 10000));
+    EXPECT_EQ(0, report_size(delta, names, v, 11000));
+
+    // a new name table of the group forces a full report
+    neu_tag_names_t *other = make_names(2);
+    EXPECT_EQ(2, report_size(delta, other, v, 12000));
+    EXPECT_EQ(0, report_size(delta, other, v, 13000));
+
+    neu_tag_names_unref(other);
+    neu_report_delta_free(delta);
+    neu_tag_names_unref(names);
+}
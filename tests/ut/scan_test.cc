@@ -0,0 +1,365 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "adapter/driver/scan.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+struct lane_probe {
+    std::atomic<int> *active;
+    std::atomic<int> *peak;
+    std::atomic<int>  runs;
+    useconds_t        sleep_us;
+};
+
+static void probe_cb(void *usr_data, const neu_scan_run_t *run)
+{
+    lane_probe *probe = (lane_probe *) usr_data;
+    int         n     = probe->active->fetch_add(1) + 1;
+    int         peak  = probe->peak->load();
+
+    (void) run;
+    while (n > peak && !probe->peak->compare_exchange_weak(peak, n)) {
+    }
+    usleep(probe->sleep_us);
+    probe->active->fetch_sub(1);
+    probe->runs.fetch_add(1);
+}
+
+static void count_cb(void *usr_data, const neu_scan_run_t *run)
+{
+    (void) run;
+    ((std::atomic<int> *) usr_data)->fetch_add(1);
+}
+
+TEST(ScanTest, lane_serialized)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(4);
+    std::atomic<int> active(0), peak(0);
+    lane_probe       probes[3];
+
+    ASSERT_NE(nullptr, pool);
+    for (auto &probe : probes) {
+        probe.active   = &active;
+        probe.peak     = &peak;
+        probe.runs     = 0;
+        probe.sleep_us = 20 * 1000;
+    }
+
+    // three groups on one lane never overlap even with free workers
+    neu_scan_job_t *jobs[3];
+    for (int i = 0; i < 3; i++) {
+        jobs[i] = neu_scan_pool_add(pool, 7, 10, NEU_EVENT_TIMER_NOBLOCK,
+                                    probe_cb, &probes[i]);
+    }
+    usleep(300 * 1000);
+    for (auto job : jobs) {
+        neu_scan_pool_del(pool, job);
+    }
+
+    EXPECT_EQ(1, peak.load());
+    for (auto &probe : probes) {
+        EXPECT_GE(probe.runs.load(), 2);
+    }
+
+    neu_scan_pool_free(pool);
+}
+
+TEST(ScanTest, lanes_concurrent)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(3);
+    std::atomic<int> active(0), peak(0);
+    lane_probe       probes[3];
+
+    ASSERT_NE(nullptr, pool);
+    neu_scan_job_t *jobs[3];
+    for (int i = 0; i < 3; i++) {
+        probes[i].active   = &active;
+        probes[i].peak     = &peak;
+        probes[i].runs     = 0;
+        probes[i].sleep_us = 60 * 1000;
+        jobs[i] = neu_scan_pool_add(pool, i, 100, NEU_EVENT_TIMER_NOBLOCK,
+                                    probe_cb, &probes[i]);
+    }
+
+    // a slow lane does not hold back the others
+    usleep(450 * 1000);
+    for (auto job : jobs) {
+        neu_scan_pool_del(pool, job);
+    }
+    EXPECT_EQ(3, peak.load());
+    for (auto &probe : probes) {
+        EXPECT_GE(probe.runs.load(), 3);
+    }
+
+    // one worker runs everything in turn
+    EXPECT_EQ(0, neu_scan_pool_set_workers(pool, 1));
+    EXPECT_EQ(1, neu_scan_pool_workers(pool));
+    EXPECT_EQ(-1, neu_scan_pool_set_workers(pool, 0));
+    EXPECT_EQ(-1, neu_scan_pool_set_workers(pool, NEU_SCAN_WORKERS_MAX + 1));
+
+    peak = 0;
+    for (int i = 0; i < 3; i++) {
+        probes[i].sleep_us = 10 * 1000;
+        jobs[i] = neu_scan_pool_add(pool, i, 20, NEU_EVENT_TIMER_NOBLOCK,
+                                    probe_cb, &probes[i]);
+    }
+    usleep(200 * 1000);
+    for (auto job : jobs) {
+        neu_scan_pool_del(pool, job);
+    }
+    EXPECT_EQ(1, peak.load());
+
+    neu_scan_pool_free(pool);
+}
+
+struct run_log {
+    std::mutex                  mtx;
+    std::vector<neu_scan_run_t> runs;
+    std::atomic<useconds_t>     sleep_us;
+};
+
+static void log_cb(void *usr_data, const neu_scan_run_t *run)
+{
+    run_log *log = (run_log *) usr_data;
+
+    {
+        std::lock_guard<std::mutex> lock(log->mtx);
+        log->runs.push_back(*run);
+    }
+    usleep(log->sleep_us);
+}
+
+TEST(ScanTest, overrun_schedule)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(2);
+    run_log          block, noblock;
+
+    ASSERT_NE(nullptr, pool);
+    block.sleep_us   = 70 * 1000;
+    noblock.sleep_us = 70 * 1000;
+
+    neu_scan_job_t *j1 = neu_scan_pool_add(pool, 1, 50, NEU_EVENT_TIMER_BLOCK,
+                                           log_cb, &block);
+    neu_scan_job_t *j2 = neu_scan_pool_add(
+        pool, 2, 50, NEU_EVENT_TIMER_NOBLOCK, log_cb, &noblock);
+    usleep(600 * 1000);
+    neu_scan_pool_del(pool, j1);
+    neu_scan_pool_del(pool, j2);
+
+    // a run is never queued twice, the deadline is one interval after due
+    ASSERT_GE(block.runs.size(), 3);
+    for (size_t i = 1; i < block.runs.size(); i++) {
+        EXPECT_EQ(block.runs[i].due + 50, block.runs[i].deadline);
+        // the period starts once the previous run ends
+        EXPECT_GE(block.runs[i].due - block.runs[i - 1].start, 50 + 70 - 2);
+    }
+
+    ASSERT_GE(noblock.runs.size(), 3);
+    for (size_t i = 1; i < noblock.runs.size(); i++) {
+        // keeps the phase and skips the period missed by each late run
+        EXPECT_EQ(100, noblock.runs[i].due - noblock.runs[i - 1].due);
+        EXPECT_GT(noblock.runs[i - 1].start + 70, noblock.runs[i - 1].deadline);
+    }
+
+    neu_scan_pool_free(pool);
+}
+
+TEST(ScanTest, trigger)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(1);
+    std::atomic<int> n(0);
+
+    ASSERT_NE(nullptr, pool);
+    neu_scan_job_t *job =
+        neu_scan_pool_add(pool, NEU_SCAN_LANE_DEFAULT, 0,
+                          NEU_EVENT_TIMER_NOBLOCK, count_cb, &n);
+
+    // on demand only
+    usleep(50 * 1000);
+    EXPECT_EQ(0, n.load());
+
+    neu_scan_pool_trigger(pool, job);
+    neu_scan_pool_trigger(pool, job);
+    usleep(50 * 1000);
+    EXPECT_LE(1, n.load());
+    EXPECT_GE(2, n.load());
+
+    int last = n.load();
+    usleep(50 * 1000);
+    EXPECT_EQ(last, n.load());
+
+    neu_scan_pool_del(pool, job);
+    neu_scan_pool_free(pool);
+}
+
+struct self_del {
+    neu_scan_pool_t *              pool;
+    std::atomic<neu_scan_job_t *> job;
+    std::atomic<int>               runs;
+};
+
+static void self_del_cb(void *usr_data, const neu_scan_run_t *run)
+{
+    self_del *ctx = (self_del *) usr_data;
+
+    (void) run;
+    ctx->runs.fetch_add(1);
+    neu_scan_pool_del(ctx->pool, ctx->job.load());
+}
+
+TEST(ScanTest, delete_while_running)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(2);
+    run_log          log;
+    self_del         ctx;
+
+    ASSERT_NE(nullptr, pool);
+    log.sleep_us = 100 * 1000;
+
+    // waits for the current run
+    neu_scan_job_t *job = neu_scan_pool_add(pool, 0, 10, NEU_EVENT_TIMER_BLOCK,
+                                            log_cb, &log);
+    usleep(50 * 1000);
+    neu_scan_pool_del(pool, job);
+    size_t n = log.runs.size();
+    usleep(100 * 1000);
+    EXPECT_EQ(1, n);
+    EXPECT_EQ(n, log.runs.size());
+
+    // deleted by itself
+    ctx.pool = pool;
+    ctx.runs = 0;
+    ctx.job  = neu_scan_pool_add(pool, 1, 50, NEU_EVENT_TIMER_NOBLOCK,
+                                self_del_cb, &ctx);
+    usleep(100 * 1000);
+    EXPECT_EQ(1, ctx.runs.load());
+
+    neu_scan_pool_free(pool);
+}
+
+TEST(ScanTest, policy_parse)
+{
+    neu_scan_policy_e policy = NEU_SCAN_POLICY_TIMER;
+
+    EXPECT_EQ(0, neu_scan_policy_parse("skip", &policy));
+    EXPECT_EQ(NEU_SCAN_POLICY_SKIP, policy);
+    EXPECT_EQ(0, neu_scan_policy_parse("phase", &policy));
+    EXPECT_EQ(NEU_SCAN_POLICY_PHASE, policy);
+    EXPECT_EQ(0, neu_scan_policy_parse("stretch", &policy));
+    EXPECT_EQ(NEU_SCAN_POLICY_STRETCH, policy);
+    EXPECT_EQ(0, neu_scan_policy_parse("timer", &policy));
+    EXPECT_EQ(NEU_SCAN_POLICY_TIMER, policy);
+    EXPECT_EQ(-1, neu_scan_policy_parse("fast", &policy));
+}
+
+TEST(ScanTest, policy_skip)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(1);
+    run_log          log;
+
+    ASSERT_NE(nullptr, pool);
+    neu_scan_pool_set_policy(pool, NEU_SCAN_POLICY_SKIP);
+    log.sleep_us = 0;
+
+    // BLOCK timers keep the phase too
+    neu_scan_job_t *job = neu_scan_pool_add(pool, 0, 40, NEU_EVENT_TIMER_BLOCK,
+                                            log_cb, &log);
+    usleep(100 * 1000);
+    log.sleep_us = 90 * 1000;
+    usleep(400 * 1000);
+    neu_scan_pool_del(pool, job);
+
+    ASSERT_GE(log.runs.size(), 4);
+    uint32_t skipped = 0;
+    for (size_t i = 1; i < log.runs.size(); i++) {
+        int64_t period = log.runs[i].due - log.runs[i - 1].due;
+
+        EXPECT_EQ(0, period % 40);
+        EXPECT_EQ(period / 40 - 1, log.runs[i].skipped);
+        EXPECT_GE(log.runs[i].jitter, 0);
+        skipped += log.runs[i].skipped;
+    }
+    EXPECT_EQ(-1, log.runs[0].jitter);
+    // each 90ms run misses two periods
+    EXPECT_LE(4, skipped);
+
+    neu_scan_pool_free(pool);
+}
+
+TEST(ScanTest, policy_phase)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(1);
+    run_log          log;
+    neu_scan_job_t * jobs[8];
+
+    ASSERT_NE(nullptr, pool);
+    neu_scan_pool_set_policy(pool, NEU_SCAN_POLICY_PHASE);
+    log.sleep_us = 0;
+
+    for (auto &job : jobs) {
+        job = neu_scan_pool_add(pool, 0, 200, NEU_EVENT_TIMER_BLOCK, log_cb,
+                                &log);
+    }
+    usleep(250 * 1000);
+    for (auto job : jobs) {
+        neu_scan_pool_del(pool, job);
+    }
+
+    // jobs added together are not due on the same tick
+    std::vector<int64_t> phases;
+    for (auto &run : log.runs) {
+        phases.push_back(run.due % 200);
+    }
+    std::sort(phases.begin(), phases.end());
+    phases.erase(std::unique(phases.begin(), phases.end()), phases.end());
+    ASSERT_EQ(8, phases.size());
+    for (size_t i = 1; i < phases.size(); i++) {
+        EXPECT_GE(phases[i] - phases[i - 1], 10);
+    }
+
+    neu_scan_pool_free(pool);
+}
+
+TEST(ScanTest, policy_stretch)
+{
+    neu_scan_pool_t *pool = neu_scan_pool_new(1);
+    run_log          log;
+
+    ASSERT_NE(nullptr, pool);
+    neu_scan_pool_set_policy(pool, NEU_SCAN_POLICY_STRETCH);
+    log.sleep_us = 60 * 1000;
+
+    neu_scan_job_t *job = neu_scan_pool_add(pool, 0, 20, NEU_EVENT_TIMER_BLOCK,
+                                            log_cb, &log);
+    usleep(400 * 1000);
+
+    // stretched to fit the slow runs with some headroom
+    {
+        std::lock_guard<std::mutex> lock(log.mtx);
+        ASSERT_GE(log.runs.size(), 3);
+        neu_scan_run_t &last = log.runs.back();
+        EXPECT_GE(last.interval, 60);
+        EXPECT_LE(last.interval, 20 * NEU_SCAN_STRETCH_MAX);
+        // stretching does not drop cycles
+        EXPECT_EQ(0, last.skipped);
+        log.sleep_us = 0;
+    }
+
+    // and back once they are fast
+    usleep(600 * 1000);
+    neu_scan_pool_del(pool, job);
+    EXPECT_EQ(20, log.runs.back().interval);
+    EXPECT_EQ(0, log.runs.back().skipped);
+
+    neu_scan_pool_free(pool);
+}
@@ -0,0 +1,214 @@
+#include <string>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "base/group.h"
+#include "errcodes.h"
+#include "parser/neu_tag_import.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+// feed in chunks of 1, 2, ... bytes so that records span chunks
+static int feed(neu_tag_import_t *imp, const std::string &s)
+{
+    size_t off = 0;
+
+    for (size_t n = 1; off < s.size(); n = n % 7 + 1) {
+        size_t len = std::min(n, s.size() - off);
+        int    rv  = neu_tag_import_feed(imp, s.data() + off, len);
+        if (0 != rv) {
+            return rv;
+        }
+        off += len;
+    }
+
+    return neu_tag_import_finish(imp);
+}
+
+static void free_tags(neu_datatag_t *tags, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        neu_tag_fini(&tags[i]);
+    }
+    free(tags);
+}
+
+TEST(TagImportTest, Json)
+{
+    std::string s = " [";
+    for (int i = 0; i < 100; i++) {
+        s += i > 0 ? ",\n" : "";
+        s += "{\"name\": \"tag" + std::to_string(i) +
+            "\", \"address\": \"1!400" + std::to_string(i) +
+            "\", \"attribute\": 1, \"type\": 3, "
+            "\"description\": \"a } \\\" [ b\"}";
+    }
+    s += ",{\"name\": \"static\", \"address\": \"\", \"attribute\": 8, "
+         "\"type\": 9, \"value\": 1.5}] ";
+
+    neu_tag_import_t *imp = neu_tag_import_new(NEU_TAG_IMPORT_JSON);
+    ASSERT_EQ(0, feed(imp, s));
+
+    uint32_t       n    = 0;
+    neu_datatag_t *tags = neu_tag_import_take(imp, &n);
+    neu_tag_import_free(imp);
+
+    ASSERT_EQ(101, n);
+    EXPECT_STREQ("tag42", tags[42].name);
+    EXPECT_STREQ("1!40042", tags[42].address);
+    EXPECT_STREQ("a } \" [ b", tags[42].description);
+    EXPECT_EQ(NEU_ATTRIBUTE_READ, tags[42].attribute);
+    EXPECT_EQ(NEU_TYPE_INT16, tags[42].type);
+
+    neu_value_u value = { 0 };
+    ASSERT_EQ(0, neu_tag_get_static_value(&tags[100], &value));
+    EXPECT_EQ(1.5, value.f32);
+
+    free_tags(tags, n);
+}
+
+TEST(TagImportTest, JsonMalformed)
+{
+    const char *bodies[] = {
+        "",
+        "{}",
+        "[{\"name\": \"a\", \"address\": \"1\", \"attribute\": 1, "
+        "\"type\": 3},]",
+        "[{\"name\": \"a\", \"address\": \"1\", \"attribute\": 1, "
+        "\"type\": 3} {\"name\": \"b\"}]",
+        "[{\"name\": \"a\", \"address\": \"1\", \"attribute\": 1, "
+        "\"type\": 3}, {\"name\": \"b\"}]",
+        "[{\"name\": \"a\", \"address\": \"1\", \"attribute\": 1, "
+        "\"type\": 3}",
+        "[] x",
+    };
+
+    for (const char *body : bodies) {
+        neu_tag_import_t *imp = neu_tag_import_new(NEU_TAG_IMPORT_JSON);
+        EXPECT_EQ(NEU_ERR_BODY_IS_WRONG, feed(imp, body)) << body;
+        EXPECT_GE(1, neu_tag_import_count(imp)) << body;
+        neu_tag_import_free(imp);
+    }
+
+    neu_tag_import_t *imp = neu_tag_import_new(NEU_TAG_IMPORT_JSON);
+    EXPECT_EQ(0, feed(imp, " [ ] "));
+    EXPECT_EQ(0, neu_tag_import_count(imp));
+    neu_tag_import_free(imp);
+}
+
+TEST(TagImportTest, Csv)
+{
+    std::string s = "\xEF\xBB\xBF"
+                    "type,name,address,attribute,description,value\r\n"
+                    "3,tag0,1!40001,1,\"a, \"\"quoted\"\"\nline\",\r\n"
+                    "\n"
+                    "9,static,,8,,1.5\n"
+                    "13,text,,8,,\"\"\"hello\"\"\"\n";
+    for (int i = 1; i < 100; i++) {
+        s += "3,tag" + std::to_string(i) + ",1!4000" + std::to_string(i) +
+            ",3,,\n";
+    }
+    s += "3,last,1!40100,1,,";
+
+    neu_tag_import_t *imp = neu_tag_import_new(NEU_TAG_IMPORT_CSV);
+    ASSERT_EQ(0, feed(imp, s));
+
+    uint32_t       n    = 0;
+    neu_datatag_t *tags = neu_tag_import_take(imp, &n);
+    neu_tag_import_free(imp);
+
+    ASSERT_EQ(103, n);
+    EXPECT_STREQ("tag0", tags[0].name);
+    EXPECT_STREQ("1!40001", tags[0].address);
+    EXPECT_STREQ("a, \"quoted\"\nline", tags[0].description);
+    EXPECT_EQ(NEU_TYPE_INT16, tags[0].type);
+    EXPECT_EQ(NEU_ATTRIBUTE_READ, tags[0].attribute);
+    EXPECT_EQ(0, tags[0].precision);
+
+    neu_value_u value = { 0 };
+    ASSERT_EQ(0, neu_tag_get_static_value(&tags[1], &value));
+    EXPECT_EQ(1.5, value.f32);
+    ASSERT_EQ(0, neu_tag_get_static_value(&tags[2], &value));
+    EXPECT_STREQ("hello", value.str);
+
+    EXPECT_STREQ("tag99", tags[101].name);
+    EXPECT_EQ(NEU_ATTRIBUTE_READ | NEU_ATTRIBUTE_WRITE, tags[101].attribute);
+    EXPECT_STREQ("", tags[101].description);
+    EXPECT_STREQ("last", tags[102].name);
+
+    free_tags(tags, n);
+}
+
+TEST(TagImportTest, CsvMalformed)
+{
+    const char *bodies[] = {
+        "",
+        "name,address,attribute\n",
+        "name,address,attribute,type,color\n",
+        "name,address,attribute,type,name\n",
+        "name,address,attribute,type\na,1,1\n",
+        "name,address,attribute,type\na,1,1,x\n",
+        "name,address,attribute,type\na,1,,3\n",
+        "name,address,attribute,type,precision\na,1,1,3,256\n",
+        "name,address,attribute,type,value\na,1,1,3,2\n",
+        "name,address,attribute,type,value\na,1,8,3,\n",
+        "name,address,attribute,type\n\"a\"x,1,1,3\n",
+        "name,address,attribute,type\n\"a,1,1,3\n",
+    };
+
+    for (const char *body : bodies) {
+        neu_tag_import_t *imp = neu_tag_import_new(NEU_TAG_IMPORT_CSV);
+        EXPECT_EQ(NEU_ERR_BODY_IS_WRONG, feed(imp, body)) << body;
+        EXPECT_EQ(0, neu_tag_import_count(imp)) << body;
+        neu_tag_import_free(imp);
+    }
+}
+
+static neu_datatag_t make_tag(const char *name)
+{
+    neu_datatag_t tag = {};
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) "1!40001";
+    tag.description = (char *) "";
+    tag.attribute   = NEU_ATTRIBUTE_READ;
+    tag.type        = NEU_TYPE_INT16;
+    return tag;
+}
+
+TEST(TagImportTest, GroupAddTags)
+{
+    neu_group_t * group   = neu_group_new("group", 1000);
+    neu_datatag_t tags[3] = { make_tag("a"), make_tag("b"), make_tag("c") };
+    uint32_t      index   = 0;
+
+    ASSERT_EQ(0, neu_group_add_tags(group, tags, 3, &index));
+    EXPECT_EQ(3, index);
+    EXPECT_EQ(3, neu_group_tag_size(group));
+    int64_t timestamp = neu_group_get_timestamp(group);
+
+    // nothing is added on conflict
+    neu_datatag_t more[3] = { make_tag("d"), make_tag("e"), make_tag("d") };
+    EXPECT_EQ(NEU_ERR_TAG_NAME_CONFLICT,
+              neu_group_add_tags(group, more, 3, &index));
+    EXPECT_EQ(2, index);
+    more[2] = make_tag("a");
+    EXPECT_EQ(NEU_ERR_TAG_NAME_CONFLICT,
+              neu_group_add_tags(group, more, 3, &index));
+    EXPECT_EQ(2, index);
+    EXPECT_EQ(3, neu_group_tag_size(group));
+    EXPECT_EQ(NULL, neu_group_find_tag(group, "d"));
+    EXPECT_FALSE(neu_group_is_change(group, timestamp));
+
+    more[2] = make_tag("f");
+    usleep(1000);
+    ASSERT_EQ(0, neu_group_add_tags(group, more, 3, &index));
+    EXPECT_EQ(6, neu_group_tag_size(group));
+    EXPECT_TRUE(neu_group_is_change(group, timestamp));
+
+    neu_group_destroy(group);
+}
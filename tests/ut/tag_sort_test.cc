@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -220,6 +221,37 @@ TEST(TagSortTest, SortDiff)
     free(tag4);
 }
 
+TEST(TagSortTest, SortLarge)
+{
+    UT_array *              tags   = NULL;
+    neu_tag_sort_result_t * result = NULL;
+    std::vector<struct tag> buf(200000);
+
+    utarray_new(tags, &ut_ptr_icd);
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i].type    = 1;
+        buf[i].station = 1 + i % 2;
+        buf[i].area    = 1;
+        buf[i].address = 1;
+        struct tag *p  = &buf[i];
+        utarray_push_back(tags, &p);
+    }
+
+    result = neu_tag_sort(tags, tag_sort_fn, tag_cmp);
+
+    ASSERT_EQ(2, result->n_sort);
+    EXPECT_EQ(100000, result->sorts[0].info.size);
+    EXPECT_EQ(100000, result->sorts[1].info.size);
+    EXPECT_EQ(100000, utarray_len(result->sorts[1].tags));
+
+    struct tag **p_tag =
+        (struct tag **) utarray_eltptr(result->sorts[1].tags, 99999);
+    EXPECT_EQ((*p_tag)->station, 2);
+
+    neu_tag_sort_free(result);
+    utarray_free(tags);
+}
+
 int main(int argc, char **argv)
 {
     zlog_init("./config/dev.conf");
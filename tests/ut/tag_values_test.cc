@@ -0,0 +1,186 @@
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "msg.h"
+#include "tag_values.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static UT_array *make_tags(int n)
+{
+    UT_array *tags = NULL;
+    char      name[32];
+
+    utarray_new(tags, neu_tag_get_icd());
+    for (int i = 0; i < n; i++) {
+        neu_datatag_t tag = {};
+
+        snprintf(name, sizeof(name), "tag%d", i);
+        tag.name        = name;
+        tag.address     = (char *) "1!400001";
+        tag.description = (char *) "";
+        tag.bias        = i;
+        utarray_push_back(tags, &tag);
+    }
+
+    return tags;
+}
+
+TEST(TagValuesTest, names)
+{
+    UT_array *       tags  = make_tags(3);
+    neu_tag_names_t *names = neu_tag_names_new(tags);
+
+    utarray_free(tags);
+    EXPECT_EQ(3, neu_tag_names_size(names));
+    EXPECT_STREQ("tag0", neu_tag_names_get(names, 0));
+    EXPECT_STREQ("tag2", neu_tag_names_get(names, 2));
+    EXPECT_EQ(NULL, neu_tag_names_get(names, 3));
+
+    neu_tag_names_ref(names);
+    neu_tag_names_unref(names);
+    neu_tag_names_unref(names);
+}
+
+TEST(TagValuesTest, push_get)
+{
+    UT_array *        tags   = make_tags(4);
+    neu_tag_names_t * names  = neu_tag_names_new(tags);
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+    neu_dvalue_t      value  = {};
+    const char *      str    = "hello";
+
+    utarray_free(tags);
+    neu_tag_names_unref(names);
+
+    value.type      = NEU_TYPE_UINT16;
+    value.value.u16 = 12;
+    EXPECT_EQ(0, neu_tag_values_push(values, 3, &value, NULL, 0));
+
+    value           = {};
+    value.type      = NEU_TYPE_DOUBLE;
+    value.value.d64 = 1.5;
+    value.precision = 2;
+    EXPECT_EQ(0, neu_tag_values_push(values, 1, &value, NULL, 0));
+
+    value      = {};
+    value.type = NEU_TYPE_STRING;
+    strcpy(value.value.str, str);
+    EXPECT_EQ(0, neu_tag_values_push(values, 0, &value, NULL, 0));
+
+    value                  = {};
+    value.type             = NEU_TYPE_PTR;
+    value.value.ptr.type   = NEU_TYPE_STRING;
+    value.value.ptr.length = 5;
+    value.value.ptr.ptr    = (uint8_t *) str;
+    EXPECT_EQ(0, neu_tag_values_push(values, 2, &value, NULL, 0));
+
+    ASSERT_EQ(4, neu_tag_values_size(values));
+    EXPECT_STREQ("tag3", neu_tag_values_name(values, 0));
+    EXPECT_STREQ("tag1", neu_tag_values_name(values, 1));
+
+    neu_tag_values_get(values, 0, &value);
+    EXPECT_EQ(NEU_TYPE_UINT16, value.type);
+    EXPECT_EQ(12, value.value.u16);
+
+    neu_tag_values_get(values, 1, &value);
+    EXPECT_EQ(NEU_TYPE_DOUBLE, value.type);
+    EXPECT_EQ(1.5, value.value.d64);
+    EXPECT_EQ(2, value.precision);
+
+    neu_tag_values_get(values, 2, &value);
+    EXPECT_EQ(NEU_TYPE_STRING, value.type);
+    EXPECT_STREQ(str, value.value.str);
+
+    neu_tag_values_get(values, 3, &value);
+    EXPECT_EQ(NEU_TYPE_PTR, value.type);
+    EXPECT_EQ(5, value.value.ptr.length);
+    EXPECT_EQ(0, memcmp(str, value.value.ptr.ptr, 5));
+    EXPECT_NE((uint8_t *) str, value.value.ptr.ptr);
+
+    neu_tag_values_unref(values);
+}
+
+TEST(TagValuesTest, metas)
+{
+    UT_array *        tags   = make_tags(100);
+    neu_tag_names_t * names  = neu_tag_names_new(tags);
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+
+    utarray_free(tags);
+    neu_tag_names_unref(names);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        neu_dvalue_t   value                    = {};
+        neu_tag_meta_t metas[NEU_TAG_META_SIZE] = {};
+
+        value.type      = NEU_TYPE_INT32;
+        value.value.i32 = i;
+        if (i % 10 == 0) {
+            strcpy(metas[0].name, "quality");
+            metas[0].value.type      = NEU_TYPE_INT32;
+            metas[0].value.value.i32 = i;
+        }
+
+        EXPECT_EQ(0,
+                  neu_tag_values_push(values, i, &value, metas,
+                                      NEU_TAG_META_SIZE));
+    }
+
+    for (uint32_t i = 0; i < 100; i++) {
+        const neu_tag_meta_t *metas = NULL;
+        int                   n     = neu_tag_values_metas(values, i, &metas);
+
+        if (i % 10 == 0) {
+            ASSERT_EQ(1, n);
+            EXPECT_STREQ("quality", metas[0].name);
+            EXPECT_EQ((int32_t) i, metas[0].value.value.i32);
+        } else {
+            EXPECT_EQ(0, n);
+            EXPECT_EQ(NULL, metas);
+        }
+    }
+
+    neu_tag_values_unref(values);
+}
+
+TEST(TagValuesTest, shared_snapshot)
+{
+    UT_array *        tags   = make_tags(2);
+    neu_tag_names_t * names  = neu_tag_names_new(tags);
+    neu_tag_values_t *values = neu_tag_values_new("modbus", "grp", names);
+    neu_dvalue_t      value  = {};
+
+    utarray_free(tags);
+    neu_tag_names_unref(names);
+
+    EXPECT_STREQ("modbus", neu_tag_values_driver(values));
+    EXPECT_STREQ("grp", neu_tag_values_group(values));
+
+    value.type      = NEU_TYPE_INT64;
+    value.value.i64 = -7;
+    EXPECT_EQ(0, neu_tag_values_push(values, 1, &value, NULL, 0));
+
+    std::vector<std::thread> subscribers;
+    for (int i = 0; i < 8; i++) {
+        neu_tag_values_t *ref = neu_tag_values_ref(values);
+        subscribers.emplace_back([ref]() {
+            neu_dvalue_t v = {};
+            neu_tag_values_get(ref, 0, &v);
+            EXPECT_EQ(-7, v.value.i64);
+            EXPECT_STREQ("tag1", neu_tag_values_name(ref, 0));
+            neu_tag_values_unref(ref);
+        });
+    }
+    neu_tag_values_unref(values);
+
+    for (auto &t : subscribers) {
+        t.join();
+    }
+}
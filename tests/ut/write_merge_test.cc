@@ -0,0 +1,78 @@
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "tag.h"
+
+#include "adapter/driver/write_merge.h"
+#include "utils/log.h"
+}
+
+zlog_category_t *neuron = NULL;
+
+static neu_datatag_t *make_tag(const char *name, const char *address)
+{
+    neu_datatag_t tag = {};
+
+    tag.name        = (char *) name;
+    tag.address     = (char *) address;
+    tag.description = (char *) "";
+    return neu_tag_dup(&tag);
+}
+
+static neu_value_u make_value(int32_t v)
+{
+    neu_value_u value = {};
+
+    value.i32 = v;
+    return value;
+}
+
+TEST(WriteMergeTest, SameTagLaterWins)
+{
+    neu_write_merge_t *merge = neu_write_merge_new();
+
+    neu_write_merge_add(merge, "grp", make_tag("tag1", "1!400001"),
+                        make_value(1));
+    neu_write_merge_add(merge, "grp", make_tag("tag2", "1!400002"),
+                        make_value(2));
+    neu_write_merge_add(merge, "grp", make_tag("tag1", "1!400001"),
+                        make_value(3));
+
+    UT_array *tvs = neu_write_merge_tvs(merge);
+    EXPECT_EQ(2U, utarray_len(tvs));
+
+    neu_plugin_tag_value_t *tv = (neu_plugin_tag_value_t *) utarray_front(tvs);
+    EXPECT_STREQ("tag1", tv->tag->name);
+    EXPECT_EQ(3, tv->value.i32);
+
+    tv = (neu_plugin_tag_value_t *) utarray_next(tvs, tv);
+    EXPECT_STREQ("tag2", tv->tag->name);
+    EXPECT_EQ(2, tv->value.i32);
+
+    neu_write_merge_free(merge);
+}
+
+TEST(WriteMergeTest, SameNameInTwoGroups)
+{
+    neu_write_merge_t *merge = neu_write_merge_new();
+
+    neu_write_merge_add(merge, "grp1", make_tag("tag1", "1!400001"),
+                        make_value(1));
+    neu_write_merge_add(merge, "grp2", make_tag("tag1", "2!400001"),
+                        make_value(2));
+
+    UT_array *tvs = neu_write_merge_tvs(merge);
+    EXPECT_EQ(2U, utarray_len(tvs));
+
+    neu_plugin_tag_value_t *tv = (neu_plugin_tag_value_t *) utarray_front(tvs);
+    EXPECT_STREQ("1!400001", tv->tag->address);
+    EXPECT_EQ(1, tv->value.i32);
+
+    tv = (neu_plugin_tag_value_t *) utarray_next(tvs, tv);
+    EXPECT_STREQ("2!400001", tv->tag->address);
+    EXPECT_EQ(2, tv->value.i32);
+
+    neu_write_merge_free(merge);
+}